@@ -12,11 +12,27 @@ TARGET = Stdf_V4_Reader
 TEMPLATE = app
 QMAKE_CXXFLAGS += -std=c++11
 
+# gzip output of StdfWriter, zstd only with CONFIG += zstd
+LIBS += -lz
+zstd {
+    DEFINES += STDF_HAVE_ZSTD
+    LIBS += -lzstd
+}
+
 SOURCES += \ 
     stdf_api/stdf_v4_api.cpp \
     stdf_api/stdf_v4_internal.cpp \
     stdf_file/stdf_v4_file.cpp \
+    stdf_file/stdf_v4_index.cpp \
+    stdf_file/stdf_v4_tail.cpp \
+    stdf_file/stdf_v4_writer.cpp \
+    stdf_file/stdf_v4_loader.cpp \
+    stdf_file/stdf_v4_columns.cpp \
+    stdf_file/stdf_v4_csv.cpp \
+    stdf_file/stdf_v4_results.cpp \
+    stdf_file/stdf_v4_batch.cpp \
     ui/stdf_window.cpp \
+    ui/record_table_model.cpp \
     debug_api/debug_api.cpp \
     main.cpp
 
@@ -24,7 +40,16 @@ HEADERS  += \
     stdf_api/stdf_v4_api.h \
     stdf_api/stdf_v4_internal.h \
     stdf_file/stdf_v4_file.h \
+    stdf_file/stdf_v4_index.h \
+    stdf_file/stdf_v4_tail.h \
+    stdf_file/stdf_v4_writer.h \
+    stdf_file/stdf_v4_loader.h \
+    stdf_file/stdf_v4_columns.h \
+    stdf_file/stdf_v4_csv.h \
+    stdf_file/stdf_v4_results.h \
+    stdf_file/stdf_v4_batch.h \
     ui/stdf_window.h \
+    ui/record_table_model.h \
     debug_api/debug_api.h \
     stdf_v4.rc
 
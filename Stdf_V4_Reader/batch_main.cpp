@@ -0,0 +1,98 @@
+/*************************************************************************
+ * Command line batch conversion of many stdf files into one output,
+ * see stdf_file/stdf_v4_batch.h.
+ * usage: stdf_batch [-j threads] [-m MB] [-z gzip|zstd]
+ *                   <text|prr|csv:TYPE|results|stdf> <output> <file|pattern|@list>...
+*************************************************************************/
+#include "stdf_file/stdf_v4_batch.h"
+#include "stdf_file/stdf_v4_columns.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <chrono>
+
+static STDF_TYPE find_type(const char* name)
+{
+    if(std::strlen(name) != 3) return UNKNOWN_TYPE;
+    char upper[4] = {0};
+    for(unsigned int i = 0; i < 3; i++) upper[i] = char(std::toupper((unsigned char)name[i]));
+
+    for(int i = 0; i < STDF_V4_RECORD_COUNT; i++)
+    {
+        if(std::strcmp(stdf_columns(STDF_TYPE(i))->name, upper) == 0) return STDF_TYPE(i);
+    }
+    return UNKNOWN_TYPE;
+}
+
+static bool find_mode(const char* name, STDF_BATCH_MODE& mode, StdfBatch& batch)
+{
+    if(std::strcmp(name, "text") == 0) mode = STDF_BATCH_TEXT;
+    else if(std::strcmp(name, "prr") == 0) mode = STDF_BATCH_PRR;
+    else if(std::strcmp(name, "results") == 0) mode = STDF_BATCH_RESULTS;
+    else if(std::strcmp(name, "stdf") == 0) mode = STDF_BATCH_STDF;
+    else if(std::strncmp(name, "csv:", 4) == 0)
+    {
+        STDF_TYPE type = find_type(name + 4);
+        if(type == UNKNOWN_TYPE) return false;
+        mode = STDF_BATCH_CSV;
+        batch.set_record_type(type);
+    }
+    else return false;
+    return true;
+}
+
+static int usage(const char* program)
+{
+    std::fprintf(stderr, "usage: %s [-j threads] [-m MB] [-z gzip|zstd] "
+                 "<text|prr|csv:TYPE|results|stdf> <output> <file|pattern|@list>...\n", program);
+    return 2;
+}
+
+int main(int argc, char *argv[])
+{
+    StdfBatch batch;
+    int arg = 1;
+    for(; arg + 1 < argc && argv[arg][0] == '-'; arg += 2)
+    {
+        const char* value = argv[arg + 1];
+        if(std::strcmp(argv[arg], "-j") == 0) batch.set_threads((unsigned int)std::atoi(value));
+        else if(std::strcmp(argv[arg], "-m") == 0) batch.set_memory_budget(std::strtoull(value, nullptr, 10) << 20);
+        else if(std::strcmp(argv[arg], "-z") == 0 && std::strcmp(value, "gzip") == 0) batch.set_compression(STDF_COMPRESS_GZIP);
+        else if(std::strcmp(argv[arg], "-z") == 0 && std::strcmp(value, "zstd") == 0) batch.set_compression(STDF_COMPRESS_ZSTD);
+        else return usage(argv[0]);
+    }
+    STDF_BATCH_MODE mode = STDF_BATCH_TEXT;
+    if(argc - arg < 3 || !find_mode(argv[arg], mode, batch)) return usage(argv[0]);
+    const char* output = argv[arg + 1];
+
+    std::vector<std::string> files;
+    for(arg += 2; arg < argc; arg++)
+    {
+        if(!StdfBatch::add_files(argv[arg], files)) std::fprintf(stderr, "no files for %s\n", argv[arg]);
+    }
+    if(files.empty())
+    {
+        std::fprintf(stderr, "no input files\n");
+        return 2;
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    STDF_FILE_ERROR ret = batch.run(mode, files, output);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for(unsigned int i = 0; i < files.size(); i++)
+    {
+        if(batch.get_result(i) != STDF_OPERATE_OK) std::fprintf(stderr, "%s failed: %d\n", files[i].c_str(), int(batch.get_result(i)));
+    }
+    double megabytes = batch.get_input_bytes() / 1048576.0;
+    std::printf("%u files, %u failed, %.1f MB in %.2f s, %.1f MB/s, %.1f MB written, peak reserved %.1f MB\n",
+                (unsigned int)files.size(), batch.get_failed_count(), megabytes, seconds,
+                seconds > 0 ? megabytes / seconds : 0.0, batch.get_output_bytes() / 1048576.0,
+                batch.get_peak_reserved() / 1048576.0);
+    if(ret != STDF_OPERATE_OK && batch.get_failed_count() == 0)
+    {
+        std::fprintf(stderr, "writing %s failed: %d\n", output, int(ret));
+    }
+    return (ret == STDF_OPERATE_OK) ? 0 : 1;
+}
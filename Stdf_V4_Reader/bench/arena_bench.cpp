@@ -0,0 +1,110 @@
+/*************************************************************************
+ * Load/unload time of a PTR heavy file, records on the heap vs in a StdfArena,
+ * and with the parallel read on all cores.
+ * usage: arena_bench [parts] [ptr_per_part] [file]
+*************************************************************************/
+#include "../stdf_api/stdf_v4_api.h"
+#include "../stdf_file/stdf_v4_file.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+typedef std::chrono::steady_clock bench_clock;
+
+static double elapsed_ms(bench_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(bench_clock::now() - start).count();
+}
+
+static bool make_ptr_file(const char* filename, unsigned int parts, unsigned int tests)
+{
+    std::ofstream out(filename, std::ios::binary);
+    if(!out) return false;
+
+    StdfHeader header;
+    StdfFAR far_record;
+    far_record.unparse(header);
+    header.write(out);
+    StdfMIR mir;
+    mir.set_lot_id("BENCH");
+    mir.unparse(header);
+    header.write(out);
+
+    StdfPIR pir;
+    StdfPTR ptr;
+    StdfPRR prr;
+    for(unsigned int part = 0; part < parts; part++)
+    {
+        pir.set_head_number(1);
+        pir.set_site_number(part % 4);
+        pir.unparse(header);
+        header.write(out);
+        for(unsigned int test = 0; test < tests; test++)
+        {
+            ptr.set_test_number(1000 + test);
+            ptr.set_head_number(1);
+            ptr.set_site_number(part % 4);
+            ptr.set_result(float(part % 100) * 0.01f + float(test));
+            ptr.set_test_text("CONTINUITY_VDD_PIN_TEST");
+            ptr.unparse(header);
+            header.write(out);
+        }
+        prr.set_head_number(1);
+        prr.set_site_number(part % 4);
+        prr.set_hardbin_number(1);
+        prr.set_softbin_number(1);
+        prr.set_part_id(std::to_string(part).c_str());
+        prr.unparse(header);
+        header.write(out);
+    }
+    StdfMRR mrr;
+    mrr.unparse(header);
+    header.write(out);
+    return true;
+}
+
+static void run(const char* filename, bool use_arena, unsigned int threads)
+{
+    bench_clock::time_point start = bench_clock::now();
+    STDF_FILE* file = new STDF_FILE(use_arena);
+    STDF_FILE_ERROR ret = (threads == 1) ? file->read(filename) : file->read(filename, threads);
+    if(ret != STDF_OPERATE_OK)
+    {
+        std::printf("read failed: %s\n", filename);
+        delete file;
+        return;
+    }
+    unsigned int count = file->get_total_count();
+    double load_ms = elapsed_ms(start);
+
+    start = bench_clock::now();
+    delete file;
+    double unload_ms = elapsed_ms(start);
+
+    std::printf("%-6s %-8s records=%u load=%.1f ms unload=%.1f ms\n",
+                use_arena ? "arena" : "heap", (threads == 1) ? "serial" : "parallel",
+                count, load_ms, unload_ms);
+}
+
+int main(int argc, char* argv[])
+{
+    unsigned int parts = (argc > 1) ? (unsigned int)std::atoi(argv[1]) : 20000;
+    unsigned int tests = (argc > 2) ? (unsigned int)std::atoi(argv[2]) : 100;
+    const char* filename = (argc > 3) ? argv[3] : "arena_bench.stdf";
+
+    if(!make_ptr_file(filename, parts, tests))
+    {
+        std::printf("can not write %s\n", filename);
+        return 1;
+    }
+    for(int round = 0; round < 3; round++)
+    {
+        run(filename, false, 1);
+        run(filename, true, 1);
+        run(filename, false, 0);
+        run(filename, true, 0);
+    }
+    std::remove(filename);
+    return 0;
+}
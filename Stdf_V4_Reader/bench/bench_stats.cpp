@@ -0,0 +1,122 @@
+#include "bench_stats.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+static std::atomic<unsigned long long> g_allocations(0);
+static std::atomic<unsigned long long> g_allocated(0);
+
+void* operator new(std::size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_allocated.fetch_add(size, std::memory_order_relaxed);
+    void* memory = std::malloc(size ? size : 1);
+    if(!memory) throw std::bad_alloc();
+    return memory;
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+unsigned long long bench_allocations()
+{
+    return g_allocations.load(std::memory_order_relaxed);
+}
+
+unsigned long long bench_allocated_bytes()
+{
+    return g_allocated.load(std::memory_order_relaxed);
+}
+
+unsigned long long bench_peak_rss()
+{
+#ifdef __linux__
+    std::FILE* status = std::fopen("/proc/self/status", "r");
+    if(!status) return 0;
+    char line[256];
+    unsigned long long kb = 0;
+    while(std::fgets(line, sizeof(line), status))
+    {
+        if(std::strncmp(line, "VmHWM:", 6) == 0)
+        {
+            kb = std::strtoull(line + 6, nullptr, 10);
+            break;
+        }
+    }
+    std::fclose(status);
+    return kb * 1024ULL;
+#else
+    return 0;
+#endif
+}
+
+void bench_reset_peak_rss()
+{
+#ifdef __GLIBC__
+    // give the freed heap of the previous stage back first, or it stays resident
+    malloc_trim(0);
+#endif
+#ifdef __linux__
+    // "5" resets VmHWM to the current RSS, since Linux 4.0
+    std::FILE* clear_refs = std::fopen("/proc/self/clear_refs", "w");
+    if(!clear_refs) return;
+    std::fputs("5", clear_refs);
+    std::fclose(clear_refs);
+#endif
+}
+
+BenchMeter::BenchMeter()
+{
+    m_allocations = 0;
+    m_allocated = 0;
+}
+
+void BenchMeter::start()
+{
+    bench_reset_peak_rss();
+    m_allocations = bench_allocations();
+    m_allocated = bench_allocated_bytes();
+    m_start = std::chrono::steady_clock::now();
+}
+
+BenchResult BenchMeter::stop(const char* stage, unsigned long long records, unsigned long long bytes) const
+{
+    BenchResult result;
+    result.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count();
+    result.stage = stage;
+    result.records = records;
+    result.bytes = bytes;
+    result.peak_rss = bench_peak_rss();
+    result.allocations = bench_allocations() - m_allocations;
+    result.allocated = bench_allocated_bytes() - m_allocated;
+    return result;
+}
+
+void BenchMeter::print_header()
+{
+    std::printf("%-16s %12s %12s %10s %10s %10s %10s %12s %10s\n", "stage", "records", "rec/s",
+                "MB", "MB/s", "ms", "peak MB", "allocs", "alloc MB");
+}
+
+void BenchMeter::print(const BenchResult& result)
+{
+    const double mb = 1024.0 * 1024.0;
+    double seconds = result.ms / 1000.0;
+    std::printf("%-16s %12llu %12.0f %10.1f %10.1f %10.1f %10.1f %12llu %10.1f\n", result.stage,
+                result.records, seconds > 0 ? result.records / seconds : 0.0,
+                result.bytes / mb, seconds > 0 ? result.bytes / mb / seconds : 0.0,
+                result.ms, result.peak_rss / mb, result.allocations, result.allocated / mb);
+}
+
+void BenchMeter::print_csv(const BenchResult& result)
+{
+    std::printf("%s,%llu,%llu,%.3f,%llu,%llu,%llu\n", result.stage, result.records, result.bytes,
+                result.ms, result.peak_rss, result.allocations, result.allocated);
+}
@@ -0,0 +1,51 @@
+/*************************************************************************
+ * Measurements of one benchmark stage: wall time, records and bytes per
+ * second, peak resident memory and the operator new calls it made.
+ * Link bench_stats.cpp into the benchmark, it replaces the global
+ * operator new/delete to count. malloc() of C code (zlib, libstdf) is not
+ * counted. The peak RSS is reset per stage on Linux (/proc/self/clear_refs),
+ * elsewhere it is the peak of the process so far, 0 where unknown.
+*************************************************************************/
+#ifndef _BENCH_STATS_H_
+#define _BENCH_STATS_H_
+
+#include <chrono>
+
+struct BenchResult
+{
+    const char* stage;
+    unsigned long long records;
+    unsigned long long bytes;
+    double ms;
+    unsigned long long peak_rss;     // bytes
+    unsigned long long allocations;
+    unsigned long long allocated;    // bytes
+};
+
+class BenchMeter
+{
+public:
+    BenchMeter();
+    void start();
+    // records and bytes the stage went through, for the rates
+    BenchResult stop(const char* stage, unsigned long long records, unsigned long long bytes) const;
+
+    static void print_header();
+    static void print(const BenchResult& result);
+    // one line per result for scripts: stage,records,bytes,ms,peak_rss,allocations,allocated
+    static void print_csv(const BenchResult& result);
+
+private:
+    std::chrono::steady_clock::time_point m_start;
+    unsigned long long m_allocations;
+    unsigned long long m_allocated;
+};
+
+// counters of the replaced operator new since the start of the process
+unsigned long long bench_allocations();
+unsigned long long bench_allocated_bytes();
+// VmHWM, 0 if not known
+unsigned long long bench_peak_rss();
+void bench_reset_peak_rss();
+
+#endif//_BENCH_STATS_H_
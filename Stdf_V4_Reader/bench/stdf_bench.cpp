@@ -0,0 +1,294 @@
+/*************************************************************************
+ * Read, scan, save, CSV export and result cache throughput on a synthetic
+ * or given file.
+ * usage: stdf_bench [--file f.stdf] [--rounds n] [--csv] [--keep]
+ *                   [--parts n] [--sites n] [--ptr n] [--mpr n] [--mpr-pins n]
+ *                   [--ftr n] [--size MB] [--seed n]
+ * Without --file a file is generated from the synth options first, --size
+ * adds touchdowns until the file has that many MB. --csv prints the results
+ * as comma separated lines for scripts. Before the timed stages save_check
+ * checks that save() writes every record as a fresh unparse() does, and
+ * stops the bench if not.
+*************************************************************************/
+#include "bench_stats.h"
+#include "stdf_synth.h"
+#include "../stdf_file/stdf_v4_csv.h"
+#include "../stdf_file/stdf_v4_results.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#define BENCH_FILE "stdf_bench.stdf"
+#define BENCH_SAVE_FILE "stdf_bench_save.stdf"
+#define BENCH_GZIP_FILE "stdf_bench_save.stdf.gz"
+#define BENCH_CSV_FILE "stdf_bench_ptr.csv"
+#define BENCH_RESULTS_FILE "stdf_bench_results.stdr"
+#define BENCH_CHECK_FILE "stdf_bench_check.stdf"
+
+static bool g_csv = false;
+
+static void report(const BenchResult& result)
+{
+    if(g_csv) BenchMeter::print_csv(result);
+    else BenchMeter::print(result);
+}
+
+static unsigned long long file_size(const char* filename)
+{
+    std::FILE* file = std::fopen(filename, "rb");
+    if(!file) return 0;
+    std::fseek(file, 0, SEEK_END);
+    long long size = std::ftell(file);
+    std::fclose(file);
+    return (size > 0) ? (unsigned long long)size : 0;
+}
+
+class CountVisitor : public StdfRecordVisitor
+{
+public:
+    CountVisitor() : records(0) {}
+    bool visit(StdfRecord*, unsigned long long)
+    {
+        records++;
+        return true;
+    }
+    unsigned long long records;
+};
+
+static bool bench_read(const char* stage, const char* filename, bool use_arena, unsigned int threads)
+{
+    unsigned long long bytes = file_size(filename);
+    BenchMeter meter;
+    meter.start();
+    STDF_FILE* file = new STDF_FILE(use_arena);
+    STDF_FILE_ERROR ret = (threads == 1) ? file->read(filename) : file->read(filename, threads);
+    unsigned long long records = file->get_total_count();
+    delete file;
+    if(ret != STDF_OPERATE_OK)
+    {
+        std::fprintf(stderr, "%s: read of %s failed: %d\n", stage, filename, int(ret));
+        return false;
+    }
+    report(meter.stop(stage, records, bytes));
+    return true;
+}
+
+static bool bench_scan(const char* filename)
+{
+    unsigned long long bytes = file_size(filename);
+    BenchMeter meter;
+    meter.start();
+    CountVisitor visitor;
+    STDF_FILE_ERROR ret = STDF_FILE::scan(filename, visitor);
+    if(ret != STDF_OPERATE_OK) return false;
+    report(meter.stop("scan", visitor.records, bytes));
+    return true;
+}
+
+// only the writing is measured, the file is read before
+static bool bench_save(const char* stage, const char* filename, const char* out, STDF_COMPRESSION compression)
+{
+    STDF_FILE file(true);
+    if(file.read(filename) != STDF_OPERATE_OK) return false;
+
+    BenchMeter meter;
+    meter.start();
+    STDF_FILE_ERROR ret = file.save(out, compression);
+    BenchResult result = meter.stop(stage, file.get_total_count(), file_size(out));
+    std::remove(out);
+    if(ret != STDF_OPERATE_OK)
+    {
+        std::fprintf(stderr, "%s: save to %s failed: %d\n", stage, out, int(ret));
+        return false;
+    }
+    report(result);
+    return true;
+}
+
+// FAR, MIR, a 250 byte DTR, GDR and MRR saved and read again: the GDR is
+// unparsed into the buffer the DTR filled, every record of the saved file has
+// to be the bytes its record gives unparsed into an unused header
+static bool check_save()
+{
+    {
+        StdfWriter writer;
+        if(writer.open(BENCH_CHECK_FILE, STDF_COMPRESS_NONE) != STDF_OPERATE_OK) return false;
+        StdfFAR far_record;
+        writer.write(&far_record);
+        StdfMIR mir;
+        writer.write(&mir);
+        StdfDTR dtr;
+        std::string text(250, 'X');
+        dtr.set_text_data(text.c_str());
+        writer.write(&dtr);
+        StdfGDR gdr;
+        gdr.set_data_count(2);
+        const unsigned char values[2] = { 'a', 'b' };
+        for(unsigned int i = 0; i < 2; i++)
+        {
+            gdr.set_data_type(VnType(1), i);
+            gdr.set_data_value(&values[i], i, 1);
+        }
+        writer.write(&gdr);
+        StdfMRR mrr;
+        writer.write(&mrr);
+        if(writer.close() != STDF_OPERATE_OK) return false;
+    }
+
+    BenchMeter meter;
+    meter.start();
+    STDF_FILE file;
+    STDF_FILE_ERROR ret = file.read(BENCH_CHECK_FILE);
+    if(ret == STDF_OPERATE_OK) ret = file.save(BENCH_SAVE_FILE);
+    std::remove(BENCH_CHECK_FILE);
+    StdfRecordCursor cursor;
+    if(ret != STDF_OPERATE_OK || !cursor.open(BENCH_SAVE_FILE))
+    {
+        std::fprintf(stderr, "save_check: save failed: %d\n", int(ret));
+        std::remove(BENCH_SAVE_FILE);
+        return false;
+    }
+
+    std::vector<char> expected(4 + 65535);
+    StdfHeader header;
+    unsigned int position = 0, index = 0;
+    bool ok = true;
+    while(ok && cursor.next(header))
+    {
+        // save() puts its ATR behind the FAR
+        if(position++ == 1 && header.get_type() == ATR_TYPE) continue;
+        StdfRecord* record = (index < file.get_total_count()) ? file.get_record(index) : nullptr;
+        index++;
+        if(!record)
+        {
+            std::fprintf(stderr, "save_check: more records saved than read\n");
+            ok = false;
+            break;
+        }
+        StdfHeader fresh;
+        record->unparse(fresh);
+        unsigned int length = fresh.serialize(&expected[0]);
+        if(length != 4U + header.get_length() ||
+           std::memcmp(&expected[0], cursor.data() + cursor.record_offset(), length) != 0)
+        {
+            std::fprintf(stderr, "save_check: record %u (%s) saved differently\n", index - 1,
+                         file.get_name(header.get_type()));
+            ok = false;
+        }
+    }
+    if(ok && index != file.get_total_count())
+    {
+        std::fprintf(stderr, "save_check: %u of %u records saved\n", index, file.get_total_count());
+        ok = false;
+    }
+    unsigned long long bytes = cursor.size();
+    cursor.close();
+    std::remove(BENCH_SAVE_FILE);
+    if(!ok) return false;
+    report(meter.stop("save_check", index, bytes));
+    return true;
+}
+
+static bool bench_csv(const char* filename)
+{
+    BenchMeter meter;
+    meter.start();
+    StdfCsvExporter exporter;
+    STDF_FILE_ERROR ret = exporter.write(filename, PTR_TYPE, BENCH_CSV_FILE);
+    BenchResult result = meter.stop("csv_ptr", exporter.row_count(), file_size(BENCH_CSV_FILE));
+    std::remove(BENCH_CSV_FILE);
+    if(ret != STDF_OPERATE_OK) return false;
+    report(result);
+    return true;
+}
+
+// results_build: PTR/MPR results into the columnar cache and its sidecar,
+// results_stats: the sidecar mapped and the statistics of every test
+static bool bench_results(const char* filename)
+{
+    BenchMeter meter;
+    meter.start();
+    StdfResultCache cache;
+    STDF_FILE_ERROR ret = cache.build(filename);
+    if(ret == STDF_OPERATE_OK) ret = cache.save(BENCH_RESULTS_FILE);
+    if(ret != STDF_OPERATE_OK)
+    {
+        std::fprintf(stderr, "results_build: cache of %s failed: %d\n", filename, int(ret));
+        std::remove(BENCH_RESULTS_FILE);
+        return false;
+    }
+    report(meter.stop("results_build", cache.get_result_count(), file_size(filename)));
+    cache.clear();
+
+    meter.start();
+    ret = cache.open(BENCH_RESULTS_FILE);
+    unsigned long long results = 0;
+    for(unsigned int test = 0; ret == STDF_OPERATE_OK && test < cache.get_test_count(); test++)
+    {
+        results += cache.get_stats(test).count;
+    }
+    BenchResult result = meter.stop("results_stats", results, file_size(BENCH_RESULTS_FILE));
+    cache.clear();
+    std::remove(BENCH_RESULTS_FILE);
+    if(ret != STDF_OPERATE_OK) return false;
+    report(result);
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    StdfSynthConfig config;
+    const char* filename = nullptr;
+    unsigned int rounds = 1;
+    bool keep = false;
+    for(int i = 1; i < argc; i++)
+    {
+        if(std::strcmp(argv[i], "--csv") == 0) g_csv = true;
+        else if(std::strcmp(argv[i], "--keep") == 0) keep = true;
+        else if(std::strcmp(argv[i], "--file") == 0 && i + 1 < argc) filename = argv[++i];
+        else if(std::strcmp(argv[i], "--rounds") == 0 && i + 1 < argc) rounds = (unsigned int)std::atoi(argv[++i]);
+        else if(i + 1 < argc && config.set_option(argv[i], argv[i + 1])) i++;
+        else
+        {
+            std::fprintf(stderr, "bad option %s, see the head of stdf_bench.cpp\n", argv[i]);
+            return 2;
+        }
+    }
+
+    if(g_csv) std::printf("stage,records,bytes,ms,peak_rss,allocations,allocated\n");
+    else BenchMeter::print_header();
+
+    bool generated = false;
+    if(!filename)
+    {
+        filename = BENCH_FILE;
+        BenchMeter meter;
+        meter.start();
+        StdfSynth synth(config);
+        if(synth.write(filename) != STDF_OPERATE_OK)
+        {
+            std::fprintf(stderr, "can not write %s\n", filename);
+            return 1;
+        }
+        report(meter.stop("generate", synth.record_count(), synth.byte_count()));
+        generated = true;
+    }
+
+    bool ok = check_save();
+    for(unsigned int round = 0; round < rounds && ok; round++)
+    {
+        ok = bench_read("read", filename, false, 1)
+          && bench_read("read_arena", filename, true, 1)
+          && bench_read("read_parallel", filename, true, 0)
+          && bench_scan(filename)
+          && bench_save("save", filename, BENCH_SAVE_FILE, STDF_COMPRESS_NONE)
+          && bench_save("save_gzip", filename, BENCH_GZIP_FILE, STDF_COMPRESS_GZIP)
+          && bench_csv(filename)
+          && bench_results(filename);
+    }
+
+    if(generated && !keep) std::remove(filename);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,312 @@
+#include "stdf_synth.h"
+#include <cstdlib>
+#include <cstring>
+
+// fixed times, same seed same file
+#define SYNTH_START_TIME 1500000000
+#define SYNTH_HARD_BINS 5
+#define SYNTH_SOFT_BINS 8
+// one in this many results is out of its limits
+#define SYNTH_FAIL_RATE 2000
+
+StdfSynthConfig::StdfSynthConfig()
+{
+    parts = 1000;
+    sites = 4;
+    ptr_per_part = 100;
+    mpr_per_part = 2;
+    mpr_pins = 8;
+    ftr_per_part = 5;
+    target_bytes = 0;
+    seed = 1;
+}
+
+static bool parse_number(const char* value, unsigned long long& number)
+{
+    if(!value || !*value) return false;
+    char* end = nullptr;
+    number = std::strtoull(value, &end, 10);
+    return *end == '\0';
+}
+
+bool StdfSynthConfig::set_option(const char* name, const char* value)
+{
+    unsigned long long number;
+    if(!parse_number(value, number)) return false;
+
+    if(std::strcmp(name, "--parts") == 0) parts = (unsigned int)number;
+    else if(std::strcmp(name, "--sites") == 0) sites = (unsigned int)number;
+    else if(std::strcmp(name, "--ptr") == 0) ptr_per_part = (unsigned int)number;
+    else if(std::strcmp(name, "--mpr") == 0) mpr_per_part = (unsigned int)number;
+    else if(std::strcmp(name, "--mpr-pins") == 0) mpr_pins = (unsigned int)number;
+    else if(std::strcmp(name, "--ftr") == 0) ftr_per_part = (unsigned int)number;
+    else if(std::strcmp(name, "--size") == 0)
+    {
+        // the size decides unless --parts follows
+        target_bytes = number * 1024ULL * 1024ULL;
+        parts = 0;
+    }
+    else if(std::strcmp(name, "--seed") == 0) seed = (unsigned int)number;
+    else return false;
+
+    if(sites < 1 || sites > 255) return false;
+    if(mpr_pins > 65535) return false;
+    return true;
+}
+
+StdfSynth::StdfSynth(const StdfSynthConfig& config) : m_config(config)
+{
+    m_random = config.seed ? config.seed : 1;
+    m_parts = 0;
+    m_records = 0;
+    m_bytes = 0;
+    m_good = 0;
+}
+
+// xorshift32, the same numbers on every platform
+unsigned int StdfSynth::next_random()
+{
+    m_random ^= m_random << 13;
+    m_random ^= m_random >> 17;
+    m_random ^= m_random << 5;
+    return m_random;
+}
+
+// in [low, high] but once in SYNTH_FAIL_RATE times above high
+float StdfSynth::next_result(float low, float high)
+{
+    unsigned int random = next_random();
+    float value = low + (high - low) * float(random % 10000U) / 10000.0f;
+    if(random % SYNTH_FAIL_RATE == 0) value = high + 1.0f;
+    return value;
+}
+
+STDF_FILE_ERROR StdfSynth::write(const char* filename)
+{
+    m_random = m_config.seed ? m_config.seed : 1;
+    m_parts = 0;
+    m_good = 0;
+    m_hard_bins.assign(SYNTH_HARD_BINS + 1, 0);
+    m_soft_bins.assign(SYNTH_SOFT_BINS + 1, 0);
+    m_ptr_fails.assign(m_config.ptr_per_part, 0);
+    m_test_names.clear();
+    unsigned int test_count = m_config.ptr_per_part + m_config.mpr_per_part + m_config.ftr_per_part;
+    for(unsigned int i = 0; i < test_count; i++)
+    {
+        m_test_names.push_back("SYNTH_TEST_" + std::to_string(i) + "_VDD_CONTINUITY");
+    }
+
+    StdfWriter writer;
+    STDF_FILE_ERROR ret = writer.open(filename, STDF_COMPRESS_NONE);
+    if(ret != STDF_OPERATE_OK) return ret;
+
+    StdfFAR far_record;
+    writer.write(&far_record);
+
+    StdfMIR mir;
+    mir.set_setup_time(SYNTH_START_TIME);
+    mir.set_start_time(SYNTH_START_TIME);
+    mir.set_station_number(1);
+    mir.set_lot_id("SYNTH_LOT");
+    mir.set_part_type("SYNTH_PART");
+    mir.set_node_name("bench");
+    mir.set_tester_type("SYNTH");
+    mir.set_program_name("synth_program");
+    mir.set_program_revision("1.0");
+    mir.set_sublot_id("SYNTH_SUBLOT");
+    writer.write(&mir);
+
+    StdfSDR sdr;
+    sdr.set_head_number(1);
+    sdr.set_site_count((unsigned char)m_config.sites);
+    for(unsigned int site = 0; site < m_config.sites; site++)
+    {
+        sdr.set_site_number((unsigned char)site, (unsigned char)(site + 1));
+    }
+    writer.write(&sdr);
+
+    for(unsigned int touchdown = 0; ; touchdown++)
+    {
+        if(m_config.parts && touchdown >= m_config.parts) break;
+        if(m_config.target_bytes && writer.byte_count() >= m_config.target_bytes) break;
+        if(!m_config.parts && !m_config.target_bytes) break;
+        ret = write_touchdown(writer);
+        if(ret != STDF_OPERATE_OK) break;
+    }
+    if(ret == STDF_OPERATE_OK) ret = write_summary(writer);
+
+    STDF_FILE_ERROR close_ret = writer.close();
+    m_records = writer.record_count();
+    m_bytes = writer.byte_count();
+    return (ret != STDF_OPERATE_OK) ? ret : close_ret;
+}
+
+STDF_FILE_ERROR StdfSynth::write_touchdown(StdfWriter& writer)
+{
+    STDF_FILE_ERROR ret = STDF_OPERATE_OK;
+    unsigned int sites = m_config.sites;
+    std::vector<bool> failed(sites, false);
+    std::vector<unsigned int> first_fail(sites, 0);
+
+    StdfPIR pir;
+    pir.set_head_number(1);
+    for(unsigned int site = 0; site < sites; site++)
+    {
+        pir.set_site_number((unsigned char)(site + 1));
+        writer.write(&pir);
+    }
+
+    // the tests of all sites, site after site as a multi-site tester logs them
+    StdfPTR ptr;
+    ptr.set_head_number(1);
+    ptr.set_low_limit(0.5f);
+    ptr.set_high_limit(1.5f);
+    ptr.set_unit("V");
+    ptr.set_result_format("%7.3f");
+    for(unsigned int site = 0; site < sites; site++)
+    {
+        ptr.set_site_number((unsigned char)(site + 1));
+        for(unsigned int test = 0; test < m_config.ptr_per_part; test++)
+        {
+            float result = next_result(0.5f, 1.5f);
+            if(result > 1.5f)
+            {
+                if(!failed[site]) first_fail[site] = test;
+                failed[site] = true;
+                m_ptr_fails[test]++;
+            }
+            ptr.set_test_number(1000 + test);
+            ptr.set_result(result);
+            ptr.set_test_text(m_test_names[test].c_str());
+            writer.write(&ptr);
+        }
+    }
+
+    StdfMPR mpr;
+    mpr.set_head_number(1);
+    mpr.set_low_limit(-1.0f);
+    mpr.set_high_limit(1.0f);
+    mpr.set_unit("mA");
+    unsigned short pins = (unsigned short)m_config.mpr_pins;
+    mpr.set_pin_count(pins);
+    mpr.set_result_count(pins);
+    for(unsigned int site = 0; site < sites; site++)
+    {
+        mpr.set_site_number((unsigned char)(site + 1));
+        for(unsigned int test = 0; test < m_config.mpr_per_part; test++)
+        {
+            mpr.set_test_number(2000 + test);
+            mpr.set_test_text(m_test_names[m_config.ptr_per_part + test].c_str());
+            for(unsigned short pin = 0; pin < pins; pin++)
+            {
+                mpr.set_return_state(pin, (unsigned char)(next_random() & 0x7));
+                mpr.set_return_result(pin, next_result(-1.0f, 1.0f));
+                mpr.set_pin_index(pin, (unsigned short)(pin + 1));
+            }
+            writer.write(&mpr);
+        }
+    }
+
+    StdfFTR ftr;
+    ftr.set_head_number(1);
+    for(unsigned int site = 0; site < sites; site++)
+    {
+        ftr.set_site_number((unsigned char)(site + 1));
+        for(unsigned int test = 0; test < m_config.ftr_per_part; test++)
+        {
+            ftr.set_test_number(3000 + test);
+            ftr.set_cycle_count(next_random() % 100000U);
+            ftr.set_vector_pattern_name("synth_pattern");
+            ftr.set_test_text(m_test_names[m_config.ptr_per_part + m_config.mpr_per_part + test].c_str());
+            writer.write(&ftr);
+        }
+    }
+
+    StdfPRR prr;
+    prr.set_head_number(1);
+    for(unsigned int site = 0; site < sites; site++)
+    {
+        unsigned int part = (unsigned int)m_parts++;
+        unsigned short hard_bin = failed[site] ? (unsigned short)(2 + first_fail[site] % (SYNTH_HARD_BINS - 1)) : 1;
+        unsigned short soft_bin = failed[site] ? (unsigned short)(2 + first_fail[site] % (SYNTH_SOFT_BINS - 1)) : 1;
+        m_hard_bins[hard_bin]++;
+        m_soft_bins[soft_bin]++;
+        if(!failed[site]) m_good++;
+
+        prr.set_site_number((unsigned char)(site + 1));
+        prr.set_number_test((unsigned short)(m_config.ptr_per_part + m_config.mpr_per_part + m_config.ftr_per_part));
+        prr.set_hardbin_number(hard_bin);
+        prr.set_softbin_number(soft_bin);
+        prr.set_x_coordinate((short)(part % 200));
+        prr.set_y_coordinate((short)((part / 200) % 200));
+        prr.set_elapsed_ms(500 + next_random() % 500U);
+        prr.set_part_id(std::to_string(part + 1).c_str());
+        ret = writer.write(&prr);
+    }
+    // the writer fails every write after the first failing one
+    return ret;
+}
+
+STDF_FILE_ERROR StdfSynth::write_summary(StdfWriter& writer)
+{
+    StdfTSR tsr;
+    tsr.set_head_number(255);
+    tsr.set_test_type(Parametric_Test);
+    tsr.set_exec_count((unsigned int)m_parts);
+    for(unsigned int test = 0; test < m_config.ptr_per_part; test++)
+    {
+        tsr.set_test_number(1000 + test);
+        tsr.set_fail_count(m_ptr_fails[test]);
+        tsr.set_test_name(m_test_names[test].c_str());
+        writer.write(&tsr);
+    }
+
+    StdfHBR hbr;
+    hbr.set_head_number(255);
+    for(unsigned short bin = 1; bin <= SYNTH_HARD_BINS; bin++)
+    {
+        if(m_hard_bins[bin] == 0) continue;
+        hbr.set_hardbin_number(bin);
+        hbr.set_hardbin_count(m_hard_bins[bin]);
+        hbr.set_hardbin_indication(bin == 1 ? 'P' : 'F');
+        hbr.set_hardbin_name(bin == 1 ? "PASS" : "FAIL");
+        writer.write(&hbr);
+    }
+
+    StdfSBR sbr;
+    sbr.set_head_number(255);
+    for(unsigned short bin = 1; bin <= SYNTH_SOFT_BINS; bin++)
+    {
+        if(m_soft_bins[bin] == 0) continue;
+        sbr.set_softbin_number(bin);
+        sbr.set_softbin_count(m_soft_bins[bin]);
+        sbr.set_softbin_indication(bin == 1 ? 'P' : 'F');
+        sbr.set_softbin_name(bin == 1 ? "PASS" : "FAIL");
+        writer.write(&sbr);
+    }
+
+    StdfPCR pcr;
+    pcr.set_head_number(255);
+    pcr.set_part_count((unsigned int)m_parts);
+    pcr.set_passed_count(m_good);
+    writer.write(&pcr);
+
+    StdfMRR mrr;
+    mrr.set_finish_time(SYNTH_START_TIME + (time_t)m_parts);
+    return writer.write(&mrr);
+}
+
+unsigned long long StdfSynth::record_count() const
+{
+    return m_records;
+}
+
+unsigned long long StdfSynth::byte_count() const
+{
+    return m_bytes;
+}
+
+unsigned long long StdfSynth::part_count() const
+{
+    return m_parts;
+}
@@ -0,0 +1,67 @@
+/*************************************************************************
+ * Synthetic stdf files for the benchmarks: a multi-site test program with
+ * a configurable number of PTR, MPR and FTR per part, written with the
+ * records' unparse() through StdfWriter as STDF_FILE::save does. The same
+ * config and seed always give the same file.
+ * Each touchdown writes a PIR per site, the tests of all sites and a PRR
+ * per site, the summary (TSR, HBR, SBR, PCR) and MRR close the file.
+*************************************************************************/
+#ifndef _STDF_SYNTH_H_
+#define _STDF_SYNTH_H_
+
+#include "../stdf_file/stdf_v4_file.h"
+#include "../stdf_file/stdf_v4_writer.h"
+#include <string>
+#include <vector>
+
+struct StdfSynthConfig
+{
+    StdfSynthConfig();
+    // --parts --sites --ptr --mpr --mpr-pins --ftr --size (MB) --seed, returns
+    // false for an unknown name or a bad value. --size drops the parts limit.
+    bool set_option(const char* name, const char* value);
+
+    unsigned int parts;              // per site, 0: as many as target_bytes needs
+    unsigned int sites;              // 1 to 255
+    unsigned int ptr_per_part;
+    unsigned int mpr_per_part;
+    unsigned int mpr_pins;           // results of each MPR
+    unsigned int ftr_per_part;
+    unsigned long long target_bytes; // stop at touchdown end past this size, 0: parts decide
+    unsigned int seed;
+};
+
+class StdfSynth
+{
+public:
+    explicit StdfSynth(const StdfSynthConfig& config);
+
+    STDF_FILE_ERROR write(const char* filename);
+
+    // of the last write()
+    unsigned long long record_count() const;
+    unsigned long long byte_count() const;
+    unsigned long long part_count() const;
+
+private:
+    unsigned int next_random();
+    float next_result(float low, float high);
+    STDF_FILE_ERROR write_touchdown(StdfWriter& writer);
+    STDF_FILE_ERROR write_summary(StdfWriter& writer);
+
+private:
+    StdfSynthConfig m_config;
+    unsigned int m_random;
+    unsigned long long m_parts;
+    unsigned long long m_records;
+    unsigned long long m_bytes;
+    // per hard bin and soft bin: parts of each, for HBR/SBR
+    std::vector<unsigned int> m_hard_bins;
+    std::vector<unsigned int> m_soft_bins;
+    unsigned int m_good;
+    // per PTR test: failures, for TSR
+    std::vector<unsigned int> m_ptr_fails;
+    std::vector<std::string> m_test_names;
+};
+
+#endif//_STDF_SYNTH_H_
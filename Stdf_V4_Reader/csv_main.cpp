@@ -0,0 +1,48 @@
+/*************************************************************************
+ * Command line CSV export, the same rows the viewer table shows.
+ * usage: stdf_csv <stdf file> <record type> <csv file>
+ * record type is the record name, FAR ... DTR. The stdf file is streamed,
+ * only the tests of the current part are kept for PTR.
+*************************************************************************/
+#include "stdf_file/stdf_v4_csv.h"
+#include <cstdio>
+#include <cstring>
+#include <cctype>
+
+static STDF_TYPE find_type(const char* name)
+{
+    if(std::strlen(name) != 3) return UNKNOWN_TYPE;
+    char upper[4] = {0};
+    for(unsigned int i = 0; i < 3; i++) upper[i] = char(std::toupper((unsigned char)name[i]));
+
+    for(int i = 0; i < STDF_V4_RECORD_COUNT; i++)
+    {
+        if(std::strcmp(stdf_columns(STDF_TYPE(i))->name, upper) == 0) return STDF_TYPE(i);
+    }
+    return UNKNOWN_TYPE;
+}
+
+int main(int argc, char *argv[])
+{
+    if(argc != 4)
+    {
+        std::fprintf(stderr, "usage: %s <stdf file> <record type> <csv file>\n", argv[0]);
+        return 2;
+    }
+    STDF_TYPE type = find_type(argv[2]);
+    if(type == UNKNOWN_TYPE)
+    {
+        std::fprintf(stderr, "unknown record type %s\n", argv[2]);
+        return 2;
+    }
+
+    StdfCsvExporter exporter;
+    STDF_FILE_ERROR ret = exporter.write(argv[1], type, argv[3]);
+    if(ret != STDF_OPERATE_OK)
+    {
+        std::fprintf(stderr, "export of %s failed: %d\n", argv[1], int(ret));
+        return 1;
+    }
+    std::printf("%llu rows written to %s\n", exporter.row_count(), argv[3]);
+    return 0;
+}
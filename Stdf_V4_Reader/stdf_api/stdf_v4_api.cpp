@@ -2,8 +2,35 @@
 #include "stdf_v4_internal.h"
 #include "../debug_api/debug_api.h"
 #include <cstring>
+#include <cstdint>
+#include <new>
+#include <unordered_map>
+#include <utility>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 //=====================================================================
 
+// Impl objects follow the record: from its arena when it has one, else the heap.
+template <typename T>
+static T* create_impl(StdfArena* arena)
+{
+    if(arena == nullptr) return new T();
+    return new (arena->allocate(sizeof(T), alignof(T))) T();
+}
+
+template <typename T>
+static void destroy_impl(T* impl, StdfArena* arena)
+{
+    if(arena == nullptr) delete impl;
+    else if(impl) impl->~T();
+}
+
 static STDF_TYPE make_record_type(int type)
 {
 	STDF_TYPE record_type;
@@ -68,6 +95,28 @@ int StdfHeader::write(std::ofstream& file_stream)
     return header->WriteRecord(file_stream);
 }
 
+unsigned int StdfHeader::serialize(char* out) const
+{
+    return header->Serialize(out);
+}
+
+static inline unsigned short record_length(const char* record, bool swapped)
+{
+    unsigned short length = 0;
+    std::memcpy(&length, record, 2);
+    if(swapped) length = (unsigned short)((length >> 8) | (length << 8));
+    return length;
+}
+
+bool StdfHeader::map(const char* record, unsigned int available_length, bool swapped)
+{
+    if(available_length < 4) return false;
+    unsigned short length = record_length(record, swapped);
+    if(available_length < 4U + length) return false;
+    header->MapRecord(record, 4U + length, swapped);
+    return true;
+}
+
 unsigned short StdfHeader::get_length() const
 {
     return header->REC_LEN;
@@ -89,49 +138,293 @@ unsigned char StdfHeader::get_sub_type() const
     return header->REC_SUB;
 }
 
-StdfRecord* StdfHeader::create_record(STDF_TYPE type)
+StdfRecord* StdfHeader::create_record(STDF_TYPE type, StdfArena* arena)
 {
     StdfRecord* record = nullptr;
     switch(type)
     {
-	case FAR_TYPE:  record = new StdfFAR(); break;
-    case ATR_TYPE:  record = new StdfATR(); break;
-	case MIR_TYPE:  record = new StdfMIR(); break;
-	case MRR_TYPE:  record = new StdfMRR(); break;
-	case PCR_TYPE:  record = new StdfPCR(); break;
-	case HBR_TYPE:  record = new StdfHBR(); break;
-	case SBR_TYPE:  record = new StdfSBR(); break;
-	case PMR_TYPE:  record = new StdfPMR(); break;
-	case PGR_TYPE:  record = new StdfPGR(); break;
-	case PLR_TYPE:  record = new StdfPLR(); break;
-	case RDR_TYPE:  record = new StdfRDR(); break;
-	case SDR_TYPE:  record = new StdfSDR(); break;
-	case WIR_TYPE:  record = new StdfWIR(); break;
-	case WRR_TYPE:  record = new StdfWRR(); break;
-	case WCR_TYPE:  record = new StdfWCR(); break;
-	case PIR_TYPE:  record = new StdfPIR(); break;
-	case PRR_TYPE:  record = new StdfPRR(); break;
-	case TSR_TYPE:  record = new StdfTSR(); break;
-	case PTR_TYPE:  record = new StdfPTR(); break;
-	case MPR_TYPE:  record = new StdfMPR(); break;
-	case FTR_TYPE:  record = new StdfFTR(); break;
-	case BPS_TYPE:  record = new StdfBPS(); break;
-	case EPS_TYPE:  record = new StdfEPS(); break;
-	case GDR_TYPE:  record = new StdfGDR(); break;
-	case DTR_TYPE:  record = new StdfDTR(); break;
+	case FAR_TYPE:  record = new (arena) StdfFAR(arena); break;
+    case ATR_TYPE:  record = new (arena) StdfATR(arena); break;
+	case MIR_TYPE:  record = new (arena) StdfMIR(arena); break;
+	case MRR_TYPE:  record = new (arena) StdfMRR(arena); break;
+	case PCR_TYPE:  record = new (arena) StdfPCR(arena); break;
+	case HBR_TYPE:  record = new (arena) StdfHBR(arena); break;
+	case SBR_TYPE:  record = new (arena) StdfSBR(arena); break;
+	case PMR_TYPE:  record = new (arena) StdfPMR(arena); break;
+	case PGR_TYPE:  record = new (arena) StdfPGR(arena); break;
+	case PLR_TYPE:  record = new (arena) StdfPLR(arena); break;
+	case RDR_TYPE:  record = new (arena) StdfRDR(arena); break;
+	case SDR_TYPE:  record = new (arena) StdfSDR(arena); break;
+	case WIR_TYPE:  record = new (arena) StdfWIR(arena); break;
+	case WRR_TYPE:  record = new (arena) StdfWRR(arena); break;
+	case WCR_TYPE:  record = new (arena) StdfWCR(arena); break;
+	case PIR_TYPE:  record = new (arena) StdfPIR(arena); break;
+	case PRR_TYPE:  record = new (arena) StdfPRR(arena); break;
+	case TSR_TYPE:  record = new (arena) StdfTSR(arena); break;
+	case PTR_TYPE:  record = new (arena) StdfPTR(arena); break;
+	case MPR_TYPE:  record = new (arena) StdfMPR(arena); break;
+	case FTR_TYPE:  record = new (arena) StdfFTR(arena); break;
+	case BPS_TYPE:  record = new (arena) StdfBPS(arena); break;
+	case EPS_TYPE:  record = new (arena) StdfEPS(arena); break;
+	case GDR_TYPE:  record = new (arena) StdfGDR(arena); break;
+	case DTR_TYPE:  record = new (arena) StdfDTR(arena); break;
 	default : record = nullptr; break;
     }
 	return record;
 }
 
+//=================================================================
+struct StdfArena::Block
+{
+    Block* next;
+};
+
+StdfArena::StdfArena(size_t block_size)
+{
+    m_blocks = nullptr;
+    m_current = nullptr;
+    m_remain = 0;
+    m_block_size = block_size;
+    m_used = 0;
+}
+
+StdfArena::~StdfArena()
+{
+    release();
+}
+
+void* StdfArena::allocate(size_t size, size_t align)
+{
+    if(align == 0) align = 1;
+    size_t pad = (align - (std::uintptr_t)m_current % align) % align;
+    if(m_current == nullptr || pad + size > m_remain)
+    {
+        size_t header_size = sizeof(std::max_align_t);
+        size_t block_size = m_block_size;
+        if(size + align + header_size > block_size) block_size = size + align + header_size;
+
+        Block* block = (Block*)::operator new(block_size);
+        block->next = m_blocks;
+        m_blocks = block;
+        m_current = (char*)block + header_size;
+        m_remain = block_size - header_size;
+        pad = (align - (std::uintptr_t)m_current % align) % align;
+    }
+    char* memory = m_current + pad;
+    m_current = memory + size;
+    m_remain -= pad + size;
+    m_used += size;
+    return memory;
+}
+
+void StdfArena::release()
+{
+    while(m_blocks)
+    {
+        Block* next = m_blocks->next;
+        ::operator delete(m_blocks);
+        m_blocks = next;
+    }
+    m_current = nullptr;
+    m_remain = 0;
+    m_used = 0;
+}
+
+size_t StdfArena::used() const
+{
+    return m_used;
+}
+
+//=================================================================
+StdfRecordCursor::StdfRecordCursor()
+{
+    m_data = nullptr;
+    m_size = 0;
+    m_offset = 0;
+    m_record_offset = 0;
+    m_handle = nullptr;
+    m_is_open = false;
+    m_swapped = false;
+}
+
+StdfRecordCursor::~StdfRecordCursor()
+{
+    close();
+}
+
+bool StdfRecordCursor::open(const char* filename)
+{
+    close();
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if(file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER file_size;
+    if(!GetFileSizeEx(file, &file_size))
+    {
+        CloseHandle(file);
+        return false;
+    }
+    m_size = (unsigned long long)file_size.QuadPart;
+    if(m_size > 0)
+    {
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if(mapping) m_data = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if(!m_data)
+        {
+            if(mapping) CloseHandle(mapping);
+            CloseHandle(file);
+            m_size = 0;
+            return false;
+        }
+        m_handle = mapping;
+    }
+    CloseHandle(file);
+#else
+    int fd = ::open(filename, O_RDONLY);
+    if(fd < 0) return false;
+    struct stat st;
+    if(fstat(fd, &st) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+    m_size = (unsigned long long)st.st_size;
+    if(m_size > 0)
+    {
+        void* addr = mmap(nullptr, (size_t)m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(addr == MAP_FAILED)
+        {
+            ::close(fd);
+            m_size = 0;
+            return false;
+        }
+        madvise(addr, (size_t)m_size, MADV_SEQUENTIAL);
+        m_data = (const char*)addr;
+    }
+    ::close(fd);
+#endif
+    m_offset = 0;
+    m_record_offset = 0;
+    m_is_open = true;
+    // FAR: REC_LEN 2, REC_TYP 0, REC_SUB 10, CPU_TYPE
+    m_swapped = (m_size >= 5 && m_data[2] == 0 && m_data[3] == 10 &&
+                 (m_data[4] == 1 || m_data[4] == 2) && m_data[4] != STDF_HOST_CPU_TYPE);
+    return true;
+}
+
+void StdfRecordCursor::close()
+{
+#ifdef _WIN32
+    if(m_data) UnmapViewOfFile(m_data);
+    if(m_handle) CloseHandle((HANDLE)m_handle);
+#else
+    if(m_data) munmap((void*)m_data, (size_t)m_size);
+#endif
+    m_data = nullptr;
+    m_size = 0;
+    m_offset = 0;
+    m_record_offset = 0;
+    m_handle = nullptr;
+    m_is_open = false;
+    m_swapped = false;
+}
+
+bool StdfRecordCursor::is_open() const
+{
+    return m_is_open;
+}
+
+bool StdfRecordCursor::next(StdfHeader& header)
+{
+    if(!map(m_offset, header)) return false;
+    m_record_offset = m_offset;
+    m_offset += 4U + header.get_length();
+    return true;
+}
+
+bool StdfRecordCursor::map(unsigned long long offset, StdfHeader& header) const
+{
+    if(m_data == nullptr || offset + 4 > m_size) return false;
+    const char* record = m_data + offset;
+    unsigned short length = record_length(record, m_swapped);
+    if(offset + 4 + length > m_size) return false;
+
+    header.header->MapRecord(record, 4U + length, m_swapped);
+    return true;
+}
+
+bool StdfRecordCursor::seek(unsigned long long offset)
+{
+    if(offset > m_size) return false;
+    m_offset = offset;
+    return true;
+}
+
+unsigned long long StdfRecordCursor::record_offset() const
+{
+    return m_record_offset;
+}
+
+unsigned long long StdfRecordCursor::tell() const
+{
+    return m_offset;
+}
+
+unsigned long long StdfRecordCursor::size() const
+{
+    return m_size;
+}
+
+const char* StdfRecordCursor::data() const
+{
+    return m_data;
+}
+
+bool StdfRecordCursor::is_swapped() const
+{
+    return m_swapped;
+}
+
 //=================================================================
 
 //====================================================================
-StdfRecord::StdfRecord(const char* name, STDF_TYPE type)
+// Every record is preceded by the arena it comes from (nullptr = heap),
+// so operator delete knows whether the memory has to be freed.
+static const size_t RECORD_PREFIX_SIZE = 2 * sizeof(void*);
+
+void* StdfRecord::operator new(size_t size)
+{
+    return StdfRecord::operator new(size, (StdfArena*)nullptr);
+}
+
+void* StdfRecord::operator new(size_t size, StdfArena* arena)
+{
+    char* memory = nullptr;
+    if(arena) memory = (char*)arena->allocate(size + RECORD_PREFIX_SIZE, RECORD_PREFIX_SIZE);
+    else memory = (char*)::operator new(size + RECORD_PREFIX_SIZE);
+    *((StdfArena**)memory) = arena;
+    return memory + RECORD_PREFIX_SIZE;
+}
+
+void StdfRecord::operator delete(void* ptr)
+{
+    if(ptr == nullptr) return;
+    char* memory = (char*)ptr - RECORD_PREFIX_SIZE;
+    if(*((StdfArena**)memory) == nullptr) ::operator delete(memory);
+}
+
+void StdfRecord::operator delete(void* ptr, StdfArena* )
+{
+    StdfRecord::operator delete(ptr);
+}
+
+StdfRecord::StdfRecord(const char* name, STDF_TYPE type, StdfArena* arena)
 {
 	std::strncpy(m_name, name, 3);
 	m_name[3] = '\0';
 	m_type = type;
+	m_arena = arena;
 }
 
 const char* StdfRecord::name()
@@ -155,9 +448,9 @@ std::ostream& operator << (std::ostream& os, const StdfRecord& record)
 	return os;
 }
 //=====================================================================
-StdfFAR::StdfFAR() : StdfRecord("FAR", FAR_TYPE)
+StdfFAR::StdfFAR(StdfArena* arena) : StdfRecord("FAR", FAR_TYPE, arena)
 {
-    impl = new FileAttributes();
+    impl = create_impl<FileAttributes>(m_arena);
 #ifdef _DEBUG_API_H_
     if(impl == nullptr)
     {
@@ -169,7 +462,7 @@ StdfFAR::StdfFAR() : StdfRecord("FAR", FAR_TYPE)
 
 StdfFAR::~StdfFAR()
 {
-    delete impl;
+    destroy_impl(impl, m_arena);
     impl = nullptr;
 }
 
@@ -221,9 +514,9 @@ void StdfFAR::print(std::ostream& os) const
 }
 
 //////////////////////////////////////////////////////////////////////////
-StdfATR::StdfATR()  : StdfRecord("ATR", ATR_TYPE)
+StdfATR::StdfATR(StdfArena* arena)  : StdfRecord("ATR", ATR_TYPE, arena)
 {
-    impl = new AuditTrail();
+    impl = create_impl<AuditTrail>(m_arena);
 #ifdef _DEBUG_API_H_
     if(impl == nullptr)
     {
@@ -237,7 +530,7 @@ StdfATR::StdfATR()  : StdfRecord("ATR", ATR_TYPE)
 
 StdfATR::~StdfATR()
 {
-    delete impl;
+    destroy_impl(impl, m_arena);
     impl = nullptr;
 }
 
@@ -278,9 +571,9 @@ void StdfATR::print(std::ostream& os) const
 }
 
 //////////////////////////////////////////////////////////////////////////
-StdfMIR::StdfMIR() : StdfRecord("MIR", MIR_TYPE)
+StdfMIR::StdfMIR(StdfArena* arena) : StdfRecord("MIR", MIR_TYPE, arena)
 {
-    impl = new MasterInformation();
+    impl = create_impl<MasterInformation>(m_arena);
 #ifdef _DEBUG_API_H_
     if(impl == nullptr)
     {
@@ -292,7 +585,7 @@ StdfMIR::StdfMIR() : StdfRecord("MIR", MIR_TYPE)
 
 StdfMIR::~StdfMIR()
 {
-    delete impl;
+    destroy_impl(impl, m_arena);
     impl = nullptr;
 }
 
@@ -712,9 +1005,9 @@ void StdfMIR::print(std::ostream& os) const
 }
 
 //////////////////////////////////////////////////////////////////////////
-StdfMRR::StdfMRR() : StdfRecord("MRR", MRR_TYPE)
+StdfMRR::StdfMRR(StdfArena* arena) : StdfRecord("MRR", MRR_TYPE, arena)
 {
-    impl = new MasterResults();
+    impl = create_impl<MasterResults>(m_arena);
 #ifdef _DEBUG_API_H_
     if(impl == nullptr)
     {
@@ -726,7 +1019,7 @@ StdfMRR::StdfMRR() : StdfRecord("MRR", MRR_TYPE)
 
 StdfMRR::~StdfMRR()
 {
-    delete impl;
+    destroy_impl(impl, m_arena);
     impl = nullptr;
 }
 
@@ -789,9 +1082,9 @@ void StdfMRR::print(std::ostream& os) const
 
 //////////////////////////////////////////////////////////////////////////
 
-StdfPCR::StdfPCR() : StdfRecord("PCR", PCR_TYPE)
+StdfPCR::StdfPCR(StdfArena* arena) : StdfRecord("PCR", PCR_TYPE, arena)
 {
-    impl = new PartCount();
+    impl = create_impl<PartCount>(m_arena);
 #ifdef _DEBUG_API_H_
     if(impl == nullptr)
     {
@@ -803,7 +1096,7 @@ StdfPCR::StdfPCR() : StdfRecord("PCR", PCR_TYPE)
 
 StdfPCR::~StdfPCR()
 {
-    delete impl;
+    destroy_impl(impl, m_arena);
     impl = nullptr;
 }
 
@@ -892,9 +1185,9 @@ void StdfPCR::print(std::ostream& os) const
 }
 
 //////////////////////////////////////////////////////////////////////////
-StdfHBR::StdfHBR() : StdfRecord("HBR", HBR_TYPE)
+StdfHBR::StdfHBR(StdfArena* arena) : StdfRecord("HBR", HBR_TYPE, arena)
 {
-    impl = new HardwareBin();
+    impl = create_impl<HardwareBin>(m_arena);
 #ifdef _DEBUG_API_H_
     if(impl == nullptr)
     {
@@ -906,7 +1199,7 @@ StdfHBR::StdfHBR() : StdfRecord("HBR", HBR_TYPE)
 
 StdfHBR::~StdfHBR()
 {
-    delete impl;
+    destroy_impl(impl, m_arena);
     impl = nullptr;
 }
 
@@ -985,9 +1278,9 @@ void StdfHBR::print(std::ostream& os) const
 }
 
 //////////////////////////////////////////////////////////////////////////
-StdfSBR::StdfSBR() : StdfRecord("SBR", SBR_TYPE)
+StdfSBR::StdfSBR(StdfArena* arena) : StdfRecord("SBR", SBR_TYPE, arena)
 {
-    impl = new SoftwareBin();
+    impl = create_impl<SoftwareBin>(m_arena);
 #ifdef _DEBUG_API_H_
     if(impl == nullptr)
     {
@@ -999,7 +1292,7 @@ StdfSBR::StdfSBR() : StdfRecord("SBR", SBR_TYPE)
 
 StdfSBR::~StdfSBR()
 {
-    delete impl;
+    destroy_impl(impl, m_arena);
     impl = nullptr;
 }
 
@@ -1079,9 +1372,9 @@ void StdfSBR::print(std::ostream& os) const
 }
 
 //////////////////////////////////////////////////////////////////////////
-StdfPMR::StdfPMR() : StdfRecord("PMR", PMR_TYPE)
+StdfPMR::StdfPMR(StdfArena* arena) : StdfRecord("PMR", PMR_TYPE, arena)
 {
-    impl = new PinMap();
+    impl = create_impl<PinMap>(m_arena);
 #ifdef _DEBUG_API_H_
     if(impl == nullptr)
     {
@@ -1093,7 +1386,7 @@ StdfPMR::StdfPMR() : StdfRecord("PMR", PMR_TYPE)
 
 StdfPMR::~StdfPMR()
 {
-    delete impl;
+    destroy_impl(impl, m_arena);
     impl = nullptr;
 }
 
@@ -1186,9 +1479,9 @@ void StdfPMR::print(std::ostream& os) const
 }
 
 //////////////////////////////////////////////////////////////////////////
-StdfPGR::StdfPGR() : StdfRecord("PGR", PGR_TYPE)
+StdfPGR::StdfPGR(StdfArena* arena) : StdfRecord("PGR", PGR_TYPE, arena)
 {
-    impl = new PinGroup();
+    impl = create_impl<PinGroup>(m_arena);
 #ifdef _DEBUG_API_H_
     if(impl == nullptr)
     {
@@ -1200,7 +1493,7 @@ StdfPGR::StdfPGR() : StdfRecord("PGR", PGR_TYPE)
 
 StdfPGR::~StdfPGR()
 {
-    delete impl;
+    destroy_impl(impl, m_arena);
     impl = nullptr;
 }
 
@@ -1279,9 +1572,9 @@ void StdfPGR::print(std::ostream& os) const
 }
 
 //////////////////////////////////////////////////////////////////////////
-StdfPLR::StdfPLR() : StdfRecord("PLR", PLR_TYPE)
+StdfPLR::StdfPLR(StdfArena* arena) : StdfRecord("PLR", PLR_TYPE, arena)
 {
-    impl = new PinList();
+    impl = create_impl<PinList>(m_arena);
 #ifdef _DEBUG_API_H_
     if(impl == nullptr)
     {
@@ -1293,7 +1586,7 @@ StdfPLR::StdfPLR() : StdfRecord("PLR", PLR_TYPE)
 
 StdfPLR::~StdfPLR()
 {
-    delete impl;
+    destroy_impl(impl, m_arena);
     impl = nullptr;
 }
 
@@ -1517,9 +1810,9 @@ void StdfPLR::print(std::ostream& os) const
 }
 
 //////////////////////////////////////////////////////////////////////////
-StdfRDR::StdfRDR() : StdfRecord("RDR", RDR_TYPE)
+StdfRDR::StdfRDR(StdfArena* arena) : StdfRecord("RDR", RDR_TYPE, arena)
 {
-    impl = new RetestData();
+    impl = create_impl<RetestData>(m_arena);
 #ifdef _DEBUG_API_H_
     if(impl == nullptr) {
         SHOW_MEMORY_ERROR();
@@ -1530,7 +1823,7 @@ StdfRDR::StdfRDR() : StdfRecord("RDR", RDR_TYPE)
 
 StdfRDR::~StdfRDR()
 {
-    delete impl;
+    destroy_impl(impl, m_arena);
     impl = nullptr;
 }
 
@@ -1587,9 +1880,9 @@ void StdfRDR::print(std::ostream& os) const
 }
 
 //////////////////////////////////////////////////////////////////////////
-StdfSDR::StdfSDR() : StdfRecord("SDR", SDR_TYPE)
+StdfSDR::StdfSDR(StdfArena* arena) : StdfRecord("SDR", SDR_TYPE, arena)
 {
-    impl = new SiteDescription();
+    impl = create_impl<SiteDescription>(m_arena);
 #ifdef _DEBUG_API_H_
     if(impl == nullptr)
     {
@@ -1601,7 +1894,7 @@ StdfSDR::StdfSDR() : StdfRecord("SDR", SDR_TYPE)
 
 StdfSDR::~StdfSDR()
 {
-    delete impl;
+    destroy_impl(impl, m_arena);
     impl = nullptr;
 }
 
@@ -1854,9 +2147,9 @@ void StdfSDR::print(std::ostream& os) const
 }
 
 //////////////////////////////////////////////////////////////////////////
-StdfWIR::StdfWIR() : StdfRecord("WIR", WIR_TYPE)
+StdfWIR::StdfWIR(StdfArena* arena) : StdfRecord("WIR", WIR_TYPE, arena)
 {
-    impl = new WaferInformation();
+    impl = create_impl<WaferInformation>(m_arena);
 #ifdef _DEBUG_API_H_
     if(impl == nullptr)
     {
@@ -1868,7 +2161,7 @@ StdfWIR::StdfWIR() : StdfRecord("WIR", WIR_TYPE)
 
 StdfWIR::~StdfWIR()
 {
-    delete impl;
+    destroy_impl(impl, m_arena);
     impl = nullptr;
 }
 
@@ -1929,9 +2222,9 @@ void StdfWIR::print(std::ostream& os) const
 }
 
 //////////////////////////////////////////////////////////////////////////
-StdfWRR::StdfWRR() : StdfRecord("WRR", WRR_TYPE)
+StdfWRR::StdfWRR(StdfArena* arena) : StdfRecord("WRR", WRR_TYPE, arena)
 {
-    impl = new WaferResults();
+    impl = create_impl<WaferResults>(m_arena);
 #ifdef _DEBUG_API_H_
     if(impl == nullptr)
     {
@@ -1943,7 +2236,7 @@ StdfWRR::StdfWRR() : StdfRecord("WRR", WRR_TYPE)
 
 StdfWRR::~StdfWRR()
 {
-    delete impl;
+    destroy_impl(impl, m_arena);
     impl = nullptr;
 }
 
@@ -2109,9 +2402,9 @@ void StdfWRR::print(std::ostream& os) const
 }
 
 //////////////////////////////////////////////////////////////////////////
-StdfWCR::StdfWCR() : StdfRecord("WCR", WCR_TYPE)
+StdfWCR::StdfWCR(StdfArena* arena) : StdfRecord("WCR", WCR_TYPE, arena)
 {
-    impl = new WaferConfiguration();
+    impl = create_impl<WaferConfiguration>(m_arena);
 #ifdef _DEBUG_API_H_
     if(impl == nullptr)
     {
@@ -2123,7 +2416,7 @@ StdfWCR::StdfWCR() : StdfRecord("WCR", WCR_TYPE)
 
 StdfWCR::~StdfWCR()
 {
-    delete impl;
+    destroy_impl(impl, m_arena);
     impl = nullptr;
 }
 
@@ -2233,9 +2526,9 @@ void StdfWCR::print(std::ostream& os) const
 }
 
 //////////////////////////////////////////////////////////////////////////
-StdfPIR::StdfPIR() : StdfRecord("PIR", PIR_TYPE)
+StdfPIR::StdfPIR(StdfArena* arena) : StdfRecord("PIR", PIR_TYPE, arena)
 {
-	impl = new PartInformation();
+	impl = create_impl<PartInformation>(m_arena);
 #ifdef _DEBUG_API_H_
 	if(impl == nullptr)
 	{
@@ -2247,7 +2540,7 @@ StdfPIR::StdfPIR() : StdfRecord("PIR", PIR_TYPE)
 
 StdfPIR::~StdfPIR()
 {
-	delete impl;
+	destroy_impl(impl, m_arena);
 	impl = nullptr;
 }
 
@@ -2287,9 +2580,9 @@ void StdfPIR::print(std::ostream& os) const
 }
 
 //////////////////////////////////////////////////////////////////////////
-StdfPRR::StdfPRR() : StdfRecord("PRR", PRR_TYPE)
+StdfPRR::StdfPRR(StdfArena* arena) : StdfRecord("PRR", PRR_TYPE, arena)
 {
-    impl = new PartResults();
+    impl = create_impl<PartResults>(m_arena);
 #ifdef _DEBUG_API_H_
     if(impl == nullptr)
     {
@@ -2301,7 +2594,7 @@ StdfPRR::StdfPRR() : StdfRecord("PRR", PRR_TYPE)
 
 StdfPRR::~StdfPRR()
 {
-    delete impl;
+    destroy_impl(impl, m_arena);
     impl = nullptr;
 }
 
@@ -2468,9 +2761,9 @@ void StdfPRR::print(std::ostream& os) const
 }
 
 //////////////////////////////////////////////////////////////////////////
-StdfTSR::StdfTSR() : StdfRecord("TSR", TSR_TYPE)
+StdfTSR::StdfTSR(StdfArena* arena) : StdfRecord("TSR", TSR_TYPE, arena)
 {
-    impl = new TestSynopsis();
+    impl = create_impl<TestSynopsis>(m_arena);
 #ifdef _DEBUG_API_H_
     if(impl == nullptr)
     {
@@ -2482,7 +2775,7 @@ StdfTSR::StdfTSR() : StdfRecord("TSR", TSR_TYPE)
 
 StdfTSR::~StdfTSR()
 {
-    delete impl;
+    destroy_impl(impl, m_arena);
     impl = nullptr;
 }
 
@@ -2715,9 +3008,9 @@ void StdfTSR::print(std::ostream& os) const
 }
 
 //////////////////////////////////////////////////////////////////////////
-StdfPTR::StdfPTR() : StdfRecord("PTR", PTR_TYPE)
+StdfPTR::StdfPTR(StdfArena* arena) : StdfRecord("PTR", PTR_TYPE, arena)
 {
-    impl = new ParametricTest();
+    impl = create_impl<ParametricTest>(m_arena);
 #ifdef _DEBUG_API_H_
     if(impl == nullptr)
     {
@@ -2729,7 +3022,7 @@ StdfPTR::StdfPTR() : StdfRecord("PTR", PTR_TYPE)
 
 StdfPTR::~StdfPTR()
 {
-    delete impl;
+    destroy_impl(impl, m_arena);
     impl = nullptr;
 }
 
@@ -3200,9 +3493,120 @@ void StdfPTR::print(std::ostream& os) const
 }
 
 //////////////////////////////////////////////////////////////////////////
-StdfMPR::StdfMPR() : StdfRecord("MPR", MPR_TYPE)
+// the default data fields of the first PTR of a test
+struct StdfPtrDefaults::Table
 {
-    impl = new MultipleResultParametric();
+    struct Defaults
+    {
+        B1 OPT_FLAG;
+        I1 RES_SCAL;
+        I1 LLM_SCAL;
+        I1 HLM_SCAL;
+        R4 LO_LIMIT;
+        R4 HI_LIMIT;
+        SharedCn UNITS;
+        SharedCn C_RESFMT;
+        SharedCn C_LLMFMT;
+        SharedCn C_HLMFMT;
+        R4 LO_SPEC;
+        R4 HI_SPEC;
+    };
+    std::unordered_map<U4, Defaults> tests;
+};
+
+StdfPtrDefaults::StdfPtrDefaults()
+{
+    m_table = new Table();
+}
+
+StdfPtrDefaults::~StdfPtrDefaults()
+{
+    delete m_table;
+    m_table = nullptr;
+}
+
+bool StdfPtrDefaults::apply(StdfPTR& ptr)
+{
+    ParametricTest& record = *(ptr.impl);
+    std::pair<std::unordered_map<U4, Table::Defaults>::iterator, bool> entry =
+            m_table->tests.insert(std::make_pair(record.TEST_NUM, Table::Defaults()));
+    Table::Defaults& first = entry.first->second;
+    if(entry.second)
+    {
+        first.OPT_FLAG = record.OPT_FLAG;
+        first.RES_SCAL = record.RES_SCAL;
+        first.LLM_SCAL = record.LLM_SCAL;
+        first.HLM_SCAL = record.HLM_SCAL;
+        first.LO_LIMIT = record.LO_LIMIT;
+        first.HI_LIMIT = record.HI_LIMIT;
+        first.UNITS    = record.UNITS;
+        first.C_RESFMT = record.C_RESFMT;
+        first.C_LLMFMT = record.C_LLMFMT;
+        first.C_HLMFMT = record.C_HLMFMT;
+        first.LO_SPEC  = record.LO_SPEC;
+        first.HI_SPEC  = record.HI_SPEC;
+        return true;
+    }
+
+    B1& flag = record.OPT_FLAG;
+    if(flag[0] && !first.OPT_FLAG[0])
+    {
+        record.RES_SCAL = first.RES_SCAL;
+        flag[0] = false;
+    }
+    // bit 4/5: use the default limit, which may be that the test has none (bit 6/7)
+    if(flag[4] && !flag[6])
+    {
+        if(first.OPT_FLAG[6]) flag[6] = true;
+        else if(!first.OPT_FLAG[4])
+        {
+            record.LLM_SCAL = first.LLM_SCAL;
+            record.LO_LIMIT = first.LO_LIMIT;
+            flag[4] = false;
+        }
+    }
+    if(flag[5] && !flag[7])
+    {
+        if(first.OPT_FLAG[7]) flag[7] = true;
+        else if(!first.OPT_FLAG[5])
+        {
+            record.HLM_SCAL = first.HLM_SCAL;
+            record.HI_LIMIT = first.HI_LIMIT;
+            flag[5] = false;
+        }
+    }
+    // the spec limits are set in the first PTR and never change
+    if(flag[2] && !first.OPT_FLAG[2])
+    {
+        record.LO_SPEC = first.LO_SPEC;
+        flag[2] = false;
+    }
+    if(flag[3] && !first.OPT_FLAG[3])
+    {
+        record.HI_SPEC = first.HI_SPEC;
+        flag[3] = false;
+    }
+    if(record.UNITS.empty())    record.UNITS    = first.UNITS;
+    if(record.C_RESFMT.empty()) record.C_RESFMT = first.C_RESFMT;
+    if(record.C_LLMFMT.empty()) record.C_LLMFMT = first.C_LLMFMT;
+    if(record.C_HLMFMT.empty()) record.C_HLMFMT = first.C_HLMFMT;
+    return false;
+}
+
+void StdfPtrDefaults::clear()
+{
+    m_table->tests.clear();
+}
+
+size_t StdfPtrDefaults::size() const
+{
+    return m_table->tests.size();
+}
+
+//////////////////////////////////////////////////////////////////////////
+StdfMPR::StdfMPR(StdfArena* arena) : StdfRecord("MPR", MPR_TYPE, arena)
+{
+    impl = create_impl<MultipleResultParametric>(m_arena);
 #ifdef _DEBUG_API_H_
     if(impl == nullptr)
     {
@@ -3214,7 +3618,7 @@ StdfMPR::StdfMPR() : StdfRecord("MPR", MPR_TYPE)
 
 StdfMPR::~StdfMPR()
 {
-    delete impl;
+    destroy_impl(impl, m_arena);
     impl = nullptr;
 }
 
@@ -3807,9 +4211,9 @@ void StdfMPR::print(std::ostream& os) const
 }
 
 //////////////////////////////////////////////////////////////////////////
-StdfFTR::StdfFTR() : StdfRecord("FTR", FTR_TYPE)
+StdfFTR::StdfFTR(StdfArena* arena) : StdfRecord("FTR", FTR_TYPE, arena)
 {
-    impl = new FunctionalTest();
+    impl = create_impl<FunctionalTest>(m_arena);
 #ifdef _DEBUG_API_H_
     if(impl == nullptr)
     {
@@ -3821,7 +4225,7 @@ StdfFTR::StdfFTR() : StdfRecord("FTR", FTR_TYPE)
 
 StdfFTR::~StdfFTR()
 {
-    delete impl;
+    destroy_impl(impl, m_arena);
     impl = nullptr;
 }
 
@@ -3955,14 +4359,9 @@ unsigned short StdfFTR::get_failpin_data_count() const
 
 unsigned char StdfFTR::get_failpin_data(unsigned short index) const
 {
-#if _MSC_VER == 1600
-    char temp = impl->FAIL_PIN.data[index];
-    return U1(temp);
-#else
-    bool temp = impl->FAIL_PIN.data[index];
+    bool temp = impl->FAIL_PIN.GetBit(index);
     if(temp) return U1(1);
     else return U1(0);
-#endif
 }
 
 const char* StdfFTR::get_vector_pattern_name() const
@@ -4019,14 +4418,9 @@ unsigned short StdfFTR::get_bitmap_data_count() const
 
 unsigned char StdfFTR::get_bitmap_data(unsigned short index) const
 {
-#if _MSC_VER == 1600
-    char temp = impl->SPIN_MAP.data[index];
-    return U1(temp);
-#else
-    bool temp = impl->SPIN_MAP.data[index];
+    bool temp = impl->SPIN_MAP.GetBit(index);
     if(temp) return U1(1);
     else return U1(0);
-#endif
 }
 
 void StdfFTR::set_test_number(unsigned int number)
@@ -4159,12 +4553,7 @@ void StdfFTR::set_failpin_data(unsigned short index, unsigned char bit_data)
 {
     unsigned short count = impl->FAIL_PIN.count;
     if(index > count) impl->FAIL_PIN.count = index;
-#if _MSC_VER == 1600
-    impl->FAIL_PIN.data[index] = C1(bit_data & 0x01);
-#else
-    if(bit_data & 0x01) impl->FAIL_PIN.data[index] = true;
-    else impl->FAIL_PIN.data[index] = false;
-#endif
+    impl->FAIL_PIN.SetBit(index, (bit_data & 0x01) != 0);
 }
 
 void StdfFTR::set_vector_pattern_name(const char* name)
@@ -4211,12 +4600,7 @@ void StdfFTR::set_bitmap_data(unsigned short index, unsigned char bit_data)
 {
     unsigned short count = impl->SPIN_MAP.count;
     if(index > count) impl->SPIN_MAP.count = index;
-#if _MSC_VER == 1600
-    impl->SPIN_MAP.data[index] = C1(bit_data & 0x01);
-#else
-    if(bit_data & 0x01) impl->SPIN_MAP.data[index] = true;
-    else impl->SPIN_MAP.data[index] = false;
-#endif
+    impl->SPIN_MAP.SetBit(index, (bit_data & 0x01) != 0);
 }
 
 // TEST_FLG
@@ -4377,9 +4761,9 @@ void StdfFTR::print(std::ostream& os) const
 }
 
 //////////////////////////////////////////////////////////////////////////
-StdfBPS::StdfBPS() : StdfRecord("BPS", BPS_TYPE)
+StdfBPS::StdfBPS(StdfArena* arena) : StdfRecord("BPS", BPS_TYPE, arena)
 {
-    impl = new BeginProgramSection();
+    impl = create_impl<BeginProgramSection>(m_arena);
 #ifdef _DEBUG_API_H_
     if(impl == nullptr)
     {
@@ -4391,7 +4775,7 @@ StdfBPS::StdfBPS() : StdfRecord("BPS", BPS_TYPE)
 
 StdfBPS::~StdfBPS()
 {
-    delete impl;
+    destroy_impl(impl, m_arena);
     impl = nullptr;
 }
 
@@ -4421,9 +4805,9 @@ void StdfBPS::print(std::ostream& os) const
 	impl->Print(os);
 }
 
-StdfEPS::StdfEPS() : StdfRecord("EPS", EPS_TYPE)
+StdfEPS::StdfEPS(StdfArena* arena) : StdfRecord("EPS", EPS_TYPE, arena)
 {
-    impl = new EndProgramSection();
+    impl = create_impl<EndProgramSection>(m_arena);
 #ifdef _DEBUG_API_H_
     if(impl == nullptr)
     {
@@ -4434,7 +4818,7 @@ StdfEPS::StdfEPS() : StdfRecord("EPS", EPS_TYPE)
 }
 StdfEPS::~StdfEPS()
 {
-    delete impl;
+    destroy_impl(impl, m_arena);
     impl = nullptr;
 }
 
@@ -4454,9 +4838,9 @@ void StdfEPS::print(std::ostream& os) const
 }
 
 //////////////////////////////////////////////////////////////////////////
-StdfGDR::StdfGDR() : StdfRecord("GDR", GDR_TYPE)
+StdfGDR::StdfGDR(StdfArena* arena) : StdfRecord("GDR", GDR_TYPE, arena)
 {
-    impl = new GenericData();
+    impl = create_impl<GenericData>(m_arena);
 #ifdef _DEBUG_API_H_
     if(impl == nullptr)
     {
@@ -4468,7 +4852,7 @@ StdfGDR::StdfGDR() : StdfRecord("GDR", GDR_TYPE)
 
 StdfGDR::~StdfGDR()
 {
-    delete impl;
+    destroy_impl(impl, m_arena);
     impl = nullptr;
 }
 
@@ -4600,7 +4984,7 @@ const unsigned char* StdfGDR::get_data_value(unsigned int index, int* byte_lengt
 		{ /*Bn*/
 			Bn* temp = (Bn*)(impl->GEN_DATA[index].data);
 			for(U1 i = 0; i < temp->count; i++)
-				data[i] = U1(temp->data[i].to_ulong());
+				data[i] = temp->data[i];
 			if(bit_count) *bit_count = 8 * length;
 		}
 		break;
@@ -4608,20 +4992,10 @@ const unsigned char* StdfGDR::get_data_value(unsigned int index, int* byte_lengt
 		{ /*Dn*/
 			Dn* temp = (Dn*)(impl->GEN_DATA[index].data);
 			U2 count = temp->count;
-			unsigned int byte_count = (count - 1)/ 8 + 1;
-
-			U1 last_bit = 0x01;
+			unsigned int byte_count = temp->ByteCount();
 			for(unsigned int i = 0; i < byte_count; i++)
 			{
-				U1 byte_temp = 0x0;
-				for(U1 n = 0; n < 8; n++)
-				{
-					if(temp->data[i*8+n])
-					{
-						byte_temp |= (last_bit<<n);
-					}
-				}
-				data[i] = byte_temp;
+				data[i] = (i < temp->data.size()) ? temp->data[i] : U1(0);
 			}
 			length = byte_count;
 			if(bit_count) *bit_count = count;
@@ -4760,8 +5134,7 @@ bool StdfGDR::set_data_value(const unsigned char* data, unsigned int index, int
         { /*Bn*/
             Bn* void_data = new Bn;
 			void_data->count = byte_length;
-			for(int i = 0; i < byte_length; i++)
-				void_data->data[i] = B1(data[i]);
+			void_data->data.assign(data, data + byte_length);
             impl->GEN_DATA[index].data = void_data;
         }
         break;
@@ -4769,19 +5142,7 @@ bool StdfGDR::set_data_value(const unsigned char* data, unsigned int index, int
         { /*Dn*/
             Dn* void_data = new Dn;
 			void_data->count = U2(byte_length * 8);
-			U1 last_bit = 0x01;
-			for(U2 i = 0; i < byte_length; i++)
-			{
-				U1 c = data[i];
-				for(U1 n = 0; n < 8; n++)
-				{
-#if _MSC_VER == 1600
-					void_data->data[i*8+n] = (c>>n) & last_bit;
-#else
-					void_data->data[i*8+n] = bool((c>>n) & last_bit);
-#endif
-				}
-			}
+			void_data->data.assign(data, data + byte_length);
             impl->GEN_DATA[index].data = void_data;
         }
         break;
@@ -4806,9 +5167,9 @@ void StdfGDR::print(std::ostream& os) const
 }
 
 //////////////////////////////////////////////////////////////////////////
-StdfDTR::StdfDTR() : StdfRecord("DTR", DTR_TYPE)
+StdfDTR::StdfDTR(StdfArena* arena) : StdfRecord("DTR", DTR_TYPE, arena)
 {
-    impl = new DatalogText();
+    impl = create_impl<DatalogText>(m_arena);
 #ifdef _DEBUG_API_H_
     if(impl == nullptr)
     {
@@ -4820,7 +5181,7 @@ StdfDTR::StdfDTR() : StdfRecord("DTR", DTR_TYPE)
 
 StdfDTR::~StdfDTR()
 {
-    delete impl;
+    destroy_impl(impl, m_arena);
     impl = nullptr;
 }
 
@@ -7,6 +7,7 @@
 #include <iostream>
 #include <fstream>
 #include <ctime>
+#include <cstddef>
 
 enum STDF_TYPE : int
 {
@@ -38,6 +39,35 @@ enum STDF_TYPE : int
     UNKNOWN_TYPE = 25, // Other Types
 };
 
+// Monotonic memory pool for records. Memory is taken from large blocks and
+// only given back all at once by release() or the destructor, so loading a
+// file does one malloc per block instead of two per record.
+// Only the record objects and their Impl live here. Variable length fields
+// (kx arrays, Bn/Dn, Cn not interned) keep their std::vector/std::string heap
+// memory, and deleting an arena record still runs its destructor: that frees
+// those fields and drops the references of interned Cn texts (SharedCn), so
+// the destructors can not be skipped.
+class StdfArena
+{
+public:
+    explicit StdfArena(size_t block_size = 1U << 20);
+    ~StdfArena();
+
+    void* allocate(size_t size, size_t align = sizeof(void*));
+    void release();
+    size_t used() const;
+
+private:
+    struct Block;
+    Block* m_blocks;
+    char* m_current;
+    size_t m_remain;
+    size_t m_block_size;
+    size_t m_used;
+    StdfArena(const StdfArena& );
+    StdfArena& operator=(const StdfArena& src);
+};
+
 class StdfRecord;
 class StdfHeader
 {
@@ -66,14 +96,26 @@ class StdfHeader
     friend class StdfEPS ;
     friend class StdfGDR ;
     friend class StdfDTR ;
+    friend class StdfRecordCursor;
 public:
     StdfHeader();
     ~StdfHeader();
 
     STDF_TYPE read(std::ifstream& file_stream);
     int write(std::ofstream& file_stream);
-
-	StdfRecord* create_record(STDF_TYPE type);
+    // Copies the record as it goes to the file (4 byte header + data) to out,
+    // which needs 4 + get_length() bytes. Returns the bytes copied.
+    // A mapped record is copied as it is in the mapping, only REC_LEN is in host
+    // byte order for a swapped one: unparse those to write them.
+    unsigned int serialize(char* out) const;
+    // Points the header at a record in memory (4 byte header + data) as
+    // StdfRecordCursor does in a mapping, the memory has to stay until parse().
+    // false if the record is not complete in available_length bytes.
+    // swapped: the record is not in host byte order, see StdfRecordCursor.
+    bool map(const char* record, unsigned int available_length, bool swapped = false);
+
+	// arena: allocate the record and its data from this pool, nullptr for the heap
+	StdfRecord* create_record(STDF_TYPE type, StdfArena* arena = nullptr);
     // getter
     STDF_TYPE get_type() const;
     unsigned short get_length() const;
@@ -88,12 +130,73 @@ private:
 	void * operator new(size_t size);
 };
 
+// FAR CPU_TYPE of files in host byte order: 1 = big endian (Sun), 2 = little endian
+#if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define STDF_HOST_CPU_TYPE 1
+#else
+#define STDF_HOST_CPU_TYPE 2
+#endif
+
+// Walks the records of a memory-mapped STDF file in place.
+// next() points a StdfHeader at the record inside the mapping, so the following
+// parse() decodes straight from the file pages without copying the record data.
+// Records can be skipped by just calling next() again, only REC_LEN is read.
+// The header stays valid until the next call of next()/seek()/close().
+// open() takes the byte order from the CPU_TYPE of the FAR: files of the other
+// order than the host (CPU_TYPE 1 vs 2) are decoded with swapped numbers.
+class StdfRecordCursor
+{
+public:
+    StdfRecordCursor();
+    ~StdfRecordCursor();
+
+    bool open(const char* filename);
+    void close();
+    bool is_open() const;
+
+    // false at end of file, or when the last record is cut off
+    bool next(StdfHeader& header);
+    // offset must be the start of a record
+    bool seek(unsigned long long offset);
+    // Points header at the record starting at offset without moving the cursor.
+    // Only reads the mapping, several threads may call it with their own headers.
+    bool map(unsigned long long offset, StdfHeader& header) const;
+
+    // offset of the record returned by the last next()
+    unsigned long long record_offset() const;
+    // offset of the record the next next() will return
+    unsigned long long tell() const;
+    unsigned long long size() const;
+    const char* data() const;
+    // the file is not in host byte order
+    bool is_swapped() const;
+
+private:
+    const char* m_data;
+    unsigned long long m_size;
+    unsigned long long m_offset;
+    unsigned long long m_record_offset;
+    void* m_handle;
+    bool m_is_open;
+    bool m_swapped;
+    StdfRecordCursor(const StdfRecordCursor& );
+    StdfRecordCursor& operator=(const StdfRecordCursor& src);
+};
+
 class StdfRecord
 {
 protected:
 	char m_name[4];
 	STDF_TYPE m_type;
+	StdfArena* m_arena;
 public:
+	// Records may live on the heap or in a StdfArena, "delete record" works for both:
+	// arena records are destroyed and their memory comes back with the arena.
+	static void* operator new(size_t size);
+	static void* operator new(size_t size, StdfArena* arena);
+	static void operator delete(void* ptr);
+	static void operator delete(void* ptr, StdfArena* arena);
+
 	virtual unsigned int parse(const StdfHeader& record) = 0;
 	virtual unsigned int unparse(StdfHeader& record) = 0;
 	virtual void print(std::ostream& os) const = 0;
@@ -101,7 +204,7 @@ public:
 
 	const char* name() ;
 	STDF_TYPE type();
-	StdfRecord(const char* name, STDF_TYPE type);
+	StdfRecord(const char* name, STDF_TYPE type, StdfArena* arena = nullptr);
 	virtual ~StdfRecord();
 private:
 	StdfRecord(const StdfRecord& );
@@ -111,7 +214,7 @@ private:
 class StdfFAR : public StdfRecord
 {
 public:
-    StdfFAR();
+    StdfFAR(StdfArena* arena = nullptr);
     ~StdfFAR();
 
     unsigned char get_cpu_type() const;
@@ -134,7 +237,7 @@ private:
 class StdfATR : public StdfRecord
 {
 public:
-    StdfATR();
+    StdfATR(StdfArena* arena = nullptr);
     ~StdfATR();
 
     const char* get_command_line() const;
@@ -167,7 +270,7 @@ enum ModeCode : char
 class StdfMIR : public StdfRecord
 {
 public:
-    StdfMIR();
+    StdfMIR(StdfArena* arena = nullptr);
     ~StdfMIR();
 
     //getter
@@ -262,7 +365,7 @@ private:
 class StdfMRR : public StdfRecord
 {
 public:
-    StdfMRR();
+    StdfMRR(StdfArena* arena = nullptr);
     ~StdfMRR();
 
     time_t get_finish_time()  const;
@@ -288,7 +391,7 @@ private:
 class StdfPCR : public StdfRecord
 {
 public:
-    StdfPCR();
+    StdfPCR(StdfArena* arena = nullptr);
     ~StdfPCR();
 
     unsigned char get_head_number() const;
@@ -320,7 +423,7 @@ private:
 class StdfHBR : public StdfRecord
 {
 public:
-    StdfHBR();
+    StdfHBR(StdfArena* arena = nullptr);
     ~StdfHBR();
 
     unsigned char get_head_number() const;
@@ -350,7 +453,7 @@ private:
 class StdfSBR : public StdfRecord
 {
 public:
-    StdfSBR();
+    StdfSBR(StdfArena* arena = nullptr);
     ~StdfSBR();
 
     unsigned char get_head_number() const;
@@ -380,7 +483,7 @@ private:
 class StdfPMR : public StdfRecord
 {
 public:
-    StdfPMR();
+    StdfPMR(StdfArena* arena = nullptr);
     ~StdfPMR();
 
     unsigned short get_pin_index() const;
@@ -412,7 +515,7 @@ private:
 class StdfPGR : public StdfRecord
 {
 public:
-    StdfPGR();
+    StdfPGR(StdfArena* arena = nullptr);
     ~StdfPGR();
 
     unsigned short get_group_index() const;
@@ -460,7 +563,7 @@ enum GroupRadix : unsigned char
 class StdfPLR : public StdfRecord
 {
 public:
-    StdfPLR();
+    StdfPLR(StdfArena* arena = nullptr);
     ~StdfPLR();
 
     unsigned short get_group_count() const;
@@ -494,7 +597,7 @@ private:
 class StdfRDR : public StdfRecord
 {
 public:
-    StdfRDR();
+    StdfRDR(StdfArena* arena = nullptr);
     ~StdfRDR();
     unsigned short get_bin_count() const;
     unsigned short get_bin_number(unsigned short index) const;
@@ -515,7 +618,7 @@ private:
 class StdfSDR : public StdfRecord
 {
 public:
-    StdfSDR();
+    StdfSDR(StdfArena* arena = nullptr);
     ~StdfSDR();
 
     unsigned char get_head_number() const;
@@ -573,7 +676,7 @@ private:
 class StdfWIR : public StdfRecord
 {
 public:
-    StdfWIR();
+    StdfWIR(StdfArena* arena = nullptr);
     ~StdfWIR();
 
     unsigned char get_head_number() const;
@@ -599,7 +702,7 @@ private:
 class StdfWRR : public StdfRecord
 {
 public:
-    StdfWRR();
+    StdfWRR(StdfArena* arena = nullptr);
     ~StdfWRR();
 
     unsigned char get_head_number() const;
@@ -669,7 +772,7 @@ enum PosDirection : char
 class StdfWCR : public StdfRecord
 {
 public:
-    StdfWCR();
+    StdfWCR(StdfArena* arena = nullptr);
     ~StdfWCR();
 
     float get_wafer_size() const;
@@ -705,7 +808,7 @@ private:
 class StdfPIR : public StdfRecord
 {
 public:
-    StdfPIR();
+    StdfPIR(StdfArena* arena = nullptr);
     ~StdfPIR();
 
     unsigned char get_head_number() const;
@@ -727,7 +830,7 @@ private:
 class StdfPRR : public StdfRecord
 {
 public:
-    StdfPRR();
+    StdfPRR(StdfArena* arena = nullptr);
     ~StdfPRR();
 
     unsigned char get_head_number() const;
@@ -782,7 +885,7 @@ enum TestType : char
 class StdfTSR : public StdfRecord
 {
 public:
-    StdfTSR();
+    StdfTSR(StdfArena* arena = nullptr);
     ~StdfTSR();
 
     unsigned char get_head_number() const;
@@ -843,7 +946,7 @@ private:
 class StdfPTR : public StdfRecord
 {
 public:
-    StdfPTR();
+    StdfPTR(StdfArena* arena = nullptr);
     ~StdfPTR();
 
     unsigned int get_test_number() const;
@@ -944,15 +1047,41 @@ public:
 	void print(std::ostream& os) const;
 
 private:
+    friend class StdfPtrDefaults;
     typedef class ParametricTest Impl;
     Impl *impl;
 };
 
+// The default data of the PTRs: the first PTR of a test number has RES_SCAL, the
+// limits, UNITS, the format strings and the spec limits, later PTRs of the test
+// leave out what did not change (OPT_FLAG bits 0, 4 and 5, empty strings).
+// apply() keeps the first PTR of every test and fills the left out fields of the
+// later ones from it, so their getters return the values that are in effect.
+// One object per file, clear() before the next one.
+class StdfPtrDefaults
+{
+public:
+    StdfPtrDefaults();
+    ~StdfPtrDefaults();
+
+    // true if ptr was the first PTR of its test number
+    bool apply(StdfPTR& ptr);
+    void clear();
+    // test numbers seen
+    size_t size() const;
+
+private:
+    struct Table;
+    Table* m_table;
+    StdfPtrDefaults(const StdfPtrDefaults& );
+    StdfPtrDefaults& operator=(const StdfPtrDefaults& src);
+};
+
 
 class StdfMPR : public StdfRecord
 {
 public:
-    StdfMPR();
+    StdfMPR(StdfArena* arena = nullptr);
     ~StdfMPR();
 
     unsigned int get_test_number() const;
@@ -1127,7 +1256,7 @@ enum SCIOModeStates : unsigned char
 class StdfFTR : public StdfRecord
 {
 public:
-    StdfFTR();
+    StdfFTR(StdfArena* arena = nullptr);
     ~StdfFTR();
 
     unsigned int get_test_number() const;
@@ -1235,7 +1364,7 @@ private:
 class StdfBPS : public StdfRecord
 {
 public:
-    StdfBPS();
+    StdfBPS(StdfArena* arena = nullptr);
     ~StdfBPS();
 
     const char* get_section_name() const;
@@ -1254,7 +1383,7 @@ private:
 class StdfEPS : public StdfRecord
 {
 public:
-    StdfEPS();
+    StdfEPS(StdfArena* arena = nullptr);
     ~StdfEPS();
 
     unsigned int parse(const StdfHeader& record);
@@ -1286,7 +1415,7 @@ enum VnType : unsigned char
 class StdfGDR : public StdfRecord
 {
 public:
-    StdfGDR();
+    StdfGDR(StdfArena* arena = nullptr);
     ~StdfGDR();
 
     unsigned short get_data_count() const;
@@ -1311,7 +1440,7 @@ private:
 class StdfDTR : public StdfRecord
 {
 public:
-    StdfDTR();
+    StdfDTR(StdfArena* arena = nullptr);
     ~StdfDTR();
     const char* get_text_data() const;
     void set_text_data(const char*data);
@@ -4,6 +4,9 @@
 #include <ctime>
 #include <iomanip>
 #include <cstring>
+#include <cstdint>
+#include <mutex>
+#include <unordered_set>
 
 // Note: call the template functions using explicit template arguments for error proof
 //=======================For Number Convert====================
@@ -14,20 +17,74 @@ union NumType
     char bytes[sizeof(T)];
 };
 
+//=======================Byte Order============================
+// Numbers are copied as they are for files in host byte order (CPU_TYPE=2 on
+// x86/ARM) and reversed for the other order (CPU_TYPE=1, Sun).
+// The shifts compile to a single bswap instruction.
+template <unsigned int N> struct ByteOrder;
+template <> struct ByteOrder<1>
+{
+    typedef uint8_t Bits;
+    static Bits swap(Bits value) { return value; }
+};
+template <> struct ByteOrder<2>
+{
+    typedef uint16_t Bits;
+    static Bits swap(Bits value) { return Bits((value >> 8) | (value << 8)); }
+};
+template <> struct ByteOrder<4>
+{
+    typedef uint32_t Bits;
+    static Bits swap(Bits value)
+    {
+        return ((value >> 24) & 0x000000FFU) | ((value >> 8) & 0x0000FF00U) |
+               ((value << 8) & 0x00FF0000U) | ((value << 24) & 0xFF000000U);
+    }
+};
+template <> struct ByteOrder<8>
+{
+    typedef uint64_t Bits;
+    static Bits swap(Bits value)
+    {
+        return (Bits(ByteOrder<4>::swap(uint32_t(value))) << 32) | ByteOrder<4>::swap(uint32_t(value >> 32));
+    }
+};
+
+// unaligned load of one number of the record
+template <typename T>
+inline T load_number(const char* data, bool swapped)
+{
+    typedef typename ByteOrder<sizeof(T)>::Bits Bits;
+    Bits bits;
+    std::memcpy(&bits, data, sizeof(T));
+    if(swapped) bits = ByteOrder<sizeof(T)>::swap(bits);
+    T value;
+    std::memcpy(&value, &bits, sizeof(T));
+    return value;
+}
+
 //=======================Read Number===========================
 // for C1,U1,U2,U4,I1,I2,I4,R4,R8
 // Tested
 template <typename T>
-unsigned int read_type(T& value, const char* rawdata, unsigned int& start_pos)
+unsigned int read_type(T& value, const RecordView& rawdata, unsigned int& start_pos)
 {
-    unsigned int size = sizeof(T);
-    NumType<T> temp;
-    for(unsigned int i = 0; i < size; i++)
+    const unsigned int size = sizeof(T);
+    if(start_pos + size <= rawdata.length)
+    {
+        value = load_number<T>(rawdata.data + start_pos, rawdata.swapped);
+    }
+    else
     {
-        temp.bytes[i] = rawdata[start_pos+i];
+        // cut by the end of the record, the missing bytes read as 0
+        char bytes[size];
+        for(unsigned int i = 0; i < size; i++)
+        {
+            bytes[i] = rawdata[start_pos+i];
+        }
+        value = load_number<T>(bytes, rawdata.swapped);
     }
     start_pos += size;
-    value = temp.number;
     return size;
 }
 
@@ -35,7 +92,7 @@ unsigned int read_type(T& value, const char* rawdata, unsigned int& start_pos)
 // for B1
 // Tested
 template <>
-unsigned int read_type<B1>(B1& value, const char* rawdata, unsigned int& start_pos)
+unsigned int read_type<B1>(B1& value, const RecordView& rawdata, unsigned int& start_pos)
 {
     C1 c = rawdata[start_pos];
     start_pos +=1;
@@ -47,19 +104,16 @@ unsigned int read_type<B1>(B1& value, const char* rawdata, unsigned int& start_p
 // for Bn
 // Testing
 template <>
-unsigned int read_type<Bn>(Bn& value, const char* rawdata, unsigned int& start_pos)
+unsigned int read_type<Bn>(Bn& value, const RecordView& rawdata, unsigned int& start_pos)
 {
     U1 n = 0;
     read_type<U1>(n, rawdata, start_pos);
     value.count = n;
-    value.data.fill(B1(0));
+    value.data.assign(n, U1(0));
     if(n == 0) return n;
 
-    for(U1 i = 0; i < n; i++)
-    {
-        char c = rawdata[start_pos+i];
-        value.data[i] = B1(c);
-    }
+    unsigned int copy_count = rawdata.available(start_pos, n);
+    if(copy_count) std::memcpy(&(value.data[0]), rawdata.data + start_pos, copy_count);
     start_pos += n;
     return n;
 }
@@ -68,15 +122,214 @@ unsigned int read_type<Bn>(Bn& value, const char* rawdata, unsigned int& start_p
 // for Cn
 // Tested
 template <>
-unsigned int read_type<Cn>(Cn& value, const char* rawdata, unsigned int& start_pos)
+unsigned int read_type<Cn>(Cn& value, const RecordView& rawdata, unsigned int& start_pos)
 {
     value.clear();
     U1 n;
     read_type<U1>(n, rawdata, start_pos);
     if(n == 0) return n;
 
-    const char* str = &(rawdata[start_pos]);
-    value.assign(str, n);
+    const char* str = rawdata.data + start_pos;
+    value.assign(str, rawdata.available(start_pos, n));
+    start_pos += n;
+    return n;
+}
+
+//=====================String Pool=============================
+// Interned SharedCn texts, found through a set of (pointer, length) keys into the
+// entries, so a lookup hashes the record bytes in place without building a
+// std::string. Every entry counts the SharedCn holding it. An entry without any
+// stays for a while, a text coming back soon (the next part of a file) is found
+// again, and those entries are swept out once they are many, so the pool holds
+// about the strings of the records alive and not the strings of every file read.
+// Every thread first looks into its own small direct mapped cache of recent
+// strings and only takes the lock on a miss; a cache slot holds a reference, so
+// its entry stays alive while it is cached.
+namespace
+{
+struct CnKey
+{
+    const char*  data;
+    unsigned int length;
+    uint32_t     hash;
+    CnEntry*     entry;     // null in lookup keys
+};
+
+struct CnKeyHash
+{
+    size_t operator()(const CnKey& key) const { return key.hash; }
+};
+
+struct CnKeyEqual
+{
+    bool operator()(const CnKey& a, const CnKey& b) const
+    {
+        return a.length == b.length && std::memcmp(a.data, b.data, a.length) == 0;
+    }
+};
+
+// FNV-1a
+uint32_t cn_hash(const char* data, unsigned int length)
+{
+    uint32_t hash = 2166136261U;
+    for(unsigned int i = 0; i < length; i++)
+    {
+        hash = (hash ^ (unsigned char)data[i]) * 16777619U;
+    }
+    return hash;
+}
+
+class CnPool
+{
+public:
+    // the entry of the text with one reference for the caller
+    CnEntry* intern(const char* data, unsigned int length, uint32_t hash)
+    {
+        CnKey key = {data, length, hash, nullptr};
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::unordered_set<CnKey, CnKeyHash, CnKeyEqual>::const_iterator it = m_keys.find(key);
+        if(it != m_keys.end())
+        {
+            if(it->entry->refs.fetch_add(1, std::memory_order_relaxed) == 0) m_unused.fetch_sub(1, std::memory_order_relaxed);
+            return it->entry;
+        }
+        CnEntry* entry = new CnEntry();
+        entry->text.assign(data, length);
+        entry->hash = hash;
+        entry->refs.store(1, std::memory_order_relaxed);
+        key.data = entry->text.data();
+        key.entry = entry;
+        m_keys.insert(key);
+        return entry;
+    }
+
+    // Outside of the lock the count is only raised by a holder, from 1 or more,
+    // and comes back from 0 only in intern(). So an entry at 0 is not known to
+    // anyone but the pool, and the sweep under the lock can delete it.
+    void release(CnEntry* entry)
+    {
+        if(entry->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+        // entry may be swept from here on
+        if(m_unused.fetch_add(1, std::memory_order_relaxed) + 1 < CN_UNUSED_MIN) return;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        long long unused = m_unused.load(std::memory_order_relaxed);
+        if(unused >= CN_UNUSED_MIN && unused > (long long)(m_keys.size() / 2)) sweep();
+    }
+
+    // never destroyed, records of static objects may still point into it at exit
+    static CnPool& instance()
+    {
+        static CnPool* pool = new CnPool();
+        return *pool;
+    }
+
+private:
+    CnPool() : m_unused(0) {}
+
+    // under the lock, deletes the entries nobody holds
+    void sweep()
+    {
+        for(std::unordered_set<CnKey, CnKeyHash, CnKeyEqual>::iterator it = m_keys.begin(); it != m_keys.end();)
+        {
+            if(it->entry->refs.load(std::memory_order_acquire) != 0)
+            {
+                ++it;
+                continue;
+            }
+            CnEntry* entry = it->entry;
+            it = m_keys.erase(it);
+            delete entry;
+        }
+        m_unused.store(0, std::memory_order_relaxed);
+    }
+
+    // unused entries kept at least, before they are swept out
+    static const long long CN_UNUSED_MIN = 65536;
+
+    std::mutex m_mutex;
+    std::unordered_set<CnKey, CnKeyHash, CnKeyEqual> m_keys;
+    // entries at 0, a hint only: a release racing with intern() or the sweep
+    // counts one off for a moment
+    std::atomic<long long> m_unused;
+};
+
+const unsigned int CN_CACHE_SIZE = 1024;
+
+thread_local CnEntry* cn_cache[CN_CACHE_SIZE];
+
+// gives the references of the cache back when the thread ends; kept apart from the
+// plain cache array, whose lookups then need no thread_local initialization check
+struct CnCacheRelease
+{
+    bool used;
+    ~CnCacheRelease()
+    {
+        for(unsigned int i = 0; i < CN_CACHE_SIZE; i++)
+        {
+            if(cn_cache[i]) CnPool::instance().release(cn_cache[i]);
+            cn_cache[i] = nullptr;
+        }
+    }
+};
+thread_local CnCacheRelease cn_cache_release;
+
+// the entry of the text with one reference for the caller
+CnEntry* cn_intern(const char* data, unsigned int length)
+{
+    uint32_t hash = cn_hash(data, length);
+    CnEntry*& cached = cn_cache[hash & (CN_CACHE_SIZE - 1)];
+    if(!cached || cached->text.size() != length || std::memcmp(cached->text.data(), data, length) != 0)
+    {
+        CnEntry* entry = CnPool::instance().intern(data, length, hash);
+        if(cached) CnPool::instance().release(cached);
+        else cn_cache_release.used = true;
+        cached = entry;
+    }
+    cached->refs.fetch_add(1, std::memory_order_relaxed);
+    return cached;
+}
+}
+
+SharedCn& SharedCn::operator=(const SharedCn& src)
+{
+    if(entry == src.entry) return *this;
+    if(src.entry) src.entry->refs.fetch_add(1, std::memory_order_relaxed);
+    clear();
+    entry = src.entry;
+    return *this;
+}
+
+void SharedCn::release(CnEntry* entry)
+{
+    CnPool::instance().release(entry);
+}
+
+void SharedCn::assign(const char* str)
+{
+    assign(str, str ? (unsigned int)std::strlen(str) : 0);
+}
+
+void SharedCn::assign(const char* str, unsigned int count)
+{
+    // the same text again, as for every record of one test, changes nothing
+    if(entry && entry->text.size() == count && std::memcmp(entry->text.data(), str, count) == 0) return;
+    CnEntry* old = entry;
+    entry = (count == 0) ? nullptr : cn_intern(str, count);
+    if(old) release(old);
+}
+
+std::ostream& operator<<(std::ostream& os, const SharedCn& value)
+{
+    return os.write(value.c_str(), value.length());
+}
+
+// for SharedCn, same bytes as Cn
+template <>
+unsigned int read_type<SharedCn>(SharedCn& value, const RecordView& rawdata, unsigned int& start_pos)
+{
+    U1 n;
+    read_type<U1>(n, rawdata, start_pos);
+    value.assign(rawdata.data + start_pos, rawdata.available(start_pos, n));
     start_pos += n;
     return n;
 }
@@ -85,7 +338,7 @@ unsigned int read_type<Cn>(Cn& value, const char* rawdata, unsigned int& start_p
 // for N1
 // Untest
 template <>
-unsigned int read_type<N1>(N1& value, const char* rawdata, unsigned int& start_pos)
+unsigned int read_type<N1>(N1& value, const RecordView& rawdata, unsigned int& start_pos)
 {
     C1 c = rawdata[start_pos];
     start_pos +=1;
@@ -97,72 +350,91 @@ unsigned int read_type<N1>(N1& value, const char* rawdata, unsigned int& start_p
 // for Dn
 //Untest
 template <>
-unsigned int read_type<Dn>(Dn& value, const char* rawdata, unsigned int& start_pos)
+unsigned int read_type<Dn>(Dn& value, const RecordView& rawdata, unsigned int& start_pos)
 {
     U2 bit_count = 0;
     read_type<U2>(bit_count, rawdata, start_pos);
-#if _MSC_VER == 1600
-    value.data.fill(C1(0));
-#else
-    value.data.reset();
-#endif
     value.count = bit_count;
+    unsigned int byte_count = value.ByteCount();
+    value.data.assign(byte_count, U1(0));
     if(bit_count == 0) return 0;
 
-    unsigned int byte_count = (bit_count - 1)/ 8 + 1;
+    // bits are stored packed, copy the bytes as they are
+    unsigned int copy_count = rawdata.available(start_pos, byte_count);
+    if(copy_count) std::memcpy(&(value.data[0]), rawdata.data + start_pos, copy_count);
+    start_pos += byte_count;
+    return byte_count;
+}
 
-    char last_bit = 0x01;
-    for(U2 i = 0; i < byte_count; i++)
+//=====================Read kxType=============================
+// for kxU1,kxU2,kxU4,kxI1,kxI2,kxI4,kxR4,kxR8,kxCn
+// Testing
+// Numbers: one copy of the whole array when it lies inside the record,
+// then an in place swap for the other byte order.
+template <typename T>
+unsigned int read_array(T& value, const RecordView& rawdata, unsigned int& start_pos, const unsigned int count, std::true_type)
+{
+    typedef typename T::value_type Tn;
+    const unsigned int byte_count = count * sizeof(Tn);
+    value.resize(count);
+    if(start_pos + byte_count <= rawdata.length)
     {
-        char c = rawdata[start_pos+i];
-        for(U1 n = 0; n < 8; n++)
+        std::memcpy(&value[0], rawdata.data + start_pos, byte_count);
+        if(rawdata.swapped && sizeof(Tn) > 1)
         {
-#if _MSC_VER == 1600
-            value.data[i*8+n] = (c>>n) & last_bit;
-#else
-            value.data[i*8+n] = bool((c>>n) & last_bit);
-#endif
+            for(unsigned int i = 0; i < count; i++)
+            {
+                value[i] = load_number<Tn>((const char*)&value[i], true);
+            }
         }
+        start_pos += byte_count;
+        return byte_count;
+    }
+    for(unsigned int i = 0; i < count; i++)
+    {
+        read_type<Tn>(value[i], rawdata, start_pos);
     }
-    start_pos += byte_count;
     return byte_count;
 }
 
-//=====================Read kxType=============================
-// for kxU1,kxU2,kxU4,kxI1,kxI2,kxI4,kxR4,kxR8,kxCn
-// Testing
 template <typename T>
-unsigned int read_type(T& value, const char* rawdata, unsigned int& start_pos, const unsigned int count)
+unsigned int read_array(T& value, const RecordView& rawdata, unsigned int& start_pos, const unsigned int count, std::false_type)
 {
     typedef typename T::value_type Tn;
     unsigned int byte_count = 0;
-    value.clear();
-    if(count == 0) return 0;
-    Tn temp;
+    value.resize(count);
     for(unsigned int i = 0; i < count; i++)
     {
-        byte_count += read_type<Tn>(temp, rawdata, start_pos);
-        value.push_back(temp);
+        byte_count += read_type<Tn>(value[i], rawdata, start_pos);
     }
     return byte_count;
 }
 
+template <typename T>
+unsigned int read_type(T& value, const RecordView& rawdata, unsigned int& start_pos, const unsigned int count)
+{
+    typedef typename T::value_type Tn;
+    value.clear();
+    if(count == 0) return 0;
+    return read_array(value, rawdata, start_pos, count, std::integral_constant<bool, std::is_arithmetic<Tn>::value>());
+}
+
 //=====================Read kxType=============================
 // for kxN1
 // Untested
+// Two nibbles per byte, low nibble first
 template <>
-unsigned int read_type<kxN1>(kxN1& value, const char* rawdata, unsigned int& start_pos,const unsigned int count)
+unsigned int read_type<kxN1>(kxN1& value, const RecordView& rawdata, unsigned int& start_pos,const unsigned int count)
 {
+    value.clear();
     if(count == 0) return 0;
     unsigned int byte_count = (count - 1) / 2 + 1;
+    value.resize(2 * byte_count);
     for(unsigned int i = 0; i < byte_count; i++)
     {
-        char c = rawdata[start_pos+i];
-        N1 n1 = N1(c);
-        value.push_back(n1);
-
-        N1 n2 = N1(c>>NIBBLE_LENGTH);
-        value.push_back(n2);
+        unsigned char c = (unsigned char)rawdata[start_pos+i];
+        value[2*i] = N1(c & 0x0F);
+        value[2*i + 1] = N1(c >> NIBBLE_LENGTH);
     }
     start_pos += byte_count;
     return byte_count;
@@ -173,7 +445,7 @@ unsigned int read_type<kxN1>(kxN1& value, const char* rawdata, unsigned int& sta
 // Untested
 // Note: this function use "new", need "delete"
 template <>
-unsigned int read_type<V1>(V1& value, const char* rawdata, unsigned int& start_pos)
+unsigned int read_type<V1>(V1& value, const RecordView& rawdata, unsigned int& start_pos)
 {
     U1 type = 0;
     unsigned int byte_count = 0;
@@ -202,7 +474,7 @@ unsigned int read_type<V1>(V1& value, const char* rawdata, unsigned int& start_p
 }
 
 template <>
-unsigned int read_type<Vn>(Vn& value, const char* rawdata, unsigned int& start_pos, unsigned int count)
+unsigned int read_type<Vn>(Vn& value, const RecordView& rawdata, unsigned int& start_pos, unsigned int count)
 {
     if(count == 0) return 0;
     unsigned int byte_count = 0;
@@ -251,6 +523,19 @@ U2 write_type<Cn>(Cn& value, char *const rawdata, unsigned int& start_pos, bool
     return U2(value_length+1);
 }
 
+// for SharedCn
+template <>
+U2 write_type<SharedCn>(SharedCn& value, char *const rawdata, unsigned int& start_pos, bool *alignment )
+{
+    unsigned int value_length = value.length();
+    rawdata[start_pos] = C1(value_length);
+    start_pos += 1;
+    if(value_length) std::memcpy(rawdata + start_pos, value.c_str(), value_length);
+    start_pos += value_length;
+    if(alignment) *alignment = false;
+    return U2(value_length+1);
+}
+
 //=====================Write Flag==============================
 // for B1
 // Tested
@@ -291,12 +576,9 @@ U2 write_type<Bn>(Bn& value, char *const rawdata, unsigned int& start_pos, bool
     start_pos ++;
     write_length ++;
 
-    for(U1 i = 0; i < data_count; i++)
-    {
-        B1 temp = value.data[i];
-        char b1 = char(temp.to_ulong());
-        rawdata[start_pos+i] = b1;
-    }
+    unsigned int copy_count = (value.data.size() < data_count) ? value.data.size() : data_count;
+    if(copy_count) std::memcpy(rawdata + start_pos, &(value.data[0]), copy_count);
+    if(copy_count < data_count) std::memset(rawdata + start_pos + copy_count, 0, data_count - copy_count);
     start_pos += data_count;
     write_length += data_count;
     if(alignment) *alignment = false;
@@ -314,7 +596,7 @@ U2 write_type<Dn>(Dn& value, char *const rawdata, unsigned int& start_pos, bool
     write_length += write_type<U2>(bits_count, rawdata, start_pos);
     if(bits_count == 0) return write_length;
 
-    unsigned int bytes_count = (bits_count - 1) / 8 + 1;
+    unsigned int bytes_count = value.ByteCount();
     if(alignment)
     {
         unsigned int check_bytes = bits_count / 8;
@@ -322,19 +604,9 @@ U2 write_type<Dn>(Dn& value, char *const rawdata, unsigned int& start_pos, bool
         else *alignment = false;
     }
 
-    char last_bit = 0x01;
-    for(unsigned int i = 0; i < bytes_count; i++)
-    {
-        char temp = 0x0;
-        for(U1 n = 0; n < 8; n++)
-        {
-            if(value.data[i*8+n])
-            {
-                temp |= (last_bit<<n);
-            }
-        }
-        rawdata[start_pos+i] = temp;
-    }
+    unsigned int copy_count = (value.data.size() < bytes_count) ? value.data.size() : bytes_count;
+    if(copy_count) std::memcpy(rawdata + start_pos, &(value.data[0]), copy_count);
+    if(copy_count < bytes_count) std::memset(rawdata + start_pos + copy_count, 0, bytes_count - copy_count);
     start_pos += bytes_count;
     write_length += bytes_count;
     return write_length;
@@ -543,12 +815,30 @@ U2 write_type<Vn>(Vn& value, char *const rawdata, unsigned int& start_pos, const
     return write_length;
 }
 
+//=====================Print Time==============================
+// Text of ctime() with its '\n', but reentrant: records are printed on
+// several threads at once. Just the '\n' for a time ctime() can not show.
+static std::string time_text(U4 value)
+{
+    time_t t = (time_t)value;
+    char text[32];
+#ifdef _WIN32
+    if(ctime_s(text, sizeof(text), &t) != 0) return "\n";
+#else
+    if(ctime_r(&t, text) == nullptr) return "\n";
+#endif
+    return std::string(text);
+}
+
 //======================RecordHeader===========================
 RecordHeader::RecordHeader()
 {
     REC_LEN = 0;
     REC_TYP = 0;
     REC_SUB = 0;
+    view = rawdata;
+    view_length = 0;
+    view_swapped = false;
     std::memset(rawdata,0, MAX_REC_LENGTH);
 }
 
@@ -557,22 +847,28 @@ int RecordHeader::GetRecordType() const
     return ((int)REC_TYP)<<8 | REC_SUB;
 }
 
-const char* RecordHeader::GetReadOnlyData() const
+RecordView RecordHeader::GetReadOnlyData() const
 {
-    return rawdata;
+    return RecordView(view, view_length, view_swapped);
 }
 
+// No need to clear rawdata either: Unparse writes every byte of [0, REC_LEN),
+// GDR clears the bytes it counts without writing them itself.
 char * RecordHeader::GetWriteOnlyData()
 {
-    std::memset(rawdata,0, MAX_REC_LENGTH);
+    view = rawdata;
+    view_length = 0;
+    view_swapped = false;
     return rawdata;
 }
 
 int RecordHeader::WriteRecord(std::ofstream& out)
 {
-    out.write((char*)&REC_LEN, 2);
-    out.write((char*)&REC_TYP, 1);
-    out.write((char*)&REC_SUB, 1);
+    char head[4];
+    std::memcpy(head, &REC_LEN, 2);
+    head[2] = char(REC_TYP);
+    head[3] = char(REC_SUB);
+    out.write(head, 4);
     if(REC_LEN > 0)
     {
         out.write(rawdata, REC_LEN);
@@ -580,13 +876,48 @@ int RecordHeader::WriteRecord(std::ofstream& out)
     return 0;
 }
 
+// The data of a mapped record comes from the mapping, in the byte order of its file.
+unsigned int RecordHeader::Serialize(char* out) const
+{
+    std::memcpy(out, &REC_LEN, 2);
+    out[2] = char(REC_TYP);
+    out[3] = char(REC_SUB);
+    if(REC_LEN == 0) return 4U;
+    if(view == rawdata) std::memcpy(out + 4, rawdata, REC_LEN);
+    else
+    {
+        // a record cut off at the end of the file is filled up with 0
+        std::memcpy(out + 4, view, view_length);
+        if(view_length < REC_LEN) std::memset(out + 4 + view_length, 0, REC_LEN - view_length);
+    }
+    return 4U + REC_LEN;
+}
+
+// No need to clear rawdata here: the RecordView only exposes the bytes really read.
 int RecordHeader::ReadRecord(std::ifstream& in)
 {
-    std::memset(rawdata,0, MAX_REC_LENGTH);
     in.read((char*)&REC_LEN, 2);
     in.read((char*)&REC_TYP, 1);
     in.read((char*)&REC_SUB, 1);
     in.read(rawdata, REC_LEN);
+    view = rawdata;
+    view_length = (unsigned int)in.gcount();
+    view_swapped = false;
+
+    int type = ((int)REC_TYP)<<8 | REC_SUB;
+    return type;
+}
+
+int RecordHeader::MapRecord(const char* record, unsigned int available_length, bool swapped)
+{
+    std::memcpy(&REC_LEN, record, 2);
+    if(swapped) REC_LEN = ByteOrder<2>::swap(REC_LEN);
+    REC_TYP = U1(record[2]);
+    REC_SUB = U1(record[3]);
+    view = record + 4;
+    view_length = (available_length < 4U) ? 0 : (available_length - 4);
+    if(view_length > REC_LEN) view_length = REC_LEN;
+    view_swapped = swapped;
 
     int type = ((int)REC_TYP)<<8 | REC_SUB;
     return type;
@@ -608,7 +939,7 @@ unsigned int FileAttributes::Parse(const RecordHeader& header)
     REC_LEN = header.REC_LEN;
     REC_TYP = header.REC_TYP;
     REC_SUB = header.REC_SUB;
-    const char* rawdata = header.GetReadOnlyData();
+    const RecordView rawdata = header.GetReadOnlyData();
 
     unsigned int pos = 0;
     read_type<U1>(CPU_TYPE, rawdata, pos);
@@ -651,7 +982,7 @@ unsigned int AuditTrail::Parse(const RecordHeader& header)
     REC_LEN = header.REC_LEN;
     REC_TYP = header.REC_TYP;
     REC_SUB = header.REC_SUB;
-    const char* rawdata = header.GetReadOnlyData();
+    const RecordView rawdata = header.GetReadOnlyData();
 
     unsigned int pos = 0;
     read_type<U4>(MOD_TIM , rawdata, pos);
@@ -675,8 +1006,7 @@ unsigned int AuditTrail::Unparse(RecordHeader& header)
 
 void AuditTrail::Print(std::ostream& os)
 {
-    time_t mod_tim = (time_t)MOD_TIM;
-    os<<"MOD_TIM  : "<<std::string(ctime(&mod_tim));
+    os<<"MOD_TIM  : "<<time_text(MOD_TIM);
     os<<"CMD_LINE : "<<CMD_LINE <<"\n";
 }
 //=============================================================
@@ -702,7 +1032,7 @@ unsigned int MasterInformation::Parse(const RecordHeader& header)
     REC_LEN = header.REC_LEN;
     REC_TYP = header.REC_TYP;
     REC_SUB = header.REC_SUB;
-    const char* rawdata = header.GetReadOnlyData();
+    const RecordView rawdata = header.GetReadOnlyData();
 
     unsigned int pos = 0;
     read_type<U4>(SETUP_T , rawdata, pos);
@@ -798,10 +1128,8 @@ unsigned int MasterInformation::Unparse(RecordHeader& header)
 
 void MasterInformation::Print(std::ostream& os)
 {
-    time_t setup_tim = (time_t)SETUP_T;
-    time_t start_tim = (time_t)START_T;
-    os<<"SETUP_T  : "<<std::string(ctime(&setup_tim));
-    os<<"START_T  : "<<std::string(ctime(&start_tim));
+    os<<"SETUP_T  : "<<time_text(SETUP_T);
+    os<<"START_T  : "<<time_text(START_T);
     os<<"STAT_NUM : "<<(unsigned int)STAT_NUM <<"\n";
     os<<"MODE_COD : "<<MODE_COD <<"\n";
     os<<"RTST_COD : "<<RTST_COD <<"\n";
@@ -857,7 +1185,7 @@ unsigned int MasterResults::Parse(const RecordHeader& header)
     REC_LEN = header.REC_LEN;
     REC_TYP = header.REC_TYP;
     REC_SUB = header.REC_SUB;
-    const char* rawdata = header.GetReadOnlyData();
+    const RecordView rawdata = header.GetReadOnlyData();
 
     unsigned int pos = 0;
     read_type<U4>(FINISH_T, rawdata, pos);
@@ -885,8 +1213,7 @@ unsigned int MasterResults::Unparse(RecordHeader& header)
 
 void MasterResults::Print(std::ostream& os)
 {
-    time_t finish_t = (time_t)FINISH_T;
-    os<<"FINISH_T : "<<std::string(ctime(&finish_t));
+    os<<"FINISH_T : "<<time_text(FINISH_T);
     os<<"DISP_COD : "<<DISP_COD <<"\n";
     os<<"USR_DESC : "<<USR_DESC <<"\n";
     os<<"EXC_DESC : "<<EXC_DESC <<"\n";
@@ -913,7 +1240,7 @@ unsigned int PartCount::Parse(const RecordHeader& header)
     REC_LEN = header.REC_LEN;
     REC_TYP = header.REC_TYP;
     REC_SUB = header.REC_SUB;
-    const char* rawdata = header.GetReadOnlyData();
+    const RecordView rawdata = header.GetReadOnlyData();
 
     unsigned int pos = 0;
     read_type<U1>(HEAD_NUM, rawdata, pos) ;
@@ -975,7 +1302,7 @@ unsigned int HardwareBin::Parse(const RecordHeader& header)
     REC_LEN = header.REC_LEN;
     REC_TYP = header.REC_TYP;
     REC_SUB = header.REC_SUB;
-    const char* rawdata = header.GetReadOnlyData();
+    const RecordView rawdata = header.GetReadOnlyData();
 
     unsigned int pos = 0;
     read_type<U1>(HEAD_NUM, rawdata, pos);
@@ -1034,7 +1361,7 @@ unsigned int SoftwareBin::Parse(const RecordHeader& header)
     REC_LEN = header.REC_LEN;
     REC_TYP = header.REC_TYP;
     REC_SUB = header.REC_SUB;
-    const char* rawdata = header.GetReadOnlyData();
+    const RecordView rawdata = header.GetReadOnlyData();
 
     unsigned int pos = 0;
     read_type<U1>(HEAD_NUM, rawdata, pos);
@@ -1092,7 +1419,7 @@ unsigned int PinMap::Parse(const RecordHeader& header)
     REC_LEN = header.REC_LEN;
     REC_TYP = header.REC_TYP;
     REC_SUB = header.REC_SUB;
-    const char* rawdata = header.GetReadOnlyData();
+    const RecordView rawdata = header.GetReadOnlyData();
 
     unsigned int pos = 0;
     read_type<U2>(PMR_INDX, rawdata, pos) ;
@@ -1151,7 +1478,7 @@ unsigned int PinGroup::Parse(const RecordHeader& header)
     REC_LEN = header.REC_LEN;
     REC_TYP = header.REC_TYP;
     REC_SUB = header.REC_SUB;
-    const char* rawdata = header.GetReadOnlyData();
+    const RecordView rawdata = header.GetReadOnlyData();
 
     unsigned int pos = 0;
     read_type<U2>(GRP_INDX, rawdata, pos) ;
@@ -1205,7 +1532,7 @@ unsigned int PinList::Parse(const RecordHeader& header)
     REC_LEN = header.REC_LEN;
     REC_TYP = header.REC_TYP;
     REC_SUB = header.REC_SUB;
-    const char* rawdata = header.GetReadOnlyData();
+    const RecordView rawdata = header.GetReadOnlyData();
 
     unsigned int pos = 0;
     read_type<U2>( GRP_CNT , rawdata, pos) ;
@@ -1273,7 +1600,7 @@ unsigned int RetestData::Parse(const RecordHeader& header)
     REC_LEN = header.REC_LEN;
     REC_TYP = header.REC_TYP;
     REC_SUB = header.REC_SUB;
-    const char* rawdata = header.GetReadOnlyData();
+    const RecordView rawdata = header.GetReadOnlyData();
 
     unsigned int pos = 0;
     read_type<U2>( NUM_BINS, rawdata, pos) ;
@@ -1323,7 +1650,7 @@ unsigned int SiteDescription::Parse(const RecordHeader& header)
     REC_LEN = header.REC_LEN;
     REC_TYP = header.REC_TYP;
     REC_SUB = header.REC_SUB;
-    const char* rawdata = header.GetReadOnlyData();
+    const RecordView rawdata = header.GetReadOnlyData();
 
     unsigned int pos = 0;
     read_type<U1>(HEAD_NUM, rawdata, pos);
@@ -1427,7 +1754,7 @@ unsigned int WaferInformation::Parse(const RecordHeader& header)
     REC_LEN = header.REC_LEN;
     REC_TYP = header.REC_TYP;
     REC_SUB = header.REC_SUB;
-    const char* rawdata = header.GetReadOnlyData();
+    const RecordView rawdata = header.GetReadOnlyData();
 
     unsigned int pos = 0;
     read_type<U1>( HEAD_NUM, rawdata, pos) ;
@@ -1457,8 +1784,7 @@ void WaferInformation::Print(std::ostream& os)
 {
     os<<"HEAD_NUM : "<<(unsigned int)HEAD_NUM<<"\n";
     os<<"SITE_GRP : "<<(unsigned int)SITE_GRP<<"\n";
-    time_t start_t = (time_t)START_T;
-    os<<"START_T  : "<<std::string(ctime(&start_t));
+    os<<"START_T  : "<<time_text(START_T);
     os<<"WAFER_ID : "<<WAFER_ID<<"\n";
 }
 //=============================================================
@@ -1484,7 +1810,7 @@ unsigned int WaferResults::Parse(const RecordHeader& header)
     REC_LEN = header.REC_LEN;
     REC_TYP = header.REC_TYP;
     REC_SUB = header.REC_SUB;
-    const char* rawdata = header.GetReadOnlyData();
+    const RecordView rawdata = header.GetReadOnlyData();
 
     unsigned int pos = 0;
     read_type<U1>( HEAD_NUM , rawdata, pos);
@@ -1571,7 +1897,7 @@ unsigned int WaferConfiguration::Parse(const RecordHeader& header)
     REC_LEN = header.REC_LEN;
     REC_TYP = header.REC_TYP;
     REC_SUB = header.REC_SUB;
-    const char* rawdata = header.GetReadOnlyData();
+    const RecordView rawdata = header.GetReadOnlyData();
 
     unsigned int pos = 0;
     read_type<R4>(WAFR_SIZ, rawdata, pos) ;
@@ -1644,7 +1970,7 @@ unsigned int PartInformation::Parse(const RecordHeader& header)
     REC_LEN = header.REC_LEN;
     REC_TYP = header.REC_TYP;
     REC_SUB = header.REC_SUB;
-    const char* rawdata = header.GetReadOnlyData();
+    const RecordView rawdata = header.GetReadOnlyData();
 
     unsigned int pos = 0;
     read_type<U1>(HEAD_NUM, rawdata, pos);
@@ -1696,7 +2022,7 @@ unsigned int PartResults::Parse(const RecordHeader& header)
     REC_LEN = header.REC_LEN;
     REC_TYP = header.REC_TYP;
     REC_SUB = header.REC_SUB;
-    const char* rawdata = header.GetReadOnlyData();
+    const RecordView rawdata = header.GetReadOnlyData();
 
     unsigned int pos = 0;
     read_type<U1>(HEAD_NUM, rawdata, pos);
@@ -1754,7 +2080,7 @@ void PartResults::Print(std::ostream& os)
     os<<"PART_FIX : ";
     for(unsigned int i = 0; i < PART_FIX.count; i++)
     {
-        os<<PART_FIX.data[i]<<" ";
+        os<<B1(PART_FIX.data[i])<<" ";
     }
 	os<<"\n";
 }
@@ -1786,7 +2112,7 @@ unsigned int TestSynopsis::Parse(const RecordHeader& header)
     REC_LEN = header.REC_LEN;
     REC_TYP = header.REC_TYP;
     REC_SUB = header.REC_SUB;
-    const char* rawdata = header.GetReadOnlyData();
+    const RecordView rawdata = header.GetReadOnlyData();
 
     unsigned int pos = 0;
     read_type<U1>(HEAD_NUM, rawdata, pos);
@@ -1796,9 +2122,9 @@ unsigned int TestSynopsis::Parse(const RecordHeader& header)
     read_type<U4>(EXEC_CNT, rawdata, pos);
     read_type<U4>(FAIL_CNT, rawdata, pos);
     read_type<U4>(ALRM_CNT, rawdata, pos);
-    read_type<Cn>(TEST_NAM, rawdata, pos);
-    read_type<Cn>(SEQ_NAME, rawdata, pos);
-    read_type<Cn>(TEST_LBL, rawdata, pos);
+    read_type<SharedCn>(TEST_NAM, rawdata, pos);
+    read_type<SharedCn>(SEQ_NAME, rawdata, pos);
+    read_type<SharedCn>(TEST_LBL, rawdata, pos);
     read_type<B1>(OPT_FLAG, rawdata, pos);
     read_type<R4>(TEST_TIM, rawdata, pos);
     read_type<R4>(TEST_MIN, rawdata, pos);
@@ -1823,9 +2149,9 @@ unsigned int TestSynopsis::Unparse(RecordHeader& header)
     length += write_type<U4>(EXEC_CNT, rawdata, pos);
     length += write_type<U4>(FAIL_CNT, rawdata, pos);
     length += write_type<U4>(ALRM_CNT, rawdata, pos);
-    length += write_type<Cn>(TEST_NAM, rawdata, pos);
-    length += write_type<Cn>(SEQ_NAME, rawdata, pos);
-    length += write_type<Cn>(TEST_LBL, rawdata, pos);
+    length += write_type<SharedCn>(TEST_NAM, rawdata, pos);
+    length += write_type<SharedCn>(SEQ_NAME, rawdata, pos);
+    length += write_type<SharedCn>(TEST_LBL, rawdata, pos);
     length += write_type<B1>(OPT_FLAG, rawdata, pos);
     length += write_type<R4>(TEST_TIM, rawdata, pos);
     length += write_type<R4>(TEST_MIN, rawdata, pos);
@@ -1877,6 +2203,7 @@ ParametricTest::ParametricTest()
      HI_LIMIT = R4(0);
      LO_SPEC  = R4(0);
      HI_SPEC  = R4(0);
+     CUT_LEN  = U2(0);
 }
 
 unsigned int ParametricTest::Parse(const RecordHeader& header)
@@ -1884,7 +2211,7 @@ unsigned int ParametricTest::Parse(const RecordHeader& header)
     REC_LEN = header.REC_LEN;
     REC_TYP = header.REC_TYP;
     REC_SUB = header.REC_SUB;
-    const char* rawdata = header.GetReadOnlyData();
+    const RecordView rawdata = header.GetReadOnlyData();
 
     unsigned int pos = 0;
     read_type<U4>(TEST_NUM, rawdata, pos);
@@ -1893,18 +2220,22 @@ unsigned int ParametricTest::Parse(const RecordHeader& header)
     read_type<B1>(TEST_FLG, rawdata, pos);
     read_type<B1>(PARM_FLG, rawdata, pos);
     read_type<R4>(RESULT  , rawdata, pos);
-    read_type<Cn>(TEST_TXT, rawdata, pos);
-    read_type<Cn>(ALARM_ID, rawdata, pos);
+    read_type<SharedCn>(TEST_TXT, rawdata, pos);
+    read_type<SharedCn>(ALARM_ID, rawdata, pos);
+    // without OPT_FLAG the record ends here: RES_SCAL and the limits are
+    // the defaults of the first PTR of the test, there are no spec limits
+    CUT_LEN = (pos >= rawdata.length) ? U2(rawdata.length) : U2(0);
     read_type<B1>(OPT_FLAG, rawdata, pos);
+    if(CUT_LEN) OPT_FLAG = B1(0x3F);
     read_type<I1>(RES_SCAL, rawdata, pos);
     read_type<I1>(LLM_SCAL, rawdata, pos);
     read_type<I1>(HLM_SCAL, rawdata, pos);
     read_type<R4>(LO_LIMIT, rawdata, pos);
     read_type<R4>(HI_LIMIT, rawdata, pos);
-    read_type<Cn>(UNITS   , rawdata, pos);
-    read_type<Cn>(C_RESFMT, rawdata, pos);
-    read_type<Cn>(C_LLMFMT, rawdata, pos);
-    read_type<Cn>(C_HLMFMT, rawdata, pos);
+    read_type<SharedCn>(UNITS   , rawdata, pos);
+    read_type<SharedCn>(C_RESFMT, rawdata, pos);
+    read_type<SharedCn>(C_LLMFMT, rawdata, pos);
+    read_type<SharedCn>(C_HLMFMT, rawdata, pos);
     read_type<R4>(LO_SPEC , rawdata, pos);
     read_type<R4>(HI_SPEC , rawdata, pos);
     return pos;
@@ -1924,24 +2255,51 @@ unsigned int ParametricTest::Unparse(RecordHeader& header)
     length += write_type<B1>(TEST_FLG, rawdata, pos);
     length += write_type<B1>(PARM_FLG, rawdata, pos);
     length += write_type<R4>(RESULT  , rawdata, pos);
-    length += write_type<Cn>(TEST_TXT, rawdata, pos);
-    length += write_type<Cn>(ALARM_ID, rawdata, pos);
+    const unsigned int text_pos = pos;
+    length += write_type<SharedCn>(TEST_TXT, rawdata, pos);
+    const unsigned int alarm_pos = pos;
+    length += write_type<SharedCn>(ALARM_ID, rawdata, pos);
+    if(OptionalDataCut())
+    {
+        pos = CutLength(text_pos, alarm_pos, pos);
+        header.REC_LEN = U2(pos);
+        return pos;
+    }
     length += write_type<B1>(OPT_FLAG, rawdata, pos);
     length += write_type<I1>(RES_SCAL, rawdata, pos);
     length += write_type<I1>(LLM_SCAL, rawdata, pos);
     length += write_type<I1>(HLM_SCAL, rawdata, pos);
     length += write_type<R4>(LO_LIMIT, rawdata, pos);
     length += write_type<R4>(HI_LIMIT, rawdata, pos);
-    length += write_type<Cn>(UNITS   , rawdata, pos);
-    length += write_type<Cn>(C_RESFMT, rawdata, pos);
-    length += write_type<Cn>(C_LLMFMT, rawdata, pos);
-    length += write_type<Cn>(C_HLMFMT, rawdata, pos);
+    length += write_type<SharedCn>(UNITS   , rawdata, pos);
+    length += write_type<SharedCn>(C_RESFMT, rawdata, pos);
+    length += write_type<SharedCn>(C_LLMFMT, rawdata, pos);
+    length += write_type<SharedCn>(C_HLMFMT, rawdata, pos);
     length += write_type<R4>(LO_SPEC , rawdata, pos);
     length += write_type<R4>(HI_SPEC , rawdata, pos);
     header.REC_LEN = length;
     return pos;
 }
 
+// a record that ended before OPT_FLAG is written as short as it was read,
+// unless one of the optional fields was set since
+bool ParametricTest::OptionalDataCut() const
+{
+    return CUT_LEN && OPT_FLAG.to_ulong() == 0x3F &&
+           RES_SCAL == 0 && LLM_SCAL == 0 && HLM_SCAL == 0 &&
+           LO_LIMIT == 0 && HI_LIMIT == 0 && LO_SPEC == 0 && HI_SPEC == 0 &&
+           UNITS.empty() && C_RESFMT.empty() && C_LLMFMT.empty() && C_HLMFMT.empty();
+}
+
+// end of the written record: an empty ALARM_ID or TEST_TXT is left out again
+// when the parsed record did not reach it
+unsigned int ParametricTest::CutLength(unsigned int text_pos, unsigned int alarm_pos, unsigned int opt_pos) const
+{
+    if(CUT_LEN > alarm_pos || !ALARM_ID.empty()) return opt_pos;
+    if(CUT_LEN > text_pos || !TEST_TXT.empty()) return alarm_pos;
+    return text_pos;
+}
+
 void ParametricTest::Print(std::ostream& os)
 {
     os<<"TEST_NUM : "<< TEST_NUM <<"\n";
@@ -1990,6 +2348,7 @@ MultipleResultParametric::MultipleResultParametric()
    INCR_IN  = R4(0.0);
    LO_SPEC  = R4(0.0);
    HI_SPEC  = R4(0.0);
+   CUT_LEN  = U2(0);
 }
 
 unsigned int MultipleResultParametric::Parse(const RecordHeader& header)
@@ -1997,7 +2356,7 @@ unsigned int MultipleResultParametric::Parse(const RecordHeader& header)
     REC_LEN = header.REC_LEN;
     REC_TYP = header.REC_TYP;
     REC_SUB = header.REC_SUB;
-    const char* rawdata = header.GetReadOnlyData();
+    const RecordView rawdata = header.GetReadOnlyData();
 
     unsigned int pos = 0;
     read_type<U4>( TEST_NUM, rawdata, pos) ;
@@ -2009,9 +2368,12 @@ unsigned int MultipleResultParametric::Parse(const RecordHeader& header)
     read_type<U2>( RSLT_CNT, rawdata, pos) ;
     read_type<kxN1>( RTN_STAT, rawdata, pos, RTN_ICNT) ;
     read_type<kxR4>( RTN_RSLT, rawdata, pos, RSLT_CNT) ;
-    read_type<Cn>( TEST_TXT, rawdata, pos) ;
-    read_type<Cn>( ALARM_ID, rawdata, pos) ;
+    read_type<SharedCn>( TEST_TXT, rawdata, pos) ;
+    read_type<SharedCn>( ALARM_ID, rawdata, pos) ;
+    // without OPT_FLAG the record ends here, as for the PTR
+    CUT_LEN = (pos >= rawdata.length) ? U2(rawdata.length) : U2(0);
     read_type<B1>( OPT_FLAG, rawdata, pos) ;
+    if(CUT_LEN) OPT_FLAG = B1(0x3F);
     read_type<I1>( RES_SCAL, rawdata, pos) ;
     read_type<I1>( LLM_SCAL, rawdata, pos) ;
     read_type<I1>( HLM_SCAL, rawdata, pos) ;
@@ -2020,11 +2382,11 @@ unsigned int MultipleResultParametric::Parse(const RecordHeader& header)
     read_type<R4>( START_IN, rawdata, pos) ;
     read_type<R4>( INCR_IN , rawdata, pos) ;
     read_type<kxU2>( RTN_INDX, rawdata, pos, RTN_ICNT) ;
-    read_type<Cn>( UNITS   , rawdata, pos) ;
-    read_type<Cn>( UNITS_IN, rawdata, pos) ;
-    read_type<Cn>( C_RESFMT, rawdata, pos) ;
-    read_type<Cn>( C_LLMFMT, rawdata, pos) ;
-    read_type<Cn>( C_HLMFMT, rawdata, pos) ;
+    read_type<SharedCn>( UNITS   , rawdata, pos) ;
+    read_type<SharedCn>( UNITS_IN, rawdata, pos) ;
+    read_type<SharedCn>( C_RESFMT, rawdata, pos) ;
+    read_type<SharedCn>( C_LLMFMT, rawdata, pos) ;
+    read_type<SharedCn>( C_HLMFMT, rawdata, pos) ;
     read_type<R4>( LO_SPEC , rawdata, pos) ;
     read_type<R4>( HI_SPEC , rawdata, pos) ;
     return pos;
@@ -2047,8 +2409,16 @@ unsigned int MultipleResultParametric::Unparse(RecordHeader& header)
     length += write_type<U2>( RSLT_CNT , rawdata, pos);
     length += write_type<kxN1>( RTN_STAT , rawdata, pos, RTN_ICNT);
     length += write_type<kxR4>( RTN_RSLT , rawdata, pos, RSLT_CNT);
-    length += write_type<Cn>( TEST_TXT , rawdata, pos);
-    length += write_type<Cn>( ALARM_ID , rawdata, pos);
+    const unsigned int text_pos = pos;
+    length += write_type<SharedCn>( TEST_TXT , rawdata, pos);
+    const unsigned int alarm_pos = pos;
+    length += write_type<SharedCn>( ALARM_ID , rawdata, pos);
+    if(OptionalDataCut())
+    {
+        pos = CutLength(text_pos, alarm_pos, pos);
+        header.REC_LEN = U2(pos);
+        return pos;
+    }
     length += write_type<B1>( OPT_FLAG , rawdata, pos);
     length += write_type<I1>( RES_SCAL , rawdata, pos);
     length += write_type<I1>( LLM_SCAL , rawdata, pos);
@@ -2058,17 +2428,38 @@ unsigned int MultipleResultParametric::Unparse(RecordHeader& header)
     length += write_type<R4>( START_IN , rawdata, pos);
     length += write_type<R4>( INCR_IN  , rawdata, pos);
     length += write_type<kxU2>( RTN_INDX , rawdata, pos, RTN_ICNT);
-    length += write_type<Cn>( UNITS    , rawdata, pos);
-    length += write_type<Cn>( UNITS_IN , rawdata, pos);
-    length += write_type<Cn>( C_RESFMT , rawdata, pos);
-    length += write_type<Cn>( C_LLMFMT , rawdata, pos);
-    length += write_type<Cn>( C_HLMFMT , rawdata, pos);
+    length += write_type<SharedCn>( UNITS    , rawdata, pos);
+    length += write_type<SharedCn>( UNITS_IN , rawdata, pos);
+    length += write_type<SharedCn>( C_RESFMT , rawdata, pos);
+    length += write_type<SharedCn>( C_LLMFMT , rawdata, pos);
+    length += write_type<SharedCn>( C_HLMFMT , rawdata, pos);
     length += write_type<R4>( LO_SPEC  , rawdata, pos);
     length += write_type<R4>( HI_SPEC  , rawdata, pos);
     header.REC_LEN = length;
     return pos;
 }
 
+// as for the PTR, RTN_INDX was not in the record either
+bool MultipleResultParametric::OptionalDataCut() const
+{
+    if(!CUT_LEN || OPT_FLAG.to_ulong() != 0x3F) return false;
+    for(unsigned int i = 0; i < RTN_INDX.size(); i++)
+    {
+        if(RTN_INDX[i] != 0) return false;
+    }
+    return RES_SCAL == 0 && LLM_SCAL == 0 && HLM_SCAL == 0 &&
+           LO_LIMIT == 0 && HI_LIMIT == 0 && START_IN == 0 && INCR_IN == 0 &&
+           LO_SPEC == 0 && HI_SPEC == 0 && UNITS.empty() && UNITS_IN.empty() &&
+           C_RESFMT.empty() && C_LLMFMT.empty() && C_HLMFMT.empty();
+}
+
+unsigned int MultipleResultParametric::CutLength(unsigned int text_pos, unsigned int alarm_pos, unsigned int opt_pos) const
+{
+    if(CUT_LEN > alarm_pos || !ALARM_ID.empty()) return opt_pos;
+    if(CUT_LEN > text_pos || !TEST_TXT.empty()) return alarm_pos;
+    return text_pos;
+}
+
 void MultipleResultParametric::Print(std::ostream& os)
 {
     os<<"TEST_NUM : "<<TEST_NUM<<"\n";
@@ -2146,7 +2537,7 @@ unsigned int FunctionalTest::Parse(const RecordHeader& header)
     REC_LEN = header.REC_LEN;
     REC_TYP = header.REC_TYP;
     REC_SUB = header.REC_SUB;
-    const char* rawdata = header.GetReadOnlyData();
+    const RecordView rawdata = header.GetReadOnlyData();
 
     unsigned int pos = 0;
     read_type<U4>( TEST_NUM , rawdata, pos);
@@ -2168,11 +2559,11 @@ unsigned int FunctionalTest::Parse(const RecordHeader& header)
     read_type<kxU2>( PGM_INDX , rawdata, pos, PGM_ICNT);
     read_type<kxN1>( PGM_STAT , rawdata, pos, PGM_ICNT);
     read_type<Dn>( FAIL_PIN , rawdata, pos);
-    read_type<Cn>( VECT_NAM , rawdata, pos);
-    read_type<Cn>( TIME_SET , rawdata, pos);
-    read_type<Cn>( OP_CODE  , rawdata, pos);
-    read_type<Cn>( TEST_TXT , rawdata, pos);
-    read_type<Cn>( ALARM_ID , rawdata, pos);
+    read_type<SharedCn>( VECT_NAM , rawdata, pos);
+    read_type<SharedCn>( TIME_SET , rawdata, pos);
+    read_type<SharedCn>( OP_CODE  , rawdata, pos);
+    read_type<SharedCn>( TEST_TXT , rawdata, pos);
+    read_type<SharedCn>( ALARM_ID , rawdata, pos);
     read_type<Cn>( PROG_TXT , rawdata, pos);
     read_type<Cn>( RSLT_TXT , rawdata, pos);
     read_type<U1>( PATG_NUM , rawdata, pos);
@@ -2207,11 +2598,11 @@ unsigned int FunctionalTest::Unparse(RecordHeader& header)
     length += write_type<kxU2>( PGM_INDX , rawdata, pos, PGM_ICNT);
     length += write_type<kxN1>( PGM_STAT , rawdata, pos, PGM_ICNT);
     length += write_type<Dn>( FAIL_PIN , rawdata, pos);
-    length += write_type<Cn>( VECT_NAM , rawdata, pos);
-    length += write_type<Cn>( TIME_SET , rawdata, pos);
-    length += write_type<Cn>( OP_CODE  , rawdata, pos);
-    length += write_type<Cn>( TEST_TXT , rawdata, pos);
-    length += write_type<Cn>( ALARM_ID , rawdata, pos);
+    length += write_type<SharedCn>( VECT_NAM , rawdata, pos);
+    length += write_type<SharedCn>( TIME_SET , rawdata, pos);
+    length += write_type<SharedCn>( OP_CODE  , rawdata, pos);
+    length += write_type<SharedCn>( TEST_TXT , rawdata, pos);
+    length += write_type<SharedCn>( ALARM_ID , rawdata, pos);
     length += write_type<Cn>( PROG_TXT , rawdata, pos);
     length += write_type<Cn>( RSLT_TXT , rawdata, pos);
     length += write_type<U1>( PATG_NUM , rawdata, pos);
@@ -2268,7 +2659,7 @@ void FunctionalTest::Print(std::ostream& os)
     {
         if((i != 0) && (i % 32 == 0)) os<<"\n          ";
         if((i != 0) && (i % 8 == 0)) os<<" ";
-        if(FAIL_PIN.data[i]) os<<"1";
+        if(FAIL_PIN.GetBit(i)) os<<"1";
         else os<<"0";
     }
     os<<"\n";
@@ -2286,7 +2677,7 @@ void FunctionalTest::Print(std::ostream& os)
     {
         if((i != 0) && (i % 32 == 0)) os<<"\n          ";
         if((i != 0) && (i % 8 == 0)) os<<" ";
-        if(SPIN_MAP.data[i]) os<<"1";
+        if(SPIN_MAP.GetBit(i)) os<<"1";
         else os<<"0";
     }
     os<<"\n";
@@ -2307,7 +2698,7 @@ unsigned int BeginProgramSection::Parse(const RecordHeader& header)
     REC_LEN = header.REC_LEN;
     REC_TYP = header.REC_TYP;
     REC_SUB = header.REC_SUB;
-    const char* rawdata = header.GetReadOnlyData();
+    const RecordView rawdata = header.GetReadOnlyData();
 
     unsigned int pos = 0;
     read_type<Cn>( SEQ_NAME , rawdata, pos);
@@ -2377,6 +2768,11 @@ GenericData::GenericData()
 }
 
 GenericData::~GenericData()
+{
+    ClearData();
+}
+
+void GenericData::ClearData()
 {
     if(FLD_CNT != 0)
     {
@@ -2409,8 +2805,10 @@ unsigned int GenericData::Parse(const RecordHeader& header)
     REC_LEN = header.REC_LEN;
     REC_TYP = header.REC_TYP;
     REC_SUB = header.REC_SUB;
-    const char* rawdata = header.GetReadOnlyData();
+    const RecordView rawdata = header.GetReadOnlyData();
 
+    // the same object may be reused to parse the next GDR
+    ClearData();
     unsigned int pos = 0;
     read_type<U2>( FLD_CNT  , rawdata, pos);
     read_type<Vn>( GEN_DATA , rawdata, pos, FLD_CNT);
@@ -2429,6 +2827,9 @@ unsigned int GenericData::Unparse(RecordHeader& header)
 
     pos += 2; // write data before length
     length += write_type<Vn>( GEN_DATA , rawdata, pos, FLD_CNT, &pad_count);
+    // write_type<Vn> counts FLD_CNT bytes more than it writes, those have to be
+    // zero and not what the last record left in the buffer
+    if(pos < length + 2U) std::memset(rawdata + pos, 0, length + 2U - pos);
     unsigned int null_data_count = 0;
     unsigned int vector_count = GEN_DATA.size();
     for(unsigned int i = 0; i < vector_count; i++)
@@ -2528,7 +2929,7 @@ void GenericData::Print(std::ostream& os)
                 Bn* temp = (Bn*)GEN_DATA.at(i).data;
                 for(U2 n = 0; n < temp->count; n++)
                 {
-                    os<<temp->data.at(n)<<" ";
+                    os<<B1(temp->data.at(n))<<" ";
                 }
                 os<<"\n";
             }
@@ -2542,7 +2943,7 @@ void GenericData::Print(std::ostream& os)
                 {
                     if((n != 0) && (n % 32 == 0)) os<<"\n          ";
                     if((n != 0) && (n % 8 == 0)) os<<" ";
-                    if(temp->data[n]) os<<"1";
+                    if(temp->GetBit(n)) os<<"1";
                     else os<<"0";
                 }
                 os<<"\n";
@@ -2581,7 +2982,7 @@ unsigned int DatalogText::Parse(const RecordHeader& header)
     REC_LEN = header.REC_LEN;
     REC_TYP = header.REC_TYP;
     REC_SUB = header.REC_SUB;
-    const char* rawdata = header.GetReadOnlyData();
+    const RecordView rawdata = header.GetReadOnlyData();
 
     unsigned int pos = 0;
     read_type<Cn>( TEXT_DAT , rawdata, pos);
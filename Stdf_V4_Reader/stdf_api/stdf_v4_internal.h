@@ -7,6 +7,8 @@
 #include <iostream>
 #include <string>
 #include <array>
+#include <atomic>
+#include <cstdint>
 
 /********************************************************************************
 The STDF test data file must contain one FAR, one MIR, at least one PCR, and one MRR.
@@ -155,15 +157,68 @@ typedef std::bitset<BYTE_LENGTH>         B1; //One byte bit-encoded data
 typedef std::bitset<NIBBLE_LENGTH>       N1; //(Nibble = 4 bits of a byte).First item in low 4 bits, second item in high 4 bits.
 typedef std::string                      Cn; //first byte = unsigned count of bytes to follow (maximum of 255 bytes)
 
-typedef struct{ U1 count; std::array<B1, MAX_BYTE_LENGTH> data;} Bn; //First byte = unsigned count of bytes to follow (maximum of 255 bytes).
-// Replace std::bitset with std::array
-// Because of the VS2010's bug. BUG ID:612692
-#if _MSC_VER == 1600   
-// https://connect.microsoft.com/VisualStudio/feedback/details/612692
-typedef struct{ U2 count; std::array<C1, MAX_BITS_LENGTH> data;} Dn; //First two bytes = unsigned count of bits to follow (maximum of 65,535 bits).
-#else
-typedef struct{ U2 count; std::bitset<MAX_BITS_LENGTH>    data;} Dn; //First two bytes = unsigned count of bits to follow (maximum of 65,535 bits).
-#endif
+//Cn of the fields that repeat in every record of a test: test names and texts, alarm ids,
+//units, format strings, vector/time set names. The text is interned, equal strings share
+//one counted copy that is freed with the last SharedCn holding it, and the record only
+//holds a pointer to it, so parsing a value seen before does not allocate. Empty strings
+//are a null pointer.
+struct CnEntry
+{
+    std::string text;
+    uint32_t hash;
+    std::atomic<unsigned int> refs;
+};
+
+class SharedCn
+{
+public:
+    SharedCn() : entry(nullptr) {}
+    SharedCn(const SharedCn& src) : entry(src.entry) { if(entry) entry->refs.fetch_add(1, std::memory_order_relaxed); }
+    SharedCn& operator=(const SharedCn& src);
+    ~SharedCn() { if(entry) release(entry); }
+    bool empty() const { return entry == nullptr; }
+    unsigned int length() const { return entry ? (unsigned int)entry->text.size() : 0; }
+    const char* c_str() const { return entry ? entry->text.c_str() : ""; }
+    void clear() { if(entry) release(entry); entry = nullptr; }
+    void assign(const char* str);
+    void assign(const char* str, unsigned int count);
+private:
+    static void release(CnEntry* entry);
+    CnEntry* entry;
+};
+std::ostream& operator<<(std::ostream& os, const SharedCn& value);
+
+//First byte = unsigned count of bytes to follow (maximum of 255 bytes).
+//Only the bytes really present are stored, data.size() == count after parsing.
+struct Bn
+{
+    U1 count;
+    std::vector<U1> data;
+};
+
+//First two bytes = unsigned count of bits to follow (maximum of 65,535 bits).
+//The bits are kept packed as in the file: bit i is bit (i % 8) of data[i / 8],
+//so a record only holds (count + 7) / 8 bytes instead of a 64K bitset.
+struct Dn
+{
+    U2 count;
+    std::vector<U1> data;
+
+    unsigned int ByteCount() const { return (count == 0) ? 0 : (count - 1U) / 8U + 1U; }
+    bool GetBit(unsigned int index) const
+    {
+        unsigned int byte = index / 8U;
+        if(byte >= data.size()) return false;
+        return ((data[byte] >> (index % 8U)) & 0x01) != 0;
+    }
+    void SetBit(unsigned int index, bool bit)
+    {
+        unsigned int byte = index / 8U;
+        if(byte >= data.size()) data.resize(byte + 1U, U1(0));
+        if(bit) data[byte] = U1(data[byte] |  (0x01 << (index % 8U)));
+        else    data[byte] = U1(data[byte] & ~(0x01 << (index % 8U)));
+    }
+};
 
 typedef std::vector<U1>    kxU1; // Array of data of the type U1.
 typedef std::vector<U2>    kxU2; // Array of data of the type U2.
@@ -179,6 +234,30 @@ typedef std::vector<Cn>    kxCn; // Array of data of the type Cn.
 typedef struct {U1 type; void *data;} V1; //The data type is specified by a code in the first byte, and the data follows (maximum of 255 bytes)
 typedef std::vector<V1>    Vn;
 
+// Read-only view of one record's data bytes, either in RecordHeader's own buffer
+// or in place inside a mapped file. Reads past the end of the record return 0,
+// so missing optional fields at the end of a record decode as binary 0 without
+// clearing any buffer first.
+// swapped: the numbers are stored in the other byte order than the host's
+// (CPU_TYPE=1 file on a little endian host).
+class   RecordView
+{
+public:
+    const char*  data;
+    unsigned int length;
+    bool         swapped;
+public:
+    RecordView(const char* record_data, unsigned int record_length, bool byte_swapped = false)
+        : data(record_data), length(record_length), swapped(byte_swapped) {}
+    char operator[](unsigned int pos) const { return (pos < length) ? data[pos] : 0; }
+    // number of bytes of [pos, pos+count) that lie inside the record
+    unsigned int available(unsigned int pos, unsigned int count) const
+    {
+        if(pos >= length) return 0;
+        return (length - pos < count) ? (length - pos) : count;
+    }
+};
+
 class   RecordHeader
 {
 public:
@@ -189,14 +268,24 @@ public:
 public:
     int ReadRecord(std::ifstream& file_stream);
     int WriteRecord(std::ofstream& file_stream);
+    // Copy the 4 bytes header and REC_LEN data bytes to out, returns the bytes copied.
+    // out needs room for 4 + REC_LEN bytes.
+    unsigned int Serialize(char* out) const;
+    // Point at a record in memory (4 bytes header followed by REC_LEN bytes), no copy.
+    // The caller keeps the memory alive until the next Read/Map/Write call.
+    // swapped: REC_LEN and the data are in the other byte order (see RecordView).
+    int MapRecord(const char* record, unsigned int available_length, bool swapped = false);
 
     RecordHeader();
     ~RecordHeader(){};
-    const char*GetReadOnlyData() const;
+    RecordView GetReadOnlyData() const;
     char* GetWriteOnlyData();
     int GetRecordType() const;
 
 private:
+    const char*  view;
+    unsigned int view_length;
+    bool view_swapped;
     char rawdata[MAX_REC_LENGTH];
     RecordHeader(RecordHeader& );
     RecordHeader& operator=(const RecordHeader& src);
@@ -1003,9 +1092,9 @@ public:
     U4 EXEC_CNT ; // Number of test executions ,default: 4,294,967,295
     U4 FAIL_CNT ; // Number of test failures ,default: 4,294,967,295
     U4 ALRM_CNT ; // Number of alarmed tests ,default: 4,294,967,295
-    Cn TEST_NAM ; // Test name ,default: length byte = 0
-    Cn SEQ_NAME ; // Sequencer (program segment/flow) name ,default: length byte = 0
-    Cn TEST_LBL ; // Test label or text ,default: length byte = 0
+    SharedCn TEST_NAM ; // Test name ,default: length byte = 0
+    SharedCn SEQ_NAME ; // Sequencer (program segment/flow) name ,default: length byte = 0
+    SharedCn TEST_LBL ; // Test label or text ,default: length byte = 0
     B1 OPT_FLAG ; // Optional data flag
     R4 TEST_TIM ; // Average test execution time in seconds ,default: OPT_FLAG bit 2 = 1
     R4 TEST_MIN ; // Lowest test result value ,default: OPT_FLAG bit 0 = 1
@@ -1066,20 +1155,21 @@ public:
     B1 TEST_FLG ; // Test flags (fail, alarm, etc.)
     B1 PARM_FLG ; // Parametric test flags (drift, etc.)
     R4 RESULT   ; // Test result ,default: TEST_FLG bit 1 = 1
-    Cn TEST_TXT ; // Test description text or label ,default: length byte = 0
-    Cn ALARM_ID ; // Name of alarm ,default: length byte = 0
+    SharedCn TEST_TXT ; // Test description text or label ,default: length byte = 0
+    SharedCn ALARM_ID ; // Name of alarm ,default: length byte = 0
     B1 OPT_FLAG ; // Optional data flag
     I1 RES_SCAL ; // Test results scaling exponent ,default: OPT_FLAG bit 0 = 1
     I1 LLM_SCAL ; // Low limit scaling exponent ,default: OPT_FLAG bit 4 or 6 = 1
     I1 HLM_SCAL ; // High limit scaling exponent ,default: OPT_FLAG bit 5 or 7 = 1
     R4 LO_LIMIT ; // Low test limit value ,default: OPT_FLAG bit 4 or 6 = 1
     R4 HI_LIMIT ; // High test limit value ,default: OPT_FLAG bit 5 or 7 = 1
-    Cn UNITS    ; // Test units ,default: length byte = 0
-    Cn C_RESFMT ; // ANSI C result format string ,default: length byte = 0
-    Cn C_LLMFMT ; // ANSI C low limit format string ,default: length byte = 0
-    Cn C_HLMFMT ; // ANSI C high limit format string ,default: length byte = 0
+    SharedCn UNITS    ; // Test units ,default: length byte = 0
+    SharedCn C_RESFMT ; // ANSI C result format string ,default: length byte = 0
+    SharedCn C_LLMFMT ; // ANSI C low limit format string ,default: length byte = 0
+    SharedCn C_HLMFMT ; // ANSI C high limit format string ,default: length byte = 0
     R4 LO_SPEC  ; // Low specification limit value ,default: OPT_FLAG bit 2 = 1
     R4 HI_SPEC  ; // High specification limit value ,default: OPT_FLAG bit 3 = 1
+    U2 CUT_LEN  ; // Length of a parsed record that ended before OPT_FLAG, 0 otherwise
 public:
     ParametricTest();
     ~ParametricTest(){};
@@ -1088,6 +1178,8 @@ public:
     void Print(std::ostream& os);
 
 private:
+    bool OptionalDataCut() const;
+    unsigned int CutLength(unsigned int text_pos, unsigned int alarm_pos, unsigned int opt_pos) const;
     ParametricTest(const ParametricTest& );
     ParametricTest& operator=(const ParametricTest& );
 };
@@ -1210,8 +1302,8 @@ public:
     U2   RSLT_CNT ; // Count of returned results
     kxN1 RTN_STAT ; // Array of returned states ,default: RTN_ICNT = 0
     kxR4 RTN_RSLT ; // Array of returned results ,default: RSLT_CNT = 0
-    Cn   TEST_TXT ; // Descriptive text or label ,default: length byte = 0
-    Cn   ALARM_ID ; // Name of alarm ,default: length byte = 0
+    SharedCn   TEST_TXT ; // Descriptive text or label ,default: length byte = 0
+    SharedCn   ALARM_ID ; // Name of alarm ,default: length byte = 0
     B1   OPT_FLAG ; // Optional data flag
     I1   RES_SCAL ; // Test result scaling exponent ,default: OPT_FLAG bit 0 = 1
     I1   LLM_SCAL ; // Test low limit scaling exponent ,default: OPT_FLAG bit 4 or 6 = 1
@@ -1221,13 +1313,14 @@ public:
     R4   START_IN ; // Starting input value (condition) ,default: OPT_FLAG bit 1 = 1
     R4   INCR_IN  ; // Increment of input condition ,default: OPT_FLAG bit 1 = 1
     kxU2 RTN_INDX ; // Array of PMR indexes ,default: RTN_ICNT = 0
-    Cn   UNITS    ; // Units of returned results ,default: length byte = 0
-    Cn   UNITS_IN ; // Input condition units ,default: length byte = 0
-    Cn   C_RESFMT ; // ANSI C result format string ,default: length byte = 0
-    Cn   C_LLMFMT ; // ANSI C low limit format string ,default: length byte = 0
-    Cn   C_HLMFMT ; // ANSI C high limit format string ,default: length byte = 0
+    SharedCn   UNITS    ; // Units of returned results ,default: length byte = 0
+    SharedCn   UNITS_IN ; // Input condition units ,default: length byte = 0
+    SharedCn   C_RESFMT ; // ANSI C result format string ,default: length byte = 0
+    SharedCn   C_LLMFMT ; // ANSI C low limit format string ,default: length byte = 0
+    SharedCn   C_HLMFMT ; // ANSI C high limit format string ,default: length byte = 0
     R4   LO_SPEC  ; // Low specification limit value ,default: OPT_FLAG bit 2 = 1
     R4   HI_SPEC  ; // High specification limit value ,default: OPT_FLAG bit 3 = 1
+    U2   CUT_LEN  ; // Length of a parsed record that ended before OPT_FLAG, 0 otherwise
 public:
     MultipleResultParametric();
     ~MultipleResultParametric(){};
@@ -1236,6 +1329,8 @@ public:
     void Print(std::ostream& os);
 
 private:
+    bool OptionalDataCut() const;
+    unsigned int CutLength(unsigned int text_pos, unsigned int alarm_pos, unsigned int opt_pos) const;
     MultipleResultParametric(const MultipleResultParametric& );
     MultipleResultParametric& operator=(const MultipleResultParametric& );
 };
@@ -1369,11 +1464,11 @@ public:
     kxU2 PGM_INDX ; // Array of programmed state indexes ,default: PGM_ICNT = 0
     kxN1 PGM_STAT ; // Array of programmed states ,default: PGM_ICNT = 0
     Dn   FAIL_PIN ; // Failing pin bitfield ,default: length bytes = 0
-    Cn   VECT_NAM ; // Vector module pattern name ,default: length byte = 0
-    Cn   TIME_SET ; // Time set name ,default: length byte = 0
-    Cn   OP_CODE  ; // Vector Op Code ,default: length byte = 0
-    Cn   TEST_TXT ; // Descriptive text or label ,default: length byte = 0
-    Cn   ALARM_ID ; // Name of alarm ,default: length byte = 0
+    SharedCn   VECT_NAM ; // Vector module pattern name ,default: length byte = 0
+    SharedCn   TIME_SET ; // Time set name ,default: length byte = 0
+    SharedCn   OP_CODE  ; // Vector Op Code ,default: length byte = 0
+    SharedCn   TEST_TXT ; // Descriptive text or label ,default: length byte = 0
+    SharedCn   ALARM_ID ; // Name of alarm ,default: length byte = 0
     Cn   PROG_TXT ; // Additional programmed information ,default: length byte = 0
     Cn   RSLT_TXT ; // Additional result information ,default: length byte = 0
     U1   PATG_NUM ; // Pattern generator number ,default: 255
@@ -1579,6 +1674,7 @@ public:
     void Print(std::ostream& os);
 
 private:
+    void ClearData();
     GenericData(const GenericData& );
     GenericData& operator=(const GenericData& );
 };
@@ -0,0 +1,44 @@
+#-------------------------------------------------
+#
+# Command line CSV export of one record type,
+# without Qt, see csv_main.cpp
+#
+#-------------------------------------------------
+
+QT       -= core gui
+CONFIG   += console thread
+CONFIG   -= app_bundle qt
+
+TARGET = stdf_csv
+TEMPLATE = app
+QMAKE_CXXFLAGS += -std=c++11
+
+# gzip output of StdfWriter, zstd only with CONFIG += zstd
+LIBS += -lz
+zstd {
+    DEFINES += STDF_HAVE_ZSTD
+    LIBS += -lzstd
+}
+
+SOURCES += \
+    csv_main.cpp \
+    stdf_api/stdf_v4_api.cpp \
+    stdf_api/stdf_v4_internal.cpp \
+    stdf_file/stdf_v4_file.cpp \
+    stdf_file/stdf_v4_index.cpp \
+    stdf_file/stdf_v4_writer.cpp \
+    stdf_file/stdf_v4_columns.cpp \
+    stdf_file/stdf_v4_csv.cpp \
+    stdf_file/stdf_v4_results.cpp \
+    debug_api/debug_api.cpp
+
+HEADERS  += \
+    stdf_api/stdf_v4_api.h \
+    stdf_api/stdf_v4_internal.h \
+    stdf_file/stdf_v4_file.h \
+    stdf_file/stdf_v4_index.h \
+    stdf_file/stdf_v4_writer.h \
+    stdf_file/stdf_v4_columns.h \
+    stdf_file/stdf_v4_csv.h \
+    stdf_file/stdf_v4_results.h \
+    debug_api/debug_api.h
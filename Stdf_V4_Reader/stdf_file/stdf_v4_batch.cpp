@@ -0,0 +1,671 @@
+#include "stdf_v4_batch.h"
+#include "stdf_v4_csv.h"
+#include "stdf_v4_results.h"
+#include "stdf_v4_writer.h"
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <glob.h>
+#endif
+
+// memory of the streaming modes while a file runs: read ahead, output buffers
+#define STDF_BATCH_STREAM_MEMORY (4ULL << 20)
+// parts are copied to the output in blocks of this size
+#define STDF_BATCH_COPY_BLOCK (1U << 20)
+
+static bool file_info(const char* filename, unsigned long long& size, long long& mtime)
+{
+    struct stat info;
+    if(stat(filename, &info) != 0) return false;
+    size = (unsigned long long)info.st_size;
+    mtime = (long long)info.st_mtime;
+    return true;
+}
+
+static bool is_pattern(const char* argument)
+{
+    return std::strpbrk(argument, "*?[") != nullptr;
+}
+
+static bool add_matches(const char* pattern, std::vector<std::string>& files)
+{
+    std::vector<std::string> matches;
+#ifdef _WIN32
+    // FindFirstFile only matches the last part of the path
+    std::string directory(pattern);
+    size_t slash = directory.find_last_of("\\/");
+    directory = (slash == std::string::npos) ? std::string() : directory.substr(0, slash + 1);
+    WIN32_FIND_DATAA data;
+    HANDLE find = FindFirstFileA(pattern, &data);
+    if(find != INVALID_HANDLE_VALUE)
+    {
+        do
+        {
+            if(!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) matches.push_back(directory + data.cFileName);
+        } while(FindNextFileA(find, &data));
+        FindClose(find);
+    }
+#else
+    glob_t result;
+    if(glob(pattern, 0, nullptr, &result) == 0)
+    {
+        for(size_t i = 0; i < result.gl_pathc; i++) matches.push_back(result.gl_pathv[i]);
+    }
+    globfree(&result);
+#endif
+    std::sort(matches.begin(), matches.end());
+    files.insert(files.end(), matches.begin(), matches.end());
+    return !matches.empty();
+}
+
+//=============================================================
+// PRR lines of STDF_BATCH_PRR, the fields of the daemon's NdjsonWriter
+class PrrLineWriter : public StdfRecordVisitor
+{
+public:
+    PrrLineWriter(std::FILE* file, const char* stdf_filename, long long mtime)
+        : m_file(file), m_filename(stdf_filename), m_mtime(mtime), m_failed(false)
+    {
+        m_buffer.reserve(STDF_BATCH_COPY_BLOCK + 4096);
+    }
+
+    bool visit(StdfRecord* record, unsigned long long)
+    {
+        const StdfPRR& prr = *static_cast<StdfPRR*>(record);
+        m_buffer += "{\"file\":";
+        put_string(m_filename);
+        put_number(",\"head_number\":", prr.get_head_number());
+        put_number(",\"site_number\":", prr.get_site_number());
+        put_number(",\"test_count\":", prr.get_number_test());
+        put_number(",\"hard_bin\":", prr.get_hardbin_number());
+        put_number(",\"soft_bin\":", prr.get_softbin_number());
+        put_number(",\"x_coord\":", prr.get_x_coordinate());
+        put_number(",\"y_coord\":", prr.get_y_coordinate());
+        put_number(",\"test_time\":", prr.get_elapsed_ms());
+        m_buffer += ",\"part_flags\":{\"superseded\":";
+        m_buffer += prr.part_supersede_flag() ? "true" : "false";
+        m_buffer += ",\"abnormal\":";
+        m_buffer += prr.part_abnormal_flag() ? "true" : "false";
+        m_buffer += ",\"failed\":";
+        m_buffer += prr.part_failed_flag() ? "true" : "false";
+        m_buffer += ",\"invalid_flag\":";
+        m_buffer += prr.pass_fail_flag_invalid() ? "true" : "false";
+        m_buffer += '}';
+        if(prr.get_part_id())
+        {
+            m_buffer += ",\"part_id\":";
+            put_string(prr.get_part_id());
+        }
+        if(prr.get_part_discription())
+        {
+            m_buffer += ",\"part_text\":";
+            put_string(prr.get_part_discription());
+        }
+        put_number(",\"last_modified\":", m_mtime);
+        put_number(",\"sot\":", m_mtime - prr.get_elapsed_ms() / 1000);
+        put_number(",\"eot\":", m_mtime);
+        m_buffer += "}\n";
+        if(m_buffer.size() >= STDF_BATCH_COPY_BLOCK) flush();
+        return !m_failed;
+    }
+
+    bool flush()
+    {
+        if(!m_buffer.empty() && std::fwrite(m_buffer.data(), 1, m_buffer.size(), m_file) != m_buffer.size()) m_failed = true;
+        m_buffer.clear();
+        return !m_failed;
+    }
+
+private:
+    void put_number(const char* key, long long value)
+    {
+        char digits[24];
+        int length = std::snprintf(digits, sizeof(digits), "%lld", value);
+        m_buffer += key;
+        m_buffer.append(digits, (size_t)length);
+    }
+
+    // printable ASCII only, as the daemon writes them
+    void put_string(const char* text)
+    {
+        m_buffer += '"';
+        for(const char* c = text; *c; c++)
+        {
+            unsigned char ch = (unsigned char)*c;
+            if(ch == '\\' || ch == '"')
+            {
+                m_buffer += '\\';
+                m_buffer += char(ch);
+            }
+            else if(ch >= 32 && ch < 127) m_buffer += char(ch);
+            else m_buffer += '?';
+        }
+        m_buffer += '"';
+    }
+
+    std::FILE* m_file;
+    const char* m_filename;
+    long long m_mtime;
+    bool m_failed;
+    std::string m_buffer;
+};
+
+//=============================================================
+class StdfBatch::Run
+{
+public:
+    Run(StdfBatch& batch, STDF_BATCH_MODE mode, const std::vector<std::string>& files, const char* output)
+        : m_batch(batch), m_mode(mode), m_files(files), m_output(output),
+          m_done(files.size(), false), m_mir(files.size()), m_mrr(files.size()),
+          m_reserved(0), m_cancel(false), m_out(nullptr), m_head_written(false), m_last_mrr(0)
+    {
+    }
+
+    ~Run()
+    {
+        for(unsigned int i = 0; i < m_queues.size(); i++) delete m_queues[i];
+    }
+
+    STDF_FILE_ERROR execute()
+    {
+        m_sizes.assign(m_files.size(), 0);
+        for(unsigned int i = 0; i < m_files.size(); i++)
+        {
+            long long mtime = 0;
+            file_info(m_files[i].c_str(), m_sizes[i], mtime);
+            m_batch.m_input_bytes += m_sizes[i];
+        }
+
+        if(m_mode != STDF_BATCH_RESULTS)
+        {
+            m_out = std::fopen(m_output.c_str(), "wb");
+            if(!m_out) return WRITE_ERROR;
+        }
+
+        unsigned int threads = m_batch.m_threads ? m_batch.m_threads : std::thread::hardware_concurrency();
+        if(threads == 0) threads = 1;
+        if(threads > m_files.size()) threads = (unsigned int)std::max<size_t>(m_files.size(), 1);
+        // every thread gets every threads-th file, so the files are done about in order
+        for(unsigned int i = 0; i < threads; i++) m_queues.push_back(new Queue());
+        for(unsigned int i = 0; i < m_files.size(); i++) m_queues[i % threads]->files.push_back(i);
+
+        std::vector<std::thread> workers;
+        for(unsigned int i = 0; i < threads; i++) workers.push_back(std::thread(&Run::work, this, i));
+
+        STDF_FILE_ERROR ret = STDF_OPERATE_OK;
+        for(unsigned int i = 0; i < m_files.size(); i++)
+        {
+            wait_done(i);
+            if(ret == STDF_OPERATE_OK) ret = merge(i);
+            else std::remove(part_name(i).c_str());
+            if(ret != STDF_OPERATE_OK) m_cancel = true;
+        }
+        for(unsigned int i = 0; i < workers.size(); i++) workers[i].join();
+
+        if(ret == STDF_OPERATE_OK) ret = finish();
+        if(m_out && std::fclose(m_out) != 0 && ret == STDF_OPERATE_OK) ret = WRITE_ERROR;
+        m_out = nullptr;
+        return ret;
+    }
+
+private:
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<unsigned int> files;
+    };
+
+    std::string part_name(unsigned int file) const
+    {
+        char suffix[32];
+        std::snprintf(suffix, sizeof(suffix), ".%u.part", file);
+        return m_output + suffix;
+    }
+
+    // the own queue from the front, else the last file of another one
+    bool take(unsigned int worker, unsigned int& file)
+    {
+        for(unsigned int n = 0; n < m_queues.size(); n++)
+        {
+            Queue& queue = *m_queues[(worker + n) % m_queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if(queue.files.empty()) continue;
+            if(n == 0)
+            {
+                file = queue.files.front();
+                queue.files.pop_front();
+            }
+            else
+            {
+                file = queue.files.back();
+                queue.files.pop_back();
+            }
+            return true;
+        }
+        return false;
+    }
+
+    void work(unsigned int worker)
+    {
+        unsigned int file = 0;
+        while(take(worker, file))
+        {
+            // after a failed merge the queues are only drained, every file has to
+            // be done for the merge loop to come to the end
+            STDF_FILE_ERROR ret = WRITE_ERROR;
+            if(!m_cancel)
+            {
+                unsigned long long memory = estimate(file);
+                reserve(memory);
+                ret = process(file);
+                release(memory);
+            }
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_batch.m_results[file] = ret;
+            m_done[file] = true;
+            m_done_condition.notify_all();
+        }
+    }
+
+    // what a file takes while it runs: the records of STDF_FILE::read (about 4 times
+    // the file, see the read_arena stage of stdf_bench), the result columns of a cache
+    // build (less than half), or only the buffers of the streaming modes. The mapped
+    // file itself is page cache and not counted.
+    unsigned long long estimate(unsigned int file) const
+    {
+        switch(m_mode)
+        {
+        case STDF_BATCH_TEXT: return 4 * m_sizes[file] + STDF_BATCH_STREAM_MEMORY;
+        case STDF_BATCH_RESULTS: return m_sizes[file] / 2 + STDF_BATCH_STREAM_MEMORY;
+        default: return STDF_BATCH_STREAM_MEMORY;
+        }
+    }
+
+    // waits until the memory fits into the budget, or nothing else runs
+    void reserve(unsigned long long memory)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_budget_condition.wait(lock, [&]() {
+            return m_reserved == 0 || m_reserved + memory <= m_batch.m_memory_budget;
+        });
+        m_reserved += memory;
+        m_batch.m_peak_reserved = std::max(m_batch.m_peak_reserved, m_reserved);
+    }
+
+    void release(unsigned long long memory)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_reserved -= memory;
+        m_budget_condition.notify_all();
+    }
+
+    void wait_done(unsigned int file)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done_condition.wait(lock, [&]() { return (bool)m_done[file]; });
+    }
+
+    STDF_FILE_ERROR process(unsigned int file)
+    {
+        const char* filename = m_files[file].c_str();
+        std::string part = part_name(file);
+        STDF_FILE_ERROR ret = STDF_OPERATE_OK;
+        switch(m_mode)
+        {
+        case STDF_BATCH_TEXT:
+        {
+            STDF_FILE stdf_file(true);
+            ret = stdf_file.read(filename);
+            if(ret == STDF_OPERATE_OK) ret = stdf_file.write(part.c_str());
+            break;
+        }
+        case STDF_BATCH_PRR:
+        {
+            unsigned long long size = 0;
+            long long mtime = 0;
+            file_info(filename, size, mtime);
+            std::FILE* out = std::fopen(part.c_str(), "wb");
+            if(!out) return WRITE_ERROR;
+            PrrLineWriter writer(out, filename, mtime);
+            ret = STDF_FILE::scan(filename, writer, STDF_TYPE_MASK(PRR_TYPE));
+            bool written = writer.flush();
+            if(std::fclose(out) != 0) written = false;
+            if(ret == STDF_OPERATE_OK && !written) ret = WRITE_ERROR;
+            break;
+        }
+        case STDF_BATCH_CSV:
+        {
+            StdfCsvExporter exporter;
+            exporter.set_file_column(filename);
+            ret = exporter.write(filename, m_batch.m_record_type, part.c_str());
+            break;
+        }
+        case STDF_BATCH_RESULTS:
+        {
+            StdfResultCache cache;
+            ret = cache.update(filename);
+            break;
+        }
+        case STDF_BATCH_STDF:
+            ret = copy_records(file, part.c_str());
+            break;
+        }
+        if(ret != STDF_OPERATE_OK) std::remove(part.c_str());
+        return ret;
+    }
+
+    // the records of the file in host byte order, MIR and MRR kept aside for the merge
+    STDF_FILE_ERROR copy_records(unsigned int file, const char* part)
+    {
+        StdfRecordCursor cursor;
+        if(!cursor.open(m_files[file].c_str())) return READ_ERROR;
+        StdfHeader header;
+        if(!cursor.next(header) || header.get_type() != FAR_TYPE) return FORMATE_ERROR;
+        StdfFAR far_record;
+        far_record.parse(header);
+        if(!STDF_CPU_TYPE_SUPPORTED(far_record.get_cpu_type())) return STDF_CPU_TYPE_NOT_SUPPORT;
+        if(far_record.get_stdf_version() != 4) return STDF_VERSION_NOT_SUPPORT;
+
+        StdfWriter writer;
+        STDF_FILE_ERROR ret = writer.open(part, m_batch.m_compression, m_batch.m_level);
+        if(ret != STDF_OPERATE_OK) return ret;
+
+        const bool swapped = cursor.is_swapped();
+        StdfRecord* records[STDF_V4_RECORD_COUNT] = {nullptr};
+        StdfHeader unparsed;
+        while(ret == STDF_OPERATE_OK && cursor.next(header))
+        {
+            STDF_TYPE type = header.get_type();
+            if(type == FAR_TYPE) continue;
+            const StdfHeader* out = &header;
+            if(swapped)
+            {
+                // the bytes of records of unknown layout can not be turned around, left out
+                if(type == UNKNOWN_TYPE) continue;
+                if(!records[type]) records[type] = header.create_record(type);
+                records[type]->parse(header);
+                records[type]->unparse(unparsed);
+                out = &unparsed;
+            }
+            if(type == MIR_TYPE || type == MRR_TYPE)
+            {
+                std::string& bytes = (type == MIR_TYPE) ? m_mir[file] : m_mrr[file];
+                bytes.resize(4 + out->get_length());
+                out->serialize(&bytes[0]);
+                continue;
+            }
+            ret = writer.write(*out);
+        }
+        for(int i = 0; i < STDF_V4_RECORD_COUNT; i++) delete records[i];
+        STDF_FILE_ERROR close_ret = writer.close();
+        return (ret != STDF_OPERATE_OK) ? ret : close_ret;
+    }
+
+    // appends the part of a finished file to the output, in the order of the files
+    STDF_FILE_ERROR merge(unsigned int file)
+    {
+        std::string part = part_name(file);
+        if(m_batch.m_results[file] != STDF_OPERATE_OK)
+        {
+            m_batch.m_failed++;
+            return STDF_OPERATE_OK;
+        }
+        STDF_FILE_ERROR ret = STDF_OPERATE_OK;
+        switch(m_mode)
+        {
+        case STDF_BATCH_TEXT:
+        {
+            std::string line = "FILE : " + m_files[file] + "\n";
+            ret = put(line.data(), line.size());
+            if(ret == STDF_OPERATE_OK) ret = append(part, false);
+            break;
+        }
+        case STDF_BATCH_PRR:
+            ret = append(part, false);
+            break;
+        case STDF_BATCH_CSV:
+            // the header row of the first file only
+            ret = append(part, m_head_written);
+            m_head_written = true;
+            break;
+        case STDF_BATCH_RESULTS:
+            m_sidecars.push_back(StdfResultCache::sidecar_name(m_files[file].c_str()));
+            break;
+        case STDF_BATCH_STDF:
+            if(!m_head_written)
+            {
+                ret = write_records(file, true);
+                m_head_written = true;
+            }
+            if(ret == STDF_OPERATE_OK) ret = append(part, false);
+            if(!m_mrr[file].empty()) m_last_mrr = file;
+            std::string().swap(m_mir[file]);
+            break;
+        }
+        std::remove(part.c_str());
+        return ret;
+    }
+
+    STDF_FILE_ERROR finish()
+    {
+        if(m_mode == STDF_BATCH_RESULTS)
+        {
+            if(m_sidecars.empty()) return STDF_OPERATE_OK;
+            STDF_FILE_ERROR ret = StdfResultCache::merge(m_sidecars, m_output.c_str());
+            unsigned long long size = 0;
+            long long mtime = 0;
+            if(ret == STDF_OPERATE_OK && file_info(m_output.c_str(), size, mtime)) m_batch.m_output_bytes = size;
+            return ret;
+        }
+        if(m_mode == STDF_BATCH_STDF && m_head_written && !m_mrr[m_last_mrr].empty())
+        {
+            return write_records(m_last_mrr, false);
+        }
+        return STDF_OPERATE_OK;
+    }
+
+    // head: FAR, ATR and the MIR of file, else the MRR of file, compressed as the parts
+    STDF_FILE_ERROR write_records(unsigned int file, bool head)
+    {
+        std::string part = m_output + (head ? ".head.part" : ".tail.part");
+        StdfWriter writer;
+        STDF_FILE_ERROR ret = writer.open(part.c_str(), m_batch.m_compression, m_batch.m_level);
+        if(ret != STDF_OPERATE_OK) return ret;
+        if(head)
+        {
+            StdfFAR far_record;
+            ret = writer.write(&far_record);
+            StdfATR atr;
+            atr.set_command_line("Merged By STDF Reader");
+            atr.set_modify_time(time(NULL));
+            if(ret == STDF_OPERATE_OK) ret = writer.write(&atr);
+        }
+        const std::string& bytes = head ? m_mir[file] : m_mrr[file];
+        StdfHeader header;
+        if(ret == STDF_OPERATE_OK && !bytes.empty() && header.map(bytes.data(), (unsigned int)bytes.size()))
+        {
+            ret = writer.write(header);
+        }
+        STDF_FILE_ERROR close_ret = writer.close();
+        if(ret == STDF_OPERATE_OK) ret = close_ret;
+        if(ret == STDF_OPERATE_OK) ret = append(part, false);
+        std::remove(part.c_str());
+        return ret;
+    }
+
+    STDF_FILE_ERROR put(const char* data, size_t size)
+    {
+        if(size && std::fwrite(data, 1, size, m_out) != size) return WRITE_ERROR;
+        m_batch.m_output_bytes += size;
+        return STDF_OPERATE_OK;
+    }
+
+    STDF_FILE_ERROR append(const std::string& part, bool skip_first_line)
+    {
+        std::FILE* in = std::fopen(part.c_str(), "rb");
+        if(!in) return READ_ERROR;
+        m_block.resize(STDF_BATCH_COPY_BLOCK);
+        STDF_FILE_ERROR ret = STDF_OPERATE_OK;
+        size_t count = 0;
+        while(ret == STDF_OPERATE_OK && (count = std::fread(&m_block[0], 1, m_block.size(), in)) > 0)
+        {
+            const char* data = &m_block[0];
+            if(skip_first_line)
+            {
+                const char* end = (const char*)std::memchr(data, '\n', count);
+                if(!end) continue;
+                count -= (size_t)(end + 1 - data);
+                data = end + 1;
+                skip_first_line = false;
+            }
+            ret = put(data, count);
+        }
+        if(std::ferror(in)) ret = READ_ERROR;
+        std::fclose(in);
+        return ret;
+    }
+
+    Run(const Run& src);
+    Run& operator=(const Run& src);
+
+private:
+    StdfBatch& m_batch;
+    STDF_BATCH_MODE m_mode;
+    const std::vector<std::string>& m_files;
+    std::string m_output;
+    std::vector<unsigned long long> m_sizes;
+
+    std::vector<Queue*> m_queues;
+    // m_done, m_reserved and m_batch.m_results are guarded by m_mutex
+    std::mutex m_mutex;
+    std::condition_variable m_done_condition;
+    std::condition_variable m_budget_condition;
+    std::vector<bool> m_done;
+    // STDF_BATCH_STDF: host byte order MIR/MRR of every file, written by its worker
+    std::vector<std::string> m_mir;
+    std::vector<std::string> m_mrr;
+    unsigned long long m_reserved;
+    std::atomic<bool> m_cancel;
+
+    // merge, only the calling thread
+    std::FILE* m_out;
+    bool m_head_written;
+    unsigned int m_last_mrr;
+    std::vector<std::string> m_sidecars;
+    std::vector<char> m_block;
+};
+
+//=============================================================
+StdfBatch::StdfBatch()
+{
+    m_threads = 0;
+    m_memory_budget = 2048ULL << 20;
+    m_record_type = PTR_TYPE;
+    m_compression = STDF_COMPRESS_NONE;
+    m_level = -1;
+    m_failed = 0;
+    m_input_bytes = 0;
+    m_output_bytes = 0;
+    m_peak_reserved = 0;
+}
+
+StdfBatch::~StdfBatch()
+{
+}
+
+bool StdfBatch::add_files(const char* argument, std::vector<std::string>& files)
+{
+    if(argument[0] == '@')
+    {
+        std::ifstream list(argument + 1);
+        if(!list) return false;
+        std::string line;
+        while(std::getline(list, line))
+        {
+            while(!line.empty() && (line[line.size() - 1] == '\r' || line[line.size() - 1] == ' ')) line.erase(line.size() - 1);
+            if(line.empty() || line[0] == '#') continue;
+            if(is_pattern(line.c_str())) add_matches(line.c_str(), files);
+            else files.push_back(line);
+        }
+        return true;
+    }
+    if(is_pattern(argument)) return add_matches(argument, files);
+    files.push_back(argument);
+    return true;
+}
+
+void StdfBatch::set_threads(unsigned int threads)
+{
+    m_threads = threads;
+}
+
+void StdfBatch::set_memory_budget(unsigned long long bytes)
+{
+    m_memory_budget = bytes;
+}
+
+void StdfBatch::set_record_type(STDF_TYPE type)
+{
+    m_record_type = type;
+}
+
+void StdfBatch::set_compression(STDF_COMPRESSION compression, int level)
+{
+    m_compression = compression;
+    m_level = level;
+}
+
+STDF_FILE_ERROR StdfBatch::run(STDF_BATCH_MODE mode, const std::vector<std::string>& files, const char* output)
+{
+    m_results.assign(files.size(), STDF_OPERATE_OK);
+    m_failed = 0;
+    m_input_bytes = 0;
+    m_output_bytes = 0;
+    m_peak_reserved = 0;
+
+    Run batch_run(*this, mode, files, output);
+    STDF_FILE_ERROR ret = batch_run.execute();
+    if(ret != STDF_OPERATE_OK) return ret;
+    for(unsigned int i = 0; i < m_results.size(); i++)
+    {
+        if(m_results[i] != STDF_OPERATE_OK) return m_results[i];
+    }
+    return STDF_OPERATE_OK;
+}
+
+STDF_FILE_ERROR StdfBatch::get_result(unsigned int file) const
+{
+    return (file < m_results.size()) ? m_results[file] : READ_ERROR;
+}
+
+unsigned int StdfBatch::get_failed_count() const
+{
+    return m_failed;
+}
+
+unsigned long long StdfBatch::get_input_bytes() const
+{
+    return m_input_bytes;
+}
+
+unsigned long long StdfBatch::get_output_bytes() const
+{
+    return m_output_bytes;
+}
+
+unsigned long long StdfBatch::get_peak_reserved() const
+{
+    return m_peak_reserved;
+}
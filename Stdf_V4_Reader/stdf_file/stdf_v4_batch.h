@@ -0,0 +1,90 @@
+/*************************************************************************
+ * Batch processing of many stdf files, e.g. all files of a lot, into one
+ * merged output. The files are shared out to worker threads that steal
+ * from each other when their own queue runs dry; every file writes its
+ * part of the output to "<output>.<n>.part" and the calling thread
+ * appends the parts to the output in the order of the file list as soon
+ * as they are done, so the output does not depend on the thread count.
+ * Before a file is started its memory is reserved from a budget; a file
+ * bigger than the budget runs when no other one does.
+*************************************************************************/
+#ifndef _STDF_V4_BATCH_H_
+#define _STDF_V4_BATCH_H_
+
+#include "stdf_v4_file.h"
+#include <string>
+#include <vector>
+
+enum STDF_BATCH_MODE : int
+{
+    // STDF_FILE::read + write, every record as text, a "FILE : <name>" line before each file
+    STDF_BATCH_TEXT = 0,
+    // one JSON object per PRR and line, the fields of the daemon's NDJSON output,
+    // with the modification time of the file as time stamps
+    STDF_BATCH_PRR = 1,
+    // StdfCsvExporter of one record type, with a FILE column in front, one header row
+    STDF_BATCH_CSV = 2,
+    // StdfResultCache::update of every file (the sidecars stay for the next run),
+    // then StdfResultCache::merge of the sidecars
+    STDF_BATCH_RESULTS = 3,
+    // One stdf file: a new FAR, an ATR, the MIR of the first file, the records of
+    // every file without FAR/MIR/MRR, the MRR of the last file. The summaries
+    // (PCR/HBR/SBR/TSR) stay those of each file. Compressed output is written as
+    // one gzip member / zstd frame per file by the workers.
+    STDF_BATCH_STDF = 4,
+};
+
+class StdfBatch
+{
+public:
+    StdfBatch();
+    ~StdfBatch();
+
+    // Appends the files of one command line argument: a file name, a pattern with
+    // * ? [ ] (the matches sorted by name) or "@list" with one file name per line.
+    // false if a pattern matches nothing or the list can not be read.
+    static bool add_files(const char* argument, std::vector<std::string>& files);
+
+    // 0 = one per core (default)
+    void set_threads(unsigned int threads);
+    // bytes the running files may take together, default 2 GB
+    void set_memory_budget(unsigned long long bytes);
+    // record type of STDF_BATCH_CSV, default PTR
+    void set_record_type(STDF_TYPE type);
+    // output of STDF_BATCH_STDF, see StdfWriter::open
+    void set_compression(STDF_COMPRESSION compression, int level = -1);
+
+    // Processes the files in mode and merges everything into output. A file that
+    // fails leaves no trace in the output, the others go on; returns the error of
+    // the first failed file then, WRITE_ERROR when the output can not be written.
+    STDF_FILE_ERROR run(STDF_BATCH_MODE mode, const std::vector<std::string>& files, const char* output);
+
+    // of the last run, in the order of the files
+    STDF_FILE_ERROR get_result(unsigned int file) const;
+    unsigned int get_failed_count() const;
+    unsigned long long get_input_bytes() const;
+    unsigned long long get_output_bytes() const;
+    // most memory reserved at one time
+    unsigned long long get_peak_reserved() const;
+
+private:
+    class Run;
+    friend class Run;
+    StdfBatch(const StdfBatch& src);
+    StdfBatch& operator=(const StdfBatch& src);
+
+private:
+    unsigned int m_threads;
+    unsigned long long m_memory_budget;
+    STDF_TYPE m_record_type;
+    STDF_COMPRESSION m_compression;
+    int m_level;
+
+    std::vector<STDF_FILE_ERROR> m_results;
+    unsigned int m_failed;
+    unsigned long long m_input_bytes;
+    unsigned long long m_output_bytes;
+    unsigned long long m_peak_reserved;
+};
+
+#endif//_STDF_V4_BATCH_H_
@@ -0,0 +1,961 @@
+#include "stdf_v4_columns.h"
+#include <cstdio>
+#include <cstdarg>
+#include <cmath>
+
+// large enough for any number or flag a cell gets
+#define STDF_CELL_NUMBER_SIZE 64
+
+static void append_vformat(std::string& text, const char* format, va_list args)
+{
+    char number[STDF_CELL_NUMBER_SIZE];
+    int length = std::vsnprintf(number, sizeof(number), format, args);
+    if(length > 0) text.append(number, (length < int(sizeof(number))) ? length : int(sizeof(number)) - 1);
+}
+
+static void append_format(std::string& text, const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    append_vformat(text, format, args);
+    va_end(args);
+}
+
+// The printf conversions of the cells by hand, with the same text: an export
+// formats tens of millions of numbers, vsnprintf was most of its time.
+
+// "%u"
+static void append_unsigned(std::string& text, unsigned long long value)
+{
+    char digits[20];
+    char* first = digits + sizeof(digits);
+    do
+    {
+        *--first = char('0' + value % 10);
+        value /= 10;
+    } while(value);
+    text.append(first, digits + sizeof(digits) - first);
+}
+
+// "%d"
+static void append_signed(std::string& text, long long value)
+{
+    if(value < 0)
+    {
+        text += '-';
+        append_unsigned(text, 0ULL - (unsigned long long)value);
+    }
+    else
+    {
+        append_unsigned(text, (unsigned long long)value);
+    }
+}
+
+// "0x%X"
+static void append_flag(std::string& text, unsigned int value)
+{
+    static const char HEX[] = "0123456789ABCDEF";
+    char digits[8];
+    char* first = digits + sizeof(digits);
+    do
+    {
+        *--first = HEX[value & 0xF];
+        value >>= 4;
+    } while(value);
+    text += "0x";
+    text.append(first, digits + sizeof(digits) - first);
+}
+
+// "%f": the exact value of the float rounded to 6 decimals, half to even, as
+// printf does. Values too large or too small for 64 bit fixed point, whose
+// binary point is more than 40 bits off, and inf and nan go to vsnprintf.
+static void append_fixed(std::string& text, float value)
+{
+    if(!std::isfinite(value))
+    {
+        append_format(text, "%f", value);
+        return;
+    }
+    int exponent;
+    float mantissa = std::frexp(std::fabs(value), &exponent);
+    // exact, a float has 24 bits: value = bits / 2^shift
+    unsigned long long bits = (unsigned long long)std::ldexp(mantissa, 24);
+    int shift = 24 - exponent;
+    if(shift < -40 || shift > 40)
+    {
+        append_format(text, "%f", value);
+        return;
+    }
+
+    unsigned long long integer, decimals = 0;
+    if(shift <= 0)
+    {
+        integer = bits << -shift;
+    }
+    else
+    {
+        unsigned long long mask = (1ULL << shift) - 1;
+        integer = bits >> shift;
+        unsigned long long scaled = (bits & mask) * 1000000ULL;
+        decimals = scaled >> shift;
+        unsigned long long rest = scaled & mask;
+        unsigned long long half = 1ULL << (shift - 1);
+        if(rest > half || (rest == half && (decimals & 1))) decimals++;
+        if(decimals == 1000000ULL)
+        {
+            decimals = 0;
+            integer++;
+        }
+    }
+
+    if(std::signbit(value)) text += '-';
+    append_unsigned(text, integer);
+    char fraction[7] = { '.', '0', '0', '0', '0', '0', '0' };
+    for(int i = 6; i > 0 && decimals; i--)
+    {
+        fraction[i] = char('0' + decimals % 10);
+        decimals /= 10;
+    }
+    text.append(fraction, sizeof(fraction));
+}
+
+void StdfRow::end_cell()
+{
+    m_ends.push_back((unsigned int)m_text.size());
+}
+
+void StdfRow::add_format(const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    append_vformat(m_text, format, args);
+    va_end(args);
+    end_cell();
+}
+
+void StdfRow::add(unsigned int value)
+{
+    append_unsigned(m_text, value);
+    end_cell();
+}
+
+void StdfRow::add(int value)
+{
+    append_signed(m_text, value);
+    end_cell();
+}
+
+void StdfRow::add(const char* value)
+{
+    if(value) m_text += value;
+    end_cell();
+}
+
+// as ctime() did, which is not reentrant: the export formats on its own thread
+void StdfRow::add(time_t value)
+{
+    static const char* const DAYS[] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+    static const char* const MONTHS[] =
+    {
+        "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"
+    };
+
+    struct tm local;
+#ifdef _WIN32
+    bool valid = (localtime_s(&local, &value) == 0);
+#else
+    bool valid = (localtime_r(&value, &local) != nullptr);
+#endif
+    if(!valid)
+    {
+        add("");
+        return;
+    }
+    add_format("%.3s %.3s%3d %.2d:%.2d:%.2d %d\n", DAYS[local.tm_wday], MONTHS[local.tm_mon],
+               local.tm_mday, local.tm_hour, local.tm_min, local.tm_sec, 1900 + local.tm_year);
+}
+
+void StdfRow::add(char value)
+{
+    add_format("%c", value);
+}
+
+void StdfRow::add(unsigned char value)
+{
+    append_unsigned(m_text, value);
+    end_cell();
+}
+
+void StdfRow::add(unsigned short value)
+{
+    append_unsigned(m_text, value);
+    end_cell();
+}
+
+void StdfRow::add(float value)
+{
+    append_fixed(m_text, value);
+    end_cell();
+}
+
+void StdfRow::add(short value)
+{
+    append_signed(m_text, value);
+    end_cell();
+}
+
+void StdfRow::add(signed char value)
+{
+    append_signed(m_text, value);
+    end_cell();
+}
+
+void StdfRow::add(const std::string& value)
+{
+    m_text += value;
+    end_cell();
+}
+
+void StdfRow::add_flag(unsigned char flag)
+{
+    append_flag(m_text, flag);
+    end_cell();
+}
+
+void StdfRow::clear()
+{
+    m_text.clear();
+    m_ends.clear();
+}
+
+unsigned int StdfRow::size() const
+{
+    return (unsigned int)m_ends.size();
+}
+
+const char* StdfRow::cell_data(unsigned int index) const
+{
+    return m_text.data() + (index ? m_ends[index - 1] : 0);
+}
+
+unsigned int StdfRow::cell_length(unsigned int index) const
+{
+    return m_ends[index] - (index ? m_ends[index - 1] : 0);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// helper for the cells listing the values of an array
+
+static void append_text(std::string& text, const char* value)
+{
+    if(value) text += value;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Column labels and row formatter of each record type
+
+static const char* const FAR_LABELS[] =
+{
+    "CPU_TYPE", "STDF_VER"
+};
+
+static void format_far(StdfRecord* stdf_record, const char*, StdfRow& row)
+{
+    StdfFAR* record = static_cast<StdfFAR*>(stdf_record);
+    row.add(record->get_cpu_type());     // CPU_TYPE
+    row.add(record->get_stdf_version()); // STDF_VER
+}
+
+static const char* const ATR_LABELS[] =
+{
+    "SETUP_T", "CMD_LINE"
+};
+
+static void format_atr(StdfRecord* stdf_record, const char*, StdfRow& row)
+{
+    StdfATR* record = static_cast<StdfATR*>(stdf_record);
+    row.add(record->get_modify_time());  // SETUP_T
+    row.add(record->get_command_line()); // CMD_LINE
+}
+
+static const char* const MIR_LABELS[] =
+{
+    "SETUP_T", "START_T", "STAT_NUM", "MODE_COD", "RTST_COD", "PROT_COD",
+    "BURN_TIM", "CMOD_COD", "LOT_ID  ", "PART_TYP", "NODE_NAM", "TSTR_TYP",
+    "JOB_NAM ", "JOB_REV ", "SBLOT_ID", "OPER_NAM", "EXEC_TYP", "EXEC_VER",
+    "TEST_COD", "TST_TEMP", "USER_TXT", "AUX_FILE", "PKG_TYP ", "FAMLY_ID",
+    "DATE_COD", "FACIL_ID", "FLOOR_ID", "PROC_ID ", "OPER_FRQ", "SPEC_NAM",
+    "SPEC_VER", "FLOW_ID ", "SETUP_ID", "DSGN_REV", "ENG_ID  ", "ROM_COD ",
+    "SERL_NUM", "SUPR_NAM"
+};
+
+static void format_mir(StdfRecord* stdf_record, const char*, StdfRow& row)
+{
+    StdfMIR* record = static_cast<StdfMIR*>(stdf_record);
+    row.add(record->get_setup_time());         // SETUP_T
+    row.add(record->get_start_time());         // START_T
+    row.add(record->get_station_number());     // STAT_NUM
+    row.add(record->get_mode_code());          // MODE_COD
+    row.add(record->get_retest_code());        // RTST_COD
+    row.add(record->get_protection_code());    // PROT_COD
+    row.add(record->get_burn_time());          // BURN_TIM
+    row.add(record->get_command_code());       // CMOD_COD
+    row.add(record->get_lot_id());             // LOT_ID
+    row.add(record->get_part_type());          // PART_TYP
+    row.add(record->get_node_name());          // NODE_NAM
+    row.add(record->get_tester_type());        // TSTR_TYP
+    row.add(record->get_program_name());       // JOB_NAM
+    row.add(record->get_program_revision());   // JOB_REV
+    row.add(record->get_sublot_id());          // SBLOT_ID
+    row.add(record->get_operator_id());        // OPER_NAM
+    row.add(record->get_exec_file_type());     // EXEC_TYP
+    row.add(record->get_exec_file_version());  // EXEC_VER
+    row.add(record->get_test_code());          // TEST_COD
+    row.add(record->get_test_temperature());   // TST_TEMP
+    row.add(record->get_user_text());          // USER_TXT
+    row.add(record->get_auxiliary_filename()); // AUX_FILE
+    row.add(record->get_package_type());       // PKG_TYP
+    row.add(record->get_family_id());          // FAMLY_ID
+    row.add(record->get_date_code());          // DATE_COD
+    row.add(record->get_facility_id());        // FACIL_ID
+    row.add(record->get_floor_id());           // FLOOR_ID
+    row.add(record->get_process_id());         // PROC_ID
+    row.add(record->get_operation_freq());     // OPER_FRQ
+    row.add(record->get_spec_name());          // SPEC_NAM
+    row.add(record->get_spec_version());       // SPEC_VER
+    row.add(record->get_testflow_id());        // FLOW_ID
+    row.add(record->get_setup_id());           // SETUP_ID
+    row.add(record->get_design_version());     // DSGN_REV
+    row.add(record->get_engineering_id());     // ENG_ID
+    row.add(record->get_rom_id());             // ROM_COD
+    row.add(record->get_tester_number());      // SERL_NUM
+    row.add(record->get_supervisor_name());    // SUPR_NAM
+}
+
+static const char* const MRR_LABELS[] =
+{
+    "FINISH_T", "DISP_COD", "USR_DESC", "EXC_DESC"
+};
+
+static void format_mrr(StdfRecord* stdf_record, const char*, StdfRow& row)
+{
+    StdfMRR* record = static_cast<StdfMRR*>(stdf_record);
+    row.add(record->get_finish_time());      // FINISH_T
+    row.add(record->get_disposition_code()); // DISP_COD
+    row.add(record->get_user_discription()); // USR_DESC
+    row.add(record->get_exec_discription()); // EXC_DESC
+}
+
+static const char* const PCR_LABELS[] =
+{
+    "HEAD_NUM", "SITE_NUM", "PART_CNT", "RTST_CNT", "ABRT_CNT", "GOOD_CNT",
+    "FUNC_CNT"
+};
+
+static void format_pcr(StdfRecord* stdf_record, const char*, StdfRow& row)
+{
+    StdfPCR* record = static_cast<StdfPCR*>(stdf_record);
+    row.add(record->get_head_number());     // HEAD_NUM
+    row.add(record->get_site_number());     // SITE_NUM
+    row.add(record->get_part_count());      // PART_CNT
+    row.add(record->get_retest_count());    // RTST_CNT
+    row.add(record->get_abort_count());     // ABRT_CNT
+    row.add(record->get_passed_count());    // GOOD_CNT
+    row.add(record->get_func_test_count()); // FUNC_CNT
+}
+
+static const char* const HBR_LABELS[] =
+{
+    "HEAD_NUM", "SITE_NUM", "HBIN_NUM", "HBIN_CNT", "HBIN_PF ", "HBIN_NAM"
+};
+
+static void format_hbr(StdfRecord* stdf_record, const char*, StdfRow& row)
+{
+    StdfHBR* record = static_cast<StdfHBR*>(stdf_record);
+    row.add(record->get_head_number());        //HEAD_NUM
+    row.add(record->get_site_number());        //SITE_NUM
+    row.add(record->get_hardbin_number());     //HBIN_NUM
+    row.add(record->get_hardbin_count());      //HBIN_CNT
+    row.add(record->get_hardbin_indication()); //HBIN_PF
+    row.add(record->get_hardbin_name());       //HBIN_NAM
+}
+
+static const char* const SBR_LABELS[] =
+{
+    "HEAD_NUM", "SITE_NUM", "SBIN_NUM", "SBIN_CNT", "SBIN_PF", "SBIN_NAM"
+};
+
+static void format_sbr(StdfRecord* stdf_record, const char*, StdfRow& row)
+{
+    StdfSBR* record = static_cast<StdfSBR*>(stdf_record);
+    row.add(record->get_head_number());        // HEAD_NUM
+    row.add(record->get_site_number());        // SITE_NUM
+    row.add(record->get_softbin_number());     // SBIN_NUM
+    row.add(record->get_softbin_count());      // SBIN_CNT
+    row.add(record->get_softbin_indication()); // SBIN_PF
+    row.add(record->get_softbin_name());       // SBIN_NAM
+}
+
+static const char* const PMR_LABELS[] =
+{
+    "PMR_INDX", "CHAN_TYP", "CHAN_NAM", "PHY_NAM", "LOG_NAM", "HEAD_NUM",
+    "SITE_NUM"
+};
+
+static void format_pmr(StdfRecord* stdf_record, const char*, StdfRow& row)
+{
+    StdfPMR* record = static_cast<StdfPMR*>(stdf_record);
+    row.add(record->get_pin_index());     // PMR_INDX
+    row.add(record->get_channel_type());  // CHAN_TYP
+    row.add(record->get_channel_name());  // CHAN_NAM
+    row.add(record->get_physical_name()); // PHY_NAM
+    row.add(record->get_logical_name());  // LOG_NAM
+    row.add(record->get_head_number());   // HEAD_NUM
+    row.add(record->get_site_number());   // SITE_NUM
+}
+
+static const char* const PGR_LABELS[] =
+{
+    "GRP_INDX", "GRP_NAM ", "INDX_CNT", "PMR_INDX"
+};
+
+static void format_pgr(StdfRecord* stdf_record, const char*, StdfRow& row)
+{
+    StdfPGR* record = static_cast<StdfPGR*>(stdf_record);
+    unsigned short pin_count = record->get_pin_count();
+    std::string pin_number_list;
+    for(unsigned short n = 0; n < pin_count; n++)
+    {
+        append_unsigned(pin_number_list, record->get_pin_number(n));
+        if(n != pin_count-1) pin_number_list += " ,";
+    }
+
+    row.add(record->get_group_index()); // GRP_INDX
+    row.add(record->get_group_name());  // GRP_NAM
+    row.add(pin_count);                 // INDX_CNT
+    row.add(pin_number_list);           // PMR_INDX
+}
+
+static const char* const PLR_LABELS[] =
+{
+    "GRP_CNT", "GRP_INDX", "GRP_MODE", "GRP_RADX", "PGM_CHAR", "RTN_CHAR",
+    "PGM_CHAL", "RTN_CHAL"
+};
+
+static void format_plr(StdfRecord* stdf_record, const char*, StdfRow& row)
+{
+    StdfPLR* record = static_cast<StdfPLR*>(stdf_record);
+    unsigned short group_count = record->get_group_count();
+    std::string group_number_list;
+    for(unsigned short n = 0; n < group_count; n++)
+    {
+        append_unsigned(group_number_list, record->get_group_number(n));
+        if(n != group_count-1) group_number_list += " ,";
+    }
+    std::string group_mode_list;
+    for(unsigned short n = 0; n < group_count; n++)
+    {
+        append_unsigned(group_mode_list, record->get_group_mode(n));
+        if(n != group_count-1) group_mode_list += " ,";
+    }
+
+    std::string group_radix_list;
+    for(unsigned short n = 0; n < group_count; n++)
+    {
+        append_unsigned(group_radix_list, record->get_group_radix(n));
+        if(n != group_count-1) group_radix_list += " ,";
+    }
+    std::string program_state_right_list;
+    for(unsigned short n = 0; n < group_count; n++)
+    {
+        append_text(program_state_right_list, record->get_program_state_right(n));
+        if(n != group_count-1) program_state_right_list += " ,";
+    }
+
+    std::string return_state_right_list;
+    for(unsigned short n = 0; n < group_count; n++)
+    {
+        append_text(return_state_right_list, record->get_return_state_right(n));
+        if(n != group_count-1) return_state_right_list += " ,";
+    }
+
+    std::string program_state_left_list;
+    for(unsigned short n = 0; n < group_count; n++)
+    {
+        append_text(program_state_left_list, record->get_program_state_left(n));
+        if(n != group_count-1) program_state_left_list += " ,";
+    }
+
+    std::string return_state_left_list;
+    for(unsigned short n = 0; n < group_count; n++)
+    {
+        append_text(return_state_left_list, record->get_return_state_left(n));
+        if(n != group_count-1) return_state_left_list += " ,";
+    }
+
+    row.add(group_count);              // GRP_CNT
+    row.add(group_number_list);        // GRP_INDX
+    row.add(group_mode_list);          // GRP_MODE
+    row.add(group_radix_list);         // GRP_RADX
+    row.add(program_state_right_list); // PGM_CHAR
+    row.add(return_state_right_list);  // RTN_CHAR
+    row.add(program_state_left_list);  // PGM_CHAL
+    row.add(return_state_left_list);   // RTN_CHAL
+}
+
+static const char* const RDR_LABELS[] =
+{
+    "NUM_BINS", "RTST_BIN"
+};
+
+static void format_rdr(StdfRecord* stdf_record, const char*, StdfRow& row)
+{
+    StdfRDR* record = static_cast<StdfRDR*>(stdf_record);
+    unsigned short bin_count = record->get_bin_count();
+    std::string bin_number_list;
+    for(unsigned short n = 0; n < bin_count; n++)
+    {
+        append_unsigned(bin_number_list, record->get_bin_number(n));
+        if(n != bin_count-1) bin_number_list += " ,";
+    }
+
+    row.add(bin_count);       // NUM_BINS
+    row.add(bin_number_list); // RTST_BIN
+}
+
+static const char* const SDR_LABELS[] =
+{
+    "HEAD_NUM", "SITE_GRP", "SITE_CNT", "SITE_NUM", "HAND_TYP", "HAND_ID ",
+    "CARD_TYP", "CARD_ID ", "LOAD_TYP", "LOAD_ID ", "DIB_TYP ", "DIB_ID  ",
+    "CABL_TYP", "CABL_ID ", "CONT_TYP", "CONT_ID ", "LASR_TYP", "LASR_ID ",
+    "EXTR_TYP", "EXTR_ID "
+};
+
+static void format_sdr(StdfRecord* stdf_record, const char*, StdfRow& row)
+{
+    StdfSDR* record = static_cast<StdfSDR*>(stdf_record);
+    unsigned int site_count = record->get_site_count();
+    std::string site_number_list;
+    for(unsigned int k = 0; k < site_count; k++)
+    {
+        append_unsigned(site_number_list, record->get_site_number(k));
+        if(k != site_count-1) site_number_list += ", ";
+    }
+
+    row.add(record->get_head_number());       // HEAD_NUM
+    row.add(record->get_site_group_number()); // SITE_GRP
+    row.add(site_count);                      // SITE_CNT
+    row.add(site_number_list);                // SITE_NUM
+    row.add(record->get_handler_type());      // HAND_TYP
+    row.add(record->get_handler_id());        // HAND_ID
+    row.add(record->get_probecard_type());    // CARD_TYP
+    row.add(record->get_probecard_id());      // CARD_ID
+    row.add(record->get_loadboard_type());    // LOAD_TYP
+    row.add(record->get_loadboard_id());      // LOAD_ID
+    row.add(record->get_dibboard_type());     // DIB_TYP
+    row.add(record->get_dibboard_id());       // DIB_ID
+    row.add(record->get_cable_type());        // CABL_TYP
+    row.add(record->get_cable_id());          // CABL_ID
+    row.add(record->get_contactor_type());    // CONT_TYP
+    row.add(record->get_contactor_id());      // CONT_ID
+    row.add(record->get_laser_type());        // LASR_TYP
+    row.add(record->get_laser_id());          // LASR_ID
+    row.add(record->get_equipment_type());    // EXTR_TYP
+    row.add(record->get_equipment_id());      // EXTR_ID
+}
+
+static const char* const WIR_LABELS[] =
+{
+    "HEAD_NUM", "SITE_GRP", "START_T", "WAFER_ID"
+};
+
+static void format_wir(StdfRecord* stdf_record, const char*, StdfRow& row)
+{
+    StdfWIR* record = static_cast<StdfWIR*>(stdf_record);
+    row.add(record->get_head_number());  // HEAD_NUM
+    row.add(record->get_group_number()); // SITE_GRP
+    row.add(record->get_start_time());   // START_T
+    row.add(record->get_wafer_id());     // WAFER_ID
+}
+
+static const char* const WRR_LABELS[] =
+{
+    "HEAD_NUM", "SITE_GRP", "FINISH_T", "PART_CNT", "RTST_CNT", "ABRT_CNT",
+    "GOOD_CNT", "FUNC_CNT", "WAFER_ID", "FABWF_ID", "FRAME_ID", "MASK_ID",
+    "USR_DESC", "EXC_DESC"
+};
+
+static void format_wrr(StdfRecord* stdf_record, const char*, StdfRow& row)
+{
+    StdfWRR* record = static_cast<StdfWRR*>(stdf_record);
+    row.add(record->get_head_number());      // HEAD_NUM
+    row.add(record->get_group_number());     // SITE_GRP
+    row.add(record->get_finish_time());      // FINISH_T
+    row.add(record->get_part_count());       // PART_CNT
+    row.add(record->get_retest_count());     // RTST_CNT
+    row.add(record->get_abort_count());      // ABRT_CNT
+    row.add(record->get_pass_count());       // GOOD_CNT
+    row.add(record->get_func_count());       // FUNC_CNT
+    row.add(record->get_wafer_id());         // WAFER_ID
+    row.add(record->get_fabwafer_id());      // FABWF_ID
+    row.add(record->get_frame_id());         // FRAME_ID
+    row.add(record->get_mask_id());          // MASK_ID
+    row.add(record->get_user_discription()); // USR_DESC
+    row.add(record->get_exec_discription()); // EXC_DESC
+}
+
+static const char* const WCR_LABELS[] =
+{
+    "WAFR_SIZ", "DIE_HT", "DIE_WID", "WF_UNITS", "WF_FLAT", "CENTER_X",
+    "CENTER_Y", "POS_X", "POS_Y"
+};
+
+static void format_wcr(StdfRecord* stdf_record, const char*, StdfRow& row)
+{
+    StdfWCR* record = static_cast<StdfWCR*>(stdf_record);
+    std::string wafer_unit;
+    unsigned char unit_code = record->get_wafer_unit();
+    switch(unit_code)
+    {
+    case 1: wafer_unit = "Inches"; break;
+    case 2: wafer_unit = "Centimeters"; break;
+    case 3: wafer_unit = "Millimeters"; break;
+    case 4: wafer_unit = "Mils"; break;
+    default: wafer_unit = "Unknown"; break;
+    }
+
+    row.add(record->get_wafer_size()); // WAFR_SIZ
+    row.add(record->get_die_height()); // DIE_HT
+    row.add(record->get_die_width());  // DIE_WID
+    row.add(wafer_unit);               // WF_UNITS
+    row.add(record->get_wafer_flat()); // WF_FLAT
+    row.add(record->get_center_x());   // CENTER_X
+    row.add(record->get_center_y());   // CENTER_Y
+    row.add(record->get_positive_x()); // POS_X
+    row.add(record->get_positive_y()); // POS_Y
+}
+
+static const char* const PIR_LABELS[] =
+{
+    "HEAD_NUM", "SITE_NUM"
+};
+
+static void format_pir(StdfRecord* stdf_record, const char*, StdfRow& row)
+{
+    StdfPIR* record = static_cast<StdfPIR*>(stdf_record);
+    row.add(record->get_head_number()); // HEAD_NUM
+    row.add(record->get_site_number()); // SITE_NUM
+}
+
+static const char* const PRR_LABELS[] =
+{
+    "HEAD_NUM", "SITE_NUM", "PART_FLG", "NUM_TEST", "HARD_BIN", "SOFT_BIN",
+    "X_COORD", "Y_COORD", "TEST_T(MS)", "PART_ID", "PART_TXT"
+};
+
+static void format_prr(StdfRecord* stdf_record, const char*, StdfRow& row)
+{
+    StdfPRR* record = static_cast<StdfPRR*>(stdf_record);
+    row.add(record->get_head_number());                // HEAD_NUM
+    row.add(record->get_site_number());                // SITE_NUM
+    row.add_flag(record->get_part_information_flag()); // PART_FLG
+    row.add(record->get_number_test());                // NUM_TEST
+    row.add(record->get_hardbin_number());             // HARD_BIN
+    row.add(record->get_softbin_number());             // SOFT_BIN
+    row.add(record->get_x_coordinate());               // X_COORD
+    row.add(record->get_y_coordinate());               // Y_COORD
+    row.add(record->get_elapsed_ms());                 // TEST_T(MS)
+    row.add(record->get_part_id());                    // PART_ID
+    row.add(record->get_part_discription());           // PART_TXT
+}
+
+static const char* const TSR_LABELS[] =
+{
+    "HEAD_NUM", "SITE_NUM", "TEST_TYP", "TEST_NUM", "EXEC_CNT", "FAIL_CNT",
+    "ALRM_CNT", "TEST_NAM", "SEQ_NAME", "TEST_LBL", "OPT_FLAG", "TEST_TIM(S)",
+    "TEST_MIN", "TEST_MAX", "TST_SUMS", "TST_SQRS"
+};
+
+static void format_tsr(StdfRecord* stdf_record, const char*, StdfRow& row)
+{
+    StdfTSR* record = static_cast<StdfTSR*>(stdf_record);
+    row.add(record->get_head_number());             // HEAD_NUM
+    row.add(record->get_site_number());             // SITE_NUM
+    row.add(record->get_test_type());               // TEST_TYP
+    row.add(record->get_test_number());             // TEST_NUM
+    row.add(record->get_exec_count());              // EXEC_CNT
+    row.add(record->get_fail_count());              // FAIL_CNT
+    row.add(record->get_alarm_count());             // ALRM_CNT
+    row.add(record->get_test_name());               // TEST_NAM
+    row.add(record->get_sequencer_name());          // SEQ_NAME
+    row.add(record->get_test_label());              // TEST_LBL
+    row.add_flag(record->get_optional_data_flag()); // OPT_FLAG
+    row.add(record->get_average_time_s());          // TEST_TIM(S)
+    row.add(record->get_result_min());              // TEST_MIN
+    row.add(record->get_result_max());              // TEST_MAX
+    row.add(record->get_result_sum());              // TST_SUMS
+    row.add(record->get_result_squares_sum());      // TST_SQRS
+}
+
+static const char* const PTR_LABELS[] =
+{
+    "Part ID", "TEST_NUM", "HEAD_NUM", "SITE_NUM", "TEST_FLG", "PARM_FLG",
+    "RESULT", "TEST_TXT", "ALARM_ID", "OPT_FLAG", "RES_SCAL", "LLM_SCAL",
+    "HLM_SCAL", "LO_LIMIT", "HI_LIMIT", "UNITS", "C_RESFMT", "C_LLMFMT",
+    "C_HLMFMT", "LO_SPEC", "HI_SPEC"
+};
+
+static void format_ptr(StdfRecord* stdf_record, const char* part_id, StdfRow& row)
+{
+    StdfPTR* record = static_cast<StdfPTR*>(stdf_record);
+    row.add(part_id);
+    row.add(record->get_test_number());               // TEST_NUM
+    row.add(record->get_head_number());               // HEAD_NUM
+    row.add(record->get_site_number());               // SITE_NUM
+    row.add_flag(record->get_test_flag());            // TEST_FLG
+    row.add_flag(record->get_parametric_test_flag()); // PARM_FLG
+    row.add(record->get_result());                    // RESULT
+    row.add(record->get_test_text());                 // TEST_TXT
+    row.add(record->get_alarm_id());                  // ALARM_ID
+    row.add_flag(record->get_optional_data_flag());   // OPT_FLAG
+    row.add(record->get_result_exponent());           // RES_SCAL
+    row.add(record->get_lowlimit_exponent());         // LLM_SCAL
+    row.add(record->get_highlimit_exponent());        // HLM_SCAL
+    row.add(record->get_low_limit());                 // LO_LIMIT
+    row.add(record->get_high_limit());                // HI_LIMIT
+    row.add(record->get_unit());                      // UNITS
+    row.add(record->get_result_format());             // C_RESFMT
+    row.add(record->get_lowlimit_format());           // C_LLMFMT
+    row.add(record->get_highlimit_format());          // C_HLMFMT
+    row.add(record->get_low_spec());                  // LO_SPEC
+    row.add(record->get_high_spec());                 // HI_SPEC
+}
+
+static const char* const MPR_LABELS[] =
+{
+    "TEST_NUM", "HEAD_NUM", "SITE_NUM", "TEST_FLG", "PARM_FLG", "RTN_ICNT",
+    "RSLT_CNT", "RTN_STAT", "RTN_RSLT", "TEST_TXT", "ALARM_ID", "OPT_FLAG",
+    "RES_SCAL", "LLM_SCAL", "HLM_SCAL", "LO_LIMIT", "HI_LIMIT", "START_IN",
+    "INCR_IN", "RTN_INDX", "UNITS", "UNITS_IN", "C_RESFMT", "C_LLMFMT",
+    "C_HLMFMT", "LO_SPEC", "HI_SPEC"
+};
+
+static void format_mpr(StdfRecord* stdf_record, const char*, StdfRow& row)
+{
+    StdfMPR* record = static_cast<StdfMPR*>(stdf_record);
+    unsigned short pin_count = record->get_pin_count();
+    std::string return_state_list;
+    for(unsigned short n = 0; n < pin_count; n++)
+    {
+        append_unsigned(return_state_list, record->get_return_state(n));
+        if(n != pin_count-1) return_state_list += ", ";
+    }
+    std::string pin_index_list;
+    for(unsigned short n = 0; n < pin_count; n++)
+    {
+        append_unsigned(pin_index_list, record->get_pin_index(n));
+        if(n != pin_count-1) pin_index_list += ", ";
+    }
+
+    unsigned short result_count = record->get_result_count();
+    std::string return_result_list;
+    for(unsigned short n = 0; n < result_count; n++)
+    {
+        append_fixed(return_result_list, record->get_return_result(n));
+        if(n != result_count-1) return_result_list += ", ";
+    }
+
+    row.add(record->get_test_number());               // TEST_NUM
+    row.add(record->get_head_number());               // HEAD_NUM
+    row.add(record->get_site_number());               // SITE_NUM
+    row.add_flag(record->get_test_flag());            // TEST_FLG
+    row.add_flag(record->get_parametric_test_flag()); // PARM_FLG
+    row.add(pin_count);                               // RTN_ICNT
+    row.add(result_count);                            // RSLT_CNT
+    row.add(return_state_list);                       // RTN_STAT
+    row.add(return_result_list);                      // RTN_RSLT
+    row.add(record->get_test_text());                 // TEST_TXT
+    row.add(record->get_alarm_id());                  // ALARM_ID
+    row.add_flag(record->get_optional_data_flag());   // OPT_FLAG
+    row.add(record->get_result_exponent());           // RES_SCAL
+    row.add(record->get_lowlimit_exponent());         // LLM_SCAL
+    row.add(record->get_highlimit_exponent());        // HLM_SCAL
+    row.add(record->get_low_limit());                 // LO_LIMIT
+    row.add(record->get_high_limit());                // HI_LIMIT
+    row.add(record->get_starting_input());            // START_IN
+    row.add(record->get_increment_input());           // INCR_IN
+    row.add(pin_index_list);                          // RTN_INDX
+    row.add(record->get_unit());                      // UNITS
+    row.add(record->get_unit_input());                // UNITS_IN
+    row.add(record->get_result_format());             // C_RESFMT
+    row.add(record->get_lowlimit_format());           // C_LLMFMT
+    row.add(record->get_highlimit_format());          // C_HLMFMT
+    row.add(record->get_low_spec());                  // LO_SPEC
+    row.add(record->get_high_spec());                 // HI_SPEC
+}
+
+static const char* const FTR_LABELS[] =
+{
+    "TEST_NUM", "HEAD_NUM", "SITE_NUM", "TEST_FLG", "OPT_FLAG", "CYCL_CNT",
+    "REL_VADR", "REPT_CNT", "NUM_FAIL", "XFAIL_AD", "YFAIL_AD", "VECT_OFF",
+    "RTN_ICNT", "PGM_ICNT", "RTN_INDX", "RTN_STAT", "PGM_INDX", "PGM_STAT",
+    "FAIL_PIN", "VECT_NAM", "TIME_SET", "OP_CODE", "TEST_TXT", "ALARM_ID",
+    "PROG_TXT", "RSLT_TXT", "PATG_NUM", "SPIN_MAP"
+};
+
+static void format_ftr(StdfRecord* stdf_record, const char*, StdfRow& row)
+{
+    StdfFTR* record = static_cast<StdfFTR*>(stdf_record);
+    unsigned short pin_count = record->get_pin_count();
+    std::string pin_number_list;
+    for(unsigned short n = 0; n < pin_count; n++)
+    {
+        append_unsigned(pin_number_list, record->get_pin_number(n));
+        if(n != pin_count-1) pin_number_list += ", ";
+    }
+
+    std::string pin_state_list;
+    for(unsigned short n = 0; n < pin_count; n++)
+    {
+        append_unsigned(pin_state_list, record->get_pin_state(n));
+        if(n != pin_count-1) pin_state_list += ", ";
+    }
+
+    unsigned short program_state_count = record->get_program_state_count();
+    std::string program_index_list;
+    for(unsigned short n = 0; n < program_state_count; n++)
+    {
+        append_unsigned(program_index_list, record->get_program_index(n));
+        if(n != program_state_count-1) program_index_list += ", ";
+    }
+
+    std::string program_state_list;
+    for(unsigned short n = 0; n < program_state_count; n++)
+    {
+        append_unsigned(program_state_list, record->get_program_state(n));
+        if(n != program_state_count-1) program_state_list += ", ";
+    }
+
+    std::string failpin_data_list;
+    for(unsigned short n = 0; n < record->get_failpin_data_count(); n++)
+    {
+        append_unsigned(failpin_data_list, record->get_failpin_data(n));
+    }
+
+    std::string bitmap_data_bits;
+    for(unsigned short n = 0; n < record->get_bitmap_data_count(); n++)
+    {
+        append_unsigned(bitmap_data_bits, record->get_bitmap_data(n));
+    }
+
+    row.add(record->get_test_number());             // TEST_NUM
+    row.add(record->get_head_number());             // HEAD_NUM
+    row.add(record->get_site_number());             // SITE_NUM
+    row.add_flag(record->get_test_flag());          // TEST_FLG
+    row.add_flag(record->get_optional_data_flag()); // OPT_FLAG
+    row.add(record->get_cycle_count());             // CYCL_CNT
+    row.add(record->get_relative_address());        // REL_VADR
+    row.add(record->get_repeat_count());            // REPT_CNT
+    row.add(record->get_failpin_count());           // NUM_FAIL
+    row.add(record->get_xfail_address());           // XFAIL_AD
+    row.add(record->get_yfail_address());           // YFAIL_AD
+    row.add(record->get_vector_offset());           // VECT_OFF
+    row.add(pin_count);                             // RTN_ICNT
+    row.add(program_state_count);                   // PGM_ICNT
+    row.add(pin_number_list);                       // RTN_INDX
+    row.add(pin_state_list);                        // RTN_STAT
+    row.add(program_index_list);                    // PGM_INDX
+    row.add(program_state_list);                    // PGM_STAT
+    row.add(failpin_data_list);                     // FAIL_PIN
+    row.add(record->get_vector_pattern_name());     // VECT_NAM
+    row.add(record->get_timeset_name());            // TIME_SET
+    row.add(record->get_vector_op_code());          // OP_CODE
+    row.add(record->get_test_text());               // TEST_TXT
+    row.add(record->get_alarm_id());                // ALARM_ID
+    row.add(record->get_program_text());            // PROG_TXT
+    row.add(record->get_result_text());             // RSLT_TXT
+    row.add(record->get_pattern_genertor_number()); // PATG_NUM
+    row.add(bitmap_data_bits);                      // SPIN_MAP
+}
+
+static const char* const BPS_LABELS[] =
+{
+    "SEQ_NAME"
+};
+
+static void format_bps(StdfRecord* stdf_record, const char*, StdfRow& row)
+{
+    StdfBPS* record = static_cast<StdfBPS*>(stdf_record);
+    row.add(record->get_section_name()); // SEQ_NAME
+}
+
+static const char* const EPS_LABELS[] =
+{
+    "EPS"
+};
+
+static void format_eps(StdfRecord*, const char*, StdfRow& row)
+{
+    row.add("EPS");
+}
+
+static const char* const GDR_LABELS[] =
+{
+    "FLD_CNT", "GEN_DATA"
+};
+
+static void format_gdr(StdfRecord* stdf_record, const char*, StdfRow& row)
+{
+    StdfGDR* record = static_cast<StdfGDR*>(stdf_record);
+    row.add(record->get_data_count()); // FLD_CNT
+    row.add("Not Parse.");    // GEN_DATA
+}
+
+static const char* const DTR_LABELS[] =
+{
+    "TEXT_DAT"
+};
+
+static void format_dtr(StdfRecord* stdf_record, const char*, StdfRow& row)
+{
+    StdfDTR* record = static_cast<StdfDTR*>(stdf_record);
+    row.add(record->get_text_data()); // TEXT_DAT
+}
+
+#define STDF_COLUMNS_OF(name, format) { #name, name##_LABELS, int(sizeof(name##_LABELS) / sizeof(name##_LABELS[0])), format }
+
+// in STDF_TYPE order
+static const StdfColumns STDF_COLUMNS[STDF_V4_RECORD_COUNT] =
+{
+    STDF_COLUMNS_OF(FAR, format_far),
+    STDF_COLUMNS_OF(ATR, format_atr),
+    STDF_COLUMNS_OF(MIR, format_mir),
+    STDF_COLUMNS_OF(MRR, format_mrr),
+    STDF_COLUMNS_OF(PCR, format_pcr),
+    STDF_COLUMNS_OF(HBR, format_hbr),
+    STDF_COLUMNS_OF(SBR, format_sbr),
+    STDF_COLUMNS_OF(PMR, format_pmr),
+    STDF_COLUMNS_OF(PGR, format_pgr),
+    STDF_COLUMNS_OF(PLR, format_plr),
+    STDF_COLUMNS_OF(RDR, format_rdr),
+    STDF_COLUMNS_OF(SDR, format_sdr),
+    STDF_COLUMNS_OF(WIR, format_wir),
+    STDF_COLUMNS_OF(WRR, format_wrr),
+    STDF_COLUMNS_OF(WCR, format_wcr),
+    STDF_COLUMNS_OF(PIR, format_pir),
+    STDF_COLUMNS_OF(PRR, format_prr),
+    STDF_COLUMNS_OF(TSR, format_tsr),
+    STDF_COLUMNS_OF(PTR, format_ptr),
+    STDF_COLUMNS_OF(MPR, format_mpr),
+    STDF_COLUMNS_OF(FTR, format_ftr),
+    STDF_COLUMNS_OF(BPS, format_bps),
+    STDF_COLUMNS_OF(EPS, format_eps),
+    STDF_COLUMNS_OF(GDR, format_gdr),
+    STDF_COLUMNS_OF(DTR, format_dtr),
+};
+
+const StdfColumns* stdf_columns(STDF_TYPE type)
+{
+    if(type < 0 || type >= STDF_V4_RECORD_COUNT) return nullptr;
+    return &STDF_COLUMNS[type];
+}
@@ -0,0 +1,62 @@
+/*************************************************************************
+ * The table columns of each record type: the labels, and a formatter
+ * that turns a record into one row of text cells. Shared by the record
+ * table of the viewer and the CSV export, so both show the same values.
+*************************************************************************/
+#ifndef _STDF_V4_COLUMNS_H_
+#define _STDF_V4_COLUMNS_H_
+
+#include "stdf_v4_file.h"
+#include <string>
+#include <vector>
+#include <ctime>
+
+// The cells of one table row, each value formatted by the type it has.
+// The cells are kept back to back in one string, clear() keeps the memory
+// for the next row.
+class StdfRow
+{
+public:
+    void add(unsigned int value);
+    void add(int value);
+    void add(unsigned short value);
+    void add(const char* value);
+    void add(time_t value);
+    void add(char value);
+    void add(unsigned char value);
+    void add(signed char value);
+    void add(float value);
+    void add(short value);
+    void add(const std::string& value);
+    void add_flag(unsigned char flag);
+
+    void clear();
+    unsigned int size() const;
+    // cell index, not 0 terminated
+    const char* cell_data(unsigned int index) const;
+    unsigned int cell_length(unsigned int index) const;
+
+private:
+    void end_cell();
+    void add_format(const char* format, ...);
+
+private:
+    std::string m_text;
+    std::vector<unsigned int> m_ends;
+};
+
+// part_id: PTR rows only, the PART_ID of the PRR closing the part of the test
+typedef void (*StdfRowFormatter)(StdfRecord* record, const char* part_id, StdfRow& row);
+
+struct StdfColumns
+{
+    const char* name;            // record name, "PTR"
+    const char* const* labels;
+    int count;
+    StdfRowFormatter format;
+};
+
+// nullptr for UNKNOWN_TYPE
+const StdfColumns* stdf_columns(STDF_TYPE type);
+
+#endif//_STDF_V4_COLUMNS_H_
@@ -0,0 +1,282 @@
+#include "stdf_v4_csv.h"
+
+// records between two updates of the progress counters
+#define STDF_CSV_PROGRESS_STEP 4096
+
+class StdfCsvExporter::RecordVisitor : public StdfRecordVisitor
+{
+public:
+    explicit RecordVisitor(StdfCsvExporter& exporter) : m_exporter(exporter) {}
+    bool visit(StdfRecord* record, unsigned long long)
+    {
+        return m_exporter.add_record(record);
+    }
+
+private:
+    StdfCsvExporter& m_exporter;
+};
+
+StdfCsvExporter::StdfCsvExporter(unsigned int buffer_size) :
+    m_running(false), m_cancel(false), m_rows(0), m_records_done(0), m_records_total(0)
+{
+    if(buffer_size < 4096U) buffer_size = 4096U;
+    m_buffer.resize(buffer_size);
+    m_used = 0;
+    m_file = nullptr;
+    m_failed = false;
+    m_type = UNKNOWN_TYPE;
+    m_columns = nullptr;
+    m_part_row_count = 0;
+    m_written = 0;
+    m_visited = 0;
+    m_has_file_column = false;
+    m_result = STDF_OPERATE_OK;
+}
+
+StdfCsvExporter::~StdfCsvExporter()
+{
+    cancel();
+    wait();
+    close();
+}
+
+STDF_FILE_ERROR StdfCsvExporter::write(STDF_FILE& file, STDF_TYPE type, const char* csv_filename)
+{
+    STDF_FILE_ERROR ret = open(type, csv_filename);
+    if(ret != STDF_OPERATE_OK) return ret;
+
+    unsigned int record_count = file.get_total_count();
+    m_records_total = record_count;
+    for(unsigned int n = 0; n < record_count; n++)
+    {
+        if(!add_record(file.get_record(n))) break;
+    }
+    return close();
+}
+
+STDF_FILE_ERROR StdfCsvExporter::write(const char* stdf_filename, STDF_TYPE type, const char* csv_filename)
+{
+    STDF_FILE_ERROR ret = open(type, csv_filename);
+    if(ret != STDF_OPERATE_OK) return ret;
+
+    unsigned int type_mask = STDF_TYPE_MASK(type);
+    if(type == PTR_TYPE) type_mask |= STDF_TYPE_MASK(PIR_TYPE) | STDF_TYPE_MASK(PRR_TYPE);
+    RecordVisitor visitor(*this);
+    ret = STDF_FILE::scan(stdf_filename, visitor, type_mask);
+    STDF_FILE_ERROR close_ret = close();
+    return (ret != STDF_OPERATE_OK) ? ret : close_ret;
+}
+
+void StdfCsvExporter::set_file_column(const char* text)
+{
+    m_has_file_column = (text != nullptr);
+    m_file_column.assign(text ? text : "");
+}
+
+bool StdfCsvExporter::start(STDF_FILE* file, STDF_TYPE type, const char* csv_filename)
+{
+    if(m_thread.joinable() || !file) return false;
+
+    m_running = true;
+    m_cancel = false;
+    m_result = STDF_OPERATE_OK;
+    m_thread = std::thread(&StdfCsvExporter::run, this, file, type, std::string(csv_filename));
+    return true;
+}
+
+void StdfCsvExporter::run(STDF_FILE* file, STDF_TYPE type, std::string csv_filename)
+{
+    m_result = write(*file, type, csv_filename.c_str());
+    m_running = false;
+}
+
+void StdfCsvExporter::cancel()
+{
+    m_cancel = true;
+}
+
+void StdfCsvExporter::wait()
+{
+    if(m_thread.joinable()) m_thread.join();
+}
+
+STDF_FILE_ERROR StdfCsvExporter::open(STDF_TYPE type, const char* csv_filename)
+{
+    close();
+    m_columns = stdf_columns(type);
+    if(!m_columns) return WRITE_ERROR;
+    m_file = std::fopen(csv_filename, "wb");
+    if(!m_file) return WRITE_ERROR;
+    // the buffer is large already, stdio would only copy it once more
+    std::setvbuf(m_file, nullptr, _IONBF, 0);
+
+    m_type = type;
+    m_used = 0;
+    m_failed = false;
+    m_part_row_count = 0;
+    m_written = 0;
+    m_visited = 0;
+    m_rows = 0;
+    m_records_done = 0;
+    m_records_total = 0;
+
+    if(m_has_file_column)
+    {
+        put("FILE", 4);
+        put(',');
+    }
+    for(int i = 0; i < m_columns->count; i++)
+    {
+        const char* label = m_columns->labels[i];
+        put(label, (unsigned int)std::char_traits<char>::length(label));
+        put(',');
+    }
+    put('\n');
+    return STDF_OPERATE_OK;
+}
+
+STDF_FILE_ERROR StdfCsvExporter::close()
+{
+    if(!m_file) return STDF_OPERATE_OK;
+
+    flush();
+    if(std::fclose(m_file) != 0) m_failed = true;
+    m_file = nullptr;
+    m_rows = m_written;
+    m_records_done = m_visited;
+    return m_failed ? WRITE_ERROR : STDF_OPERATE_OK;
+}
+
+// PTRs as RecordTableModel orders them: the PTRs since the last PIR come once per
+// PRR, the ones of a part without PRR are left out
+bool StdfCsvExporter::add_record(StdfRecord* record)
+{
+    STDF_TYPE type = record->type();
+    if(type == m_type)
+    {
+        if(type == PTR_TYPE)
+        {
+            if(m_part_row_count == m_part_rows.size()) m_part_rows.push_back(StdfRow());
+            StdfRow& row = m_part_rows[m_part_row_count++];
+            row.clear();
+            m_columns->format(record, nullptr, row);
+        }
+        else
+        {
+            m_row.clear();
+            m_columns->format(record, nullptr, m_row);
+            put_file_column();
+            put_row(m_row, 0);
+            m_written++;
+        }
+    }
+    else if(m_type == PTR_TYPE && type == PIR_TYPE)
+    {
+        m_part_row_count = 0;
+    }
+    else if(m_type == PTR_TYPE && type == PRR_TYPE)
+    {
+        put_part_tests(static_cast<StdfPRR*>(record)->get_part_id());
+    }
+
+    if(++m_visited % STDF_CSV_PROGRESS_STEP == 0)
+    {
+        m_rows = m_written;
+        m_records_done = m_visited;
+    }
+    return !m_cancel && !m_failed;
+}
+
+// the rows were formatted without PART_ID, the first cell is left empty then
+void StdfCsvExporter::put_part_tests(const char* part_id)
+{
+    unsigned int part_id_length = part_id ? (unsigned int)std::char_traits<char>::length(part_id) : 0;
+    for(unsigned int i = 0; i < m_part_row_count; i++)
+    {
+        put_file_column();
+        put(part_id, part_id_length);
+        put(',');
+        put_row(m_part_rows[i], 1);
+    }
+    m_written += m_part_row_count;
+}
+
+void StdfCsvExporter::put_file_column()
+{
+    if(!m_has_file_column) return;
+    put(m_file_column.data(), (unsigned int)m_file_column.size());
+    put(',');
+}
+
+void StdfCsvExporter::put_row(const StdfRow& row, unsigned int first_cell)
+{
+    for(unsigned int i = first_cell; i < row.size(); i++)
+    {
+        put(row.cell_data(i), row.cell_length(i));
+        put(',');
+    }
+    put('\n');
+}
+
+// As the table export always did, a comma in a value becomes a space. So do line
+// breaks, the times end with one.
+void StdfCsvExporter::put(const char* text, unsigned int length)
+{
+    while(length > 0)
+    {
+        if(m_used == m_buffer.size()) flush();
+        unsigned int count = (unsigned int)m_buffer.size() - m_used;
+        if(count > length) count = length;
+        char* out = &m_buffer[m_used];
+        for(unsigned int i = 0; i < count; i++)
+        {
+            char c = text[i];
+            out[i] = (c == ',' || c == '\n' || c == '\r') ? ' ' : c;
+        }
+        m_used += count;
+        text += count;
+        length -= count;
+    }
+}
+
+void StdfCsvExporter::put(char c)
+{
+    if(m_used == m_buffer.size()) flush();
+    m_buffer[m_used++] = c;
+}
+
+void StdfCsvExporter::flush()
+{
+    if(m_used > 0 && !m_failed && std::fwrite(&m_buffer[0], 1, m_used, m_file) != m_used) m_failed = true;
+    m_used = 0;
+}
+
+bool StdfCsvExporter::is_running() const
+{
+    return m_running;
+}
+
+bool StdfCsvExporter::is_cancelled() const
+{
+    return m_cancel;
+}
+
+STDF_FILE_ERROR StdfCsvExporter::result() const
+{
+    return m_result;
+}
+
+unsigned long long StdfCsvExporter::row_count() const
+{
+    return m_rows;
+}
+
+unsigned long long StdfCsvExporter::records_done() const
+{
+    return m_records_done;
+}
+
+unsigned long long StdfCsvExporter::records_total() const
+{
+    return m_records_total;
+}
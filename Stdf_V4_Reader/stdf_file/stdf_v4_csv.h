@@ -0,0 +1,94 @@
+/*************************************************************************
+ * Writes all records of one type to a CSV file, one row per record with
+ * the columns of stdf_v4_columns.h, as the viewer table shows them. The
+ * rows go through one large buffer straight to the file, nothing per row
+ * is allocated, so a long export is bound by the disk.
+ * PTR rows come in part order with the PART_ID of their PRR in front,
+ * the tests of a part are only held until its PRR.
+*************************************************************************/
+#ifndef _STDF_V4_CSV_H_
+#define _STDF_V4_CSV_H_
+
+#include "stdf_v4_columns.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+
+class StdfCsvExporter
+{
+public:
+    explicit StdfCsvExporter(unsigned int buffer_size = 1024U * 1024U);
+    // cancels and waits for a start()ed export
+    ~StdfCsvExporter();
+
+    // Exports the records of type from file, in the calling thread
+    STDF_FILE_ERROR write(STDF_FILE& file, STDF_TYPE type, const char* csv_filename);
+    // Exports straight from an stdf file through STDF_FILE::scan, without a STDF_FILE
+    STDF_FILE_ERROR write(const char* stdf_filename, STDF_TYPE type, const char* csv_filename);
+    // A FILE column in front of the others with this text in every row, for the
+    // exports of several files that go to one table. nullptr for none (default).
+    void set_file_column(const char* text);
+
+    // write(*file, ...) on a thread. file is only read, it must not change or go
+    // away until is_running() is false. false if an export is running already.
+    bool start(STDF_FILE* file, STDF_TYPE type, const char* csv_filename);
+    // stops at the next record, the rows written so far stay in the file
+    void cancel();
+    void wait();
+
+    bool is_running() const;
+    bool is_cancelled() const;
+    // result of the start()ed export, valid once is_running() is false
+    STDF_FILE_ERROR result() const;
+    // progress: rows written, records gone through and all records of the
+    // file, the last is 0 when exporting from an stdf file
+    unsigned long long row_count() const;
+    unsigned long long records_done() const;
+    unsigned long long records_total() const;
+
+private:
+    class RecordVisitor;
+    friend class RecordVisitor;
+
+    void run(STDF_FILE* file, STDF_TYPE type, std::string csv_filename);
+    STDF_FILE_ERROR open(STDF_TYPE type, const char* csv_filename);
+    STDF_FILE_ERROR close();
+    bool add_record(StdfRecord* record);
+    void put_part_tests(const char* part_id);
+    void put_file_column();
+    void put_row(const StdfRow& row, unsigned int first_cell);
+    void put(const char* text, unsigned int length);
+    void put(char c);
+    void flush();
+    StdfCsvExporter(const StdfCsvExporter& src);
+    StdfCsvExporter& operator=(const StdfCsvExporter& src);
+
+private:
+    std::vector<char> m_buffer;
+    unsigned int m_used;
+    std::FILE* m_file;
+    bool m_failed;
+    STDF_TYPE m_type;
+    const StdfColumns* m_columns;
+    StdfRow m_row;
+    // PTR only: the rows of the part not closed yet, reused from part to part
+    std::vector<StdfRow> m_part_rows;
+    unsigned int m_part_row_count;
+    unsigned long long m_written;
+    unsigned long long m_visited;
+    bool m_has_file_column;
+    std::string m_file_column;
+
+    std::thread m_thread;
+    std::atomic<bool> m_running;
+    std::atomic<bool> m_cancel;
+    // m_written and m_visited, published every few thousand records
+    std::atomic<unsigned long long> m_rows;
+    std::atomic<unsigned long long> m_records_done;
+    std::atomic<unsigned long long> m_records_total;
+    STDF_FILE_ERROR m_result;
+};
+
+#endif//_STDF_V4_CSV_H_
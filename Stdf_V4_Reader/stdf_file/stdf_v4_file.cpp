@@ -1,5 +1,9 @@
 #include "stdf_v4_file.h"
+#include "stdf_v4_index.h"
+#include "stdf_v4_writer.h"
 #include <string>
+#include <atomic>
+#include <thread>
 
 const char* REC_NAME[STDF_V4_RECORD_COUNT] =
 {
@@ -64,8 +68,9 @@ static std::string to_string(STDF_TYPE type)
 	}
 }
 
-STDF_FILE::STDF_FILE()
+STDF_FILE::STDF_FILE(bool use_arena)
 {
+	m_arena = use_arena ? new StdfArena() : nullptr;
 }
 
 STDF_FILE::~STDF_FILE()
@@ -74,33 +79,62 @@ STDF_FILE::~STDF_FILE()
 	{
 		delete Record_Vector[i];
 	}
+	delete m_arena;
+	for(unsigned int i = 0; i < m_thread_arenas.size(); i++)
+	{
+		delete m_thread_arenas[i];
+	}
 }
 
-STDF_FILE_ERROR STDF_FILE::read(const char* filename)
+STDF_FILE_ERROR STDF_FILE::read_far(StdfRecordCursor& cursor)
 {
-	std::ifstream in(filename, std::ios::in | std::ios::binary);
-	if(!in) return READ_ERROR;
-
 	StdfHeader header;
-	STDF_TYPE type = header.read(in);
+	if(!cursor.next(header)) return FORMATE_ERROR;
+	STDF_TYPE type = header.get_type();
 	if(type != FAR_TYPE) return FORMATE_ERROR;
 
-	StdfFAR* far_record = new StdfFAR();
+	StdfFAR* far_record = static_cast<StdfFAR*>(header.create_record(FAR_TYPE, m_arena));
 	far_record->parse(header);
 
 	unsigned char cpu_type = far_record->get_cpu_type();
-    if(cpu_type != 2) return STDF_CPU_TYPE_NOT_SUPPORT;
+    if(!STDF_CPU_TYPE_SUPPORTED(cpu_type)) { delete far_record; return STDF_CPU_TYPE_NOT_SUPPORT; }
 
 	unsigned char stdf_version = far_record->get_stdf_version();
-	if(stdf_version != 4) return STDF_VERSION_NOT_SUPPORT;
+	if(stdf_version != 4) { delete far_record; return STDF_VERSION_NOT_SUPPORT; }
 
 	Record_Vector.push_back(far_record);
 	append_record_by_type(far_record);
+	return STDF_OPERATE_OK;
+}
 
-	while(!in.eof())
+// no reserve here: called once per batch, the vectors keep growing geometrically
+void STDF_FILE::append(const std::vector<StdfRecord*>& records)
+{
+	for(unsigned int i = 0; i < records.size(); i++)
 	{
-        type = header.read(in);
-		StdfRecord* record = header.create_record(type);
+		Record_Vector.push_back(records[i]);
+		append_record_by_type(records[i]);
+	}
+}
+
+void STDF_FILE::adopt_arena(StdfArena* arena)
+{
+	if(arena) m_thread_arenas.push_back(arena);
+}
+
+STDF_FILE_ERROR STDF_FILE::read(const char* filename)
+{
+	StdfRecordCursor cursor;
+	if(!cursor.open(filename)) return READ_ERROR;
+
+	STDF_FILE_ERROR ret = read_far(cursor);
+	if(ret != STDF_OPERATE_OK) return ret;
+
+	StdfHeader header;
+	while(cursor.next(header))
+	{
+        STDF_TYPE type = header.get_type();
+		StdfRecord* record = header.create_record(type, m_arena);
 		if(record)
 		{
 			record->parse(header);
@@ -109,10 +143,162 @@ STDF_FILE_ERROR STDF_FILE::read(const char* filename)
 		}
         if(type == MRR_TYPE) break;
 	}
-    in.close();
+    cursor.close();
+    return STDF_OPERATE_OK;
+}
+
+// records per work item of the parallel read, small enough to balance PTR heavy
+// parts against the rest, large enough to keep the shared counter cold
+#define STDF_PARSE_CHUNK 4096
+
+STDF_FILE_ERROR STDF_FILE::read(const char* filename, unsigned int threads)
+{
+	if(threads == 0) threads = std::thread::hardware_concurrency();
+	if(threads <= 1) return read(filename);
+
+	StdfRecordCursor cursor;
+	if(!cursor.open(filename)) return READ_ERROR;
+
+	STDF_FILE_ERROR ret = read_far(cursor);
+	if(ret != STDF_OPERATE_OK) return ret;
+
+	// pass 1: record boundaries, only REC_LEN is touched
+	std::vector<unsigned long long> offsets;
+	offsets.reserve(cursor.size() / 32);
+	StdfHeader header;
+	while(cursor.next(header))
+	{
+		offsets.push_back(cursor.record_offset());
+		if(header.get_type() == MRR_TYPE) break;
+	}
+
+	// pass 2: threads take chunks of offsets and decode them into their slots
+	std::vector<StdfRecord*> records(offsets.size(), nullptr);
+	unsigned int chunk_count = (offsets.size() + STDF_PARSE_CHUNK - 1) / STDF_PARSE_CHUNK;
+	if(threads > chunk_count) threads = (chunk_count > 0) ? chunk_count : 1;
+	std::atomic<unsigned int> next_chunk(0);
+	std::vector<StdfArena*> arenas(threads, nullptr);
+	if(m_arena)
+	{
+		for(unsigned int i = 0; i < threads; i++) arenas[i] = new StdfArena();
+	}
+
+	auto decode = [&](unsigned int id)
+	{
+		StdfHeader chunk_header;
+		unsigned int chunk;
+		while((chunk = next_chunk.fetch_add(1)) < chunk_count)
+		{
+			size_t begin = size_t(chunk) * STDF_PARSE_CHUNK;
+			size_t end = begin + STDF_PARSE_CHUNK;
+			if(end > offsets.size()) end = offsets.size();
+			for(size_t i = begin; i < end; i++)
+			{
+				cursor.map(offsets[i], chunk_header);
+				StdfRecord* record = chunk_header.create_record(chunk_header.get_type(), arenas[id]);
+				if(record) record->parse(chunk_header);
+				records[i] = record;
+			}
+		}
+	};
+	std::vector<std::thread> workers;
+	for(unsigned int i = 1; i < threads; i++) workers.push_back(std::thread(decode, i));
+	decode(0);
+	for(unsigned int i = 0; i < workers.size(); i++) workers[i].join();
+
+	// merge in file order
+	Record_Vector.reserve(Record_Vector.size() + records.size());
+	for(unsigned int i = 0; i < records.size(); i++)
+	{
+		if(records[i] == nullptr) continue;
+		Record_Vector.push_back(records[i]);
+		append_record_by_type(records[i]);
+	}
+	for(unsigned int i = 0; i < arenas.size(); i++)
+	{
+		if(arenas[i]) m_thread_arenas.push_back(arenas[i]);
+	}
+    cursor.close();
     return STDF_OPERATE_OK;
 }
 
+STDF_FILE_ERROR STDF_FILE::read(const char* filename, const StdfIndex& index, STDF_TYPE type,
+                                unsigned int first, unsigned int count)
+{
+	std::vector<unsigned int> entries;
+	unsigned int type_count = index.get_count(type);
+	for(unsigned int i = first; i < type_count && i - first < count; i++)
+	{
+		entries.push_back(index.get_entry_index(type, i));
+	}
+	return read_entries(filename, index, entries);
+}
+
+STDF_FILE_ERROR STDF_FILE::read_part(const char* filename, const StdfIndex& index, unsigned int part)
+{
+	std::vector<unsigned int> entries;
+	index.get_part_entries(part, UNKNOWN_TYPE, entries);
+	return read_entries(filename, index, entries);
+}
+
+STDF_FILE_ERROR STDF_FILE::read_entries(const char* filename, const StdfIndex& index,
+                                        const std::vector<unsigned int>& entries)
+{
+	StdfRecordCursor cursor;
+	if(!cursor.open(filename)) return READ_ERROR;
+
+	StdfHeader header;
+	for(unsigned int i = 0; i < entries.size(); i++)
+	{
+		if(!cursor.map(index.get_entry(entries[i]).offset, header)) return FORMATE_ERROR;
+		StdfRecord* record = header.create_record(header.get_type(), m_arena);
+		if(record)
+		{
+			record->parse(header);
+			Record_Vector.push_back(record);
+			append_record_by_type(record);
+		}
+	}
+	cursor.close();
+	return STDF_OPERATE_OK;
+}
+
+STDF_FILE_ERROR STDF_FILE::scan(const char* filename, StdfRecordVisitor& visitor, unsigned int type_mask)
+{
+	StdfRecordCursor cursor;
+	if(!cursor.open(filename)) return READ_ERROR;
+
+	StdfHeader header;
+	if(!cursor.next(header)) return FORMATE_ERROR;
+	if(header.get_type() != FAR_TYPE) return FORMATE_ERROR;
+
+	StdfFAR far_record;
+	far_record.parse(header);
+	if(!STDF_CPU_TYPE_SUPPORTED(far_record.get_cpu_type())) return STDF_CPU_TYPE_NOT_SUPPORT;
+	if(far_record.get_stdf_version() != 4) return STDF_VERSION_NOT_SUPPORT;
+	if((type_mask & STDF_TYPE_MASK(FAR_TYPE)) && !visitor.visit(&far_record, 0)) return STDF_OPERATE_OK;
+
+	StdfRecord* records[STDF_V4_RECORD_COUNT] = {nullptr};
+	while(cursor.next(header))
+	{
+		STDF_TYPE type = header.get_type();
+		if(type < STDF_V4_RECORD_COUNT && (type_mask & STDF_TYPE_MASK(type)))
+		{
+			if(records[type] == nullptr) records[type] = header.create_record(type);
+			records[type]->parse(header);
+			if(!visitor.visit(records[type], cursor.record_offset())) break;
+		}
+		if(type == MRR_TYPE) break;
+	}
+
+	for(unsigned int i = 0; i < STDF_V4_RECORD_COUNT; i++)
+	{
+		delete records[i];
+	}
+	cursor.close();
+	return STDF_OPERATE_OK;
+}
+
 STDF_FILE_ERROR STDF_FILE::write(const char* filename)
 {
 	std::ofstream out(filename, std::ios::out );
@@ -131,26 +317,29 @@ STDF_FILE_ERROR STDF_FILE::write(const char* filename)
 
 STDF_FILE_ERROR STDF_FILE::save(const char* filename)
 {
-    std::ofstream out(filename, std::ios::binary );
-    if(!out) return WRITE_ERROR;
+    return save(filename, STDF_COMPRESS_NONE);
+}
+
+STDF_FILE_ERROR STDF_FILE::save(const char* filename, STDF_COMPRESSION compression, int level)
+{
+    StdfWriter writer;
+    STDF_FILE_ERROR ret = writer.open(filename, compression, level);
+    if(ret != STDF_OPERATE_OK) return ret;
 
-    StdfHeader header;
-    for(unsigned int i = 0; i < Record_Vector.size(); i++)
+    for(unsigned int i = 0; i < Record_Vector.size() && ret == STDF_OPERATE_OK; i++)
     {
         if(i == 1)
         {
-            StdfATR* atr = new StdfATR();
-            atr->set_command_line("Save As By STDF Reader");
-            atr->set_modify_time(time(NULL));
-            atr->unparse(header);
-            header.write(out);
+            StdfATR atr;
+            atr.set_command_line("Save As By STDF Reader");
+            atr.set_modify_time(time(NULL));
+            ret = writer.write(&atr);
+            if(ret != STDF_OPERATE_OK) break;
         }
-        StdfRecord* record = Record_Vector[i];
-        record->unparse(header);
-        header.write(out);
+        ret = writer.write(Record_Vector[i]);
     }
-    out.close();
-    return STDF_OPERATE_OK;
+    STDF_FILE_ERROR close_ret = writer.close();
+    return (ret != STDF_OPERATE_OK) ? ret : close_ret;
 }
 
 
@@ -9,6 +9,14 @@
 
 #define STDF_V4_RECORD_COUNT 25
 
+// Record type mask for STDF_FILE::scan
+#define STDF_TYPE_MASK(type)  (1U << (type))
+#define STDF_ALL_TYPES_MASK   ((1U << STDF_V4_RECORD_COUNT) - 1U)
+
+// FAR CPU_TYPE the StdfRecordCursor based reads decode: 2 (little endian) and
+// 1 (Sun, big endian, numbers swapped on the fly)
+#define STDF_CPU_TYPE_SUPPORTED(type) ((type) == 1 || (type) == 2)
+
 enum STDF_FILE_ERROR : int
 {
     STDF_OPERATE_OK = 0,
@@ -19,28 +27,78 @@ enum STDF_FILE_ERROR : int
 	WRITE_ERROR = -5,
 };
 
+// Output format of STDF_FILE::save and StdfWriter
+enum STDF_COMPRESSION : int
+{
+    STDF_COMPRESS_NONE = 0,
+    STDF_COMPRESS_GZIP = 1,
+    // only with STDF_HAVE_ZSTD defined at build time, writing fails otherwise
+    STDF_COMPRESS_ZSTD = 2,
+};
+
+// Callback for STDF_FILE::scan.
+// The record object belongs to the scan and is overwritten by the next record
+// of the same type, copy out what has to be kept.
+class StdfRecordVisitor
+{
+public:
+    // offset: file offset of the record header. Return false to stop the scan.
+    virtual bool visit(StdfRecord* record, unsigned long long offset) = 0;
+    virtual ~StdfRecordVisitor(){}
+};
+
+class StdfIndex;
+
 class STDF_FILE
 {
 public:
-	STDF_FILE();
+	// use_arena: keep all records of the file in one StdfArena, the destructor
+	// then gives the memory back at once instead of freeing record by record.
+	// The records are still destroyed one by one, see StdfArena.
+	explicit STDF_FILE(bool use_arena = false);
 	~STDF_FILE();
 
 	STDF_FILE_ERROR read(const char* filename);
+	// Two pass read: collects the record offsets, then decodes chunks of records on
+	// threads (0 = one per core). The records end up in file order as with read().
+	STDF_FILE_ERROR read(const char* filename, unsigned int threads);
+	// Random access through a StdfIndex of the file: only the records [first, first+count)
+	// of type, or all records of one part, are read and appended to this file.
+	STDF_FILE_ERROR read(const char* filename, const StdfIndex& index, STDF_TYPE type,
+	                     unsigned int first, unsigned int count);
+	STDF_FILE_ERROR read_part(const char* filename, const StdfIndex& index, unsigned int part);
+	// Streaming read: parses one record at a time into one reused object per type
+	// and keeps nothing. Records whose type is not in type_mask are skipped by length.
+	static STDF_FILE_ERROR scan(const char* filename, StdfRecordVisitor& visitor,
+	                            unsigned int type_mask = STDF_ALL_TYPES_MASK);
 	STDF_FILE_ERROR write(const char* filename, STDF_TYPE type);
 	STDF_FILE_ERROR write(const char* filename);
     STDF_FILE_ERROR save(const char* filename);
+    // level: -1 for the default of the compressor, see StdfWriter::open
+    STDF_FILE_ERROR save(const char* filename, STDF_COMPRESSION compression, int level = -1);
 	const char* get_name(STDF_TYPE type);
 	unsigned int get_count(STDF_TYPE type);
 	StdfRecord* get_record(STDF_TYPE type, unsigned int index);
     unsigned int get_total_count();
     StdfRecord* get_record(unsigned int index);
+	// Appends records parsed elsewhere (StdfLoader) in file order, the file owns them then.
+	void append(const std::vector<StdfRecord*>& records);
+	// Takes over the arena appended records were allocated from, it goes with the file.
+	void adopt_arena(StdfArena* arena);
 
 private:
 	void append_record_by_type(StdfRecord* record);
+	STDF_FILE_ERROR read_far(StdfRecordCursor& cursor);
+	STDF_FILE_ERROR read_entries(const char* filename, const StdfIndex& index,
+	                             const std::vector<unsigned int>& entries);
 	STDF_FILE(const STDF_FILE& src);
 	STDF_FILE& operator=(const STDF_FILE& src);
 
 private:
+	StdfArena* m_arena;
+	// one arena per decode thread of read(filename, threads), the arena is not thread safe,
+	// and the arenas of adopt_arena()
+	std::vector<StdfArena*> m_thread_arenas;
 	std::vector<StdfRecord*> Record_Vector;
 	std::vector<StdfFAR*> StdfFAR_Vector;
 	std::vector<StdfATR*> StdfATR_Vector;
@@ -0,0 +1,339 @@
+#include "stdf_v4_index.h"
+#include <cstring>
+
+static const char STDX_MAGIC[4] = {'S', 'T', 'D', 'X'};
+static const unsigned int STDX_VERSION = 1;
+static const unsigned int STDX_FLAG_COMPLETE = 0x1;
+
+struct StdxHeader
+{
+    char magic[4];
+    unsigned int version;
+    unsigned long long indexed_size;
+    unsigned long long entry_count;
+    unsigned int flags;
+    unsigned int reserved;
+};
+
+// position of HEAD_NUM in the record data, the site (group) follows, -1 for none
+static int head_position(STDF_TYPE type)
+{
+    switch(type)
+    {
+    case PCR_TYPE:
+    case HBR_TYPE:
+    case SBR_TYPE:
+    case SDR_TYPE:
+    case WIR_TYPE:
+    case WRR_TYPE:
+    case PIR_TYPE:
+    case PRR_TYPE:
+    case TSR_TYPE: return 0;
+    case PTR_TYPE:
+    case MPR_TYPE:
+    case FTR_TYPE: return 4;
+    default: return -1;
+    }
+}
+
+StdfIndex::StdfIndex()
+{
+    clear();
+}
+
+StdfIndex::~StdfIndex()
+{
+}
+
+std::string StdfIndex::sidecar_name(const char* filename)
+{
+    return std::string(filename) + ".stdx";
+}
+
+void StdfIndex::clear()
+{
+    m_indexed_size = 0;
+    m_complete = false;
+    m_entries.clear();
+    for(unsigned int i = 0; i < STDF_V4_RECORD_COUNT; i++) m_type_entries[i].clear();
+    m_parts.clear();
+    m_open_parts.clear();
+}
+
+STDF_FILE_ERROR StdfIndex::update(const char* filename)
+{
+    std::string sidecar = sidecar_name(filename);
+    clear();
+    if(load(sidecar.c_str()) != STDF_OPERATE_OK) clear();
+
+    unsigned int first_entry = m_entries.size();
+    STDF_FILE_ERROR ret = index_file(filename);
+    if(ret == FORMATE_ERROR && first_entry > 0)
+    {
+        clear();
+        first_entry = 0;
+        ret = index_file(filename);
+    }
+    if(ret != STDF_OPERATE_OK) return ret;
+
+    if(first_entry == 0) return save(sidecar.c_str());
+    return append(sidecar.c_str(), first_entry);
+}
+
+STDF_FILE_ERROR StdfIndex::build(const char* filename)
+{
+    clear();
+    return index_file(filename);
+}
+
+STDF_FILE_ERROR StdfIndex::index_file(const char* filename)
+{
+    StdfRecordCursor cursor;
+    if(!cursor.open(filename)) return READ_ERROR;
+
+    StdfHeader header;
+    if(m_entries.empty())
+    {
+        if(!cursor.next(header)) return FORMATE_ERROR;
+        if(header.get_type() != FAR_TYPE) return FORMATE_ERROR;
+        StdfFAR far_record;
+        far_record.parse(header);
+        if(!STDF_CPU_TYPE_SUPPORTED(far_record.get_cpu_type())) return STDF_CPU_TYPE_NOT_SUPPORT;
+        if(far_record.get_stdf_version() != 4) return STDF_VERSION_NOT_SUPPORT;
+        cursor.seek(0);
+    }
+    else
+    {
+        // the last indexed record has to end where the index ends,
+        // otherwise the sidecar belongs to another file
+        const StdfIndexEntry& last = m_entries.back();
+        if(!cursor.map(last.offset, header)) return FORMATE_ERROR;
+        if(header.get_type() != STDF_TYPE(last.type)) return FORMATE_ERROR;
+        if(last.offset + 4 + header.get_length() != m_indexed_size) return FORMATE_ERROR;
+        if(m_complete) return STDF_OPERATE_OK;
+        cursor.seek(m_indexed_size);
+    }
+
+    const char* data = cursor.data();
+    while(cursor.next(header))
+    {
+        STDF_TYPE type = header.get_type();
+        StdfIndexEntry entry;
+        entry.offset = cursor.record_offset();
+        entry.type = (unsigned short)type;
+        entry.head = 0;
+        entry.site = 0;
+        entry.part = STDF_INDEX_NO_PART;
+
+        int position = head_position(type);
+        if(position >= 0 && header.get_length() >= position + 2)
+        {
+            entry.head = (unsigned char)data[entry.offset + 4 + position];
+            entry.site = (unsigned char)data[entry.offset + 4 + position + 1];
+        }
+
+        unsigned short key = (unsigned short)(entry.head << 8 | entry.site);
+        if(type == PIR_TYPE)
+        {
+            entry.part = m_parts.size();
+        }
+        else if(position >= 0)
+        {
+            std::map<unsigned short, unsigned int>::const_iterator it = m_open_parts.find(key);
+            if(it != m_open_parts.end()) entry.part = it->second;
+        }
+        else if(m_open_parts.size() == 1)
+        {
+            // DTR/GDR... inside the only open part
+            entry.part = m_open_parts.begin()->second;
+        }
+
+        add_entry(entry);
+        m_indexed_size = cursor.tell();
+        if(type == MRR_TYPE)
+        {
+            m_complete = true;
+            break;
+        }
+    }
+    cursor.close();
+    return STDF_OPERATE_OK;
+}
+
+void StdfIndex::add_entry(const StdfIndexEntry& entry)
+{
+    unsigned int index = m_entries.size();
+    m_entries.push_back(entry);
+    if(entry.type < STDF_V4_RECORD_COUNT) m_type_entries[entry.type].push_back(index);
+    if(entry.part == STDF_INDEX_NO_PART) return;
+
+    unsigned short key = (unsigned short)(entry.head << 8 | entry.site);
+    if(entry.type == PIR_TYPE)
+    {
+        StdfIndexPart part;
+        part.pir_offset = entry.offset;
+        part.prr_offset = 0;
+        part.first_entry = index;
+        part.last_entry = index;
+        part.head = entry.head;
+        part.site = entry.site;
+        m_parts.push_back(part);
+        m_open_parts[key] = entry.part;
+    }
+    else if(entry.part < m_parts.size())
+    {
+        StdfIndexPart& part = m_parts[entry.part];
+        part.last_entry = index;
+        if(entry.type == PRR_TYPE)
+        {
+            part.prr_offset = entry.offset;
+            m_open_parts.erase(key);
+        }
+    }
+}
+
+STDF_FILE_ERROR StdfIndex::load(const char* index_filename)
+{
+    clear();
+    std::ifstream in(index_filename, std::ios::binary);
+    if(!in) return READ_ERROR;
+
+    StdxHeader header;
+    in.read((char*)&header, sizeof(header));
+    if(in.gcount() != sizeof(header)) return FORMATE_ERROR;
+    if(std::memcmp(header.magic, STDX_MAGIC, 4) != 0 || header.version != STDX_VERSION) return FORMATE_ERROR;
+
+    // the count is checked against the sidecar before anything is allocated for
+    // it, a cut or damaged sidecar fails here and update() builds the index again;
+    // entries behind the count are left by an interrupted append()
+    in.seekg(0, std::ios::end);
+    unsigned long long file_size = (unsigned long long)in.tellg();
+    in.seekg(std::streamoff(sizeof(header)));
+    if(header.entry_count > 0xFFFFFFFFULL) return FORMATE_ERROR;
+    if(header.entry_count > (file_size - sizeof(header)) / sizeof(StdfIndexEntry)) return FORMATE_ERROR;
+
+    std::vector<StdfIndexEntry> entries(header.entry_count);
+    if(header.entry_count)
+    {
+        std::streamsize size = std::streamsize(header.entry_count * sizeof(StdfIndexEntry));
+        in.read((char*)&entries[0], size);
+        if(in.gcount() != size) return FORMATE_ERROR;
+    }
+
+    m_entries.reserve(entries.size());
+    for(unsigned int i = 0; i < entries.size(); i++)
+    {
+        add_entry(entries[i]);
+    }
+    m_indexed_size = header.indexed_size;
+    m_complete = (header.flags & STDX_FLAG_COMPLETE) != 0;
+    return STDF_OPERATE_OK;
+}
+
+STDF_FILE_ERROR StdfIndex::save(const char* index_filename)
+{
+    std::ofstream out(index_filename, std::ios::binary | std::ios::trunc);
+    if(!out) return WRITE_ERROR;
+    out.close();
+    return append(index_filename, 0);
+}
+
+// writes the entries from first_entry on behind the ones already in the sidecar,
+// then the header, so an interrupted update leaves the old header valid
+STDF_FILE_ERROR StdfIndex::append(const char* index_filename, unsigned int first_entry)
+{
+    std::fstream out(index_filename, std::ios::in | std::ios::out | std::ios::binary);
+    if(!out) return WRITE_ERROR;
+
+    out.seekp(std::streamoff(sizeof(StdxHeader) + (unsigned long long)first_entry * sizeof(StdfIndexEntry)));
+    if(first_entry < m_entries.size())
+    {
+        out.write((const char*)&m_entries[first_entry], std::streamsize((m_entries.size() - first_entry) * sizeof(StdfIndexEntry)));
+    }
+
+    StdxHeader header;
+    std::memcpy(header.magic, STDX_MAGIC, 4);
+    header.version = STDX_VERSION;
+    header.indexed_size = m_indexed_size;
+    header.entry_count = m_entries.size();
+    header.flags = m_complete ? STDX_FLAG_COMPLETE : 0;
+    header.reserved = 0;
+    out.seekp(0);
+    out.write((const char*)&header, sizeof(header));
+    if(!out) return WRITE_ERROR;
+    out.close();
+    return STDF_OPERATE_OK;
+}
+
+unsigned long long StdfIndex::indexed_size() const
+{
+    return m_indexed_size;
+}
+
+bool StdfIndex::is_complete() const
+{
+    return m_complete;
+}
+
+unsigned int StdfIndex::get_count() const
+{
+    return m_entries.size();
+}
+
+const StdfIndexEntry& StdfIndex::get_entry(unsigned int index) const
+{
+    return m_entries[index];
+}
+
+unsigned int StdfIndex::find_entry(unsigned long long offset) const
+{
+    unsigned int low = 0, high = m_entries.size();
+    while(low < high)
+    {
+        unsigned int mid = low + (high - low) / 2;
+        if(m_entries[mid].offset < offset) low = mid + 1;
+        else high = mid;
+    }
+    return low;
+}
+
+unsigned int StdfIndex::get_count(STDF_TYPE type) const
+{
+    if(type >= STDF_V4_RECORD_COUNT) return 0;
+    return m_type_entries[type].size();
+}
+
+unsigned int StdfIndex::get_entry_index(STDF_TYPE type, unsigned int index) const
+{
+    return m_type_entries[type][index];
+}
+
+unsigned long long StdfIndex::get_offset(STDF_TYPE type, unsigned int index) const
+{
+    return m_entries[m_type_entries[type][index]].offset;
+}
+
+unsigned int StdfIndex::get_part_count() const
+{
+    return m_parts.size();
+}
+
+const StdfIndexPart& StdfIndex::get_part(unsigned int part) const
+{
+    return m_parts[part];
+}
+
+unsigned int StdfIndex::get_part_entries(unsigned int part, STDF_TYPE type, std::vector<unsigned int>& entries) const
+{
+    entries.clear();
+    if(part >= m_parts.size()) return 0;
+    const StdfIndexPart& info = m_parts[part];
+    for(unsigned int i = info.first_entry; i <= info.last_entry; i++)
+    {
+        const StdfIndexEntry& entry = m_entries[i];
+        if(entry.part != part) continue;
+        if(type != UNKNOWN_TYPE && entry.type != type) continue;
+        entries.push_back(i);
+    }
+    return entries.size();
+}
@@ -0,0 +1,95 @@
+/*************************************************************************
+ * Record offset index of a stdf file, kept in a ".stdx" sidecar file.
+ * One entry per record with its file offset, type, head/site and the part
+ * (PIR ... PRR) it belongs to, so records can be read without a scan.
+ * The index is extended by update() when the stdf file grows.
+*************************************************************************/
+#ifndef _STDF_V4_INDEX_H_
+#define _STDF_V4_INDEX_H_
+
+#include "stdf_v4_file.h"
+#include <string>
+#include <vector>
+#include <map>
+
+#define STDF_INDEX_NO_PART 0xFFFFFFFFU
+
+// Sidecar layout (byte order of the machine that wrote it):
+//   "STDX", U4 version, U8 indexed stdf bytes, U8 entry count, U4 flags, U4 reserved
+//   then entry count * StdfIndexEntry
+struct StdfIndexEntry
+{
+    unsigned long long offset;  // offset of the record header in the stdf file
+    unsigned int part;          // index into the part list, STDF_INDEX_NO_PART outside of a part
+    unsigned short type;        // STDF_TYPE
+    unsigned char head;         // 0 for records without head number
+    unsigned char site;         // site or site group, 0 for records without
+};
+
+struct StdfIndexPart
+{
+    unsigned long long pir_offset;
+    unsigned long long prr_offset;  // 0 while the part is still open
+    unsigned int first_entry;       // entry of the PIR
+    unsigned int last_entry;        // entry of the PRR, or of the last record seen so far
+    unsigned char head;
+    unsigned char site;
+};
+
+class StdfIndex
+{
+public:
+    StdfIndex();
+    ~StdfIndex();
+
+    // "<filename>.stdx"
+    static std::string sidecar_name(const char* filename);
+
+    // Loads the sidecar of filename if there is a valid one, indexes whatever the
+    // file gained since and writes the new entries back. A sidecar that does not
+    // fit the file (shorter file, other format) is rebuilt from the start.
+    STDF_FILE_ERROR update(const char* filename);
+    // Same without the sidecar, only in memory.
+    STDF_FILE_ERROR build(const char* filename);
+    STDF_FILE_ERROR load(const char* index_filename);
+    STDF_FILE_ERROR save(const char* index_filename);
+    void clear();
+
+    // bytes of the stdf file covered, the next update() starts here
+    unsigned long long indexed_size() const;
+    // MRR indexed, the file will not grow any more
+    bool is_complete() const;
+
+    unsigned int get_count() const;
+    const StdfIndexEntry& get_entry(unsigned int index) const;
+    // first entry starting at or after offset, get_count() if there is none
+    unsigned int find_entry(unsigned long long offset) const;
+
+    unsigned int get_count(STDF_TYPE type) const;
+    // entry number of the index-th record of this type
+    unsigned int get_entry_index(STDF_TYPE type, unsigned int index) const;
+    unsigned long long get_offset(STDF_TYPE type, unsigned int index) const;
+
+    unsigned int get_part_count() const;
+    const StdfIndexPart& get_part(unsigned int part) const;
+    // entries of one part, type UNKNOWN_TYPE for all records of the part
+    unsigned int get_part_entries(unsigned int part, STDF_TYPE type, std::vector<unsigned int>& entries) const;
+
+private:
+    STDF_FILE_ERROR index_file(const char* filename);
+    void add_entry(const StdfIndexEntry& entry);
+    STDF_FILE_ERROR append(const char* index_filename, unsigned int first_entry);
+    StdfIndex(const StdfIndex& src);
+    StdfIndex& operator=(const StdfIndex& src);
+
+private:
+    unsigned long long m_indexed_size;
+    bool m_complete;
+    std::vector<StdfIndexEntry> m_entries;
+    std::vector<unsigned int> m_type_entries[STDF_V4_RECORD_COUNT];
+    std::vector<StdfIndexPart> m_parts;
+    // head<<8|site -> part opened by a PIR and not yet closed by its PRR
+    std::map<unsigned short, unsigned int> m_open_parts;
+};
+
+#endif//_STDF_V4_INDEX_H_
@@ -0,0 +1,146 @@
+#include "stdf_v4_loader.h"
+
+// records parsed before they are handed over, keeps the lock cold and
+// the owner's take() cheap
+#define STDF_LOAD_BATCH 8192
+
+StdfLoader::StdfLoader() : m_running(false), m_cancel(false), m_offset(0), m_size(0)
+{
+    m_finished = true;
+    m_arena = nullptr;
+    m_result = STDF_OPERATE_OK;
+}
+
+StdfLoader::~StdfLoader()
+{
+    cancel();
+    wait();
+    for(unsigned int i = 0; i < m_pending.size(); i++)
+    {
+        delete m_pending[i];
+    }
+    delete m_arena;
+}
+
+bool StdfLoader::start(const char* filename, bool use_arena)
+{
+    if(m_thread.joinable() || m_arena) return false;
+
+    m_filename = filename;
+    m_finished = false;
+    m_running = true;
+    m_cancel = false;
+    m_offset = 0;
+    m_size = 0;
+    m_result = STDF_OPERATE_OK;
+    m_arena = use_arena ? new StdfArena() : nullptr;
+    m_thread = std::thread(&StdfLoader::run, this);
+    return true;
+}
+
+void StdfLoader::cancel()
+{
+    m_cancel = true;
+}
+
+void StdfLoader::wait()
+{
+    if(m_thread.joinable()) m_thread.join();
+}
+
+void StdfLoader::run()
+{
+    StdfRecordCursor cursor;
+    STDF_FILE_ERROR ret = cursor.open(m_filename.c_str()) ? load(cursor) : READ_ERROR;
+    cursor.close();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_result = ret;
+    m_finished = true;
+    m_running = false;
+}
+
+STDF_FILE_ERROR StdfLoader::load(StdfRecordCursor& cursor)
+{
+    m_size = cursor.size();
+
+    // same checks as STDF_FILE::read
+    StdfHeader header;
+    if(!cursor.next(header) || header.get_type() != FAR_TYPE) return FORMATE_ERROR;
+    StdfFAR* far_record = static_cast<StdfFAR*>(header.create_record(FAR_TYPE, m_arena));
+    far_record->parse(header);
+    if(!STDF_CPU_TYPE_SUPPORTED(far_record->get_cpu_type())) { delete far_record; return STDF_CPU_TYPE_NOT_SUPPORT; }
+    if(far_record->get_stdf_version() != 4) { delete far_record; return STDF_VERSION_NOT_SUPPORT; }
+
+    std::vector<StdfRecord*> batch;
+    batch.reserve(STDF_LOAD_BATCH);
+    batch.push_back(far_record);
+    while(!m_cancel && cursor.next(header))
+    {
+        STDF_TYPE type = header.get_type();
+        StdfRecord* record = header.create_record(type, m_arena);
+        if(record)
+        {
+            record->parse(header);
+            batch.push_back(record);
+        }
+        if(type == MRR_TYPE) break;
+        if(batch.size() >= STDF_LOAD_BATCH) hand_over(batch, cursor.tell());
+    }
+    hand_over(batch, cursor.tell());
+    return STDF_OPERATE_OK;
+}
+
+void StdfLoader::hand_over(std::vector<StdfRecord*>& batch, unsigned long long offset)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending.insert(m_pending.end(), batch.begin(), batch.end());
+    }
+    batch.clear();
+    m_offset = offset;
+}
+
+bool StdfLoader::take(STDF_FILE& file)
+{
+    std::vector<StdfRecord*> records;
+    bool finished;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        records.swap(m_pending);
+        finished = m_finished;
+    }
+    file.append(records);
+    if(!finished) return true;
+
+    // the thread handed over its last batch before it set m_finished
+    wait();
+    file.adopt_arena(m_arena);
+    m_arena = nullptr;
+    return false;
+}
+
+bool StdfLoader::is_running() const
+{
+    return m_running;
+}
+
+bool StdfLoader::is_cancelled() const
+{
+    return m_cancel;
+}
+
+STDF_FILE_ERROR StdfLoader::result() const
+{
+    return m_result;
+}
+
+unsigned long long StdfLoader::bytes_read() const
+{
+    return m_offset;
+}
+
+unsigned long long StdfLoader::file_size() const
+{
+    return m_size;
+}
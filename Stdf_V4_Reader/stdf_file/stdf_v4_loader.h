@@ -0,0 +1,68 @@
+/*************************************************************************
+ * Reads a stdf file on a background thread for a viewer that stays usable
+ * meanwhile. The thread walks the file with a StdfRecordCursor and parses
+ * one record after the other, batches of records are handed over through
+ * take(), which the owner calls from its own thread and which appends them
+ * to an STDF_FILE there. So the STDF_FILE is only touched by the owner and
+ * the records already taken can be browsed while the rest is still read.
+*************************************************************************/
+#ifndef _STDF_V4_LOADER_H_
+#define _STDF_V4_LOADER_H_
+
+#include "stdf_v4_file.h"
+#include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+class StdfLoader
+{
+public:
+    StdfLoader();
+    // Cancels and waits for the thread. Records not taken yet are freed, records
+    // taken already need their arena: take() until it returns false before.
+    ~StdfLoader();
+
+    // use_arena: allocate the records from one StdfArena, handed to the file by
+    // the last take(). false if a load is running already.
+    bool start(const char* filename, bool use_arena = true);
+    // stops the thread at the next record, take() still has to follow
+    void cancel();
+    // waits for the thread to end, after cancel() or to read the rest at once
+    void wait();
+
+    // Appends the records parsed since the last call to file. Returns false once
+    // the thread is done and everything went to file, including the arena.
+    bool take(STDF_FILE& file);
+
+    bool is_running() const;
+    bool is_cancelled() const;
+    // result of the read, valid once take() returned false
+    STDF_FILE_ERROR result() const;
+    // progress: file offset behind the records parsed so far, and the file size
+    unsigned long long bytes_read() const;
+    unsigned long long file_size() const;
+
+private:
+    void run();
+    STDF_FILE_ERROR load(StdfRecordCursor& cursor);
+    void hand_over(std::vector<StdfRecord*>& batch, unsigned long long offset);
+    StdfLoader(const StdfLoader& src);
+    StdfLoader& operator=(const StdfLoader& src);
+
+private:
+    std::string m_filename;
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::vector<StdfRecord*> m_pending;  // parsed, not taken yet
+    bool m_finished;                     // guarded by m_mutex
+    std::atomic<bool> m_running;
+    std::atomic<bool> m_cancel;
+    std::atomic<unsigned long long> m_offset;
+    std::atomic<unsigned long long> m_size;
+    StdfArena* m_arena;
+    STDF_FILE_ERROR m_result;
+};
+
+#endif//_STDF_V4_LOADER_H_
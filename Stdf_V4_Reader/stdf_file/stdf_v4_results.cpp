@@ -0,0 +1,1032 @@
+#include "stdf_v4_results.h"
+#include <fstream>
+#include <sys/stat.h>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+
+static const char STDR_MAGIC[4] = {'S', 'T', 'D', 'R'};
+static const unsigned int STDR_VERSION = 1;
+// results per lane of the statistics loops, independent sums the compiler can vectorize
+static const unsigned int LANES = 8;
+
+struct StdrHeader
+{
+    char magic[4];
+    unsigned int version;
+    unsigned long long source_size;     // size and mtime of the stdf file the cache was built from
+    long long source_mtime;
+    unsigned int test_count;
+    unsigned int part_count;
+    unsigned long long result_count;
+    unsigned long long string_bytes;
+    unsigned long long tests_offset;
+    unsigned long long parts_offset;
+    unsigned long long strings_offset;
+    unsigned long long values_offset;
+    unsigned long long part_column_offset;
+    unsigned long long site_column_offset;
+    unsigned long long flag_column_offset;
+};
+
+static unsigned long long align8(unsigned long long offset)
+{
+    return (offset + 7) & ~7ULL;
+}
+
+static bool source_info(const char* filename, unsigned long long& size, long long& mtime)
+{
+    struct stat info;
+    if(stat(filename, &info) != 0) return false;
+    size = (unsigned long long)info.st_size;
+    mtime = (long long)info.st_mtime;
+    return true;
+}
+
+// header of a cache with these counts, the sections laid out one after the other
+static void init_header(StdrHeader& header, unsigned int test_count, unsigned int part_count,
+                        unsigned long long result_count, unsigned long long string_bytes)
+{
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, STDR_MAGIC, 4);
+    header.version = STDR_VERSION;
+    header.test_count = test_count;
+    header.part_count = part_count;
+    header.result_count = result_count;
+    header.string_bytes = string_bytes;
+    header.tests_offset = align8(sizeof(StdrHeader));
+    header.parts_offset = align8(header.tests_offset + (unsigned long long)test_count * sizeof(StdfResultTest));
+    header.strings_offset = align8(header.parts_offset + (unsigned long long)part_count * sizeof(StdfResultPart));
+    header.values_offset = align8(header.strings_offset + string_bytes);
+    header.part_column_offset = align8(header.values_offset + result_count * sizeof(float));
+    header.site_column_offset = align8(header.part_column_offset + result_count * sizeof(unsigned int));
+    header.flag_column_offset = align8(header.site_column_offset + result_count);
+}
+
+static void pad_to(std::ofstream& out, unsigned long long& position, unsigned long long offset)
+{
+    static const char padding[8] = {0};
+    out.write(padding, std::streamsize(offset - position));
+    position = offset;
+}
+
+// renames the written temp file over the cache, removes it after a write error
+static STDF_FILE_ERROR replace_file(const std::string& temp_filename, const char* cache_filename, bool failed)
+{
+    if(failed)
+    {
+        std::remove(temp_filename.c_str());
+        return WRITE_ERROR;
+    }
+    if(std::rename(temp_filename.c_str(), cache_filename) != 0)
+    {
+        // Windows does not rename over an existing file
+        std::remove(cache_filename);
+        if(std::rename(temp_filename.c_str(), cache_filename) != 0)
+        {
+            std::remove(temp_filename.c_str());
+            return WRITE_ERROR;
+        }
+    }
+    return STDF_OPERATE_OK;
+}
+
+// bytes of a Cn field with the text parse() returned
+static unsigned int cn_size(const char* text)
+{
+    return 1 + (text ? (unsigned int)std::strlen(text) : 0);
+}
+
+// The result is kept: test flags without STDF_RESULT_INVALID_FLAGS, not NaN and of the site.
+// All comparisons, no branches, so the loops below stay vectorizable.
+static inline unsigned int keep_result(float value, unsigned char flags, unsigned char site_value,
+                                       bool all_sites, unsigned char site)
+{
+    return (unsigned int)(((flags & STDF_RESULT_INVALID_FLAGS) == 0) & (value == value) &
+                          (all_sites | (site_value == site)));
+}
+
+namespace {
+
+// collects the results of one test while the file is read
+struct TestColumns
+{
+    StdfResultTest test;
+    std::vector<float> values;
+    std::vector<unsigned int> parts;
+    std::vector<unsigned char> sites;
+    std::vector<unsigned char> flags;
+};
+
+struct TsrCounts
+{
+    unsigned int name;
+    unsigned long long exec_count;      // summed over the per site TSRs
+    unsigned long long fail_count;
+    bool has_summary;                   // HEAD_NUM 255: the counts of all sites
+    unsigned int summary_exec_count;
+    unsigned int summary_fail_count;
+};
+
+// the 0 terminated strings of a cache, each once
+class StringTable
+{
+public:
+    StringTable() : m_data(1, '\0') {}
+
+    unsigned int add(const char* text)
+    {
+        if(!text || !text[0]) return 0;
+        std::unordered_map<std::string, unsigned int>::const_iterator it = m_offsets.find(text);
+        if(it != m_offsets.end()) return it->second;
+        unsigned int offset = (unsigned int)m_data.size();
+        m_data.append(text);
+        m_data += '\0';
+        m_offsets[text] = offset;
+        return offset;
+    }
+
+    std::string& data() { return m_data; }
+
+private:
+    std::string m_data;
+    std::unordered_map<std::string, unsigned int> m_offsets;
+};
+
+class CacheBuilder
+{
+public:
+    unsigned int add_string(const char* text)
+    {
+        return m_strings.add(text);
+    }
+
+    // new tests take name, unit and limits from their first record
+    TestColumns& test(STDF_TYPE type, unsigned int number, unsigned short index, bool& created)
+    {
+        unsigned long long key = (unsigned long long)number << 16 | index;
+        std::unordered_map<unsigned long long, unsigned int>::const_iterator it = m_test_index.find(key);
+        created = (it == m_test_index.end());
+        if(!created) return m_tests[it->second];
+
+        m_test_index[key] = (unsigned int)m_tests.size();
+        m_tests.push_back(TestColumns());
+        TestColumns& columns = m_tests.back();
+        std::memset(&columns.test, 0, sizeof(columns.test));
+        columns.test.number = number;
+        columns.test.index = index;
+        columns.test.type = (unsigned short)type;
+        return columns;
+    }
+
+    void set_limits(TestColumns& columns, unsigned char opt_flag, float low, float high, signed char exponent)
+    {
+        // bits 4/6: LO_LIMIT invalid / no low limit, 5/7 the same for HI_LIMIT
+        if((opt_flag & 0x50) == 0) columns.test.limit_flags |= STDF_RESULT_LOW_LIMIT;
+        if((opt_flag & 0xA0) == 0) columns.test.limit_flags |= STDF_RESULT_HIGH_LIMIT;
+        columns.test.low_limit = low;
+        columns.test.high_limit = high;
+        columns.test.result_exponent = exponent;
+    }
+
+    static void add_result(TestColumns& columns, float value, unsigned int part, unsigned char site, unsigned char flags)
+    {
+        columns.values.push_back(value);
+        columns.parts.push_back(part);
+        columns.sites.push_back(site);
+        columns.flags.push_back(flags);
+    }
+
+    unsigned int open_part(unsigned char head, unsigned char site)
+    {
+        StdfResultPart part;
+        std::memset(&part, 0, sizeof(part));
+        part.head = head;
+        part.site = site;
+        unsigned int index = (unsigned int)m_parts.size();
+        m_parts.push_back(part);
+        m_open_parts[(unsigned short)(head << 8 | site)] = index;
+        return index;
+    }
+
+    unsigned int find_part(unsigned char head, unsigned char site) const
+    {
+        std::map<unsigned short, unsigned int>::const_iterator it = m_open_parts.find((unsigned short)(head << 8 | site));
+        return (it == m_open_parts.end()) ? STDF_RESULT_NO_PART : it->second;
+    }
+
+    void close_part(const StdfPRR& prr)
+    {
+        unsigned short key = (unsigned short)(prr.get_head_number() << 8 | prr.get_site_number());
+        std::map<unsigned short, unsigned int>::iterator it = m_open_parts.find(key);
+        if(it == m_open_parts.end()) return;
+        StdfResultPart& part = m_parts[it->second];
+        part.part_id = add_string(prr.get_part_id());
+        part.test_time = prr.get_elapsed_ms();
+        part.hard_bin = prr.get_hardbin_number();
+        part.soft_bin = prr.get_softbin_number();
+        part.x = prr.get_x_coordinate();
+        part.y = prr.get_y_coordinate();
+        part.part_flag = prr.get_part_information_flag();
+        m_open_parts.erase(it);
+    }
+
+    void add_tsr(const StdfTSR& tsr)
+    {
+        std::map<unsigned int, TsrCounts>::iterator it = m_tsr_counts.find(tsr.get_test_number());
+        if(it == m_tsr_counts.end())
+        {
+            TsrCounts counts;
+            std::memset(&counts, 0, sizeof(counts));
+            it = m_tsr_counts.insert(std::make_pair(tsr.get_test_number(), counts)).first;
+        }
+        TsrCounts& counts = it->second;
+        if(!counts.name) counts.name = add_string(tsr.get_test_name());
+        // 0xFFFFFFFF: count not given
+        unsigned int exec_count = tsr.get_exec_count() == 0xFFFFFFFFU ? 0 : tsr.get_exec_count();
+        unsigned int fail_count = tsr.get_fail_count() == 0xFFFFFFFFU ? 0 : tsr.get_fail_count();
+        if(tsr.get_head_number() == 255)
+        {
+            counts.has_summary = true;
+            counts.summary_exec_count = exec_count;
+            counts.summary_fail_count = fail_count;
+        }
+        else
+        {
+            counts.exec_count += exec_count;
+            counts.fail_count += fail_count;
+        }
+    }
+
+    // TSR data into the tests, tests ordered by number and index, columns back to back
+    void finish(std::vector<StdfResultTest>& tests, std::vector<StdfResultPart>& parts, std::string& strings,
+                std::vector<float>& values, std::vector<unsigned int>& part_column,
+                std::vector<unsigned char>& site_column, std::vector<unsigned char>& flag_column)
+    {
+        std::vector<unsigned int> order(m_tests.size());
+        unsigned long long result_count = 0;
+        for(unsigned int i = 0; i < m_tests.size(); i++)
+        {
+            order[i] = i;
+            result_count += m_tests[i].values.size();
+        }
+        std::sort(order.begin(), order.end(), [this](unsigned int a, unsigned int b) {
+            const StdfResultTest& left = m_tests[a].test;
+            const StdfResultTest& right = m_tests[b].test;
+            if(left.number != right.number) return left.number < right.number;
+            return left.index < right.index;
+        });
+
+        tests.clear();
+        tests.reserve(m_tests.size());
+        values.clear();
+        values.reserve(result_count);
+        part_column.clear();
+        part_column.reserve(result_count);
+        site_column.clear();
+        site_column.reserve(result_count);
+        flag_column.clear();
+        flag_column.reserve(result_count);
+        for(unsigned int i = 0; i < order.size(); i++)
+        {
+            TestColumns& columns = m_tests[order[i]];
+            StdfResultTest test = columns.test;
+            std::map<unsigned int, TsrCounts>::const_iterator tsr = m_tsr_counts.find(test.number);
+            if(tsr != m_tsr_counts.end())
+            {
+                const TsrCounts& counts = tsr->second;
+                if(!test.name) test.name = counts.name;
+                test.exec_count = counts.has_summary ? counts.summary_exec_count : (unsigned int)counts.exec_count;
+                test.fail_count = counts.has_summary ? counts.summary_fail_count : (unsigned int)counts.fail_count;
+            }
+            test.first = values.size();
+            test.count = (unsigned int)columns.values.size();
+            tests.push_back(test);
+
+            values.insert(values.end(), columns.values.begin(), columns.values.end());
+            part_column.insert(part_column.end(), columns.parts.begin(), columns.parts.end());
+            site_column.insert(site_column.end(), columns.sites.begin(), columns.sites.end());
+            flag_column.insert(flag_column.end(), columns.flags.begin(), columns.flags.end());
+            // the columns of the test are copied, give their memory back now
+            std::vector<float>().swap(columns.values);
+            std::vector<unsigned int>().swap(columns.parts);
+            std::vector<unsigned char>().swap(columns.sites);
+            std::vector<unsigned char>().swap(columns.flags);
+        }
+        parts.swap(m_parts);
+        strings.swap(m_strings.data());
+    }
+
+private:
+    std::vector<TestColumns> m_tests;
+    // TEST_NUM << 16 | index -> m_tests
+    std::unordered_map<unsigned long long, unsigned int> m_test_index;
+    std::vector<StdfResultPart> m_parts;
+    // head<<8|site -> part opened by a PIR and not yet closed by its PRR
+    std::map<unsigned short, unsigned int> m_open_parts;
+    std::map<unsigned int, TsrCounts> m_tsr_counts;
+    StringTable m_strings;
+};
+
+}
+
+StdfResultCache::StdfResultCache() : m_mapping(nullptr)
+{
+    clear();
+}
+
+StdfResultCache::~StdfResultCache()
+{
+    clear();
+}
+
+std::string StdfResultCache::sidecar_name(const char* filename)
+{
+    return std::string(filename) + ".stdr";
+}
+
+void StdfResultCache::clear()
+{
+    if(m_mapping)
+    {
+        delete m_mapping;
+        m_mapping = nullptr;
+    }
+    m_test_data.clear();
+    m_part_data.clear();
+    m_string_data.assign(1, '\0');
+    m_value_data.clear();
+    m_part_column_data.clear();
+    m_site_column_data.clear();
+    m_flag_column_data.clear();
+    m_source_size = 0;
+    m_source_mtime = 0;
+    set_columns(nullptr, 0, nullptr, 0, m_string_data.data(), m_string_data.size(),
+                nullptr, nullptr, nullptr, nullptr, 0);
+}
+
+bool StdfResultCache::is_mapped() const
+{
+    return m_mapping != nullptr;
+}
+
+void StdfResultCache::set_columns(const StdfResultTest* tests, unsigned int test_count,
+                                  const StdfResultPart* parts, unsigned int part_count,
+                                  const char* strings, unsigned long long string_bytes,
+                                  const float* values, const unsigned int* part_column,
+                                  const unsigned char* site_column, const unsigned char* flag_column,
+                                  unsigned long long result_count)
+{
+    m_tests = tests;
+    m_test_count = test_count;
+    m_parts = parts;
+    m_part_count = part_count;
+    m_strings = strings;
+    m_string_bytes = string_bytes;
+    m_values = values;
+    m_part_column = part_column;
+    m_site_column = site_column;
+    m_flag_column = flag_column;
+    m_result_count = result_count;
+}
+
+STDF_FILE_ERROR StdfResultCache::update(const char* filename)
+{
+    unsigned long long size = 0;
+    long long mtime = 0;
+    if(!source_info(filename, size, mtime)) return READ_ERROR;
+
+    std::string sidecar = sidecar_name(filename);
+    if(open(sidecar.c_str()) == STDF_OPERATE_OK && m_source_size == size && m_source_mtime == mtime)
+    {
+        return STDF_OPERATE_OK;
+    }
+    STDF_FILE_ERROR ret = build(filename);
+    if(ret != STDF_OPERATE_OK) return ret;
+    return save(sidecar.c_str());
+}
+
+STDF_FILE_ERROR StdfResultCache::build(const char* filename)
+{
+    clear();
+    // stat before the mapping: a file growing meanwhile is stamped older than
+    // what was read and fails the check of the next update()
+    if(!source_info(filename, m_source_size, m_source_mtime)) return READ_ERROR;
+    StdfRecordCursor cursor;
+    if(!cursor.open(filename)) return READ_ERROR;
+
+    StdfHeader header;
+    if(!cursor.next(header) || header.get_type() != FAR_TYPE) return FORMATE_ERROR;
+    StdfFAR far_record;
+    far_record.parse(header);
+    if(!STDF_CPU_TYPE_SUPPORTED(far_record.get_cpu_type())) return STDF_CPU_TYPE_NOT_SUPPORT;
+    if(far_record.get_stdf_version() != 4) return STDF_VERSION_NOT_SUPPORT;
+
+    CacheBuilder builder;
+    StdfPIR pir;
+    StdfPRR prr;
+    StdfPTR ptr;
+    StdfMPR mpr;
+    StdfTSR tsr;
+    bool created = false;
+    while(cursor.next(header))
+    {
+        switch(header.get_type())
+        {
+        case PIR_TYPE:
+            pir.parse(header);
+            builder.open_part(pir.get_head_number(), pir.get_site_number());
+            break;
+        case PRR_TYPE:
+            prr.parse(header);
+            builder.close_part(prr);
+            break;
+        case PTR_TYPE:
+        {
+            ptr.parse(header);
+            TestColumns& columns = builder.test(PTR_TYPE, ptr.get_test_number(), STDF_RESULT_NO_INDEX, created);
+            if(created)
+            {
+                columns.test.name = builder.add_string(ptr.get_test_text());
+                // missing fields read as 0, the limits count only if the record has them
+                unsigned int opt_position = 12 + cn_size(ptr.get_test_text()) + cn_size(ptr.get_alarm_id());
+                if(opt_position + 12 <= header.get_length())
+                {
+                    builder.set_limits(columns, ptr.get_optional_data_flag(), ptr.get_low_limit(),
+                                       ptr.get_high_limit(), ptr.get_result_exponent());
+                }
+                columns.test.unit = builder.add_string(ptr.get_unit());
+            }
+            else if(!columns.test.name)
+            {
+                columns.test.name = builder.add_string(ptr.get_test_text());
+            }
+            CacheBuilder::add_result(columns, ptr.get_result(),
+                                     builder.find_part(ptr.get_head_number(), ptr.get_site_number()),
+                                     ptr.get_site_number(), ptr.get_test_flag());
+            break;
+        }
+        case MPR_TYPE:
+        {
+            mpr.parse(header);
+            unsigned int part = builder.find_part(mpr.get_head_number(), mpr.get_site_number());
+            unsigned int opt_position = 12 + (mpr.get_pin_count() + 1) / 2 + 4 * (unsigned int)mpr.get_result_count()
+                                        + cn_size(mpr.get_test_text()) + cn_size(mpr.get_alarm_id());
+            for(unsigned short i = 0; i < mpr.get_result_count() && i < STDF_RESULT_NO_INDEX; i++)
+            {
+                TestColumns& columns = builder.test(MPR_TYPE, mpr.get_test_number(), i, created);
+                if(created)
+                {
+                    columns.test.name = builder.add_string(mpr.get_test_text());
+                    if(opt_position + 12 <= header.get_length())
+                    {
+                        builder.set_limits(columns, mpr.get_optional_data_flag(), mpr.get_low_limit(),
+                                           mpr.get_high_limit(), mpr.get_result_exponent());
+                    }
+                    columns.test.unit = builder.add_string(mpr.get_unit());
+                }
+                CacheBuilder::add_result(columns, mpr.get_return_result(i), part,
+                                         mpr.get_site_number(), mpr.get_test_flag());
+            }
+            break;
+        }
+        case TSR_TYPE:
+            tsr.parse(header);
+            builder.add_tsr(tsr);
+            break;
+        default:
+            break;
+        }
+    }
+    cursor.close();
+
+    builder.finish(m_test_data, m_part_data, m_string_data, m_value_data,
+                   m_part_column_data, m_site_column_data, m_flag_column_data);
+    set_columns(m_test_data.data(), (unsigned int)m_test_data.size(),
+                m_part_data.data(), (unsigned int)m_part_data.size(),
+                m_string_data.data(), m_string_data.size(),
+                m_value_data.data(), m_part_column_data.data(),
+                m_site_column_data.data(), m_flag_column_data.data(), m_value_data.size());
+    return STDF_OPERATE_OK;
+}
+
+// to "<cache>.tmp" and renamed over the cache, readers may have the old one mapped
+STDF_FILE_ERROR StdfResultCache::save(const char* cache_filename) const
+{
+    StdrHeader header;
+    init_header(header, m_test_count, m_part_count, m_result_count, m_string_bytes);
+    header.source_size = m_source_size;
+    header.source_mtime = m_source_mtime;
+
+    struct Section
+    {
+        unsigned long long offset;
+        const void* data;
+        unsigned long long size;
+    };
+    const Section sections[] = {
+        {0, &header, sizeof(header)},
+        {header.tests_offset, m_tests, (unsigned long long)m_test_count * sizeof(StdfResultTest)},
+        {header.parts_offset, m_parts, (unsigned long long)m_part_count * sizeof(StdfResultPart)},
+        {header.strings_offset, m_strings, m_string_bytes},
+        {header.values_offset, m_values, m_result_count * sizeof(float)},
+        {header.part_column_offset, m_part_column, m_result_count * sizeof(unsigned int)},
+        {header.site_column_offset, m_site_column, m_result_count},
+        {header.flag_column_offset, m_flag_column, m_result_count},
+    };
+
+    std::string temp_filename = std::string(cache_filename) + ".tmp";
+    std::ofstream out(temp_filename.c_str(), std::ios::binary | std::ios::trunc);
+    if(!out) return WRITE_ERROR;
+    unsigned long long position = 0;
+    for(unsigned int i = 0; i < sizeof(sections) / sizeof(sections[0]); i++)
+    {
+        pad_to(out, position, sections[i].offset);
+        if(sections[i].size) out.write((const char*)sections[i].data, std::streamsize(sections[i].size));
+        position += sections[i].size;
+    }
+    out.close();
+    return replace_file(temp_filename, cache_filename, !out);
+}
+
+namespace {
+
+// a test of the merged cache and where its results are in the caches
+struct MergedTest
+{
+    StdfResultTest test;
+    unsigned long long count;
+    unsigned long long exec_count;
+    unsigned long long fail_count;
+    // (cache, test of the cache), in the order of the caches
+    std::vector<std::pair<unsigned int, unsigned int> > sources;
+};
+
+}
+
+STDF_FILE_ERROR StdfResultCache::merge(const std::vector<std::string>& cache_filenames, const char* cache_filename)
+{
+    // the caches stay mapped while their columns are copied
+    std::vector<StdfResultCache*> caches;
+    STDF_FILE_ERROR ret = STDF_OPERATE_OK;
+    for(unsigned int i = 0; i < cache_filenames.size() && ret == STDF_OPERATE_OK; i++)
+    {
+        caches.push_back(new StdfResultCache());
+        ret = caches.back()->open(cache_filenames[i].c_str());
+    }
+    if(ret == STDF_OPERATE_OK) ret = write_merged(caches, cache_filename);
+    for(unsigned int i = 0; i < caches.size(); i++) delete caches[i];
+    return ret;
+}
+
+STDF_FILE_ERROR StdfResultCache::write_merged(const std::vector<StdfResultCache*>& caches, const char* cache_filename)
+{
+    StringTable strings;
+    // TEST_NUM << 16 | index, ordered as the tests of a cache
+    std::map<unsigned long long, MergedTest> tests;
+    std::vector<StdfResultPart> parts;
+    std::vector<unsigned int> part_offsets(caches.size());
+    unsigned long long result_count = 0;
+    for(unsigned int c = 0; c < caches.size(); c++)
+    {
+        const StdfResultCache& cache = *caches[c];
+        if(parts.size() + cache.get_part_count() >= STDF_RESULT_NO_PART) return WRITE_ERROR;
+        part_offsets[c] = (unsigned int)parts.size();
+        for(unsigned int p = 0; p < cache.get_part_count(); p++)
+        {
+            StdfResultPart part = cache.get_part(p);
+            part.part_id = strings.add(cache.get_string(part.part_id));
+            parts.push_back(part);
+        }
+
+        for(unsigned int t = 0; t < cache.get_test_count(); t++)
+        {
+            const StdfResultTest& test = cache.get_test(t);
+            unsigned long long key = (unsigned long long)test.number << 16 | test.index;
+            std::map<unsigned long long, MergedTest>::iterator it = tests.find(key);
+            if(it == tests.end())
+            {
+                MergedTest merged;
+                merged.test = test;
+                merged.test.name = 0;
+                merged.test.unit = 0;
+                merged.test.limit_flags = 0;
+                merged.count = merged.exec_count = merged.fail_count = 0;
+                it = tests.insert(std::make_pair(key, merged)).first;
+            }
+            // name, unit and limits of the first cache that has them
+            MergedTest& merged = it->second;
+            if(!merged.test.name) merged.test.name = strings.add(cache.get_string(test.name));
+            if(!merged.test.unit) merged.test.unit = strings.add(cache.get_string(test.unit));
+            if(!merged.test.limit_flags && test.limit_flags)
+            {
+                merged.test.limit_flags = test.limit_flags;
+                merged.test.low_limit = test.low_limit;
+                merged.test.high_limit = test.high_limit;
+                merged.test.result_exponent = test.result_exponent;
+            }
+            merged.count += test.count;
+            merged.exec_count += test.exec_count;
+            merged.fail_count += test.fail_count;
+            merged.sources.push_back(std::make_pair(c, t));
+            result_count += test.count;
+        }
+    }
+
+    std::vector<StdfResultTest> test_data;
+    test_data.reserve(tests.size());
+    unsigned long long first = 0;
+    for(std::map<unsigned long long, MergedTest>::iterator it = tests.begin(); it != tests.end(); ++it)
+    {
+        MergedTest& merged = it->second;
+        if(merged.count > 0xFFFFFFFFULL) return WRITE_ERROR;
+        merged.test.first = first;
+        merged.test.count = (unsigned int)merged.count;
+        merged.test.exec_count = (unsigned int)std::min(merged.exec_count, 0xFFFFFFFFULL);
+        merged.test.fail_count = (unsigned int)std::min(merged.fail_count, 0xFFFFFFFFULL);
+        test_data.push_back(merged.test);
+        first += merged.count;
+    }
+
+    StdrHeader header;
+    init_header(header, (unsigned int)test_data.size(), (unsigned int)parts.size(),
+                result_count, strings.data().size());
+
+    std::string temp_filename = std::string(cache_filename) + ".tmp";
+    std::ofstream out(temp_filename.c_str(), std::ios::binary | std::ios::trunc);
+    if(!out) return WRITE_ERROR;
+    unsigned long long position = 0;
+    out.write((const char*)&header, sizeof(header));
+    position += sizeof(header);
+    pad_to(out, position, header.tests_offset);
+    out.write((const char*)test_data.data(), std::streamsize(test_data.size() * sizeof(StdfResultTest)));
+    position += test_data.size() * sizeof(StdfResultTest);
+    pad_to(out, position, header.parts_offset);
+    out.write((const char*)parts.data(), std::streamsize(parts.size() * sizeof(StdfResultPart)));
+    position += parts.size() * sizeof(StdfResultPart);
+    pad_to(out, position, header.strings_offset);
+    out.write(strings.data().data(), std::streamsize(strings.data().size()));
+    position += strings.data().size();
+
+    // the columns straight from the mappings, test by test, the parts renumbered
+    std::vector<unsigned int> part_block;
+    for(unsigned int column = 0; column < 4 && out; column++)
+    {
+        const unsigned long long offset = (column == 0) ? header.values_offset :
+                                          (column == 1) ? header.part_column_offset :
+                                          (column == 2) ? header.site_column_offset : header.flag_column_offset;
+        pad_to(out, position, offset);
+        for(std::map<unsigned long long, MergedTest>::const_iterator it = tests.begin(); it != tests.end(); ++it)
+        {
+            const std::vector<std::pair<unsigned int, unsigned int> >& sources = it->second.sources;
+            for(unsigned int i = 0; i < sources.size(); i++)
+            {
+                const StdfResultCache& cache = *caches[sources[i].first];
+                unsigned int test = sources[i].second;
+                unsigned int count = cache.get_test(test).count;
+                if(column == 0)
+                {
+                    out.write((const char*)cache.get_values(test), std::streamsize(count * sizeof(float)));
+                    position += count * sizeof(float);
+                }
+                else if(column == 1)
+                {
+                    const unsigned int* part_column = cache.get_parts(test);
+                    const unsigned int part_offset = part_offsets[sources[i].first];
+                    part_block.resize(count);
+                    for(unsigned int n = 0; n < count; n++)
+                    {
+                        part_block[n] = (part_column[n] == STDF_RESULT_NO_PART) ? STDF_RESULT_NO_PART : part_column[n] + part_offset;
+                    }
+                    out.write((const char*)part_block.data(), std::streamsize(count * sizeof(unsigned int)));
+                    position += count * sizeof(unsigned int);
+                }
+                else
+                {
+                    const unsigned char* bytes = (column == 2) ? cache.get_sites(test) : cache.get_flags(test);
+                    out.write((const char*)bytes, std::streamsize(count));
+                    position += count;
+                }
+            }
+        }
+    }
+    out.close();
+    return replace_file(temp_filename, cache_filename, !out);
+}
+
+// the tests and parts of a cache whose sections are inside the file: columns of
+// every test inside the result columns, tests sorted for find_test, strings inside
+static bool valid_entries(const StdrHeader& header, const char* data)
+{
+    const StdfResultTest* tests = (const StdfResultTest*)(data + header.tests_offset);
+    for(unsigned int i = 0; i < header.test_count; i++)
+    {
+        const StdfResultTest& test = tests[i];
+        if(test.first > header.result_count || test.count > header.result_count - test.first) return false;
+        if(test.name >= header.string_bytes || test.unit >= header.string_bytes) return false;
+        if(i > 0)
+        {
+            const StdfResultTest& previous = tests[i - 1];
+            if(previous.number > test.number || (previous.number == test.number && previous.index >= test.index)) return false;
+        }
+    }
+    const StdfResultPart* parts = (const StdfResultPart*)(data + header.parts_offset);
+    for(unsigned int i = 0; i < header.part_count; i++)
+    {
+        if(parts[i].part_id >= header.string_bytes) return false;
+    }
+    return true;
+}
+
+STDF_FILE_ERROR StdfResultCache::open(const char* cache_filename)
+{
+    clear();
+    // the cursor only maps the file here, no records are read through it
+    StdfRecordCursor* mapping = new StdfRecordCursor();
+    if(!mapping->open(cache_filename))
+    {
+        delete mapping;
+        return READ_ERROR;
+    }
+    const char* data = mapping->data();
+    unsigned long long size = mapping->size();
+
+    StdrHeader header;
+    bool valid = size >= sizeof(header);
+    if(valid)
+    {
+        std::memcpy(&header, data, sizeof(header));
+        valid = std::memcmp(header.magic, STDR_MAGIC, 4) == 0 && header.version == STDR_VERSION;
+    }
+    // every section inside the file and aligned for its type
+    if(valid)
+    {
+        const unsigned long long sections[][2] = {
+            {header.tests_offset, (unsigned long long)header.test_count * sizeof(StdfResultTest)},
+            {header.parts_offset, (unsigned long long)header.part_count * sizeof(StdfResultPart)},
+            {header.strings_offset, header.string_bytes},
+            {header.values_offset, header.result_count * sizeof(float)},
+            {header.part_column_offset, header.result_count * sizeof(unsigned int)},
+            {header.site_column_offset, header.result_count},
+            {header.flag_column_offset, header.result_count},
+        };
+        for(unsigned int i = 0; i < sizeof(sections) / sizeof(sections[0]) && valid; i++)
+        {
+            valid = (sections[i][0] % 8 == 0) && sections[i][0] <= size && sections[i][1] <= size - sections[i][0];
+        }
+        valid = valid && header.string_bytes > 0 && data[header.strings_offset + header.string_bytes - 1] == '\0';
+        valid = valid && valid_entries(header, data);
+    }
+    if(!valid)
+    {
+        delete mapping;
+        return FORMATE_ERROR;
+    }
+
+    m_mapping = mapping;
+    m_source_size = header.source_size;
+    m_source_mtime = header.source_mtime;
+    set_columns((const StdfResultTest*)(data + header.tests_offset), header.test_count,
+                (const StdfResultPart*)(data + header.parts_offset), header.part_count,
+                data + header.strings_offset, header.string_bytes,
+                (const float*)(data + header.values_offset),
+                (const unsigned int*)(data + header.part_column_offset),
+                (const unsigned char*)(data + header.site_column_offset),
+                (const unsigned char*)(data + header.flag_column_offset), header.result_count);
+    return STDF_OPERATE_OK;
+}
+
+unsigned int StdfResultCache::get_test_count() const
+{
+    return m_test_count;
+}
+
+const StdfResultTest& StdfResultCache::get_test(unsigned int test) const
+{
+    return m_tests[test];
+}
+
+int StdfResultCache::find_test(unsigned int number, unsigned short index) const
+{
+    unsigned int low = 0, high = m_test_count;
+    while(low < high)
+    {
+        unsigned int mid = low + (high - low) / 2;
+        const StdfResultTest& test = m_tests[mid];
+        if(test.number < number || (test.number == number && test.index < index)) low = mid + 1;
+        else high = mid;
+    }
+    if(low < m_test_count && m_tests[low].number == number && m_tests[low].index == index) return int(low);
+    return -1;
+}
+
+const char* StdfResultCache::get_string(unsigned int offset) const
+{
+    if(offset >= m_string_bytes) return "";
+    return m_strings + offset;
+}
+
+const float* StdfResultCache::get_values(unsigned int test) const
+{
+    return m_values + m_tests[test].first;
+}
+
+const unsigned int* StdfResultCache::get_parts(unsigned int test) const
+{
+    return m_part_column + m_tests[test].first;
+}
+
+const unsigned char* StdfResultCache::get_sites(unsigned int test) const
+{
+    return m_site_column + m_tests[test].first;
+}
+
+const unsigned char* StdfResultCache::get_flags(unsigned int test) const
+{
+    return m_flag_column + m_tests[test].first;
+}
+
+unsigned long long StdfResultCache::get_result_count() const
+{
+    return m_result_count;
+}
+
+unsigned int StdfResultCache::get_part_count() const
+{
+    return m_part_count;
+}
+
+const StdfResultPart& StdfResultCache::get_part(unsigned int part) const
+{
+    return m_parts[part];
+}
+
+StdfResultStats StdfResultCache::get_stats(unsigned int test, int site) const
+{
+    const StdfResultTest& info = m_tests[test];
+    const float* values = get_values(test);
+    const unsigned char* flags = get_flags(test);
+    const unsigned char* sites = get_sites(test);
+    const unsigned int count = info.count;
+    const bool all_sites = site < 0;
+    const unsigned char site_value = (unsigned char)site;
+
+    StdfResultStats stats;
+    std::memset(&stats, 0, sizeof(stats));
+
+    // first pass: count, sum, min, max
+    double sums[LANES] = {0};
+    float mins[LANES], maxs[LANES];
+    unsigned int kept[LANES] = {0}, selected[LANES] = {0};
+    for(unsigned int l = 0; l < LANES; l++)
+    {
+        mins[l] = std::numeric_limits<float>::infinity();
+        maxs[l] = -std::numeric_limits<float>::infinity();
+    }
+    unsigned int i = 0;
+    for(; i + LANES <= count; i += LANES)
+    {
+        for(unsigned int l = 0; l < LANES; l++)
+        {
+            float value = values[i + l];
+            unsigned int keep = keep_result(value, flags[i + l], sites[i + l], all_sites, site_value);
+            selected[l] += (unsigned int)(all_sites | (sites[i + l] == site_value));
+            kept[l] += keep;
+            sums[l] += keep ? value : 0.0f;
+            mins[l] = (keep && value < mins[l]) ? value : mins[l];
+            maxs[l] = (keep && value > maxs[l]) ? value : maxs[l];
+        }
+    }
+    for(; i < count; i++)
+    {
+        float value = values[i];
+        unsigned int keep = keep_result(value, flags[i], sites[i], all_sites, site_value);
+        selected[0] += (unsigned int)(all_sites | (sites[i] == site_value));
+        kept[0] += keep;
+        sums[0] += keep ? value : 0.0f;
+        mins[0] = (keep && value < mins[0]) ? value : mins[0];
+        maxs[0] = (keep && value > maxs[0]) ? value : maxs[0];
+    }
+    double sum = 0;
+    stats.min = mins[0];
+    stats.max = maxs[0];
+    for(unsigned int l = 0; l < LANES; l++)
+    {
+        stats.count += selected[l];
+        stats.valid += kept[l];
+        sum += sums[l];
+        stats.min = std::min(stats.min, mins[l]);
+        stats.max = std::max(stats.max, maxs[l]);
+    }
+    if(stats.valid == 0)
+    {
+        stats.min = stats.max = 0;
+        return stats;
+    }
+    stats.mean = sum / double(stats.valid);
+
+    // second pass: squared deviations from the mean
+    double squares[LANES] = {0};
+    const double mean = stats.mean;
+    for(i = 0; i + LANES <= count; i += LANES)
+    {
+        for(unsigned int l = 0; l < LANES; l++)
+        {
+            double deviation = double(values[i + l]) - mean;
+            unsigned int keep = keep_result(values[i + l], flags[i + l], sites[i + l], all_sites, site_value);
+            squares[l] += keep ? deviation * deviation : 0.0;
+        }
+    }
+    for(; i < count; i++)
+    {
+        double deviation = double(values[i]) - mean;
+        unsigned int keep = keep_result(values[i], flags[i], sites[i], all_sites, site_value);
+        squares[0] += keep ? deviation * deviation : 0.0;
+    }
+    double square_sum = 0;
+    for(unsigned int l = 0; l < LANES; l++) square_sum += squares[l];
+    stats.sigma = (stats.valid > 1) ? std::sqrt(square_sum / double(stats.valid - 1)) : 0.0;
+
+    bool has_low = (info.limit_flags & STDF_RESULT_LOW_LIMIT) != 0;
+    bool has_high = (info.limit_flags & STDF_RESULT_HIGH_LIMIT) != 0;
+    check_limits(test, has_low ? info.low_limit : -std::numeric_limits<float>::infinity(),
+                 has_high ? info.high_limit : std::numeric_limits<float>::infinity(),
+                 stats.below_low, stats.above_high, site);
+
+    if(stats.sigma > 0 && (has_low || has_high))
+    {
+        double cpk_low = has_low ? (stats.mean - info.low_limit) / (3 * stats.sigma) : std::numeric_limits<double>::infinity();
+        double cpk_high = has_high ? (info.high_limit - stats.mean) / (3 * stats.sigma) : std::numeric_limits<double>::infinity();
+        stats.cpk = std::min(cpk_low, cpk_high);
+        stats.has_cpk = true;
+    }
+    return stats;
+}
+
+void StdfResultCache::check_limits(unsigned int test, float low, float high,
+                                   unsigned long long& below, unsigned long long& above, int site) const
+{
+    const float* values = get_values(test);
+    const unsigned char* flags = get_flags(test);
+    const unsigned char* sites = get_sites(test);
+    const unsigned int count = m_tests[test].count;
+    const bool all_sites = site < 0;
+    const unsigned char site_value = (unsigned char)site;
+
+    unsigned int belows[LANES] = {0}, aboves[LANES] = {0};
+    unsigned int i = 0;
+    for(; i + LANES <= count; i += LANES)
+    {
+        for(unsigned int l = 0; l < LANES; l++)
+        {
+            float value = values[i + l];
+            unsigned int keep = keep_result(value, flags[i + l], sites[i + l], all_sites, site_value);
+            belows[l] += keep & (unsigned int)(value < low);
+            aboves[l] += keep & (unsigned int)(value > high);
+        }
+    }
+    for(; i < count; i++)
+    {
+        float value = values[i];
+        unsigned int keep = keep_result(value, flags[i], sites[i], all_sites, site_value);
+        belows[0] += keep & (unsigned int)(value < low);
+        aboves[0] += keep & (unsigned int)(value > high);
+    }
+    below = 0;
+    above = 0;
+    for(unsigned int l = 0; l < LANES; l++)
+    {
+        below += belows[l];
+        above += aboves[l];
+    }
+}
+
+unsigned long long StdfResultCache::get_histogram(unsigned int test, float low, float high,
+                                                  unsigned int* bins, unsigned int bin_count, int site) const
+{
+    if(bin_count == 0 || !(high > low)) return 0;
+    const float* values = get_values(test);
+    const unsigned char* flags = get_flags(test);
+    const unsigned char* sites = get_sites(test);
+    const unsigned int count = m_tests[test].count;
+    const bool all_sites = site < 0;
+    const unsigned char site_value = (unsigned char)site;
+    const double scale = double(bin_count) / (double(high) - double(low));
+
+    unsigned long long in_range = 0;
+    for(unsigned int i = 0; i < count; i++)
+    {
+        float value = values[i];
+        if(!keep_result(value, flags[i], sites[i], all_sites, site_value)) continue;
+        if(!(value >= low && value < high)) continue;
+        unsigned int bin = (unsigned int)((double(value) - double(low)) * scale);
+        if(bin >= bin_count) bin = bin_count - 1;
+        bins[bin]++;
+        in_range++;
+    }
+    return in_range;
+}
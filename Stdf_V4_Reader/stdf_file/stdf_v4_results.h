@@ -0,0 +1,166 @@
+/*************************************************************************
+ * Columnar cache of the parametric results of a stdf file, kept in a
+ * ".stdr" sidecar file that is used memory-mapped.
+ * The PTR/MPR tests are a dictionary (number, MPR result index, name,
+ * unit, limits, TSR counts) and the results of each test are contiguous
+ * columns: value, part, site and test flags. Statistics, limit checks and
+ * histograms of a test are then plain loops over one float array.
+*************************************************************************/
+#ifndef _STDF_V4_RESULTS_H_
+#define _STDF_V4_RESULTS_H_
+
+#include "stdf_v4_file.h"
+#include <string>
+#include <vector>
+
+#define STDF_RESULT_NO_PART 0xFFFFFFFFU
+// index of PTR tests, MPR tests have the index of the result in RTN_RSLT
+#define STDF_RESULT_NO_INDEX 0xFFFF
+// TEST_FLG bits of results left out of statistics: result invalid, not executed, aborted
+#define STDF_RESULT_INVALID_FLAGS 0x32
+// StdfResultTest::limit_flags
+#define STDF_RESULT_LOW_LIMIT 0x1
+#define STDF_RESULT_HIGH_LIMIT 0x2
+
+// Sidecar layout (byte order of the machine that wrote it), sections 8 byte aligned:
+//   StdrHeader, tests, parts, strings, then the columns of all tests back to back:
+//   float values, U4 parts, U1 sites, U1 test flags
+// Strings are 0 terminated in one block, offset 0 is the empty string.
+struct StdfResultTest
+{
+    unsigned long long first;       // first result in the columns
+    unsigned int count;             // results of the test
+    unsigned int number;            // TEST_NUM
+    unsigned int name;              // string offset of TEST_TXT, else the TSR TEST_NAM
+    unsigned int unit;              // string offset of UNITS
+    unsigned int exec_count;        // from the TSRs, 0 without
+    unsigned int fail_count;
+    float low_limit;                // from the first record of the test
+    float high_limit;
+    unsigned short type;            // PTR_TYPE or MPR_TYPE
+    unsigned short index;           // STDF_RESULT_NO_INDEX for PTRs
+    unsigned char limit_flags;      // STDF_RESULT_LOW_LIMIT | STDF_RESULT_HIGH_LIMIT
+    signed char result_exponent;    // RES_SCAL
+    unsigned char reserved[2];
+};
+
+struct StdfResultPart
+{
+    unsigned int part_id;           // string offset of PART_ID
+    unsigned int test_time;         // TEST_T in ms
+    unsigned short hard_bin;
+    unsigned short soft_bin;
+    short x;
+    short y;
+    unsigned char head;
+    unsigned char site;
+    unsigned char part_flag;        // PART_FLG
+    unsigned char reserved;
+};
+
+struct StdfResultStats
+{
+    unsigned long long count;       // results of the selected sites
+    unsigned long long valid;       // of these without STDF_RESULT_INVALID_FLAGS and not NaN
+    double mean;
+    double sigma;
+    float min;
+    float max;
+    unsigned long long below_low;   // valid results below the low limit of the test
+    unsigned long long above_high;
+    bool has_cpk;                   // a limit and sigma > 0
+    double cpk;                     // one sided with only one limit
+};
+
+class StdfResultCache
+{
+public:
+    StdfResultCache();
+    ~StdfResultCache();
+
+    // "<filename>.stdr"
+    static std::string sidecar_name(const char* filename);
+
+    // Opens the sidecar of filename if it was built from the file at its current
+    // size and modification time, otherwise builds the cache and saves the sidecar.
+    STDF_FILE_ERROR update(const char* filename);
+    // Only in memory, from the PIR/PRR/PTR/MPR/TSR records of the file.
+    STDF_FILE_ERROR build(const char* filename);
+    STDF_FILE_ERROR save(const char* cache_filename) const;
+    // One cache of several, the sidecars of the files of a lot: the tests of all of
+    // them by number and index, each with the results of the caches in the given
+    // order, and the parts numbered through. Name, unit and limits of a test come from
+    // the first cache that has them, the TSR counts are summed. The columns are copied
+    // from the mapped caches to cache_filename, the merged cache is not kept in memory;
+    // it has no source file, open() it.
+    static STDF_FILE_ERROR merge(const std::vector<std::string>& cache_filenames, const char* cache_filename);
+    // Maps the sidecar, the columns are read from the file pages.
+    STDF_FILE_ERROR open(const char* cache_filename);
+    void clear();
+    bool is_mapped() const;
+
+    // tests are sorted by number and index
+    unsigned int get_test_count() const;
+    const StdfResultTest& get_test(unsigned int test) const;
+    // -1 if the file has no such test
+    int find_test(unsigned int number, unsigned short index = STDF_RESULT_NO_INDEX) const;
+    const char* get_string(unsigned int offset) const;
+
+    // the columns of one test, get_test(test).count entries each
+    const float* get_values(unsigned int test) const;
+    const unsigned int* get_parts(unsigned int test) const;     // STDF_RESULT_NO_PART outside of a PIR/PRR
+    const unsigned char* get_sites(unsigned int test) const;
+    const unsigned char* get_flags(unsigned int test) const;    // TEST_FLG
+    unsigned long long get_result_count() const;
+
+    unsigned int get_part_count() const;
+    const StdfResultPart& get_part(unsigned int part) const;
+
+    // site -1 for all sites
+    StdfResultStats get_stats(unsigned int test, int site = -1) const;
+    // valid results outside of other limits than the ones of the test
+    void check_limits(unsigned int test, float low, float high,
+                      unsigned long long& below, unsigned long long& above, int site = -1) const;
+    // adds the valid results in [low, high) to bins[bin_count], returns how many were in range
+    unsigned long long get_histogram(unsigned int test, float low, float high,
+                                     unsigned int* bins, unsigned int bin_count, int site = -1) const;
+
+private:
+    static STDF_FILE_ERROR write_merged(const std::vector<StdfResultCache*>& caches, const char* cache_filename);
+    void set_columns(const StdfResultTest* tests, unsigned int test_count,
+                     const StdfResultPart* parts, unsigned int part_count,
+                     const char* strings, unsigned long long string_bytes,
+                     const float* values, const unsigned int* part_column,
+                     const unsigned char* site_column, const unsigned char* flag_column,
+                     unsigned long long result_count);
+    StdfResultCache(const StdfResultCache& src);
+    StdfResultCache& operator=(const StdfResultCache& src);
+
+private:
+    // the built cache, empty when mapped
+    std::vector<StdfResultTest> m_test_data;
+    std::vector<StdfResultPart> m_part_data;
+    std::string m_string_data;
+    std::vector<float> m_value_data;
+    std::vector<unsigned int> m_part_column_data;
+    std::vector<unsigned char> m_site_column_data;
+    std::vector<unsigned char> m_flag_column_data;
+    unsigned long long m_source_size;
+    long long m_source_mtime;
+    StdfRecordCursor* m_mapping;
+
+    // point into the vectors or the mapping
+    const StdfResultTest* m_tests;
+    unsigned int m_test_count;
+    const StdfResultPart* m_parts;
+    unsigned int m_part_count;
+    const char* m_strings;
+    unsigned long long m_string_bytes;
+    const float* m_values;
+    const unsigned int* m_part_column;
+    const unsigned char* m_site_column;
+    const unsigned char* m_flag_column;
+    unsigned long long m_result_count;
+};
+
+#endif//_STDF_V4_RESULTS_H_
@@ -0,0 +1,201 @@
+#include "stdf_v4_tail.h"
+#include <sys/stat.h>
+
+// bytes read from the file per step, memory stays at this plus one cut record
+#define STDF_TAIL_CHUNK (1U << 20)
+
+StdfTailReader::StdfTailReader(const char* filename, unsigned long long offset) : m_filename(filename)
+{
+    for(unsigned int i = 0; i < STDF_V4_RECORD_COUNT; i++) m_records[i] = nullptr;
+    m_generation = 0;
+    m_record_count = 0;
+    m_file_id = 0;
+    m_end = STDF_TAIL_NO_END;
+    restart();
+    m_read_offset = offset;
+    m_offset = offset;
+}
+
+StdfTailReader::~StdfTailReader()
+{
+    close();
+    for(unsigned int i = 0; i < STDF_V4_RECORD_COUNT; i++)
+    {
+        delete m_records[i];
+    }
+}
+
+void StdfTailReader::set_end(unsigned long long end)
+{
+    m_end = end;
+}
+
+void StdfTailReader::close()
+{
+    if(m_stream.is_open()) m_stream.close();
+    m_stream.clear();
+}
+
+void StdfTailReader::restart()
+{
+    close();
+    m_read_offset = 0;
+    m_offset = 0;
+    m_far_checked = false;
+    m_swapped = false;
+    m_complete = false;
+    m_buffer.clear();
+}
+
+STDF_FILE_ERROR StdfTailReader::reopen_if_replaced()
+{
+    struct stat info;
+    if(stat(m_filename.c_str(), &info) != 0) return READ_ERROR;
+    unsigned long long file_id = (unsigned long long)info.st_ino;
+    unsigned long long file_size = (unsigned long long)info.st_size;
+
+    // rsync without --inplace renames a new file over the old one,
+    // a rewrite in place shows up as a file shorter than what was read
+    if(m_stream.is_open() && (file_id != m_file_id || file_size < m_read_offset))
+    {
+        restart();
+        m_generation++;
+    }
+    if(!m_stream.is_open())
+    {
+        m_stream.open(m_filename.c_str(), std::ios::in | std::ios::binary);
+        if(!m_stream) return READ_ERROR;
+        m_file_id = file_id;
+    }
+    return STDF_OPERATE_OK;
+}
+
+// FAR: REC_LEN 2, REC_TYP 0, REC_SUB 10, CPU_TYPE, STDF_VER. Until the file
+// has these 6 bytes m_far_checked stays false and the poll reads nothing.
+STDF_FILE_ERROR StdfTailReader::read_far()
+{
+    unsigned char far_data[6];
+    m_stream.clear();
+    m_stream.seekg(0);
+    m_stream.read((char*)far_data, sizeof(far_data));
+    if(m_stream.gcount() != std::streamsize(sizeof(far_data)))
+    {
+        return m_stream.bad() ? READ_ERROR : STDF_OPERATE_OK;
+    }
+    if(far_data[2] != 0 || far_data[3] != 10) return FORMATE_ERROR;
+    if(!STDF_CPU_TYPE_SUPPORTED(far_data[4])) return STDF_CPU_TYPE_NOT_SUPPORT;
+    if(far_data[5] != 4) return STDF_VERSION_NOT_SUPPORT;
+    m_swapped = (far_data[4] != STDF_HOST_CPU_TYPE);
+    m_far_checked = true;
+    return STDF_OPERATE_OK;
+}
+
+STDF_FILE_ERROR StdfTailReader::read_new_data()
+{
+    if(m_read_offset >= m_end) return STDF_OPERATE_OK;
+    size_t chunk = (m_end - m_read_offset < STDF_TAIL_CHUNK) ? (size_t)(m_end - m_read_offset) : STDF_TAIL_CHUNK;
+    size_t used = m_buffer.size();
+    m_buffer.resize(used + chunk);
+    m_stream.clear();
+    m_stream.seekg(std::streamoff(m_read_offset));
+    m_stream.read(&m_buffer[used], std::streamsize(chunk));
+    size_t count = (size_t)m_stream.gcount();
+    m_buffer.resize(used + count);
+    m_read_offset += count;
+    if(count == 0 && m_stream.bad()) return READ_ERROR;
+    return STDF_OPERATE_OK;
+}
+
+STDF_FILE_ERROR StdfTailReader::poll(StdfRecordVisitor& visitor, unsigned int type_mask)
+{
+    return poll_records(&visitor, nullptr, type_mask);
+}
+
+STDF_FILE_ERROR StdfTailReader::poll(std::vector<StdfRecord*>& records, unsigned int type_mask)
+{
+    return poll_records(nullptr, &records, type_mask);
+}
+
+STDF_FILE_ERROR StdfTailReader::poll_records(StdfRecordVisitor* visitor, std::vector<StdfRecord*>* records, unsigned int type_mask)
+{
+    STDF_FILE_ERROR ret = reopen_if_replaced();
+    if(ret != STDF_OPERATE_OK) return ret;
+    if(!m_far_checked)
+    {
+        ret = read_far();
+        if(ret != STDF_OPERATE_OK || !m_far_checked) return ret;
+    }
+
+    StdfHeader header;
+    bool stop = m_complete;
+    while(!stop)
+    {
+        unsigned long long read_offset = m_read_offset;
+        ret = read_new_data();
+        if(ret != STDF_OPERATE_OK) return ret;
+        bool more_data = (m_read_offset != read_offset);
+
+        size_t pos = 0;
+        while(!stop && pos < m_buffer.size() && header.map(&m_buffer[pos], m_buffer.size() - pos, m_swapped))
+        {
+            STDF_TYPE type = header.get_type();
+            unsigned long long record_offset = m_offset + pos;
+            pos += 4U + header.get_length();
+            m_record_count++;
+            if(type < STDF_V4_RECORD_COUNT && (type_mask & STDF_TYPE_MASK(type)))
+            {
+                if(records)
+                {
+                    StdfRecord* record = header.create_record(type);
+                    record->parse(header);
+                    records->push_back(record);
+                }
+                else
+                {
+                    if(m_records[type] == nullptr) m_records[type] = header.create_record(type);
+                    m_records[type]->parse(header);
+                    if(!visitor->visit(m_records[type], record_offset)) stop = true;
+                }
+            }
+            if(type == MRR_TYPE)
+            {
+                m_complete = true;
+                stop = true;
+            }
+        }
+        m_buffer.erase(m_buffer.begin(), m_buffer.begin() + pos);
+        m_offset += pos;
+        if(!more_data) break;
+    }
+    return STDF_OPERATE_OK;
+}
+
+const char* StdfTailReader::filename() const
+{
+    return m_filename.c_str();
+}
+
+unsigned long long StdfTailReader::offset() const
+{
+    return m_offset;
+}
+
+unsigned int StdfTailReader::pending() const
+{
+    return m_buffer.size();
+}
+
+bool StdfTailReader::is_complete() const
+{
+    return m_complete;
+}
+
+unsigned int StdfTailReader::generation() const
+{
+    return m_generation;
+}
+
+unsigned long long StdfTailReader::record_count() const
+{
+    return m_record_count;
+}
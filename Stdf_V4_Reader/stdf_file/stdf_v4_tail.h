@@ -0,0 +1,75 @@
+/*************************************************************************
+ * Follows a stdf file that is still being written (rsync --append, tester
+ * datalog). The file stays open between polls, every poll reads only what
+ * the file gained and hands out the records completed by it. A record cut
+ * by the end of the data is kept and finished by a later poll.
+*************************************************************************/
+#ifndef _STDF_V4_TAIL_H_
+#define _STDF_V4_TAIL_H_
+
+#include "stdf_v4_file.h"
+#include <fstream>
+#include <string>
+#include <vector>
+
+#define STDF_TAIL_NO_END (~0ULL)
+
+class StdfTailReader
+{
+public:
+    // offset: start behind records handled before (e.g. by a StdfIndex lookup),
+    // it has to be a record boundary. The FAR at the start of the file is read
+    // in any case, its CPU_TYPE gives the byte order (1 is swapped on the fly).
+    explicit StdfTailReader(const char* filename, unsigned long long offset = 0);
+    ~StdfTailReader();
+
+    // Records completed since the last poll go to the visitor, the record objects
+    // are reused as in STDF_FILE::scan.
+    STDF_FILE_ERROR poll(StdfRecordVisitor& visitor, unsigned int type_mask = STDF_ALL_TYPES_MASK);
+    // Same, the new records are appended to records and belong to the caller.
+    STDF_FILE_ERROR poll(std::vector<StdfRecord*>& records, unsigned int type_mask = STDF_ALL_TYPES_MASK);
+    // polls read no further than end bytes of the file, e.g. the size a sync
+    // reported; STDF_TAIL_NO_END (default) for all there is
+    void set_end(unsigned long long end);
+    void close();
+
+    const char* filename() const;
+    // file offset behind the last complete record
+    unsigned long long offset() const;
+    // bytes of a cut record waiting for the rest
+    unsigned int pending() const;
+    // MRR seen, the file is complete
+    bool is_complete() const;
+    // counts the restarts from offset 0 after the file was replaced or truncated,
+    // records already handed out come once more after a restart
+    unsigned int generation() const;
+    // records gone through since construction, skipped ones and those read
+    // again after a restart included
+    unsigned long long record_count() const;
+
+private:
+    STDF_FILE_ERROR reopen_if_replaced();
+    STDF_FILE_ERROR read_far();
+    STDF_FILE_ERROR read_new_data();
+    STDF_FILE_ERROR poll_records(StdfRecordVisitor* visitor, std::vector<StdfRecord*>* records, unsigned int type_mask);
+    void restart();
+    StdfTailReader(const StdfTailReader& src);
+    StdfTailReader& operator=(const StdfTailReader& src);
+
+private:
+    std::string m_filename;
+    std::ifstream m_stream;
+    unsigned long long m_file_id;    // inode of the open file, 0 where unknown
+    unsigned long long m_read_offset; // bytes read from the file
+    unsigned long long m_end;
+    unsigned long long m_offset;
+    bool m_far_checked;
+    bool m_swapped;                 // file not in host byte order
+    bool m_complete;
+    unsigned int m_generation;
+    unsigned long long m_record_count;
+    std::vector<char> m_buffer;     // data from m_offset to m_read_offset
+    StdfRecord* m_records[STDF_V4_RECORD_COUNT];
+};
+
+#endif//_STDF_V4_TAIL_H_
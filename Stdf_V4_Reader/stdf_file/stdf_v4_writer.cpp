@@ -0,0 +1,195 @@
+#include "stdf_v4_writer.h"
+#include <zlib.h>
+#ifdef STDF_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+StdfWriter::StdfWriter(unsigned int buffer_size)
+{
+    // one record of the largest size has to fit
+    if(buffer_size < 4U + 65535U) buffer_size = 4U + 65535U;
+    m_buffer.resize(buffer_size);
+    m_compression = STDF_COMPRESS_NONE;
+    m_file = nullptr;
+    m_gzip = nullptr;
+    m_zstd = nullptr;
+    m_used = 0;
+    m_failed = false;
+    m_records = 0;
+    m_bytes = 0;
+}
+
+StdfWriter::~StdfWriter()
+{
+    close();
+}
+
+STDF_FILE_ERROR StdfWriter::open(const char* filename, STDF_COMPRESSION compression, int level)
+{
+    close();
+    m_compression = compression;
+    m_used = 0;
+    m_failed = false;
+    m_records = 0;
+    m_bytes = 0;
+
+    switch(compression)
+    {
+    case STDF_COMPRESS_NONE:
+        m_file = std::fopen(filename, "wb");
+        if(!m_file) return WRITE_ERROR;
+        // the blocks are large already, stdio would only copy them once more
+        std::setvbuf(m_file, nullptr, _IONBF, 0);
+        return STDF_OPERATE_OK;
+
+    case STDF_COMPRESS_GZIP:
+    {
+        char mode[4] = "wb";
+        if(level >= 0 && level <= 9) mode[2] = char('0' + level);
+        gzFile gz = gzopen(filename, mode);
+        if(!gz) return WRITE_ERROR;
+        gzbuffer(gz, 256U * 1024U);
+        m_gzip = gz;
+        return STDF_OPERATE_OK;
+    }
+
+    case STDF_COMPRESS_ZSTD:
+#ifdef STDF_HAVE_ZSTD
+    {
+        ZSTD_CCtx* cctx = ZSTD_createCCtx();
+        if(!cctx) return WRITE_ERROR;
+        if(level > 0) ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, level);
+        m_file = std::fopen(filename, "wb");
+        if(!m_file) { ZSTD_freeCCtx(cctx); return WRITE_ERROR; }
+        std::setvbuf(m_file, nullptr, _IONBF, 0);
+        m_compressed.resize(ZSTD_CStreamOutSize());
+        m_zstd = cctx;
+        return STDF_OPERATE_OK;
+    }
+#else
+        return WRITE_ERROR;
+#endif
+    }
+    return WRITE_ERROR;
+}
+
+bool StdfWriter::is_open() const
+{
+    return m_file != nullptr || m_gzip != nullptr;
+}
+
+STDF_FILE_ERROR StdfWriter::write(StdfRecord* record)
+{
+    if(!record) return WRITE_ERROR;
+    record->unparse(m_header);
+    return write(m_header);
+}
+
+STDF_FILE_ERROR StdfWriter::write(const StdfHeader& header)
+{
+    if(!is_open() || m_failed) return WRITE_ERROR;
+
+    unsigned int size = 4U + header.get_length();
+    if(m_used + size > m_buffer.size())
+    {
+        STDF_FILE_ERROR ret = flush();
+        if(ret != STDF_OPERATE_OK) return ret;
+    }
+    char* record = &m_buffer[m_used];
+    m_used += header.serialize(record);
+    // unparse writes host byte order, also for records read from a swapped file
+    if(header.get_type() == FAR_TYPE && size > 4) record[4] = char(STDF_HOST_CPU_TYPE);
+    m_records++;
+    m_bytes += size;
+    return STDF_OPERATE_OK;
+}
+
+STDF_FILE_ERROR StdfWriter::flush()
+{
+    if(!is_open() || m_failed) return WRITE_ERROR;
+    if(m_used == 0) return STDF_OPERATE_OK;
+
+    STDF_FILE_ERROR ret = write_block(&m_buffer[0], m_used);
+    m_used = 0;
+    if(ret != STDF_OPERATE_OK) m_failed = true;
+    return ret;
+}
+
+STDF_FILE_ERROR StdfWriter::write_block(const char* data, unsigned int size)
+{
+    switch(m_compression)
+    {
+    case STDF_COMPRESS_NONE:
+        return write_raw(data, size);
+    case STDF_COMPRESS_GZIP:
+        if(gzwrite(static_cast<gzFile>(m_gzip), data, size) != int(size)) return WRITE_ERROR;
+        return STDF_OPERATE_OK;
+    case STDF_COMPRESS_ZSTD:
+        return zstd_write(data, size, false);
+    }
+    return WRITE_ERROR;
+}
+
+STDF_FILE_ERROR StdfWriter::write_raw(const char* data, size_t size)
+{
+    if(std::fwrite(data, 1, size, m_file) != size) return WRITE_ERROR;
+    return STDF_OPERATE_OK;
+}
+
+// end: finish the frame, data may be empty then
+STDF_FILE_ERROR StdfWriter::zstd_write(const char* data, unsigned int size, bool end)
+{
+#ifdef STDF_HAVE_ZSTD
+    ZSTD_CCtx* cctx = static_cast<ZSTD_CCtx*>(m_zstd);
+    ZSTD_inBuffer in = { data, size, 0 };
+    ZSTD_EndDirective mode = end ? ZSTD_e_end : ZSTD_e_continue;
+    while(true)
+    {
+        ZSTD_outBuffer out = { &m_compressed[0], m_compressed.size(), 0 };
+        size_t remaining = ZSTD_compressStream2(cctx, &out, &in, mode);
+        if(ZSTD_isError(remaining)) return WRITE_ERROR;
+        if(out.pos > 0 && write_raw(&m_compressed[0], out.pos) != STDF_OPERATE_OK) return WRITE_ERROR;
+        if(end ? (remaining == 0) : (in.pos == in.size)) break;
+    }
+    return STDF_OPERATE_OK;
+#else
+    (void)data; (void)size; (void)end;
+    return WRITE_ERROR;
+#endif
+}
+
+STDF_FILE_ERROR StdfWriter::close()
+{
+    if(!is_open()) return STDF_OPERATE_OK;
+
+    STDF_FILE_ERROR ret = m_failed ? WRITE_ERROR : flush();
+    if(m_gzip)
+    {
+        if(gzclose(static_cast<gzFile>(m_gzip)) != Z_OK) ret = WRITE_ERROR;
+        m_gzip = nullptr;
+    }
+#ifdef STDF_HAVE_ZSTD
+    if(m_zstd)
+    {
+        if(ret == STDF_OPERATE_OK) ret = zstd_write(nullptr, 0, true);
+        ZSTD_freeCCtx(static_cast<ZSTD_CCtx*>(m_zstd));
+        m_zstd = nullptr;
+    }
+#endif
+    if(m_file)
+    {
+        if(std::fclose(m_file) != 0) ret = WRITE_ERROR;
+        m_file = nullptr;
+    }
+    return ret;
+}
+
+unsigned long long StdfWriter::record_count() const
+{
+    return m_records;
+}
+
+unsigned long long StdfWriter::byte_count() const
+{
+    return m_bytes;
+}
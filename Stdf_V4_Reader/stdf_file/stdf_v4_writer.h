@@ -0,0 +1,62 @@
+/*************************************************************************
+ * Buffered record output. Records are serialized back to back into one
+ * large block that goes to the file, a gzip stream or a zstd stream with a
+ * single call, instead of the four small writes per record of
+ * StdfHeader::write. The file is only complete after close().
+*************************************************************************/
+#ifndef _STDF_V4_WRITER_H_
+#define _STDF_V4_WRITER_H_
+
+#include "stdf_v4_file.h"
+#include <cstdio>
+#include <vector>
+
+// bytes collected before they are handed to the file or the compressor
+#define STDF_WRITE_BUFFER_SIZE (1024U * 1024U)
+
+class StdfWriter
+{
+public:
+    explicit StdfWriter(unsigned int buffer_size = STDF_WRITE_BUFFER_SIZE);
+    ~StdfWriter();
+
+    // level: -1 for the default of the compressor, 0-9 for gzip, 1-19 for zstd,
+    // ignored without compression
+    STDF_FILE_ERROR open(const char* filename, STDF_COMPRESSION compression = STDF_COMPRESS_NONE, int level = -1);
+    // Unparses the record into the writer's own header and appends it.
+    STDF_FILE_ERROR write(StdfRecord* record);
+    // Appends a record that was unparsed into header before.
+    STDF_FILE_ERROR write(const StdfHeader& header);
+    // Hands the buffered records to the file (and the compressor's pending output).
+    STDF_FILE_ERROR flush();
+    // Flushes, ends the compressed stream and closes the file. After an error the
+    // file is closed as well but incomplete.
+    STDF_FILE_ERROR close();
+
+    bool is_open() const;
+    unsigned long long record_count() const;
+    // uncompressed STDF bytes written so far
+    unsigned long long byte_count() const;
+
+private:
+    STDF_FILE_ERROR write_block(const char* data, unsigned int size);
+    STDF_FILE_ERROR write_raw(const char* data, size_t size);
+    STDF_FILE_ERROR zstd_write(const char* data, unsigned int size, bool end);
+    StdfWriter(const StdfWriter& src);
+    StdfWriter& operator=(const StdfWriter& src);
+
+private:
+    STDF_COMPRESSION m_compression;
+    std::FILE* m_file;               // plain and zstd output
+    void* m_gzip;                    // gzFile
+    void* m_zstd;                    // ZSTD_CCtx*
+    std::vector<char> m_buffer;
+    unsigned int m_used;
+    std::vector<char> m_compressed;  // zstd output block
+    bool m_failed;
+    unsigned long long m_records;
+    unsigned long long m_bytes;
+    StdfHeader m_header;
+};
+
+#endif//_STDF_V4_WRITER_H_
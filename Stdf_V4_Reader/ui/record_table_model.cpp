@@ -0,0 +1,156 @@
+#include "record_table_model.h"
+
+// formatted rows kept for the view, a few screens of scrolling
+#define RECORD_ROW_CACHE 1024
+
+RecordTableModel::RecordTableModel(QObject *parent) :
+    QAbstractTableModel(parent)
+{
+    m_file = nullptr;
+    m_formatter = nullptr;
+    m_type = UNKNOWN_TYPE;
+    m_row_count = 0;
+    m_scanned = 0;
+    m_rows.setMaxCost(RECORD_ROW_CACHE);
+}
+
+void RecordTableModel::set_records(STDF_FILE* file, STDF_TYPE type)
+{
+    beginResetModel();
+    m_file = file;
+    m_type = type;
+    m_formatter = nullptr;
+    m_labels.clear();
+    m_row_count = 0;
+    m_tests.clear();
+    m_part_ids.clear();
+    m_part_tests.clear();
+    m_scanned = 0;
+    m_rows.clear();
+    if(file && type < STDF_V4_RECORD_COUNT)
+    {
+        const StdfColumns* columns = stdf_columns(type);
+        for(int i = 0; i < columns->count; i++) m_labels << columns->labels[i];
+        m_formatter = columns->format;
+        if(type == PTR_TYPE)
+        {
+            collect_part_tests();
+            m_row_count = int(m_tests.size());
+        }
+        else
+        {
+            m_row_count = int(file->get_count(type));
+        }
+    }
+    endResetModel();
+}
+
+void RecordTableModel::clear()
+{
+    set_records(nullptr, UNKNOWN_TYPE);
+}
+
+void RecordTableModel::refresh()
+{
+    if(!m_formatter) return;
+
+    int row_count;
+    if(m_type == PTR_TYPE)
+    {
+        collect_part_tests();
+        row_count = int(m_tests.size());
+    }
+    else
+    {
+        row_count = int(m_file->get_count(m_type));
+    }
+    if(row_count <= m_row_count) return;
+
+    // the rows already there keep their records, only new ones are added
+    beginInsertRows(QModelIndex(), m_row_count, row_count - 1);
+    m_row_count = row_count;
+    endInsertRows();
+}
+
+// PTRs in the order of their parts as the table always showed them: the PTRs since
+// the last PIR come once per PRR, the ones of a part without PRR are left out.
+// Goes on from the record it stopped at, for a file that is still loading.
+void RecordTableModel::collect_part_tests()
+{
+    unsigned int record_count = m_file->get_total_count();
+    if(m_tests.empty()) m_tests.reserve(m_file->get_count(PTR_TYPE));
+    if(m_part_ids.empty()) m_part_ids.reserve(m_file->get_count(PTR_TYPE));
+    for(unsigned int n = m_scanned; n < record_count; n++)
+    {
+        StdfRecord* record = m_file->get_record(n);
+        STDF_TYPE type = record->type();
+        if(type == PIR_TYPE)
+        {
+            m_part_tests.clear();
+        }
+        else if(type == PRR_TYPE)
+        {
+            const char* part_id = static_cast<StdfPRR*>(record)->get_part_id();
+            m_tests.insert(m_tests.end(), m_part_tests.begin(), m_part_tests.end());
+            m_part_ids.insert(m_part_ids.end(), m_part_tests.size(), part_id);
+        }
+        else if(type == PTR_TYPE)
+        {
+            m_part_tests.push_back(static_cast<StdfPTR*>(record));
+        }
+    }
+    m_scanned = record_count;
+}
+
+const QStringList* RecordTableModel::cached_row(int row) const
+{
+    QStringList* cells = m_rows.object(row);
+    if(cells) return cells;
+
+    StdfRow record_row;
+    if(m_type == PTR_TYPE) m_formatter(m_tests[row], m_part_ids[row], record_row);
+    else m_formatter(m_file->get_record(m_type, row), nullptr, record_row);
+    cells = new QStringList();
+    for(unsigned int i = 0; i < record_row.size(); i++)
+    {
+        *cells << QString::fromLocal8Bit(record_row.cell_data(i), int(record_row.cell_length(i)));
+    }
+    m_rows.insert(row, cells);
+    return cells;
+}
+
+STDF_TYPE RecordTableModel::record_type() const
+{
+    return m_type;
+}
+
+QStringList RecordTableModel::row_cells(int row) const
+{
+    if(row < 0 || row >= m_row_count) return QStringList();
+    return *cached_row(row);
+}
+
+int RecordTableModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_row_count;
+}
+
+int RecordTableModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_labels.size();
+}
+
+QVariant RecordTableModel::data(const QModelIndex &index, int role) const
+{
+    if(role != Qt::DisplayRole || !index.isValid() || index.row() >= m_row_count) return QVariant();
+    const QStringList* cells = cached_row(index.row());
+    if(index.column() >= cells->size()) return QVariant();
+    return cells->at(index.column());
+}
+
+QVariant RecordTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if(role != Qt::DisplayRole) return QVariant();
+    if(orientation == Qt::Horizontal) return (section < m_labels.size()) ? QVariant(m_labels[section]) : QVariant();
+    return section + 1;
+}
@@ -0,0 +1,55 @@
+#ifndef RECORD_TABLE_MODEL_H
+#define RECORD_TABLE_MODEL_H
+
+#include <QAbstractTableModel>
+#include <QStringList>
+#include <QCache>
+#include "../stdf_file/stdf_v4_columns.h"
+#include <vector>
+#include <ctime>
+
+// All records of one type of a STDF_FILE as a table.
+// Nothing is formatted up front: data() formats the rows the view asks for and
+// keeps the last ones, so a type with millions of records shows as fast as one
+// with ten. PTR rows get the PART_ID of the PRR closing their part.
+class RecordTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    explicit RecordTableModel(QObject *parent = 0);
+
+    // The records stay in file, it has to live until clear() or the next set_records().
+    void set_records(STDF_FILE* file, STDF_TYPE type);
+    void clear();
+    // adds the rows of records appended to the file since, while it is loading
+    void refresh();
+    // UNKNOWN_TYPE when cleared
+    STDF_TYPE record_type() const;
+    // formatted cells of one row
+    QStringList row_cells(int row) const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
+
+private:
+    const QStringList* cached_row(int row) const;
+    void collect_part_tests();
+
+private:
+    STDF_FILE* m_file;
+    StdfRowFormatter m_formatter;
+    QStringList m_labels;
+    STDF_TYPE m_type;
+    int m_row_count;
+    // PTR only: the rows in part order and the PART_ID of each
+    std::vector<StdfPTR*> m_tests;
+    std::vector<const char*> m_part_ids;
+    std::vector<StdfPTR*> m_part_tests;  // of the part not closed yet
+    unsigned int m_scanned;              // records collect_part_tests() went through
+    mutable QCache<int, QStringList> m_rows;
+};
+
+#endif // RECORD_TABLE_MODEL_H
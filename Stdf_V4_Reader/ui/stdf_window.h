@@ -3,7 +3,12 @@
 
 #include <QMainWindow>
 #include <QAction>
+#include <QTimer>
+#include <QProgressBar>
 #include "../stdf_file/stdf_v4_file.h"
+#include "../stdf_file/stdf_v4_loader.h"
+#include "../stdf_file/stdf_v4_csv.h"
+#include "record_table_model.h"
 #include <vector>
 #include <ctime>
 
@@ -21,6 +26,7 @@ public:
 
 private slots:
     void on_OpenButton_clicked();
+    void on_CancelButton_clicked();
     void on_ClearButton_clicked();
     void on_CloseButton_clicked();
     void on_RecordListWidget_clicked(const QModelIndex &index);
@@ -30,35 +36,15 @@ private slots:
     void on_actionHelp_triggered();
     void on_SaveChangeButton_clicked();
     void SaveTableToFile();
+    void LoadProgress();
+    void ExportProgress();
 
 private:
     void UpdateUi();
     void ShowRecordTable(STDF_TYPE type);
-    void ShowStdfFAR();
-	void ShowStdfATR();
-	void ShowStdfMIR();
-	void ShowStdfMRR();
-	void ShowStdfPCR();
-	void ShowStdfHBR();
-	void ShowStdfSBR();
-	void ShowStdfPMR();
-	void ShowStdfPGR();
-	void ShowStdfPLR();
-	void ShowStdfRDR();
-	void ShowStdfSDR();
-	void ShowStdfWIR();
-	void ShowStdfWRR();
-	void ShowStdfWCR();
-	void ShowStdfPIR();
-	void ShowStdfPRR();
-	void ShowStdfTSR();
-	void ShowStdfPTR();
-	void ShowStdfMPR();
-	void ShowStdfFTR();
-	void ShowStdfBPS();
-	void ShowStdfEPS();
-	void ShowStdfGDR();
-	void ShowStdfDTR();
+    void UpdateRecordList();
+    void StopLoading();
+    void StopExport();
 
 private:
     Ui::MainWindow *ui;
@@ -66,18 +52,14 @@ private:
     QString filename;
     QAction *save_action;
     std::vector<int> stdf_types;
-    void table_set_value(int row, int col, unsigned int value);
-    void table_set_value(int row, int col, int value);
-    void table_set_value(int row, int col, unsigned short value);
-    void table_set_value(int row, int col, const char* value);
-    void table_set_value(int row, int col, time_t value);
-    void table_set_value(int row, int col, char value);
-    void table_set_value(int row, int col, unsigned char value);
-    void table_set_value(int row, int col, signed char value);
-    void table_set_value(int row, int col, float value);
-    void table_set_value(int row, int col, short value);
-    void table_set_value(int row, int col, QString value);
-    void table_set_flag(int row, int col, unsigned char flag);
+    RecordTableModel *table_model;
+    // set while the file is read in the background
+    StdfLoader *loader;
+    QTimer *load_timer;
+    // set while a table is saved to a CSV file in the background
+    StdfCsvExporter *exporter;
+    QTimer *export_timer;
+    QProgressBar *progress_bar;
 };
 
 #endif // STDF_WINDOW_H
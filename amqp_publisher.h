@@ -0,0 +1,297 @@
+#ifndef AMQP_PUBLISHER_H
+#define AMQP_PUBLISHER_H
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+#include <functional>
+#include <cstdint>
+#include <sys/time.h>
+#include <rabbitmq-c/amqp.h>
+#include <rabbitmq-c/tcp_socket.h>
+#include "logger.h"
+
+/**
+ * Long lived RabbitMQ publisher.
+ *
+ * The connection, channel and queue declaration are made once and reused for every
+ * message; a failed publish drops the connection, reconnects and retries once.
+ *
+ * Optional:
+ * - publisher confirms: publish() returns after the broker acked the message
+ * - batching: publish() queues the message, a flush thread sends the queue every
+ *   batch window. Messages with the same coalesce key inside one window are merged
+ *   into one by the merge function (default: the newer message wins).
+ */
+class AmqpPublisher {
+public:
+    typedef std::function<std::string(const std::string& older, const std::string& newer)> MergeFunction;
+
+    struct Config {
+        std::string host;
+        int port;
+        std::string user;
+        std::string password;
+        std::string vhost;
+        std::string queue;
+        std::string exchange;
+        std::string routingKey;
+        int channel;
+        bool confirms;          // wait for broker acks
+        int batchWindowMs;      // 0 = publish at once
+        int confirmTimeoutMs;
+    };
+
+    explicit AmqpPublisher(const Config& config)
+        : config_(config), conn_(nullptr), nextDeliveryTag_(1), running_(false) {
+        merge_ = [](const std::string&, const std::string& newer) { return newer; };
+        if (config_.batchWindowMs > 0) {
+            running_ = true;
+            flushThread_ = std::thread(&AmqpPublisher::flushLoop, this);
+        }
+    }
+
+    ~AmqpPublisher() {
+        if (flushThread_.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(queueMutex_);
+                running_ = false;
+            }
+            queueCondition_.notify_all();
+            flushThread_.join();
+        }
+        std::lock_guard<std::mutex> lock(connectionMutex_);
+        disconnect();
+    }
+
+    void setMergeFunction(const MergeFunction& merge) { merge_ = merge; }
+
+    /**
+     * Publish a message, or queue it in batching mode.
+     *
+     * @param message Message body
+     * @param coalesceKey Messages with the same non empty key are merged while queued
+     * @return true if sent (and confirmed, with confirms) or queued
+     */
+    bool publish(const std::string& message, const std::string& coalesceKey = "") {
+        if (config_.batchWindowMs <= 0) {
+            std::vector<std::string> messages(1, message);
+            return send(messages) == 1;
+        }
+
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        if (!coalesceKey.empty()) {
+            std::map<std::string, size_t>::iterator it = pendingKeys_.find(coalesceKey);
+            if (it != pendingKeys_.end()) {
+                pending_[it->second] = merge_(pending_[it->second], message);
+                return true;
+            }
+            pendingKeys_[coalesceKey] = pending_.size();
+        }
+        pending_.push_back(message);
+        return true;
+    }
+
+private:
+    void flushLoop() {
+        std::unique_lock<std::mutex> lock(queueMutex_);
+        while (running_) {
+            queueCondition_.wait_for(lock, std::chrono::milliseconds(config_.batchWindowMs));
+            if (pending_.empty()) continue;
+
+            std::vector<std::string> batch;
+            batch.swap(pending_);
+            pendingKeys_.clear();
+            lock.unlock();
+            size_t sent = send(batch);
+            lock.lock();
+
+            if (sent < batch.size()) {
+                // keep what did not go out, in front of what came meanwhile
+                LOG.warning("Publishing failed for " + std::to_string(batch.size() - sent) + " messages, retrying in the next window", "Publisher");
+                pending_.insert(pending_.begin(), batch.begin() + sent, batch.end());
+                pendingKeys_.clear();
+            }
+        }
+        // last flush on shutdown
+        if (!pending_.empty()) {
+            std::vector<std::string> batch;
+            batch.swap(pending_);
+            lock.unlock();
+            send(batch);
+        }
+    }
+
+    // returns how many messages from the front of the list went out; after a
+    // reconnect only the rest is sent again (unconfirmed ones are sent again too)
+    size_t send(const std::vector<std::string>& messages) {
+        std::lock_guard<std::mutex> lock(connectionMutex_);
+        size_t done = 0;
+        for (int attempt = 0; attempt < 2 && done < messages.size(); attempt++) {
+            if (!conn_ && !connect()) continue;
+
+            size_t sent = done;
+            bool failed = false;
+            uint64_t firstTag = nextDeliveryTag_;
+            for (; sent < messages.size(); sent++) {
+                const std::string& message = messages[sent];
+                amqp_basic_properties_t properties;
+                properties._flags = AMQP_BASIC_CONTENT_TYPE_FLAG | AMQP_BASIC_DELIVERY_MODE_FLAG;
+                properties.content_type = amqp_cstring_bytes("application/json");
+                properties.delivery_mode = AMQP_DELIVERY_PERSISTENT;
+
+                amqp_bytes_t body;
+                body.len = message.size();
+                body.bytes = const_cast<char*>(message.data());
+                int status = amqp_basic_publish(conn_, config_.channel,
+                    amqp_cstring_bytes(config_.exchange.c_str()),
+                    amqp_cstring_bytes(config_.routingKey.c_str()),
+                    0, 0, &properties, body);
+                if (status != AMQP_STATUS_OK) {
+                    LOG.error("Failed to publish message: " + std::string(amqp_error_string2(status)), "Publisher");
+                    failed = true;
+                    break;
+                }
+                nextDeliveryTag_++;
+            }
+
+            if (config_.confirms) {
+                if (nextDeliveryTag_ > firstTag && !waitForConfirms(firstTag, nextDeliveryTag_ - 1)) {
+                    failed = true;
+                } else {
+                    done = sent;
+                }
+            } else {
+                done = sent;
+            }
+            if (failed) {
+                disconnect();
+            }
+        }
+        if (done > 0) {
+            LOG_DEBUG("Published " + std::to_string(done) + " message(s)", "Publisher");
+        }
+        return done;
+    }
+
+    // waits until the broker acked all delivery tags up to lastTag
+    bool waitForConfirms(uint64_t firstTag, uint64_t lastTag) {
+        uint64_t confirmed = firstTag - 1;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(config_.confirmTimeoutMs);
+        while (confirmed < lastTag) {
+            auto remaining = std::chrono::duration_cast<std::chrono::microseconds>(deadline - std::chrono::steady_clock::now()).count();
+            if (remaining <= 0) {
+                LOG.error("Timeout waiting for publisher confirms", "Publisher");
+                return false;
+            }
+            struct timeval timeout;
+            timeout.tv_sec = remaining / 1000000;
+            timeout.tv_usec = remaining % 1000000;
+
+            amqp_frame_t frame;
+            int status = amqp_simple_wait_frame_noblock(conn_, &frame, &timeout);
+            if (status == AMQP_STATUS_TIMEOUT) continue;
+            if (status != AMQP_STATUS_OK) {
+                LOG.error("Failed to read publisher confirm: " + std::string(amqp_error_string2(status)), "Publisher");
+                return false;
+            }
+            if (frame.frame_type != AMQP_FRAME_METHOD) continue;
+
+            if (frame.payload.method.id == AMQP_BASIC_ACK_METHOD) {
+                amqp_basic_ack_t* ack = static_cast<amqp_basic_ack_t*>(frame.payload.method.decoded);
+                if (ack->multiple || ack->delivery_tag > confirmed) {
+                    confirmed = std::max(confirmed, static_cast<uint64_t>(ack->delivery_tag));
+                }
+            } else if (frame.payload.method.id == AMQP_BASIC_NACK_METHOD) {
+                LOG.error("Broker rejected a published message", "Publisher");
+                return false;
+            } else if (frame.payload.method.id == AMQP_CHANNEL_CLOSE_METHOD ||
+                       frame.payload.method.id == AMQP_CONNECTION_CLOSE_METHOD) {
+                LOG.error("Broker closed the channel while waiting for confirms", "Publisher");
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool connect() {
+        conn_ = amqp_new_connection();
+        amqp_socket_t* socket = amqp_tcp_socket_new(conn_);
+        if (!socket) {
+            LOG.error("Failed to create TCP socket", "Publisher");
+            disconnect();
+            return false;
+        }
+        if (amqp_socket_open(socket, config_.host.c_str(), config_.port)) {
+            LOG.error("Failed to open TCP connection", "Publisher");
+            disconnect();
+            return false;
+        }
+
+        amqp_rpc_reply_t login_reply = amqp_login(conn_, config_.vhost.c_str(), 0, 131072, 0,
+            AMQP_SASL_METHOD_PLAIN, config_.user.c_str(), config_.password.c_str());
+        if (login_reply.reply_type != AMQP_RESPONSE_NORMAL) {
+            LOG.error("Failed to log in to RabbitMQ", "Publisher");
+            disconnect();
+            return false;
+        }
+
+        amqp_channel_open(conn_, config_.channel);
+        if (amqp_get_rpc_reply(conn_).reply_type != AMQP_RESPONSE_NORMAL) {
+            LOG.error("Failed to open a channel", "Publisher");
+            disconnect();
+            return false;
+        }
+
+        amqp_queue_declare(conn_, config_.channel, amqp_cstring_bytes(config_.queue.c_str()),
+            0, 1, 0, 0, amqp_empty_table);
+        if (amqp_get_rpc_reply(conn_).reply_type != AMQP_RESPONSE_NORMAL) {
+            LOG.error("Failed to declare queue", "Publisher");
+            disconnect();
+            return false;
+        }
+
+        if (config_.confirms) {
+            amqp_confirm_select(conn_, config_.channel);
+            if (amqp_get_rpc_reply(conn_).reply_type != AMQP_RESPONSE_NORMAL) {
+                LOG.error("Failed to enable publisher confirms", "Publisher");
+                disconnect();
+                return false;
+            }
+        }
+        nextDeliveryTag_ = 1;
+        LOG.info("Publisher connected to " + config_.host + ":" + std::to_string(config_.port), "Publisher");
+        return true;
+    }
+
+    void disconnect() {
+        if (!conn_) return;
+        amqp_channel_close(conn_, config_.channel, AMQP_REPLY_SUCCESS);
+        amqp_connection_close(conn_, AMQP_REPLY_SUCCESS);
+        amqp_destroy_connection(conn_);
+        conn_ = nullptr;
+    }
+
+    AmqpPublisher(const AmqpPublisher&) = delete;
+    AmqpPublisher& operator=(const AmqpPublisher&) = delete;
+
+    Config config_;
+    amqp_connection_state_t conn_;
+    uint64_t nextDeliveryTag_;
+    std::mutex connectionMutex_;
+
+    MergeFunction merge_;
+    std::vector<std::string> pending_;
+    std::map<std::string, size_t> pendingKeys_;
+    std::mutex queueMutex_;
+    std::condition_variable queueCondition_;
+    bool running_;
+    std::thread flushThread_;
+};
+
+#endif // AMQP_PUBLISHER_H
@@ -0,0 +1,139 @@
+#ifndef APPEND_FETCHER_H
+#define APPEND_FETCHER_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "logger.h"
+
+/**
+ * Copies what an append-only source file gained into the destination, in process.
+ *
+ * Same contract as "rsync --append-verify --inplace" for a file that only grows:
+ * the bytes behind the current destination size are read from the source with
+ * pread and appended with pwrite. Before appending, the last VERIFY_BYTES of the
+ * destination are compared with the source; on a mismatch (file replaced on the
+ * tester) the destination is rewritten from offset 0.
+ *
+ * Works on sources the host can open (NFS/SMB mount of the tester share), an
+ * rsync:// daemon source still needs executeRsync.
+ */
+class AppendFetcher {
+public:
+    struct Result {
+        bool ok;
+        bool restarted;          // destination rewritten from 0
+        uint64_t previousSize;   // destination size before the fetch
+        uint64_t currentSize;    // destination size after the fetch
+    };
+
+    static const size_t BLOCK_SIZE = 1 << 20;
+    static const size_t VERIFY_BYTES = 4096;
+
+    AppendFetcher(const std::string& source, const std::string& destination)
+        : source_(source), destination_(destination), buffer_(BLOCK_SIZE) {}
+
+    const std::string& destination() const { return destination_; }
+
+    Result fetch() {
+        Result result = {false, false, 0, 0};
+
+        int in = open(source_.c_str(), O_RDONLY | O_CLOEXEC);
+        if (in < 0) {
+            LOG.error("Failed to open source " + source_ + ": " + strerror(errno), "Fetcher");
+            return result;
+        }
+        int out = open(destination_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (out < 0) {
+            LOG.error("Failed to open destination " + destination_ + ": " + strerror(errno), "Fetcher");
+            close(in);
+            return result;
+        }
+
+        struct stat sourceInfo, destinationInfo;
+        if (fstat(in, &sourceInfo) != 0 || fstat(out, &destinationInfo) != 0) {
+            LOG.error("Failed to stat " + source_ + " or " + destination_, "Fetcher");
+            close(in);
+            close(out);
+            return result;
+        }
+        uint64_t sourceSize = static_cast<uint64_t>(sourceInfo.st_size);
+        uint64_t offset = static_cast<uint64_t>(destinationInfo.st_size);
+        result.previousSize = offset;
+
+        if (offset > sourceSize || !tailMatches(in, out, offset)) {
+            LOG.warning("Destination " + destination_ + " does not match the source, fetching it again", "Fetcher");
+            if (ftruncate(out, 0) != 0) {
+                LOG.error("Failed to truncate " + destination_ + ": " + strerror(errno), "Fetcher");
+                close(in);
+                close(out);
+                return result;
+            }
+            offset = 0;
+            result.restarted = true;
+        }
+
+        result.ok = true;
+        while (offset < sourceSize) {
+            size_t wanted = static_cast<size_t>(std::min(static_cast<uint64_t>(BLOCK_SIZE), sourceSize - offset));
+            ssize_t count = pread(in, &buffer_[0], wanted, static_cast<off_t>(offset));
+            if (count <= 0) {
+                if (count < 0 && errno == EINTR) continue;
+                if (count < 0) {
+                    LOG.error("Read error on " + source_ + ": " + strerror(errno), "Fetcher");
+                    result.ok = false;
+                }
+                break;
+            }
+            if (!writeAll(out, &buffer_[0], static_cast<size_t>(count), offset)) {
+                LOG.error("Write error on " + destination_ + ": " + strerror(errno), "Fetcher");
+                result.ok = false;
+                break;
+            }
+            offset += static_cast<uint64_t>(count);
+        }
+
+        result.currentSize = offset;
+        close(in);
+        close(out);
+        return result;
+    }
+
+private:
+    // the bytes before offset have to be the same in source and destination
+    bool tailMatches(int in, int out, uint64_t offset) {
+        if (offset == 0) return true;
+        size_t length = static_cast<size_t>(std::min(static_cast<uint64_t>(VERIFY_BYTES), offset));
+        uint64_t start = offset - length;
+        std::vector<char> sourceTail(length), destinationTail(length);
+        if (pread(in, &sourceTail[0], length, static_cast<off_t>(start)) != static_cast<ssize_t>(length)) return false;
+        if (pread(out, &destinationTail[0], length, static_cast<off_t>(start)) != static_cast<ssize_t>(length)) return false;
+        return std::memcmp(&sourceTail[0], &destinationTail[0], length) == 0;
+    }
+
+    static bool writeAll(int fd, const char* data, size_t size, uint64_t offset) {
+        while (size > 0) {
+            ssize_t count = pwrite(fd, data, size, static_cast<off_t>(offset));
+            if (count < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            data += count;
+            size -= static_cast<size_t>(count);
+            offset += static_cast<uint64_t>(count);
+        }
+        return true;
+    }
+
+    std::string source_;
+    std::string destination_;
+    std::vector<char> buffer_;
+};
+
+#endif // APPEND_FETCHER_H
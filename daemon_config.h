@@ -0,0 +1,272 @@
+#ifndef DAEMON_CONFIG_H
+#define DAEMON_CONFIG_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <exception>
+#include <nlohmann/json.hpp>
+
+/**
+ * Configuration of the daemon: the broker, the output, and every tester one
+ * process syncs. Read from a JSON file given on the command line, see
+ * daemon_config.example.json; without a file defaults() keeps the settings
+ * the daemon had as constants (one tester IFLEX-38, queue LPX-67).
+ *
+ * Missing keys keep their default. All testers share the broker connections,
+ * the queue, the output and the worker threads; a tester only brings its
+ * source, its local directory and its sync state.
+ */
+
+// ON_CHANGE: a sync runs only when the source changed (inotify, stat or rsync --list-only)
+// LOOP: sync remote sources back to back with a 1 ms pause, the old behaviour as fallback
+enum class SyncMode {
+    ON_CHANGE,
+    LOOP
+};
+
+// NDJSON: PRR records appended as one JSON line each, rotated past the size limit
+// BINARY: one columnar block file (prr_block.h) per message in outputBlockDir
+enum class OutputFormat {
+    NDJSON,
+    BINARY
+};
+
+struct TesterConfig {
+    std::string name;           // in the messages and the metrics
+    std::string source;         // rsync://host/module/file, host::module/file or a mounted path
+    std::string destination;    // local directory of the copy, ends with '/'
+};
+
+struct DaemonConfig {
+    // Broker, one publisher and one consumer connection for all testers
+    std::string brokerHost;
+    int brokerPort;
+    std::string brokerUser;
+    std::string brokerPassword;
+    std::string brokerVhost;
+    std::string queue;
+    std::string exchange;
+    std::string routingKey;
+    int channel;
+
+    // Sync: the scheduler thread waits for changes of all testers, syncWorkers
+    // threads run the transfers
+    SyncMode syncMode;
+    int syncMinIntervalMs;
+    int syncMaxIntervalMs;
+    int syncWorkers;
+
+    // Publisher: wait for broker acks, and coalesce position updates of one file
+    // within this window into one message (0 = publish every update at once)
+    bool publishConfirms;
+    int publishBatchWindowMs;
+    int publishConfirmTimeoutMs;
+
+    // Consumer: unacked messages the broker may hand out, and worker threads
+    // (messages of one file always go to the same worker)
+    int consumerPrefetch;
+    int consumerWorkers;
+    // A worker keeps an open tail reader per file until its MRR; files without one
+    // (aborted lots) are closed after this idle time, and the least recently used
+    // ones beyond the count. The next message of such a file reopens it.
+    int consumerFileIdleS;
+    int consumerMaxOpenFiles;
+
+    OutputFormat outputFormat;
+    std::string outputFile;
+    unsigned long long outputMaxFileBytes;
+    std::string outputBlockDir;
+
+    // Live bin/yield summaries (yield_aggregator.h): one delta per message appended
+    // to yieldFile and published to yieldQueue, each off when empty
+    std::string yieldFile;
+    std::string yieldQueue;
+
+    std::string logPath;
+    // Prometheus text on http://<host>:metricsPort/metrics (0 = no server), and a
+    // stats line in the log every metricsLogIntervalS seconds (0 = none)
+    int metricsPort;
+    int metricsLogIntervalS;
+
+    std::vector<TesterConfig> testers;
+
+    static DaemonConfig defaults() {
+        DaemonConfig config;
+        config.brokerHost = "10.100.246.53";
+        config.brokerPort = 5672;
+        config.brokerUser = "system";
+        config.brokerPassword = "system";
+        config.brokerVhost = "/";
+        config.queue = "LPX-67";
+        config.exchange = "";
+        config.routingKey = "LPX-67";
+        config.channel = 1;
+
+        config.syncMode = SyncMode::ON_CHANGE;
+        config.syncMinIntervalMs = 200;
+        config.syncMaxIntervalMs = 5000;
+        config.syncWorkers = 4;
+
+        config.publishConfirms = true;
+        config.publishBatchWindowMs = 0;
+        config.publishConfirmTimeoutMs = 5000;
+
+        config.consumerPrefetch = 16;
+        config.consumerWorkers = 4;
+        config.consumerFileIdleS = 3600;
+        config.consumerMaxOpenFiles = 64;
+
+        config.outputFormat = OutputFormat::NDJSON;
+        config.outputFile = "/tmp/IFLEX-18/Output/Output.ndjson";
+        config.outputMaxFileBytes = 256ULL << 20;
+        config.outputBlockDir = "/tmp/IFLEX-18/Output/";
+        config.yieldFile = "";
+        config.yieldQueue = "";
+
+        config.logPath = "/tmp/IFLEX-18/Logs/application_IFLEX-38.log";
+        config.metricsPort = 9464;
+        config.metricsLogIntervalS = 60;
+
+        TesterConfig tester;
+        tester.name = "IFLEX-38";
+        tester.source = "rsync://IFLEX-38/user/IFLEX-38_1_v14082p01j_ad7149-6_2pc_AT5_6871847.1_C40239-09D4_mar02_00_09.stdf";
+        tester.destination = "/tmp/IFLEX-18/";
+        config.testers.push_back(tester);
+        return config;
+    }
+
+    /**
+     * Read a config file over the defaults.
+     *
+     * @param path JSON config file
+     * @param config Result, defaults() for keys the file does not have
+     * @param error Why the file was not accepted
+     * @return false if the file can not be read, is no valid JSON or has no usable tester
+     */
+    static bool load(const std::string& path, DaemonConfig& config, std::string& error) {
+        config = defaults();
+        std::ifstream file(path);
+        if (!file) {
+            error = "can not open " + path;
+            return false;
+        }
+        std::stringstream content;
+        content << file.rdbuf();
+
+        try {
+            nlohmann::json root = nlohmann::json::parse(content.str());
+            if (root.contains("broker")) {
+                const nlohmann::json& broker = root["broker"];
+                read(broker, "host", config.brokerHost);
+                read(broker, "port", config.brokerPort);
+                read(broker, "user", config.brokerUser);
+                read(broker, "password", config.brokerPassword);
+                read(broker, "vhost", config.brokerVhost);
+                read(broker, "queue", config.queue);
+                read(broker, "exchange", config.exchange);
+                config.routingKey = config.queue;
+                read(broker, "routing_key", config.routingKey);
+                read(broker, "channel", config.channel);
+                read(broker, "publish_confirms", config.publishConfirms);
+                read(broker, "publish_batch_window_ms", config.publishBatchWindowMs);
+                read(broker, "publish_confirm_timeout_ms", config.publishConfirmTimeoutMs);
+                read(broker, "prefetch", config.consumerPrefetch);
+            }
+            if (root.contains("sync")) {
+                const nlohmann::json& sync = root["sync"];
+                std::string mode = "on_change";
+                read(sync, "mode", mode);
+                if (mode == "on_change") config.syncMode = SyncMode::ON_CHANGE;
+                else if (mode == "loop") config.syncMode = SyncMode::LOOP;
+                else {
+                    error = "sync.mode has to be on_change or loop";
+                    return false;
+                }
+                read(sync, "min_interval_ms", config.syncMinIntervalMs);
+                read(sync, "max_interval_ms", config.syncMaxIntervalMs);
+                read(sync, "workers", config.syncWorkers);
+            }
+            if (root.contains("output")) {
+                const nlohmann::json& output = root["output"];
+                std::string format = "ndjson";
+                read(output, "format", format);
+                if (format == "ndjson") config.outputFormat = OutputFormat::NDJSON;
+                else if (format == "binary") config.outputFormat = OutputFormat::BINARY;
+                else {
+                    error = "output.format has to be ndjson or binary";
+                    return false;
+                }
+                read(output, "file", config.outputFile);
+                read(output, "max_file_bytes", config.outputMaxFileBytes);
+                read(output, "block_dir", config.outputBlockDir);
+            }
+            if (root.contains("yield")) {
+                const nlohmann::json& yield = root["yield"];
+                read(yield, "file", config.yieldFile);
+                read(yield, "queue", config.yieldQueue);
+            }
+            read(root, "consumer_workers", config.consumerWorkers);
+            read(root, "consumer_file_idle_s", config.consumerFileIdleS);
+            read(root, "consumer_max_open_files", config.consumerMaxOpenFiles);
+            read(root, "log_file", config.logPath);
+            read(root, "metrics_port", config.metricsPort);
+            read(root, "metrics_log_interval_s", config.metricsLogIntervalS);
+
+            if (root.contains("testers")) {
+                config.testers.clear();
+                for (const nlohmann::json& entry : root["testers"]) {
+                    TesterConfig tester;
+                    read(entry, "name", tester.name);
+                    read(entry, "source", tester.source);
+                    read(entry, "destination", tester.destination);
+                    if (tester.name.empty() || tester.source.empty() || tester.destination.empty()) {
+                        error = "every tester needs name, source and destination";
+                        return false;
+                    }
+                    if (tester.destination.back() != '/') tester.destination += '/';
+                    if (config.findTester(tester.name)) {
+                        error = "tester " + tester.name + " is configured twice";
+                        return false;
+                    }
+                    config.testers.push_back(tester);
+                }
+            }
+        } catch (const std::exception& e) {
+            error = path + ": " + e.what();
+            return false;
+        }
+
+        if (config.testers.empty()) {
+            error = "no testers configured";
+            return false;
+        }
+        if (!config.yieldQueue.empty() && config.yieldQueue == config.queue) {
+            error = "yield.queue has to differ from broker.queue, the daemon consumes that one";
+            return false;
+        }
+        if (config.syncWorkers < 1) config.syncWorkers = 1;
+        if (config.consumerWorkers < 1) config.consumerWorkers = 1;
+        if (config.consumerMaxOpenFiles < 1) config.consumerMaxOpenFiles = 1;
+        return true;
+    }
+
+    const TesterConfig* findTester(const std::string& name) const {
+        for (const TesterConfig& tester : testers) {
+            if (tester.name == name) return &tester;
+        }
+        return nullptr;
+    }
+
+private:
+    // field keeps its value when the key is missing or null
+    template <typename T>
+    static void read(const nlohmann::json& object, const char* key, T& field) {
+        if (object.contains(key) && !object[key].is_null()) {
+            field = object[key].template get<T>();
+        }
+    }
+};
+
+#endif // DAEMON_CONFIG_H
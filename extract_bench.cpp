@@ -0,0 +1,137 @@
+// Throughput, peak memory and allocations of the daemon's extraction and output
+// paths (StdfExtractor, NdjsonWriter) on a synthetic stdf file or a given one.
+//
+// usage: extract_bench [--file f.stdf] [--csv] [--keep] [synth options]
+// The synth options (--parts --sites --ptr --mpr --mpr-pins --ftr --size --seed)
+// are the ones of Stdf_V4_Reader/bench/stdf_bench. Build it like the daemon and
+// add Stdf_V4_Reader/bench/bench_stats.cpp and stdf_synth.cpp.
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <stdf_reader/stdf_v4_api.h>
+#include <stdf_reader/stdf_v4_file.h>
+#include "logger.h"
+#include "extractor.h"
+#include "ndjson_writer.h"
+#include "Stdf_V4_Reader/bench/bench_stats.h"
+#include "Stdf_V4_Reader/bench/stdf_synth.h"
+
+static const char* BENCH_FILE = "extract_bench.stdf";
+static const char* BENCH_JSON_FILE = "extract_bench.json";
+static const char* BENCH_BLOCK_FILE = "extract_bench.prrb";
+static const char* BENCH_NDJSON_FILE = "extract_bench.ndjson";
+
+static bool csvOutput = false;
+
+static void report(const BenchResult& result) {
+    if (csvOutput) BenchMeter::print_csv(result);
+    else BenchMeter::print(result);
+}
+
+static unsigned long long fileSize(const char* filename) {
+    std::FILE* file = std::fopen(filename, "rb");
+    if (!file) return 0;
+    std::fseek(file, 0, SEEK_END);
+    long long size = std::ftell(file);
+    std::fclose(file);
+    return (size > 0) ? static_cast<unsigned long long>(size) : 0;
+}
+
+static bool benchExtract(const char* filename) {
+    unsigned long long bytes = fileSize(filename);
+    BenchMeter meter;
+
+    meter.start();
+    std::vector<StdfPRR*> prrRecords = StdfExtractor::extractPrrRecords(filename);
+    report(meter.stop("extract_prr", prrRecords.size(), bytes));
+    StdfExtractor::freePrrRecords(prrRecords);
+
+    meter.start();
+    prrRecords = StdfExtractor::extractPrrRecordsIndexed(filename);
+    report(meter.stop("extract_indexed", prrRecords.size(), bytes));
+    StdfExtractor::freePrrRecords(prrRecords);
+
+    meter.start();
+    StdfExtraction extraction;
+    if (!StdfExtractor::extractPartResults(filename, 0, -1, STDF_ALL_TYPES_MASK, extraction)) return false;
+    unsigned long long records = extraction.hbrs.size() + extraction.sbrs.size();
+    for (const StdfPartResult& part : extraction.parts) {
+        records += (part.pir ? 1 : 0) + (part.prr ? 1 : 0) + part.ptrs.size() + part.mprs.size() + part.ftrs.size();
+    }
+    report(meter.stop("extract_parts", records, bytes));
+    StdfExtractor::freeExtraction(extraction);
+    return true;
+}
+
+// only the output is measured, the PRRs are extracted before
+static bool benchSave(const char* filename) {
+    std::vector<StdfPRR*> prrRecords = StdfExtractor::extractPrrRecordsIndexed(filename);
+    if (prrRecords.empty()) return false;
+    time_t syncTime = time(nullptr);
+    bool ok = true;
+    BenchMeter meter;
+
+    meter.start();
+    ok = ok && StdfExtractor::savePrrRecords(prrRecords, BENCH_JSON_FILE, syncTime);
+    if (ok) report(meter.stop("save_json", prrRecords.size(), fileSize(BENCH_JSON_FILE)));
+    std::remove(BENCH_JSON_FILE);
+
+    meter.start();
+    ok = ok && StdfExtractor::savePrrRecordsBinary(prrRecords, BENCH_BLOCK_FILE, syncTime);
+    if (ok) report(meter.stop("save_binary", prrRecords.size(), fileSize(BENCH_BLOCK_FILE)));
+    std::remove(BENCH_BLOCK_FILE);
+
+    {
+        meter.start();
+        NdjsonWriter writer(BENCH_NDJSON_FILE);
+        ok = ok && writer.append(prrRecords, filename, syncTime);
+    }
+    if (ok) report(meter.stop("append_ndjson", prrRecords.size(), fileSize(BENCH_NDJSON_FILE)));
+    std::remove(BENCH_NDJSON_FILE);
+
+    StdfExtractor::freePrrRecords(prrRecords);
+    return ok;
+}
+
+int main(int argc, char* argv[]) {
+    StdfSynthConfig config;
+    const char* filename = nullptr;
+    bool keep = false;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--csv") == 0) csvOutput = true;
+        else if (std::strcmp(argv[i], "--keep") == 0) keep = true;
+        else if (std::strcmp(argv[i], "--file") == 0 && i + 1 < argc) filename = argv[++i];
+        else if (i + 1 < argc && config.set_option(argv[i], argv[i + 1])) i++;
+        else {
+            std::cerr << "bad option " << argv[i] << ", see the head of extract_bench.cpp" << std::endl;
+            return 2;
+        }
+    }
+
+    // the per-range "completed in" lines would be measured with the stages
+    LOG.init("extract_bench.log", LogLevel::WARNING);
+
+    if (csvOutput) std::printf("stage,records,bytes,ms,peak_rss,allocations,allocated\n");
+    else BenchMeter::print_header();
+
+    bool generated = false;
+    if (!filename) {
+        filename = BENCH_FILE;
+        BenchMeter meter;
+        meter.start();
+        StdfSynth synth(config);
+        if (synth.write(filename) != STDF_OPERATE_OK) {
+            std::cerr << "can not write " << filename << std::endl;
+            return 1;
+        }
+        report(meter.stop("generate", synth.record_count(), synth.byte_count()));
+        generated = true;
+    }
+
+    bool ok = benchExtract(filename) && benchSave(filename);
+
+    if (generated && !keep) std::remove(filename);
+    return ok ? 0 : 1;
+}
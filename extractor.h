@@ -3,46 +3,50 @@
 
 #include "stdf_v4_api.h"
 #include "stdf_v4_file.h"
+#include "stdf_v4_index.h"
+#include "stdf_v4_tail.h"
 #include <iostream>
 #include <fstream>
 #include <cstring>
 #include <vector>
 #include "logger.h"
+#include "prr_block.h"
 #include <string>
 #include <sstream>
 #include <map>
+#include <algorithm>
 #include <memory>
 #include <nlohmann/json.hpp>
+#include <thread>
+#include <cstdio>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Results of one part: the PIR, the test records between it and the PRR of the
+// same head/site, and the PRR. pir is nullptr for a part that started before the
+// extraction range, prr is nullptr for a part still open at its end.
+struct StdfPartResult {
+    StdfPIR* pir;
+    StdfPRR* prr;
+    std::vector<StdfPTR*> ptrs;
+    std::vector<StdfMPR*> mprs;
+    std::vector<StdfFTR*> ftrs;
+    unsigned long long pirOffset;
+    unsigned long long prrOffset;
+};
+
+struct StdfExtraction {
+    std::vector<StdfPartResult> parts;  // in PRR order, open parts at the end
+    std::vector<StdfHBR*> hbrs;
+    std::vector<StdfSBR*> sbrs;
+    unsigned long long endOffset;       // behind the last record read
+};
 
 class StdfExtractor {
 private:
-    // Define all possible STDF record types
-    static constexpr int FAR_TYPE = 0;      // File Attributes Record
-    static constexpr int ATR_TYPE = 1;      // Audit Trail Record
-    static constexpr int MIR_TYPE = 2;      // Master Information Record
-    static constexpr int MRR_TYPE = 3;      // Master Results Record
-    static constexpr int PCR_TYPE = 4;      // Part Count Record
-    static constexpr int HBR_TYPE = 5;      // Hardware Bin Record
-    static constexpr int SBR_TYPE = 6;      // Software Bin Record
-    static constexpr int PMR_TYPE = 7;      // Pin Map Record
-    static constexpr int PGR_TYPE = 8;      // Pin Group Record
-    static constexpr int PLR_TYPE = 9;      // Pin List Record
-    static constexpr int RDR_TYPE = 10;     // Retest Data Record
-    static constexpr int SDR_TYPE = 11;     // Site Description Record
-    static constexpr int WIR_TYPE = 12;     // Wafer Information Record
-    static constexpr int WRR_TYPE = 13;     // Wafer Results Record
-    static constexpr int WCR_TYPE = 14;     // Wafer Configuration Record
-    static constexpr int PIR_TYPE = 15;     // Part Information Record
-    static constexpr int PRR_TYPE = 16;     // Part Results Record - standard value
-
-    // Alternative PRR types observed in your data
-    static constexpr int PRR_TYPE_ALT1 = 25;    // Based on logs
-    static constexpr int PRR_TYPE_ALT2 = 185;   // Another possible value
-    
     // Improved isInRange function with better boundary checking and error handling
-    static bool isInRange(std::ifstream& file, const StdfHeader& header, std::streampos startPos, std::streampos endPos) {
-        // Get current file position (before the record)
-        std::streampos currentPos = file.tellg();
+    static bool isInRange(std::streampos currentPos, const StdfHeader& header, std::streampos startPos, std::streampos endPos) {
         
         // Check for invalid file position
         if (currentPos < 0) {
@@ -120,62 +124,61 @@ private:
         return result;
     }
 
-    // Helper function to determine if a record type is a PRR record
-    static bool isPrrRecordType(STDF_TYPE type) {
-        Logger& logger = Logger::getInstance();
-        
-        // Check against all known PRR record types
-        if (type == PRR_TYPE) {
-            logger.debug("Found standard PRR record (type " + std::to_string(type) + ")", "StdfExtractor");
-            return true;
-        }
-        
-        // Check against alternative PRR record types observed in data
-        if (type == PRR_TYPE_ALT1) {
-            logger.debug("Found alternative PRR record (type " + std::to_string(type) + ")", "StdfExtractor");
-            return true;
+    // Writes content to a temporary file next to fileName, fsyncs it and renames it
+    // over fileName: readers never see a half written file, and the data is on disk
+    // before the caller acks the message. Several workers may write the same file.
+    static bool writeFileDurably(const std::string& fileName, const std::string& content) {
+        std::ostringstream tempName;
+        tempName << fileName << ".tmp." << std::this_thread::get_id();
+        std::string tempFileName = tempName.str();
+
+        int fd = open(tempFileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) return false;
+        const char* data = content.data();
+        size_t remaining = content.size();
+        while (remaining > 0) {
+            ssize_t count = write(fd, data, remaining);
+            if (count < 0) {
+                if (errno == EINTR) continue;
+                close(fd);
+                unlink(tempFileName.c_str());
+                return false;
+            }
+            data += count;
+            remaining -= static_cast<size_t>(count);
         }
-        
-        if (type == PRR_TYPE_ALT2) {
-            logger.debug("Found alternative PRR record (type " + std::to_string(type) + ")", "StdfExtractor");
-            return true;
+        if (fsync(fd) != 0) {
+            close(fd);
+            unlink(tempFileName.c_str());
+            return false;
         }
-        
-        // Dynamic detection of potential PRR records
-        static std::map<STDF_TYPE, int> typeCount;
-        static int totalChecks = 0;
-        
-        typeCount[type]++;
-        totalChecks++;
-        
-        // Every 1000 checks, log the most common record types
-        if (totalChecks % 1000 == 0) {
-            // Find the most common types
-            std::vector<std::pair<STDF_TYPE, int>> sortedTypes;
-            for (const auto& pair : typeCount) {
-                if (pair.second > 50) { // Only include types seen at least 50 times
-                    sortedTypes.push_back(pair);
-                }
-            }
-            
-            // Sort by frequency
-            std::sort(sortedTypes.begin(), sortedTypes.end(), 
-                     [](const auto& a, const auto& b) { return a.second > b.second; });
-            
-            // Log the top 3 most common types
-            std::stringstream typesLog;
-            typesLog << "Most common record types: ";
-            for (size_t i = 0; i < std::min(size_t(3), sortedTypes.size()); i++) {
-                typesLog << "type " << sortedTypes[i].first << " (" << sortedTypes[i].second << " times)";
-                if (i < std::min(size_t(2), sortedTypes.size() - 1)) typesLog << ", ";
-            }
-            
-            if (!sortedTypes.empty()) {
-                logger.info(typesLog.str(), "StdfExtractor");
-            }
+        close(fd);
+        if (std::rename(tempFileName.c_str(), fileName.c_str()) != 0) {
+            unlink(tempFileName.c_str());
+            return false;
         }
-        
-        return false;
+        return true;
+    }
+
+    // Reads the record at the file position as StdfHeader::read does, into buffer:
+    // header points at it until the next call. REC_LEN and the numbers of a
+    // CPU_TYPE=1 file are swapped like in StdfRecordCursor.
+    static STDF_TYPE readRecord(std::ifstream& file, StdfHeader& header, std::vector<char>& buffer, bool swapped) {
+        buffer.resize(4);
+        file.read(buffer.data(), 4);
+        if (file.gcount() != 4) return UNKNOWN_TYPE;
+        unsigned short length = 0;
+        std::memcpy(&length, buffer.data(), 2);
+        if (swapped) length = static_cast<unsigned short>((length >> 8) | (length << 8));
+        buffer.resize(4 + length);
+        file.read(buffer.data() + 4, length);
+        if (!header.map(buffer.data(), 4 + static_cast<unsigned int>(file.gcount()), swapped)) return UNKNOWN_TYPE;
+        return header.get_type();
+    }
+
+    // Helper function to determine if a record type is a PRR record
+    static bool isPrrRecordType(STDF_TYPE type) {
+        return type == PRR_TYPE;
     }
 
 public:
@@ -204,7 +207,7 @@ public:
         std::streampos fileSize = file.tellg();
         file.seekg(0, std::ios::beg);
 
-        logger.debug("File Size: " + formatPosition(fileSize), "StdfExtractor");
+        LOG_DEBUG("File Size: " + formatPosition(fileSize), "StdfExtractor");
 
         // Validate input range
         if (startPos < 0) {
@@ -227,15 +230,23 @@ public:
         logger.info("Extraction range: " + formatPosition(startPos) + " to " +
                     formatPosition(endPos) + " (" + std::to_string(endPos - startPos) + " bytes)", "StdfExtractor");
 
+        // The byte order comes from the FAR CPU_TYPE also when starting later in the file
+        StdfHeader header;
+        std::vector<char> recordData;
+        char farData[6] = {0};
+        file.read(farData, sizeof(farData));
+        bool swapped = (file.gcount() == sizeof(farData) && farData[2] == 0 && farData[3] == 10 &&
+                        STDF_CPU_TYPE_SUPPORTED(farData[4]) && farData[4] != STDF_HOST_CPU_TYPE);
+        file.clear();
+
         // Set initial file position
         file.seekg(startPos);
 
         // First, check if file is a valid STDF file if starting from beginning
         if (startPos == 0) {
-            logger.debug("Starting from file beginning, verifying FAR record", "StdfExtractor");
+            LOG_DEBUG("Starting from file beginning, verifying FAR record", "StdfExtractor");
 
-            StdfHeader header;
-            STDF_TYPE type = header.read(file);
+            STDF_TYPE type = readRecord(file, header, recordData, swapped);
 
             if (type != FAR_TYPE) {
                 logger.error("File does not start with a FAR record, found type: " + std::to_string(type), "StdfExtractor");
@@ -247,10 +258,11 @@ public:
             StdfFAR farRecord;
             farRecord.parse(header);
 
-            logger.debug("FAR record: CPU type=" + std::to_string(farRecord.get_cpu_type()) + 
+            LOG_DEBUG("FAR record: CPU type=" + std::to_string(farRecord.get_cpu_type()) + 
                          ", STDF version=" + std::to_string(farRecord.get_stdf_version()), "StdfExtractor");
             
-            if (farRecord.get_cpu_type() != 2) {
+            // CPU_TYPE=1 files are read with swapped numbers
+            if (!STDF_CPU_TYPE_SUPPORTED(farRecord.get_cpu_type())) {
                 logger.error("Unsupported CPU type: " + std::to_string(farRecord.get_cpu_type()), "StdfExtractor");
                 file.close();
                 return prrRecords;
@@ -305,8 +317,7 @@ public:
             invalidPositions = 0; // Reset counter on valid position
             
             try {
-                StdfHeader header;
-                STDF_TYPE type = header.read(file);
+                STDF_TYPE type = readRecord(file, header, recordData, swapped);
                 
                 if (file.fail()) {
                     logger.error("File read error at position " + formatPosition(recordStartPos), "StdfExtractor");
@@ -315,34 +326,16 @@ public:
                 
                 totalRecords++;
 
-                // Check if we're still within range
-                if (!isInRange(file, header, startPos, endPos)) {
-                    logger.debug("Record at " + formatPosition(recordStartPos) + 
+                // Check if we're still within range, readRecord is behind the record already
+                if (!isInRange(recordStartPos, header, startPos, endPos)) {
+                    LOG_DEBUG("Record at " + formatPosition(recordStartPos) + 
                                 " extends beyond extraction range, skipping", "StdfExtractor");
-                    
-                    // Skip to next record
-                    std::streamoff skipLength = header.get_length();
-                    
-                    // Sanity check on skip length
-                    if (skipLength <= 0 || skipLength > 100000) {
-                        logger.warning("Invalid skip length: " + std::to_string(skipLength) + ", stopping extraction", "StdfExtractor");
-                        break;
-                    }
-                    
-                    file.seekg(skipLength, std::ios::cur);
-                    
-                    // Check if seek failed
-                    if (file.fail()) {
-                        logger.error("Failed to skip to next record from " + formatPosition(recordStartPos), "StdfExtractor");
-                        break;
-                    }
-                    
                     continue;
                 }
 
                 // If this is a PRR Record, extract it
                 if (isPrrRecordType(type)) {
-                    logger.debug("Found potential PRR record (type " + std::to_string(type) + ") at position " + 
+                    LOG_DEBUG("Found potential PRR record (type " + std::to_string(type) + ") at position " + 
                                 formatPosition(recordStartPos) + " with length " + std::to_string(header.get_length()), "StdfExtractor");
                                 
                     try {
@@ -350,52 +343,27 @@ public:
                         prrRecord->parse(header);
                         
                         // Add extra logging to check the record content
-                        logger.debug("PRR content: head=" + std::to_string(prrRecord->get_head_number()) + 
+                        LOG_DEBUG("PRR content: head=" + std::to_string(prrRecord->get_head_number()) + 
                                     ", site=" + std::to_string(prrRecord->get_site_number()) + 
                                     ", hardbin=" + std::to_string(prrRecord->get_hardbin_number()) + 
                                     ", softbin=" + std::to_string(prrRecord->get_softbin_number()), "StdfExtractor");
-                        
-                        // Validate the PRR record before adding it (basic sanity checks)
-                        if (prrRecord->get_hardbin_number() < -10000 || prrRecord->get_softbin_number() < -10000 ||
-                            prrRecord->get_head_number() > 255 || prrRecord->get_site_number() > 255) {
-                            logger.warning("Suspicious PRR record values, discarding record", "StdfExtractor");
-                            delete prrRecord;
-                        } else {
-                            prrRecords.push_back(prrRecord);
-                            prrRecordsFound++;
-                            
-                            if (prrRecordsFound % 100 == 0 || prrRecordsFound == 1) {
-                                logger.info("Extracted " + std::to_string(prrRecordsFound) + " PRR records so far", "StdfExtractor");
-                            }
+
+                        prrRecords.push_back(prrRecord);
+                        prrRecordsFound++;
+
+                        if (prrRecordsFound % 100 == 0 || prrRecordsFound == 1) {
+                            logger.info("Extracted " + std::to_string(prrRecordsFound) + " PRR records so far", "StdfExtractor");
                         }
                     } catch (const std::exception& e) {
                         logger.error("Failed to parse PRR record: " + std::string(e.what()), "StdfExtractor");
                         // Continue to next record
-                        file.seekg(header.get_length(), std::ios::cur);
                     }
                 } else {
                     // Log record types periodically to identify patterns
                     if (totalRecords % 1000 == 0) {
-                        logger.debug("Processing record " + std::to_string(totalRecords) + 
+                        LOG_DEBUG("Processing record " + std::to_string(totalRecords) + 
                                     ", found " + std::to_string(prrRecordsFound) + " PRR records so far", "StdfExtractor");
                     }
-                    
-                    // Skip to the next record if not a PRR
-                    std::streamoff skipLength = header.get_length();
-                    
-                    // Sanity check
-                    if (skipLength < 0 || skipLength > 100000) {
-                        logger.warning("Suspicious record length for skipping: " + std::to_string(skipLength), "StdfExtractor");
-                        break;
-                    }
-                    
-                    file.seekg(skipLength, std::ios::cur);
-                    
-                    // Check if seek failed
-                    if (file.fail()) {
-                        logger.error("Failed to skip non-PRR record from " + formatPosition(recordStartPos), "StdfExtractor");
-                        break;
-                    }
                 }
             } catch (const std::exception& e) {
                 logger.error("Error parsing record at position " + formatPosition(recordStartPos) + 
@@ -412,6 +380,323 @@ public:
         return prrRecords;
     }
 
+    /**
+     * Extract PRR records within the byte range through the .stdx index of the file
+     * 
+     * The index is brought up to date first (only the bytes added since the last
+     * call are scanned), then the PRRs in range are parsed straight from their offsets.
+     * A record is in range under the same rule as isInRange: it starts at or after
+     * startPos and ends at or before endPos.
+     * 
+     * @param filename Path to STDF file
+     * @param startPos Starting byte position (0 = start of file)
+     * @param endPos Ending byte position (-1 = end of file)
+     * @return Vector of pointers to extracted PRR records (caller must free)
+     */
+    static std::vector<StdfPRR*> extractPrrRecordsIndexed(const char* filename, long long startPos = 0, long long endPos = -1) {
+        std::vector<StdfPRR*> prrRecords;
+        Logger& logger = Logger::getInstance();
+
+        StdfIndex index;
+        STDF_FILE_ERROR ret = index.update(filename);
+        if (ret != STDF_OPERATE_OK) {
+            logger.error("Failed to index file: " + std::string(filename) + " (error " + std::to_string(ret) + ")", "StdfExtractor");
+            return prrRecords;
+        }
+
+        unsigned long long rangeStart = (startPos < 0) ? 0 : static_cast<unsigned long long>(startPos);
+        unsigned long long rangeEnd = (endPos < 0) ? index.indexed_size() : static_cast<unsigned long long>(endPos);
+        const STDF_TYPE prrType = PRR_TYPE;
+        unsigned int prrCount = index.get_count(prrType);
+
+        // first PRR at or after startPos, PRR offsets are ascending
+        unsigned int low = 0, high = prrCount;
+        while (low < high) {
+            unsigned int mid = low + (high - low) / 2;
+            if (index.get_offset(prrType, mid) < rangeStart) low = mid + 1;
+            else high = mid;
+        }
+
+        StdfRecordCursor cursor;
+        if (!cursor.open(filename)) {
+            logger.error("Failed to open file: " + std::string(filename), "StdfExtractor");
+            return prrRecords;
+        }
+
+        StdfHeader header;
+        for (unsigned int i = low; i < prrCount; i++) {
+            unsigned long long offset = index.get_offset(prrType, i);
+            if (!cursor.map(offset, header)) break;
+            if (offset + 4 + header.get_length() > rangeEnd) break;
+
+            StdfPRR* prrRecord = new StdfPRR();
+            prrRecord->parse(header);
+            prrRecords.push_back(prrRecord);
+        }
+        cursor.close();
+
+        logger.info("Indexed extraction: " + std::to_string(prrRecords.size()) + " PRR records in range " +
+                    formatPosition(static_cast<std::streamoff>(rangeStart)) + " to " +
+                    formatPosition(static_cast<std::streamoff>(rangeEnd)), "StdfExtractor");
+        return prrRecords;
+    }
+
+    /**
+     * Open a tail reader for a file, continuing at the first record that ends after startPos
+     * 
+     * A consumer that starts in the middle of a file (restart, first message of a file
+     * already partly handled) finds the record boundary through the .stdx index. A record
+     * cut by startPos was not complete in the earlier delta, so it is read again.
+     * 
+     * @param filename Path to STDF file
+     * @param startPos Byte position already handled before
+     * @return New reader (caller must free)
+     */
+    static StdfTailReader* openTailReader(const char* filename, long long startPos = 0) {
+        Logger& logger = Logger::getInstance();
+        unsigned long long offset = 0;
+        if (startPos > 0) {
+            StdfIndex index;
+            if (index.update(filename) == STDF_OPERATE_OK) {
+                unsigned long long position = static_cast<unsigned long long>(startPos);
+                unsigned int entry = index.find_entry(position);
+                // the entries follow each other, a record ends where the next one starts
+                unsigned long long entryStart = (entry < index.get_count()) ? index.get_entry(entry).offset : index.indexed_size();
+                if (entry > 0 && entryStart > position) entry--;
+                offset = (entry < index.get_count()) ? index.get_entry(entry).offset : index.indexed_size();
+            } else {
+                logger.warning("Failed to index file: " + std::string(filename) + ", following it from the start", "StdfExtractor");
+            }
+        }
+        logger.info("Following file: " + std::string(filename) + " from " +
+                    formatPosition(static_cast<std::streamoff>(offset)), "StdfExtractor");
+        return new StdfTailReader(filename, offset);
+    }
+
+    /**
+     * Extract the PRR records completed since the last call with this reader
+     * 
+     * The reader keeps the file open, its offset and a record cut by the end of the
+     * last delta, so a PRR split across two rsync deltas comes with the second one.
+     * 
+     * @param reader Tail reader of the file
+     * @param wafers If given, a WIR adds the number of PRRs before it and its WAFER_ID
+     * @return Vector of pointers to extracted PRR records (caller must free)
+     */
+    static std::vector<StdfPRR*> extractNewPrrRecords(StdfTailReader& reader,
+                                                      std::vector<std::pair<size_t, std::string>>* wafers = nullptr) {
+        std::vector<StdfPRR*> prrRecords;
+        Logger& logger = Logger::getInstance();
+
+        std::vector<StdfRecord*> records;
+        unsigned int generation = reader.generation();
+        unsigned int typeMask = STDF_TYPE_MASK(PRR_TYPE) | (wafers ? STDF_TYPE_MASK(WIR_TYPE) : 0);
+        STDF_FILE_ERROR ret = reader.poll(records, typeMask);
+        if (ret != STDF_OPERATE_OK) {
+            logger.error("Failed to read new data of file: " + std::string(reader.filename()) + " (error " + std::to_string(ret) + ")", "StdfExtractor");
+        }
+        if (reader.generation() != generation) {
+            logger.warning("File was replaced or truncated, reading it again from the start: " + std::string(reader.filename()), "StdfExtractor");
+        }
+
+        for (StdfRecord* record : records) {
+            if (record->type() == WIR_TYPE) {
+                const char* waferId = static_cast<StdfWIR*>(record)->get_wafer_id();
+                wafers->push_back(std::make_pair(prrRecords.size(), std::string(waferId ? waferId : "")));
+                delete record;
+                continue;
+            }
+            prrRecords.push_back(static_cast<StdfPRR*>(record));
+        }
+
+        logger.info("Extracted " + std::to_string(prrRecords.size()) + " new PRR records, file offset " +
+                    formatPosition(static_cast<std::streamoff>(reader.offset())) + ", " +
+                    std::to_string(reader.pending()) + " bytes pending", "StdfExtractor");
+        return prrRecords;
+    }
+
+    /**
+     * Extract the part results within the byte range in one pass over the file
+     * 
+     * PIR and PRR are always decoded, they open and close a part per head/site.
+     * The test records in typeMask are attached to the open part of their
+     * head/site, HBR/SBR in typeMask are collected as summary records; every
+     * other record is skipped by its length without decoding.
+     * 
+     * Not used by processMessage yet, only by extract_bench: the daemon reads the
+     * deltas with the tail reader of the file, a part often starts in one delta
+     * and ends in the next, and the NDJSON and block outputs only carry PRRs.
+     * Part results there need the open parts kept in FileState across messages
+     * and an output for the test records first.
+     * 
+     * @param filename Path to STDF file
+     * @param startPos Starting byte position (0 = start of file), moved to the next record boundary
+     * @param endPos Ending byte position (-1 = end of file), records have to end at or before it
+     * @param typeMask STDF_TYPE_MASK of the record types to decode
+     * @param result Extracted records (caller must free with freeExtraction)
+     * @return true if successful, false otherwise
+     */
+    static bool extractPartResults(const char* filename, long long startPos, long long endPos,
+                                   unsigned int typeMask, StdfExtraction& result) {
+        Logger& logger = Logger::getInstance();
+        result.endOffset = 0;
+
+        StdfRecordCursor cursor;
+        if (!cursor.open(filename)) {
+            logger.error("Failed to open file: " + std::string(filename), "StdfExtractor");
+            return false;
+        }
+
+        unsigned long long rangeEnd = (endPos < 0 || static_cast<unsigned long long>(endPos) > cursor.size()) ?
+                                      cursor.size() : static_cast<unsigned long long>(endPos);
+        StdfHeader header;
+        if (startPos <= 0) {
+            if (!cursor.next(header) || header.get_type() != FAR_TYPE) {
+                logger.error("File does not start with a FAR record: " + std::string(filename), "StdfExtractor");
+                return false;
+            }
+            StdfFAR farRecord;
+            farRecord.parse(header);
+            // the cursor swaps CPU_TYPE=1 files itself
+            if (!STDF_CPU_TYPE_SUPPORTED(farRecord.get_cpu_type())) {
+                logger.error("Unsupported CPU type: " + std::to_string(farRecord.get_cpu_type()), "StdfExtractor");
+                return false;
+            }
+        } else {
+            // the range may start inside a record, continue at the next boundary
+            StdfIndex index;
+            if (index.update(filename) != STDF_OPERATE_OK) {
+                logger.error("Failed to index file: " + std::string(filename), "StdfExtractor");
+                return false;
+            }
+            unsigned int entry = index.find_entry(static_cast<unsigned long long>(startPos));
+            unsigned long long offset = (entry < index.get_count()) ? index.get_entry(entry).offset : index.indexed_size();
+            if (!cursor.seek(offset)) {
+                result.endOffset = offset;
+                return true;
+            }
+        }
+        result.endOffset = cursor.tell();
+
+        // head<<8|site -> index into result.parts of the open part
+        std::map<unsigned short, size_t> openParts;
+        size_t closedParts = 0;
+        const unsigned int testMask = STDF_TYPE_MASK(PTR_TYPE) | STDF_TYPE_MASK(MPR_TYPE) | STDF_TYPE_MASK(FTR_TYPE);
+
+        while (cursor.tell() < rangeEnd && cursor.next(header)) {
+            unsigned long long offset = cursor.record_offset();
+            if (offset + 4 + header.get_length() > rangeEnd) break;
+            result.endOffset = cursor.tell();
+
+            STDF_TYPE type = header.get_type();
+            if (type == UNKNOWN_TYPE) continue;
+            unsigned int typeBit = STDF_TYPE_MASK(type);
+            if (type != PIR_TYPE && type != PRR_TYPE && !(typeMask & typeBit)) continue;
+
+            StdfRecord* record = header.create_record(type);
+            if (!record) continue;
+            record->parse(header);
+
+            if (type == HBR_TYPE) {
+                result.hbrs.push_back(static_cast<StdfHBR*>(record));
+                continue;
+            }
+            if (type == SBR_TYPE) {
+                result.sbrs.push_back(static_cast<StdfSBR*>(record));
+                continue;
+            }
+            if (type != PIR_TYPE && type != PRR_TYPE && !(testMask & typeBit)) {
+                delete record;
+                continue;
+            }
+
+            unsigned char head = 0, site = 0;
+            switch (type) {
+                case PIR_TYPE: head = static_cast<StdfPIR*>(record)->get_head_number(); site = static_cast<StdfPIR*>(record)->get_site_number(); break;
+                case PRR_TYPE: head = static_cast<StdfPRR*>(record)->get_head_number(); site = static_cast<StdfPRR*>(record)->get_site_number(); break;
+                case PTR_TYPE: head = static_cast<StdfPTR*>(record)->get_head_number(); site = static_cast<StdfPTR*>(record)->get_site_number(); break;
+                case MPR_TYPE: head = static_cast<StdfMPR*>(record)->get_head_number(); site = static_cast<StdfMPR*>(record)->get_site_number(); break;
+                case FTR_TYPE: head = static_cast<StdfFTR*>(record)->get_head_number(); site = static_cast<StdfFTR*>(record)->get_site_number(); break;
+                default: break;
+            }
+            unsigned short key = static_cast<unsigned short>((head << 8) | site);
+
+            std::map<unsigned short, size_t>::iterator open = openParts.find(key);
+            if (type == PIR_TYPE && open != openParts.end()) {
+                logger.warning("PIR without PRR for head " + std::to_string(head) + " site " + std::to_string(site), "StdfExtractor");
+                openParts.erase(open);
+                open = openParts.end();
+            }
+            if (open == openParts.end()) {
+                StdfPartResult part;
+                part.pir = nullptr;
+                part.prr = nullptr;
+                part.pirOffset = 0;
+                part.prrOffset = 0;
+                result.parts.push_back(part);
+                open = openParts.insert(std::make_pair(key, result.parts.size() - 1)).first;
+            }
+
+            StdfPartResult& part = result.parts[open->second];
+            switch (type) {
+                case PIR_TYPE:
+                    part.pir = static_cast<StdfPIR*>(record);
+                    part.pirOffset = offset;
+                    break;
+                case PRR_TYPE:
+                    part.prr = static_cast<StdfPRR*>(record);
+                    part.prrOffset = offset;
+                    openParts.erase(open);
+                    closedParts++;
+                    break;
+                case PTR_TYPE: part.ptrs.push_back(static_cast<StdfPTR*>(record)); break;
+                case MPR_TYPE: part.mprs.push_back(static_cast<StdfMPR*>(record)); break;
+                case FTR_TYPE: part.ftrs.push_back(static_cast<StdfFTR*>(record)); break;
+                default: break;
+            }
+        }
+        cursor.close();
+
+        // parts were added in PIR order, hand them out in PRR order with the open ones last
+        std::vector<StdfPartResult> ordered;
+        ordered.reserve(result.parts.size());
+        for (const StdfPartResult& part : result.parts) {
+            if (part.prr) ordered.push_back(part);
+        }
+        std::stable_sort(ordered.begin(), ordered.end(),
+                         [](const StdfPartResult& a, const StdfPartResult& b) { return a.prrOffset < b.prrOffset; });
+        for (const StdfPartResult& part : result.parts) {
+            if (!part.prr) ordered.push_back(part);
+        }
+        result.parts.swap(ordered);
+
+        logger.info("Extracted " + std::to_string(closedParts) + " complete parts, " +
+                    std::to_string(result.parts.size() - closedParts) + " open, " +
+                    std::to_string(result.hbrs.size()) + " HBR, " + std::to_string(result.sbrs.size()) +
+                    " SBR up to " + formatPosition(static_cast<std::streamoff>(result.endOffset)), "StdfExtractor");
+        return true;
+    }
+
+    /**
+     * Free Memory used by an extraction
+     * 
+     * @param result Extraction to free
+     */
+    static void freeExtraction(StdfExtraction& result) {
+        for (StdfPartResult& part : result.parts) {
+            delete part.pir;
+            delete part.prr;
+            for (StdfPTR* ptr : part.ptrs) delete ptr;
+            for (StdfMPR* mpr : part.mprs) delete mpr;
+            for (StdfFTR* ftr : part.ftrs) delete ftr;
+        }
+        for (StdfHBR* hbr : result.hbrs) delete hbr;
+        for (StdfSBR* sbr : result.sbrs) delete sbr;
+        result.parts.clear();
+        result.hbrs.clear();
+        result.sbrs.clear();
+    }
+
     /**
      * Save extracted PRR records to JSON file
      * 
@@ -442,17 +727,12 @@ public:
                 }
                 
                 // Write to File even if empty - this ensures the file exists with valid JSON
-                std::ofstream jsonFile(outputFileName);
-                if (!jsonFile.is_open()) {
-                    logger.error("Failed to open output JSON file: " + outputFileName, "StdfExtractor");
+                // Write empty array with comment indicating no records found
+                if (!writeFileDurably(outputFileName, "// No PRR records found in the processed file range\n" + emptyArray.dump(4))) {
+                    logger.error("Failed to write output JSON file: " + outputFileName, "StdfExtractor");
                     return false;
                 }
                 
-                // Write empty array with comment indicating no records found
-                jsonFile << "// No PRR records found in the processed file range\n";
-                jsonFile << emptyArray.dump(4);
-                jsonFile.close();
-                
                 logger.info("Saved empty result to JSON file (no PRR records found)", "StdfExtractor");
                 return true;  // Return success even for empty results
             } catch (const std::exception& e) {
@@ -518,17 +798,12 @@ public:
                 jsonRecords.push_back(jsonRecord);
             }
 
-            // Write to File
-            std::ofstream jsonFile(outputFileName);
-            if (!jsonFile.is_open()) {
-                logger.error("Failed to open output JSON file: " + outputFileName, "StdfExtractor");
+            // Write to File with pretty formatting (4 spaces indentation)
+            if (!writeFileDurably(outputFileName, jsonRecords.dump(4))) {
+                logger.error("Failed to write output JSON file: " + outputFileName, "StdfExtractor");
                 return false;
             }
 
-            // Write with pretty formatting (4 spaces indentation)
-            jsonFile << jsonRecords.dump(4);
-            jsonFile.close();
-
             logger.info("Successfully saved " + std::to_string(prrRecords.size()) + " PRR records to JSON file", "StdfExtractor");
             return true;
         } catch (const std::exception& e) {
@@ -537,21 +812,38 @@ public:
         }
     }
 
+    /**
+     * Save extracted PRR records as a columnar binary block (see prr_block.h)
+     *
+     * @param prrRecords vector of PRR records to save
+     * @param outputFileName Path to the output block file
+     * @param sync_time Timestamp to use for the records
+     * @return true if successful, false otherwise
+     */
+    static bool savePrrRecordsBinary(const std::vector<StdfPRR*>& prrRecords, const std::string& outputFileName, const time_t& sync_time) {
+        Logger& logger = Logger::getInstance();
+        if (!writeFileDurably(outputFileName, PrrBlockWriter::build(prrRecords, sync_time))) {
+            logger.error("Failed to write output block file: " + outputFileName, "StdfExtractor");
+            return false;
+        }
+        logger.info("Saved " + std::to_string(prrRecords.size()) + " PRR records to block file: " + outputFileName, "StdfExtractor");
+        return true;
+    }
+
     /**
      * Free Memory used by extracted PRR records
      * 
      * @param prrRecords Vector of PRR records to free
      */
     static void freePrrRecords(std::vector<StdfPRR*>& prrRecords) {
-        Logger& logger = Logger::getInstance();
-        logger.debug("Freeing memory for " + std::to_string(prrRecords.size()) + " PRR records", "StdfExtractor");
+        LOG_DEBUG("Freeing memory for " + std::to_string(prrRecords.size()) + " PRR records", "StdfExtractor");
 
         for (StdfPRR* record : prrRecords) {
             delete record;
         }
         prrRecords.clear();
 
-        logger.debug("Memory freed", "StdfExtractor");
+        LOG_DEBUG("Memory freed", "StdfExtractor");
     }
 };
 
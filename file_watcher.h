@@ -0,0 +1,221 @@
+#ifndef FILE_WATCHER_H
+#define FILE_WATCHER_H
+
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <sys/stat.h>
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#include "logger.h"
+
+/**
+ * Tells when a sync source has changed, so the transfer only runs when there is
+ * something to transfer.
+ *
+ * - Local path (mounted share): inotify on the directory of the file, with a stat
+ *   of size/mtime as safety net for file systems that do not report remote writes.
+ * - rsync:// or host:: source: "rsync --list-only" gives size and mtime of the file
+ *   without a transfer. Polled with a backoff from minIntervalMs to maxIntervalMs
+ *   while the file does not change.
+ *
+ * waitForChange() blocks a thread per source. An event loop over many sources
+ * instead waits for eventFd() (when there is one) or intervalMs(), then calls
+ * drainEvents() and check().
+ */
+class FileWatcher {
+public:
+    enum class Probe {
+        CHANGED,
+        UNCHANGED,
+        FAILED
+    };
+
+    struct FileState {
+        long long size;
+        std::string mtime;
+        bool operator==(const FileState& other) const { return size == other.size && mtime == other.mtime; }
+        bool operator!=(const FileState& other) const { return !(*this == other); }
+    };
+
+    FileWatcher(const std::string& source, int minIntervalMs = 200, int maxIntervalMs = 5000)
+        : source_(source), minIntervalMs_(minIntervalMs), maxIntervalMs_(maxIntervalMs),
+          intervalMs_(minIntervalMs), inotifyFd_(-1), watchFd_(-1), first_(true) {
+        lastState_.size = -1;
+        remote_ = isRemote(source);
+        if (!remote_) {
+            openInotify();
+        }
+        LOG.info(std::string("Watching ") + source_ + (remote_ ? " by remote listing" :
+                 (inotifyFd_ >= 0 ? " by inotify" : " by stat polling")), "FileWatcher");
+    }
+
+    ~FileWatcher() {
+        if (inotifyFd_ >= 0) {
+            close(inotifyFd_);
+        }
+    }
+
+    static bool isRemote(const std::string& source) {
+        return source.compare(0, 8, "rsync://") == 0 || source.find("::") != std::string::npos ||
+               (source.find(':') != std::string::npos && source[0] != '/');
+    }
+
+    /**
+     * Block until the source differs from what the last call saw.
+     * The first call returns at once so the first transfer runs right away.
+     *
+     * @return true when the file changed, false when it can not be probed at the moment
+     */
+    bool waitForChange() {
+        while (true) {
+            if (!first_) {
+                waitInterval();
+            }
+            Probe result = check();
+            if (result == Probe::FAILED) return false;
+            if (result == Probe::CHANGED) return true;
+        }
+    }
+
+    /**
+     * Probe the source once, without waiting, and adapt the poll interval.
+     * The first call reports CHANGED so the first transfer runs right away.
+     */
+    Probe check() {
+        if (first_) {
+            first_ = false;
+            probe(lastState_);
+            return Probe::CHANGED;
+        }
+
+        FileState state;
+        if (!probe(state)) {
+            backoff();
+            return Probe::FAILED;
+        }
+        if (state != lastState_) {
+            LOG_DEBUG("Change detected, size " + std::to_string(lastState_.size) + " -> " +
+                      std::to_string(state.size), "FileWatcher");
+            lastState_ = state;
+            intervalMs_ = minIntervalMs_;
+            return Probe::CHANGED;
+        }
+        backoff();
+        return Probe::UNCHANGED;
+    }
+
+    // inotify descriptor to poll for events, -1 if the source has to be polled
+    int eventFd() const { return inotifyFd_; }
+
+    // How long to wait before the next check(): the poll interval, with inotify
+    // maxIntervalMs as the stat safety net
+    int intervalMs() const { return inotifyFd_ >= 0 ? maxIntervalMs_ : intervalMs_; }
+
+    // read all queued inotify events, the check() afterwards decides
+    void drainEvents() {
+        if (inotifyFd_ < 0) return;
+        alignas(struct inotify_event) char buffer[4096];
+        while (read(inotifyFd_, buffer, sizeof(buffer)) > 0) {
+        }
+    }
+
+    bool isEventDriven() const { return inotifyFd_ >= 0; }
+    long long lastSize() const { return lastState_.size; }
+
+private:
+    void openInotify() {
+        size_t slash = source_.find_last_of('/');
+        std::string directory = (slash == std::string::npos) ? "." : source_.substr(0, slash == 0 ? 1 : slash);
+
+        inotifyFd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotifyFd_ < 0) {
+            LOG.warning("inotify not available: " + std::string(strerror(errno)), "FileWatcher");
+            return;
+        }
+        // watch the directory, the file may not exist yet or be replaced by a rename
+        watchFd_ = inotify_add_watch(inotifyFd_, directory.c_str(),
+                                     IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ATTRIB);
+        if (watchFd_ < 0) {
+            LOG.warning("Failed to watch " + directory + ": " + std::string(strerror(errno)), "FileWatcher");
+            close(inotifyFd_);
+            inotifyFd_ = -1;
+        }
+    }
+
+    // With inotify: wait for an event of our file or maxIntervalMs (stat safety net).
+    // Without: sleep the current poll interval.
+    void waitInterval() {
+        if (inotifyFd_ < 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(intervalMs_));
+            return;
+        }
+
+        struct pollfd pfd;
+        pfd.fd = inotifyFd_;
+        pfd.events = POLLIN;
+        if (poll(&pfd, 1, maxIntervalMs_) <= 0) return;
+        drainEvents();
+    }
+
+    void backoff() {
+        intervalMs_ = std::min(intervalMs_ * 2, maxIntervalMs_);
+    }
+
+    bool probe(FileState& state) {
+        return remote_ ? probeRemote(state) : probeLocal(state);
+    }
+
+    bool probeLocal(FileState& state) {
+        struct stat info;
+        if (stat(source_.c_str(), &info) != 0) return false;
+        state.size = static_cast<long long>(info.st_size);
+        state.mtime = std::to_string(static_cast<long long>(info.st_mtime));
+        return true;
+    }
+
+    // "-rw-rw-r--    123,456,789 2025/03/02 00:09:12 name" from rsync --list-only
+    bool probeRemote(FileState& state) {
+        std::string command = "rsync --list-only " + source_ + " 2>/dev/null";
+        FILE* pipe = popen(command.c_str(), "r");
+        if (!pipe) {
+            LOG.error("Failed to execute rsync --list-only", "FileWatcher");
+            return false;
+        }
+
+        char line[1024];
+        bool found = false;
+        while (fgets(line, sizeof(line), pipe) != nullptr) {
+            char perms[32], size[64], date[16], time[16];
+            if (found || sscanf(line, "%31s %63s %15s %15s", perms, size, date, time) != 4 || perms[0] != '-') continue;
+
+            std::string digits;
+            for (const char* c = size; *c; c++) {
+                if (*c >= '0' && *c <= '9') digits += *c;
+            }
+            state.size = digits.empty() ? -1 : std::strtoll(digits.c_str(), nullptr, 10);
+            state.mtime = std::string(date) + " " + time;
+            found = true;
+        }
+        pclose(pipe);
+        return found;
+    }
+
+    std::string source_;
+    int minIntervalMs_;
+    int maxIntervalMs_;
+    int intervalMs_;
+    int inotifyFd_;
+    int watchFd_;
+    bool remote_;
+    bool first_;
+    FileState lastState_;
+};
+
+#endif // FILE_WATCHER_H
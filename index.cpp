@@ -3,6 +3,7 @@
 #include <vector>
 #include <regex>
 #include <memory>
+#include <map>
 #include <chrono>
 #include <thread>
 #include <cstdio>
@@ -13,22 +14,25 @@
 #include <rabbitmq-c/tcp_socket.h>
 #include <stdf_reader/stdf_v4_api.h>
 #include <stdf_reader/stdf_v4_file.h>
+#include <stdf_reader/stdf_v4_index.h>
+#include <stdf_reader/stdf_v4_tail.h>
 #include "logger.h"
 #include "extractor.h"
+#include "file_watcher.h"
+#include "append_fetcher.h"
+#include "amqp_publisher.h"
+#include "worker_pool.h"
+#include "ndjson_writer.h"
+#include "yield_aggregator.h"
+#include "metrics.h"
+#include "daemon_config.h"
+#include "sync_scheduler.h"
 #include "nlohmann/json.hpp"
 using json = nlohmann::json;
 
-// RabbitMQ Server COnfiguration
-const std::string RABBITMQ_HOST = "10.100.246.53";
-const int RABBITMQ_PORT = 5672;
-const std::string RABBITMQ_USER = "system";
-const std::string RABBITMQ_PASSWORD = "system";
-const std::string RABBITMQ_VHOST = "/";
-const std::string QUEUE_NAME = "LPX-67";
-const std::string EXCHANGE_NAME = "";
-const std::string ROUTING_KEY = "LPX-67";
-const int CHANNEL_ID = 1;
-int PREVIOUS_POSITION = 0;
+// Broker, output, sync and the testers: from the config file given on the command
+// line, DaemonConfig::defaults() without one. Set in main() before any thread starts.
+DaemonConfig CONFIG = DaemonConfig::defaults();
 
 std::string getCurrentTimestamp() {
     struct timeval tv;
@@ -42,6 +46,277 @@ std::string getCurrentTimestamp() {
     return std::string(buffer);
 }
 
+// Wall clock in ms, the publish time in the messages for the queue lag
+long long currentTimeMs() {
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    return static_cast<long long>(tv.tv_sec) * 1000 + tv.tv_usec / 1000;
+}
+
+// File name without the directory, the label of the per file metrics
+std::string baseName(const std::string& path) {
+    size_t slash = path.find_last_of('/');
+    return (slash == std::string::npos) ? path : path.substr(slash + 1);
+}
+
+// Created on the first call, main() calls it at startup so the output directory exists
+NdjsonWriter& getOutputWriter() {
+    static NdjsonWriter writer(CONFIG.outputFile, CONFIG.outputMaxFileBytes);
+    return writer;
+}
+
+// The yield deltas go to their own queue, not the one the daemon consumes
+AmqpPublisher& getYieldPublisher() {
+    static AmqpPublisher* publisher = nullptr;
+    static std::once_flag once;
+    std::call_once(once, []() {
+        AmqpPublisher::Config config;
+        config.host = CONFIG.brokerHost;
+        config.port = CONFIG.brokerPort;
+        config.user = CONFIG.brokerUser;
+        config.password = CONFIG.brokerPassword;
+        config.vhost = CONFIG.brokerVhost;
+        config.queue = CONFIG.yieldQueue;
+        config.exchange = CONFIG.exchange;
+        config.routingKey = CONFIG.yieldQueue;
+        config.channel = CONFIG.channel;
+        config.confirms = CONFIG.publishConfirms;
+        config.batchWindowMs = 0;
+        config.confirmTimeoutMs = CONFIG.publishConfirmTimeoutMs;
+        publisher = new AmqpPublisher(config);
+    });
+    return *publisher;
+}
+
+NdjsonWriter& getYieldWriter() {
+    static NdjsonWriter writer(CONFIG.yieldFile, CONFIG.outputMaxFileBytes);
+    return writer;
+}
+
+// What a worker keeps for a file between its messages, until the file is complete
+struct FileState {
+    std::unique_ptr<StdfTailReader> tailReader;
+    std::unique_ptr<YieldAggregator> yield;     // only with yield output configured
+    std::chrono::steady_clock::time_point lastUsed;
+};
+
+// Close the files of a worker that had no message for consumerFileIdleS, then the
+// least recently used ones beyond consumerMaxOpenFiles, except the file at hand.
+// A file closed here is opened again at previous_position by its next message.
+void evictIdleFiles(std::map<std::string, FileState>& files, const std::string& current) {
+    auto now = std::chrono::steady_clock::now();
+    auto idleLimit = std::chrono::seconds(CONFIG.consumerFileIdleS);
+    for (auto it = files.begin(); it != files.end();) {
+        if (it->first != current && CONFIG.consumerFileIdleS > 0 && now - it->second.lastUsed > idleLimit) {
+            LOG.info("Closing idle file: " + it->first, "StdfExtractor");
+            it = files.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    while (files.size() > static_cast<size_t>(CONFIG.consumerMaxOpenFiles)) {
+        auto oldest = files.end();
+        for (auto it = files.begin(); it != files.end(); ++it) {
+            if (it->first == current) continue;
+            if (oldest == files.end() || it->second.lastUsed < oldest->second.lastUsed) oldest = it;
+        }
+        if (oldest == files.end()) break;
+        LOG.info("Closing least recently used file: " + oldest->first, "StdfExtractor");
+        files.erase(oldest);
+    }
+}
+
+// Write and publish the changes of the yield summary. A failure is only logged:
+// the deltas carry absolute counts, the next one repairs the dashboards.
+void emitYieldDelta(YieldAggregator& yield, bool final) {
+    if (!final && !yield.hasDelta()) return;
+    std::string line = yield.takeDelta(final).dump();
+    if (!CONFIG.yieldFile.empty() && !getYieldWriter().appendLines(line + "\n")) {
+        LOG.warning("Failed to write the yield delta to " + CONFIG.yieldFile, "Yield");
+    }
+    if (!CONFIG.yieldQueue.empty() && !getYieldPublisher().publish(line)) {
+        LOG.warning("Failed to publish the yield delta to " + CONFIG.yieldQueue, "Yield");
+    }
+}
+
+// Handles one consumed message on a worker thread.
+// files belongs to the worker, all messages of a file go to the same worker.
+// Returns true if the message is to be acked, false to reject it.
+bool processMessage(const std::string& message_body, std::map<std::string, FileState>& files) {
+    bool processSuccess = false;
+    json messageJson = json::parse(message_body);
+    std::string stdfFilePath;
+    long long startPos = 0;
+    long long endPos = 0;
+    time_t sync_time = time(nullptr);
+
+
+    /*stdfFilePath = "/tmp/IFLEX-18/" + messageJson["temp_file_name"].get<std::string>();
+    startPos = messageJson["previous_position"].get<long long>();
+    endPos = messageJson["read_position"].get<long long>();
+    sync_time = messageJson["sync_time"].get<time_t>();
+
+    std::string jsonOutputFileName = "/tmp/IFLEX-18/Output/Output.json";
+    */
+
+    // The tester decides the directory of the copy; messages without one come
+    // from a single tester daemon, they belong to the first tester
+    const TesterConfig* tester = &CONFIG.testers.front();
+    if (messageJson.contains("tester") && messageJson["tester"].is_string()) {
+        tester = CONFIG.findTester(messageJson["tester"].get<std::string>());
+        if (!tester) {
+            LOG.error("Unknown tester in message: " + messageJson["tester"].get<std::string>(), "RabbitMQ");
+            return true; // Ack and skip this message
+        }
+    }
+
+    // Check and extract temp_file_name
+    if (messageJson.contains("temp_file_name") && !messageJson["temp_file_name"].is_null()) {
+        stdfFilePath = tester->destination + messageJson["temp_file_name"].get<std::string>();
+    } else {
+        LOG.error("Missing or null 'temp_file_name' in message", "RabbitMQ");
+        return true; // Ack and skip this message
+    }
+
+    // Check and extract previous_position
+    if (messageJson.contains("previous_position") && !messageJson["previous_position"].is_null()) {
+        // Handle different types (could be string or number)
+        if (messageJson["previous_position"].is_string()) {
+            std::string posStr = messageJson["previous_position"].get<std::string>();
+            // Remove commas if present
+            posStr.erase(std::remove(posStr.begin(), posStr.end(), ','), posStr.end());
+            startPos = std::stoll(posStr);
+        } else {
+            startPos = messageJson["previous_position"].get<long long>();
+        }
+    } else {
+        LOG.warning("Missing or null 'previous_position' in message, using 0", "RabbitMQ");
+    }
+
+    // Check and extract read_position
+    if (messageJson.contains("read_position") && !messageJson["read_position"].is_null()) {
+        // Handle different types (could be string or number)
+        if (messageJson["read_position"].is_string()) {
+            std::string posStr = messageJson["read_position"].get<std::string>();
+            // Remove commas if present
+            posStr.erase(std::remove(posStr.begin(), posStr.end(), ','), posStr.end());
+            endPos = std::stoll(posStr);
+        } else {
+            endPos = messageJson["read_position"].get<long long>();
+        }
+    } else {
+        LOG.error("Missing or null 'read_position' in message", "RabbitMQ");
+        return true; // Ack and skip this message
+    }
+
+    // Check and extract sync_time
+    if (messageJson.contains("sync_time") && !messageJson["sync_time"].is_null()) {
+        if (messageJson["sync_time"].is_string()) {
+            std::string timeStr = messageJson["sync_time"].get<std::string>();
+            
+            // Parse the datetime string to a time_t
+            // Assuming format like "2025/02/28 16:35:20.123"
+            struct tm tm = {};
+            char* result = strptime(timeStr.c_str(), "%Y/%m/%d %H:%M:%S", &tm);
+            
+            if (result) {
+                // Successfully parsed datetime string
+                sync_time = mktime(&tm);
+                LOG_DEBUG("Parsed sync_time: " + timeStr + " to " + std::to_string(sync_time), "RabbitMQ");
+            } else {
+                LOG.warning("Failed to parse sync_time string: " + timeStr + ", using current time", "RabbitMQ");
+                sync_time = time(nullptr);
+            }
+        } else if (messageJson["sync_time"].is_number()) {
+            sync_time = messageJson["sync_time"].get<time_t>();
+        }
+    } else {
+        LOG.warning("Missing or null 'sync_time' in message, using current time", "RabbitMQ");
+    }
+
+    std::string fileLabel = baseName(stdfFilePath);
+    if (messageJson.contains("publish_time_ms") && messageJson["publish_time_ms"].is_number()) {
+        long long lagMs = currentTimeMs() - messageJson["publish_time_ms"].get<long long>();
+        METRICS.queueLag.get(fileLabel).observe(lagMs > 0 ? lagMs / 1000.0 : 0.0);
+    }
+
+    LOG.info("Processing file: " + stdfFilePath + ", positions: " + 
+            std::to_string(startPos) + " to " + std::to_string(endPos), "StdfExtractor");
+
+    // Extract the PRR Records the delta completed, the tail reader continues where
+    // the last message of this file stopped, including a record cut by the delta
+    FileState& fileState = files[stdfFilePath];
+    fileState.lastUsed = std::chrono::steady_clock::now();
+    evictIdleFiles(files, stdfFilePath);
+    std::unique_ptr<StdfTailReader>& tailReader = fileState.tailReader;
+    if (!tailReader) {
+        tailReader.reset(StdfExtractor::openTailReader(stdfFilePath.c_str(), startPos));
+    }
+    // records behind read_position belong to the next message
+    tailReader->set_end(endPos > 0 ? static_cast<unsigned long long>(endPos) : STDF_TAIL_NO_END);
+    auto extractStart = std::chrono::steady_clock::now();
+    unsigned long long recordsBefore = tailReader->record_count();
+    unsigned long long offsetBefore = tailReader->offset();
+    const bool yieldOutput = !CONFIG.yieldFile.empty() || !CONFIG.yieldQueue.empty();
+    std::vector<std::pair<size_t, std::string>> wafers;
+    std::vector<StdfPRR*> prrRecords = StdfExtractor::extractNewPrrRecords(*tailReader, yieldOutput ? &wafers : nullptr);
+    METRICS.extractDuration.get(fileLabel).observe(Metrics::secondsSince(extractStart));
+    METRICS.recordsParsed.get(fileLabel).add(tailReader->record_count() - recordsBefore);
+    // a restart after the file was replaced moves the offset back
+    if (tailReader->offset() > offsetBefore) {
+        METRICS.bytesParsed.get(fileLabel).add(tailReader->offset() - offsetBefore);
+    }
+    METRICS.prrsExtracted.get(fileLabel).add(prrRecords.size());
+
+    if (yieldOutput) {
+        if (!fileState.yield) {
+            fileState.yield.reset(new YieldAggregator(tester->name, fileLabel));
+        } else if (tailReader->offset() < offsetBefore) {
+            fileState.yield->reset();
+        }
+        fileState.yield->add(prrRecords, wafers);
+        // the last delta of a file has all bins
+        emitYieldDelta(*fileState.yield, tailReader->is_complete());
+    }
+    if (tailReader->is_complete()) {
+        files.erase(stdfFilePath);
+    }
+
+    LOG.info("Extracted " + std::to_string(prrRecords.size()) + " PRR records from " + stdfFilePath, "StdfExtractor");
+
+    if (CONFIG.outputFormat == OutputFormat::BINARY) {
+        // <file>.<previous_position>-<read_position>.prrb, written even without records
+        std::string blockFileName = CONFIG.outputBlockDir + fileLabel + "." + std::to_string(startPos) +
+                                    "-" + std::to_string(endPos) + ".prrb";
+        auto writeStart = std::chrono::steady_clock::now();
+        processSuccess = StdfExtractor::savePrrRecordsBinary(prrRecords, blockFileName, sync_time);
+        METRICS.outputWriteDuration.get("binary").observe(Metrics::secondsSince(writeStart));
+        StdfExtractor::freePrrRecords(prrRecords);
+        return processSuccess;
+    }
+
+    // Append the records of this delta to the output file
+    try {
+        NdjsonWriter& writer = getOutputWriter();
+        auto writeStart = std::chrono::steady_clock::now();
+        bool appended = writer.append(prrRecords, stdfFilePath, sync_time);
+        METRICS.outputWriteDuration.get("ndjson").observe(Metrics::secondsSince(writeStart));
+        if (appended) {
+            LOG.info("Appended " + std::to_string(prrRecords.size()) + " PRR records to " + writer.path(), "StdfExtractor");
+            processSuccess = true; // Mark overall process as successful
+        } else {
+            LOG.error("Failed to append PRR records to " + writer.path(), "StdfExtractor");
+        }
+    } catch (const std::exception& e) {
+        LOG.error("Exception while saving PRR records: " + std::string(e.what()), "StdfExtractor");
+    }
+
+    // Clean up extracted records
+    StdfExtractor::freePrrRecords(prrRecords);
+
+    return processSuccess;
+}
+
 // Function to Handle Incoming messages
 void consumeMessages() {
     amqp_connection_state_t conn = amqp_new_connection();
@@ -53,23 +328,23 @@ void consumeMessages() {
         return;
     }
 
-    if(amqp_socket_open(socket, RABBITMQ_HOST.c_str(), RABBITMQ_PORT)) {
+    if(amqp_socket_open(socket, CONFIG.brokerHost.c_str(), CONFIG.brokerPort)) {
         std::cerr << getCurrentTimestamp() << "Failed to open TCP connection" << std::endl;
         LOG.error("Failed to open TCP connection", "RabbitMQ");
         return;
     }
 
-    LOG.debug("TCP socket opened successfully", "RabbitMQ");
+    LOG_DEBUG("TCP socket opened successfully", "RabbitMQ");
 
     amqp_rpc_reply_t login_reply = amqp_login(
         conn,
-        RABBITMQ_VHOST.c_str(),
+        CONFIG.brokerVhost.c_str(),
         0,
         131072,
         0,
         AMQP_SASL_METHOD_PLAIN,
-        RABBITMQ_USER.c_str(),
-        RABBITMQ_PASSWORD.c_str()
+        CONFIG.brokerUser.c_str(),
+        CONFIG.brokerPassword.c_str()
     );
 
     if(login_reply.reply_type != AMQP_RESPONSE_NORMAL) {
@@ -80,19 +355,19 @@ void consumeMessages() {
 
     LOG.info("Successfully logged in to RabbitMQ server", "RabbitMQ");
 
-    amqp_channel_open(conn, CHANNEL_ID);
+    amqp_channel_open(conn, CONFIG.channel);
     if (amqp_get_rpc_reply(conn).reply_type != AMQP_RESPONSE_NORMAL) {
         std::cerr << getCurrentTimestamp() << " Failed to open a channel" << std::endl;
         return;
     }
 
-    // Set QoS - Prefetch count = 1
+    // Set QoS - up to consumerPrefetch messages in flight for the workers
     amqp_basic_qos(
-        conn,           // Connection
-        CHANNEL_ID,     // Channel
-        0,              // prefetch size (0 means "no specific limit")
-        1,              // prefetch count (1 message at a time)
-        0               // global (0 = per-consumer, 1 = per-channel)
+        conn,               // Connection
+        CONFIG.channel,         // Channel
+        0,                  // prefetch size (0 means "no specific limit")
+        CONFIG.consumerPrefetch,  // prefetch count
+        0                   // global (0 = per-consumer, 1 = per-channel)
     );
     if (amqp_get_rpc_reply(conn).reply_type != AMQP_RESPONSE_NORMAL) {
         //std::cerr << getCurrentTimestamp() << " Failed to set QoS" << std::endl;
@@ -102,8 +377,8 @@ void consumeMessages() {
 
     amqp_queue_declare(
         conn,
-        CHANNEL_ID,
-        amqp_cstring_bytes(QUEUE_NAME.c_str()),
+        CONFIG.channel,
+        amqp_cstring_bytes(CONFIG.queue.c_str()),
         0, // passive: 0 = create if not exists
         1, // durable: 1 = survive server restarts
         0, // exclusive: 0 = non-exclusive
@@ -116,12 +391,12 @@ void consumeMessages() {
         LOG.error("Failed to declare queue", "RabbitMQ");
         return;
     }
-    LOG.info("Queue declared: " + QUEUE_NAME, "RabbitMQ");
+    LOG.info("Queue declared: " + CONFIG.queue, "RabbitMQ");
 
     amqp_basic_consume(
         conn,
-        CHANNEL_ID,
-        amqp_cstring_bytes(QUEUE_NAME.c_str()),
+        CONFIG.channel,
+        amqp_cstring_bytes(CONFIG.queue.c_str()),
         amqp_empty_bytes,
         0,
         1,
@@ -136,159 +411,79 @@ void consumeMessages() {
     }
 
     //std::cout << getCurrentTimestamp() << " Waiting for messages in queue: " << QUEUE_NAME << std::endl;
-    LOG.info("Waiting for messages in queue: " + QUEUE_NAME, "RabbitMQ");
+    LOG.info("Waiting for messages in queue: " + CONFIG.queue, "RabbitMQ");
+
+    // reader and yield summary per file, kept between messages until the file is
+    // complete; a map per worker, a file always lands on the same worker
+    std::vector<std::map<std::string, FileState>> files(CONFIG.consumerWorkers);
+    WorkerPool workers(CONFIG.consumerWorkers, [&files](const std::string& message, size_t worker) {
+        return processMessage(message, files[worker]);
+    });
+    std::vector<WorkerPool::Completion> completions;
+    // delivery tag -> time the message came in, for the ack latency
+    std::map<uint64_t, std::chrono::steady_clock::time_point> receivedAt;
 
     while (true)
     {
         amqp_rpc_reply_t res;
         amqp_envelope_t envelope;
 
+        // Ack what the workers finished, only after their output is written
+        completions.clear();
+        workers.takeCompletions(completions);
+        for (const WorkerPool::Completion& completion : completions) {
+            auto received = receivedAt.find(completion.deliveryTag);
+            if (received != receivedAt.end()) {
+                METRICS.ackLatency.get().observe(Metrics::secondsSince(received->second));
+                receivedAt.erase(received);
+            }
+            METRICS.messages.get(completion.success ? "acked" : "rejected").add();
+            if (completion.success) {
+                // Acknowledge the message only if processing was successful
+                amqp_basic_ack(conn, CONFIG.channel, completion.deliveryTag, false);
+                LOG.info("Message successfully processed and acknowledged", "RabbitMQ");
+            } else {
+                // Negative acknowledgment (reject) the message if processing failed
+                // requeue=false to prevent the message from being redelivered
+                amqp_basic_reject(conn, CONFIG.channel, completion.deliveryTag, false);
+                LOG.warning("Message processing failed - rejected message", "RabbitMQ");
+            }
+        }
+
         amqp_maybe_release_buffers(conn);
 
-        // Use a short timeout (1 second) to allow for graceful shutdown if needed
+        // Short timeout, so finished messages are acked soon while the queue is idle
         struct timeval timeout;
-        timeout.tv_sec = 1;
-        timeout.tv_usec = 0;
+        timeout.tv_sec = 0;
+        timeout.tv_usec = 20000;
         res = amqp_consume_message(conn, &envelope, &timeout, 0);
 
+        if (res.reply_type == AMQP_RESPONSE_LIBRARY_EXCEPTION && res.library_error == AMQP_STATUS_TIMEOUT)
+        {
+            continue;
+        }
         if (res.reply_type == AMQP_RESPONSE_NORMAL)
         {
+            receivedAt[envelope.delivery_tag] = std::chrono::steady_clock::now();
             std::string message_body((char*)envelope.message.body.bytes, envelope.message.body.len);
             //std::cout << getCurrentTimestamp() << " Received message: " << message_body << std::endl;
             LOG.info("Received message: " + message_body, "RabbitMQ");
 
-            bool processSuccess = false;
-            json messageJson = json::parse(message_body);
-            std::string stdfFilePath;
-            int startPos = 0;
-            int endPos = 0;
-            time_t sync_time = time(nullptr);
-
-
-            /*stdfFilePath = "/tmp/IFLEX-18/" + messageJson["temp_file_name"].get<std::string>();
-            startPos = messageJson["previous_position"].get<int>();
-            endPos = messageJson["read_position"].get<int>();
-            sync_time = messageJson["sync_time"].get<time_t>();
-
-            std::string jsonOutputFileName = "/tmp/IFLEX-18/Output/Output.json";
-            */
-
-            // Check and extract temp_file_name
-            if (messageJson.contains("temp_file_name") && !messageJson["temp_file_name"].is_null()) {
-                stdfFilePath = "/tmp/IFLEX-18/" + messageJson["temp_file_name"].get<std::string>();
-            } else {
-                LOG.error("Missing or null 'temp_file_name' in message", "RabbitMQ");
-                amqp_basic_ack(conn, CHANNEL_ID, envelope.delivery_tag, false);
-                amqp_destroy_envelope(&envelope);
-                continue; // Skip this message and process the next one
-            }
-
-            // Check and extract previous_position
-            if (messageJson.contains("previous_position") && !messageJson["previous_position"].is_null()) {
-                // Handle different types (could be string or number)
-                if (messageJson["previous_position"].is_string()) {
-                    std::string posStr = messageJson["previous_position"].get<std::string>();
-                    // Remove commas if present
-                    posStr.erase(std::remove(posStr.begin(), posStr.end(), ','), posStr.end());
-                    startPos = std::stoi(posStr);
-                } else {
-                    startPos = messageJson["previous_position"].get<int>();
-                }
-            } else {
-                LOG.warning("Missing or null 'previous_position' in message, using 0", "RabbitMQ");
-            }
-
-            // Check and extract read_position
-            if (messageJson.contains("read_position") && !messageJson["read_position"].is_null()) {
-                // Handle different types (could be string or number)
-                if (messageJson["read_position"].is_string()) {
-                    std::string posStr = messageJson["read_position"].get<std::string>();
-                    // Remove commas if present
-                    posStr.erase(std::remove(posStr.begin(), posStr.end(), ','), posStr.end());
-                    endPos = std::stoi(posStr);
-                } else {
-                    endPos = messageJson["read_position"].get<int>();
-                }
-            } else {
-                LOG.error("Missing or null 'read_position' in message", "RabbitMQ");
-                amqp_basic_ack(conn, CHANNEL_ID, envelope.delivery_tag, false);
-                amqp_destroy_envelope(&envelope);
-                continue; // Skip this message and process the next one
-            }
-
-            // Check and extract sync_time
-            if (messageJson.contains("sync_time") && !messageJson["sync_time"].is_null()) {
-                if (messageJson["sync_time"].is_string()) {
-                    std::string timeStr = messageJson["sync_time"].get<std::string>();
-                    
-                    // Parse the datetime string to a time_t
-                    // Assuming format like "2025/02/28 16:35:20.123"
-                    struct tm tm = {};
-                    char* result = strptime(timeStr.c_str(), "%Y/%m/%d %H:%M:%S", &tm);
-                    
-                    if (result) {
-                        // Successfully parsed datetime string
-                        sync_time = mktime(&tm);
-                        LOG.debug("Parsed sync_time: " + timeStr + " to " + std::to_string(sync_time), "RabbitMQ");
-                    } else {
-                        LOG.warning("Failed to parse sync_time string: " + timeStr + ", using current time", "RabbitMQ");
-                        sync_time = time(nullptr);
-                    }
-                } else if (messageJson["sync_time"].is_number()) {
-                    sync_time = messageJson["sync_time"].get<time_t>();
-                }
-            } else {
-                LOG.warning("Missing or null 'sync_time' in message, using current time", "RabbitMQ");
-            }
-
-            LOG.info("Processing file: " + stdfFilePath + ", positions: " + 
-                    std::to_string(startPos) + " to " + std::to_string(endPos), "StdfExtractor");
-
-            std::string jsonOutputFileName = "/tmp/IFLEX-18/Output/Output.json";
-
-            // Extract the PRR Records from the specified
-            std::vector<StdfPRR*> prrRecords = StdfExtractor::extractPrrRecords(stdfFilePath.c_str(), startPos, endPos);
-
-            LOG.info("Extracted " + std::to_string(prrRecords.size()) + " PRR records from " + stdfFilePath, "StdfExtractor");
-
-            // Save to JSON file
-            /*bool saveSuccess = StdfExtractor::savePrrRecords(prrRecords, jsonOutputFileName, sync_time);
-            if(saveSuccess) {
-                LOG.info("Saved " + std::to_string(prrRecords.size()) + " the PRR records to JSON file: " + jsonOutputFileName, "StdfExtractor");
-            } else {
-                LOG.error("Failed to save PRR records to JSON file: " + jsonOutputFileName, "StdfExtractor");
-            }*/
-            bool saveSuccess = false;
+            // Messages of one file keep their order on one worker, files run in parallel.
+            // The worker reports back, the ack is sent from this thread once the output is written.
+            std::string key;
             try {
-                saveSuccess = StdfExtractor::savePrrRecords(prrRecords, jsonOutputFileName, sync_time);
-                if(saveSuccess) {
-                    LOG.info("Saved " + std::to_string(prrRecords.size()) + " PRR records to JSON file: " + jsonOutputFileName, "StdfExtractor");
-                    processSuccess = true; // Mark overall process as successful
-                } else {
-                    LOG.error("Failed to save PRR records to JSON file: " + jsonOutputFileName, "StdfExtractor");
+                json messageJson = json::parse(message_body);
+                if (messageJson.contains("tester") && messageJson["tester"].is_string()) {
+                    key = messageJson["tester"].get<std::string>() + "/";
+                }
+                if (messageJson.contains("temp_file_name") && messageJson["temp_file_name"].is_string()) {
+                    key += messageJson["temp_file_name"].get<std::string>();
                 }
             } catch (const std::exception& e) {
-                LOG.error("Exception while saving PRR records: " + std::string(e.what()), "StdfExtractor");
-            }
-
-            // Clean up extracted records
-            StdfExtractor::freePrrRecords(prrRecords);
-
-            // Ack the message
-            //amqp_basic_ack(conn, CHANNEL_ID, envelope.delivery_tag, false);
-            //LOG.debug("Message acknowledged", "RabbitMQ");
-
-            // Handle message acknowledgment based on processing success
-            if (processSuccess) {
-                // Acknowledge the message only if processing was successful
-                amqp_basic_ack(conn, CHANNEL_ID, envelope.delivery_tag, false);
-                LOG.info("Message successfully processed and acknowledged", "RabbitMQ");
-            } else {
-                // Negative acknowledgment (reject) the message if processing failed
-                // requeue=false to prevent the message from being redelivered
-                amqp_basic_reject(conn, CHANNEL_ID, envelope.delivery_tag, false);
-                LOG.warning("Message processing failed - rejected message", "RabbitMQ");
+                LOG.error("Invalid message: " + std::string(e.what()), "RabbitMQ");
             }
+            workers.submit(key, envelope.delivery_tag, message_body);
 
             amqp_destroy_envelope(&envelope);
         } else{
@@ -300,95 +495,65 @@ void consumeMessages() {
     }
 
     LOG.info("Closing RabbitMQ connection", "RabbitMQ");
-    amqp_channel_close(conn, CHANNEL_ID, AMQP_REPLY_SUCCESS);
+    amqp_channel_close(conn, CONFIG.channel, AMQP_REPLY_SUCCESS);
     amqp_connection_close(conn, AMQP_REPLY_SUCCESS);
     amqp_destroy_connection(conn);
     
 }
 
-bool publishMessage(const std::string& message) {
-    amqp_connection_state_t conn = amqp_new_connection();
-    amqp_socket_t* socket = amqp_tcp_socket_new(conn);
-
-    if(!socket) {
-        //std::cerr << getCurrentTimestamp() << "Failed to create TCP socket" << std::endl;
-        LOG.error("Failed to create TCP socket", "RabbitMQ");
-        return false;
-    }
-
-    if(amqp_socket_open(socket, RABBITMQ_HOST.c_str(), RABBITMQ_PORT)) {
-        //std::cerr << getCurrentTimestamp() << "Failed to open TCP connection" << std::endl;
-        LOG.error("Failed to open TCP connection", "RabbitMQ");
-        return false;
-    }
-
-    amqp_rpc_reply_t login_reply = amqp_login(
-        conn,
-        RABBITMQ_VHOST.c_str(),
-        0,
-        131072,
-        0,
-        AMQP_SASL_METHOD_PLAIN,
-        RABBITMQ_USER.c_str(),
-        RABBITMQ_PASSWORD.c_str()
-    );
-
-    if (login_reply.reply_type != AMQP_RESPONSE_NORMAL) {
-        //std::cerr << getCurrentTimestamp() << "FAILED to log in to rabbitMQ" << std::endl;
-        LOG.error("Failed to log in to RabbitMQ", "RabbitMQ");
-        return false;
-    }
-
-    amqp_channel_open(conn, 1);
-    amqp_rpc_reply_t channel_type = amqp_get_rpc_reply(conn);
-    if(channel_type.reply_type != AMQP_RESPONSE_NORMAL) {
-        //std::cerr << getCurrentTimestamp() << "Failed to open a channel" << std::endl;
-        LOG.error("Failed to open a channel", "RabbitMQ");
-        return false;
-    }
-
-    amqp_queue_declare(
-        conn,
-        1,
-        amqp_cstring_bytes(QUEUE_NAME.c_str()),
-        0, // passive: 0 = create if not exists
-        1, // durable: 1 = survive server restarts
-        0, // exclusive: 0 = non-exclusive
-        0, // auto-delete: 0 = do not auto-delete when not in use
-        amqp_empty_table
-    );
-
-    if(amqp_get_rpc_reply(conn).reply_type != AMQP_RESPONSE_NORMAL) {
-        //std::cerr << getCurrentTimestamp() << "Failed to declare queue" << std::endl;
-        LOG.error("Failed to declare queue", "RabbitMQ");
-        return false;
+// Two position updates of the same file merged into one: the range starts
+// where the older one started and ends where the newer one ends
+std::string mergePositionMessages(const std::string& older, const std::string& newer) {
+    try {
+        json olderJson = json::parse(older);
+        json newerJson = json::parse(newer);
+        if (olderJson.contains("previous_position")) {
+            newerJson["previous_position"] = olderJson["previous_position"];
+        }
+        return newerJson.dump();
+    } catch (const std::exception& e) {
+        LOG.warning("Failed to merge position messages: " + std::string(e.what()), "RabbitMQ");
+        return newer;
     }
+}
 
-    amqp_bytes_t message_bytes = amqp_cstring_bytes(message.c_str());
-    int publish_status = amqp_basic_publish(
-        conn,
-        1,
-        amqp_cstring_bytes(EXCHANGE_NAME.c_str()),
-        amqp_cstring_bytes(ROUTING_KEY.c_str()),
-        0,
-        0,
-        nullptr,
-        message_bytes
-    );
+AmqpPublisher& getPublisher() {
+    static AmqpPublisher* publisher = nullptr;
+    static std::once_flag once;
+    std::call_once(once, []() {
+        AmqpPublisher::Config config;
+        config.host = CONFIG.brokerHost;
+        config.port = CONFIG.brokerPort;
+        config.user = CONFIG.brokerUser;
+        config.password = CONFIG.brokerPassword;
+        config.vhost = CONFIG.brokerVhost;
+        config.queue = CONFIG.queue;
+        config.exchange = CONFIG.exchange;
+        config.routingKey = CONFIG.routingKey;
+        config.channel = CONFIG.channel;
+        config.confirms = CONFIG.publishConfirms;
+        config.batchWindowMs = CONFIG.publishBatchWindowMs;
+        config.confirmTimeoutMs = CONFIG.publishConfirmTimeoutMs;
+        publisher = new AmqpPublisher(config);
+        publisher->setMergeFunction(mergePositionMessages);
+    });
+    return *publisher;
+}
 
-    if(publish_status < 0) {
-        //std::cerr << getCurrentTimestamp() << "Failed to publish message" << std::endl;
+// coalesceKey: position updates with the same key (the file name) may be merged when batching
+// tester: label of the publish metrics
+bool publishMessage(const std::string& message, const std::string& coalesceKey = "", const std::string& tester = "") {
+    auto start = std::chrono::steady_clock::now();
+    bool ok = getPublisher().publish(message, coalesceKey);
+    METRICS.publishDuration.get(tester).observe(Metrics::secondsSince(start));
+    METRICS.published.get(ok ? "ok" : "failed").add();
+    if (!ok) {
         LOG.error("Failed to publish message", "RabbitMQ");
         return false;
     }
 
     //std::cout << getCurrentTimestamp() << "Message published successfully: " << message << std::endl;
     LOG.info("Message published successfully: " + message, "RabbitMQ");
-
-    amqp_channel_close(conn, 1, AMQP_REPLY_SUCCESS);
-    amqp_connection_close(conn, AMQP_REPLY_SUCCESS);
-    amqp_destroy_connection(conn);
-
     return true;
 }
 
@@ -402,28 +567,47 @@ std::string createJsonMessage(const std::string& file_name, const std::string& s
     return ss.str();
 }*/
 
-std::string createJsonMessage(const std::string& file_name, const std::string& sync_time, 
+std::string createJsonMessage(const std::string& tester, const std::string& file_name, const std::string& sync_time,
     const std::string& read_position, const std::string& previous_position) {
     // Use nlohmann::json to build the message properly
     json message;
+    message["tester"] = tester;
     message["temp_file_name"] = file_name;
     message["sync_time"] = sync_time;  // Convert to numeric timestamp
 
     // Clean and convert read_position to number
     std::string clean_read_pos = read_position;
     clean_read_pos.erase(std::remove(clean_read_pos.begin(), clean_read_pos.end(), ','), clean_read_pos.end());
-    message["read_position"] = std::stoi(clean_read_pos);
+    message["read_position"] = std::stoll(clean_read_pos);
 
     // Clean and convert previous_position to number
     std::string clean_prev_pos = previous_position;
     clean_prev_pos.erase(std::remove(clean_prev_pos.begin(), clean_prev_pos.end(), ','), clean_prev_pos.end());
-    message["previous_position"] = std::stoi(clean_prev_pos);
+    message["previous_position"] = std::stoll(clean_prev_pos);
+    message["publish_time_ms"] = currentTimeMs();
 
     return message.dump();
 }
 
+std::string createJsonMessage(const std::string& tester, const std::string& file_name, const std::string& sync_time,
+    uint64_t read_position, uint64_t previous_position) {
+    json message;
+    message["tester"] = tester;
+    message["temp_file_name"] = file_name;
+    message["sync_time"] = sync_time;
+    message["read_position"] = read_position;
+    message["previous_position"] = previous_position;
+    message["publish_time_ms"] = currentTimeMs();
+    return message.dump();
+}
+
+// One rsync run of a tester's source, publishes the new read position of every
+// file rsync completed. Runs on a sync worker, state belongs to it meanwhile.
+void executeRsync(SyncState& state) {
+    const std::string& source = state.tester.source;
+    const std::string& destination = state.tester.destination;
+    const std::string& tester = state.tester.name;
 
-void executeRsync(const std::string& source, const std::string&  destination, const std::string& logfile) {
     // Get the current time with milliseconds for logging
     //struct timeval tv;
     //gettimeofday(&tv, nullptr);
@@ -436,8 +620,9 @@ void executeRsync(const std::string& source, const std::string&  destination, co
 
     // Capture the start time
     auto start_time = std::chrono::high_resolution_clock::now();
+    auto metricsStart = std::chrono::steady_clock::now();
     //std::cout << getCurrentTimestamp() << " - Starting rsync operation..." << std::endl;
-    LOG.info("Starting rsync operation...", "Rsync");
+    LOG.info("Starting rsync operation for " + tester, "Rsync");
 
     // Construct the rsync command with logging
     std::string command = "ionice -c1 -n0 nice -n -20 rsync -avz --no-perms --no-owner --no-group --update --append-verify "
@@ -450,7 +635,7 @@ void executeRsync(const std::string& source, const std::string&  destination, co
     auto executeTime = getCurrentTimestamp();
 
     //std::cout << getCurrentTimestamp() << "Executing command: " << command << std::endl;
-    LOG.debug("Executing command: " + command, "Rsync");
+    LOG_DEBUG("Executing command: " + command, "Rsync");
 
     // Execute the rsync command using popen
     //std::unique_ptr<FILE, decltype(&pclose)> pipe(popen(command.c_str(), "r"), pclose);
@@ -458,13 +643,15 @@ void executeRsync(const std::string& source, const std::string&  destination, co
     if(!pipe){
         //std::cerr << "Failed to execute rsync command" << std::endl;
         LOG.error("Failed to execute rsync command", "Rsync");
+        METRICS.syncErrors.get(tester).add();
         return;
     }
 
     char buffer[256];
     //std::regex regex(">f.* ([^ ]+)");
-    std::regex regex(R"(>f.*\s([^\s]+)\s\d{4}/\d{2}/\d{2}-\d{2}:\d{2}:\d{2})");
-    std::regex completion_regex(R"(\s(\d+(?:,\d+)*)\s100%\s+([0-9.]+[A-Z]B/s))");
+    // compiled once, not on every rsync run
+    static const std::regex regex(R"(>f.*\s([^\s]+)\s\d{4}/\d{2}/\d{2}-\d{2}:\d{2}:\d{2})");
+    static const std::regex completion_regex(R"(\s(\d+(?:,\d+)*)\s100%\s+([0-9.]+[A-Z]B/s))");
     std::smatch match;
     std::string file_name;
 
@@ -472,12 +659,12 @@ void executeRsync(const std::string& source, const std::string&  destination, co
     {
         std::string output(buffer);
         //std::cout << "Rsync Output: " << output;
-        LOG.debug("Rsync Output: " + output, "Rsync");
+        LOG_DEBUG("Rsync Output: " + output, "Rsync");
 
         // Using regex in c++
         if(std::regex_search(output, match, regex) && match.size() > 1){
             file_name = match.str(1);
-            LOG.debug("Matched File: " + file_name, "Rsync");
+            LOG_DEBUG("Matched File: " + file_name, "Rsync");
             //std::string message = createJsonMessage(file_name, executeTime);
             //std::cout << getCurrentTimestamp() << "Matched File: " << match.str(1) << std::endl;
             //std::cout << getCurrentTimestamp() << "Generated JSON Message: " << message << std::endl;
@@ -491,17 +678,21 @@ void executeRsync(const std::string& source, const std::string&  destination, co
 
             //std::cout << getCurrentTimestamp() << "Read position: " << transferred_bytes << std::endl;
             LOG.info("Read position: " + transferred_bytes + " at " + transfer_speed, "Rsync");
-            std::string message = createJsonMessage(file_name, executeTime, transferred_bytes, std::to_string(PREVIOUS_POSITION));
+            std::string message = createJsonMessage(tester, file_name, executeTime, transferred_bytes, std::to_string(state.previousPosition));
             //std::cout << getCurrentTimestamp() << "Generated JSON Message: " << message << std::endl;
             LOG.info("Generated JSON Message: " + message, "Rsync");
-            publishMessage(message);
+            publishMessage(message, tester + "/" + file_name, tester);
             //PREVIOUS_POSITION = transferred_bytes;
             std::string clean_bytes = transferred_bytes;
             clean_bytes.erase(std::remove(clean_bytes.begin(), clean_bytes.end(), ','), clean_bytes.end());
 
             try {
-                PREVIOUS_POSITION = std::stoi(clean_bytes);
-                LOG.debug("Updated PREVIOUS_POSITION to: " + std::to_string(PREVIOUS_POSITION), "Rsync");
+                long long position = std::stoll(clean_bytes);
+                if (position > state.previousPosition) {
+                    METRICS.syncBytes.get(tester).observe(static_cast<double>(position - state.previousPosition));
+                }
+                state.previousPosition = position;
+                LOG_DEBUG("Updated previous position of " + tester + " to: " + std::to_string(state.previousPosition), "Rsync");
             } catch (const std::exception& e) {
                 LOG.error("Failed to convert position value to integer: " + transferred_bytes, "Rsync");
                 // Keep previous value unchanged
@@ -514,32 +705,107 @@ void executeRsync(const std::string& source, const std::string&  destination, co
     if(result == -1) {
         //std::cerr << getCurrentTimestamp() << " - Error closing the command pipe" << std::endl;
         LOG.error("Error closing the command pipe", "Rsync");
+        METRICS.syncErrors.get(tester).add();
     } else {
+        if (WEXITSTATUS(result) != 0) {
+            METRICS.syncErrors.get(tester).add();
+        }
         //std::cout << getCurrentTimestamp() << " - Rsync completed with exit code: " << WEXITSTATUS(result) << std::endl;
-        LOG.info("Rsync completed with exit code: " + std::to_string(WEXITSTATUS(result)), "Rsync");
+        LOG.info("Rsync of " + tester + " completed with exit code: " + std::to_string(WEXITSTATUS(result)), "Rsync");
     }
     
     // Calculate and display the execution duration
     auto end_time = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double, std::milli> execution_duration = end_time - start_time;
+    METRICS.syncDuration.get(tester).observe(Metrics::secondsSince(metricsStart));
 
     //std::cout << getCurrentTimestamp() << " - Rsync operation completed in " 
     //          << std::fixed << std::setprecision(3) 
     //          << execution_duration.count() << " ms" << std::endl;
-    LOG.info("Rsync operation completed in " + 
+    LOG.info("Rsync operation of " + tester + " completed in " +
         std::to_string(execution_duration.count()) + " ms", "Rsync");
 }
 
-// Function to read part of an STDF file and extract PRR records
-int main() {
-    const std::string source = "rsync://IFLEX-38/user/IFLEX-38_1_v14082p01j_ad7149-6_2pc_AT5_6871847.1_C40239-09D4_mar02_00_09.stdf";
-    const std::string destination = "/tmp/IFLEX-18/";
-    const std::string logfile = "/tmp/IFLEX-18/Logs/rsync_log_IFLEX-LPX-67.txt";
+// In process replacement of executeRsync for sources the host can open:
+// appends the new bytes to the destination and publishes the exact offsets.
+void executeFetch(SyncState& state) {
+    const std::string& tester = state.tester.name;
+    std::string file_name = baseName(state.tester.source);
+    if (!state.fetcher) {
+        state.fetcher.reset(new AppendFetcher(state.tester.source, state.tester.destination + file_name));
+    }
+    auto start_time = std::chrono::high_resolution_clock::now();
+    auto metricsStart = std::chrono::steady_clock::now();
+    auto executeTime = getCurrentTimestamp();
+
+    AppendFetcher::Result result = state.fetcher->fetch();
+    METRICS.syncDuration.get(tester).observe(Metrics::secondsSince(metricsStart));
+    if (!result.ok) {
+        METRICS.syncErrors.get(tester).add();
+        return;
+    }
+
+    uint64_t previous = result.restarted ? 0 : result.previousSize;
+    if (result.currentSize > previous) {
+        METRICS.syncBytes.get(tester).observe(static_cast<double>(result.currentSize - previous));
+    }
+    if (result.currentSize == previous && !result.restarted) {
+        LOG_DEBUG("No new data in " + file_name, "Fetcher");
+        return;
+    }
+
+    std::string message = createJsonMessage(tester, file_name, executeTime, result.currentSize, previous);
+    LOG.info("Generated JSON Message: " + message, "Fetcher");
+    publishMessage(message, tester + "/" + file_name, tester);
+    state.previousPosition = static_cast<long long>(result.currentSize);
+
+    std::chrono::duration<double, std::milli> execution_duration = std::chrono::high_resolution_clock::now() - start_time;
+    LOG.info("Fetched " + std::to_string(result.currentSize - previous) + " bytes of " + tester + " in " +
+        std::to_string(execution_duration.count()) + " ms", "Fetcher");
+}
+
+// Sync function of the scheduler: mounted share without rsync process (ranged
+// reads of the appended tail), rsync for remote sources
+void syncTester(SyncState& state) {
+    if (!FileWatcher::isRemote(state.tester.source)) {
+        executeFetch(state);
+    } else {
+        executeRsync(state);
+    }
+}
+
+// usage: index [config.json], without a file the built in single tester setup
+int main(int argc, char* argv[]) {
+    if (argc > 2) {
+        std::cerr << "usage: " << argv[0] << " [config.json]" << std::endl;
+        return 2;
+    }
+    if (argc == 2) {
+        std::string error;
+        if (!DaemonConfig::load(argv[1], CONFIG, error)) {
+            std::cerr << "Invalid configuration: " << error << std::endl;
+            return 1;
+        }
+    }
 
     // Initialize Logger
-    std::string appLogPath = "/tmp/IFLEX-18/Logs/application_IFLEX-38.log";
-    LOG.init(appLogPath, LogLevel::DEBUG);
-    LOG.info("Application starting....", "Main");
+    LOG.init(CONFIG.logPath, LogLevel::DEBUG);
+    LOG.info("Application starting with " + std::to_string(CONFIG.testers.size()) + " testers....", "Main");
+    getOutputWriter();
+    if (!CONFIG.yieldFile.empty()) getYieldWriter();
+
+    std::unique_ptr<MetricsServer> metricsServer;
+    if (CONFIG.metricsPort > 0) {
+        metricsServer.reset(new MetricsServer(CONFIG.metricsPort));
+    }
+    if (CONFIG.metricsLogIntervalS > 0) {
+        std::thread([]() {
+            while (true) {
+                std::this_thread::sleep_for(std::chrono::seconds(CONFIG.metricsLogIntervalS));
+                LOG.info(METRICS.summary(), "Metrics");
+            }
+        }).detach();
+    }
 
     // Create thread for message consumption
     std::thread consumer_thread([]() {
@@ -552,29 +818,18 @@ int main() {
         }
     });
 
-    // Create thread for rsync execution
-    std::thread rsync_thread([source, destination, logfile]() {
-        LOG.info("Starting rsync thread", "Rsync");
-        while(true) {
-            try{
-                executeRsync(source, destination, logfile);
-            } catch (const std::exception& e){
-                //std::cerr << "Error during rsync execution: " << e.what() << std::endl;
-                LOG.error("Error during rsync execution: " + std::string(e.what()), "Rsync");
-            }
-
-            // Wait for 1 millisecond before the next execution using C++ std::this_thread
-            std::this_thread::sleep_for(std::chrono::milliseconds(1));
-        }
-    });
+    // One event loop and CONFIG.syncWorkers threads sync all testers
+    SyncScheduler scheduler(CONFIG.testers, CONFIG.syncMode, CONFIG.syncMinIntervalMs, CONFIG.syncMaxIntervalMs,
+                            static_cast<size_t>(CONFIG.syncWorkers), syncTester);
 
     LOG.info("Threads started, waiting for completion", "Main");
 
     // Wait for threads to complete(though they should run indefinitely)
     consumer_thread.join();
-    rsync_thread.join();
-
-    LOG.info("Application shutting down", "Main");
+    LOG.warning("Consumer stopped, syncing goes on", "Main");
+    while (true) {
+        std::this_thread::sleep_for(std::chrono::hours(1));
+    }
 
     return 0;
-}
\ No newline at end of file
+}
@@ -54,7 +54,8 @@ typedef enum {
 typedef enum {
 	STDF_SETTING_WRITE_SIZE = 0x001, /**< Set the output blocksize for writing */
 	STDF_SETTING_VERSION    = 0x002, /**< Query the STDF spec version */
-	STDF_SETTING_BYTE_ORDER = 0x003  /**< Query the byte order */
+	STDF_SETTING_BYTE_ORDER = 0x003, /**< Query the byte order */
+	STDF_SETTING_COMPRESS_LEVEL = 0x004  /**< Compression level when writing gzip (0-9) */
 } stdf_runtime_settings;
 
 
@@ -17,12 +17,33 @@
 /* STDF File structure */
 #define	__STDF_HOST_BYTE_ORDER		BYTE_ORDER
 
+/* Size of the input buffer, bigger than the largest record (65535 + 4 bytes) */
+#define __STDF_READ_BUF_SIZE		(256 * 1024)
+/* Output is collected up to the write size, plus room for one more record */
+#define __STDF_WRITE_SIZE			(128 * 1024)
+#define __STDF_WRITE_BUF_SIZE		(__STDF_WRITE_SIZE + 65535 + 4)
+
 typedef struct {
 	int (*open)(void*, int, uint32_t);
 	int (*read)(void*, void*, long);
 	int (*close)(void*);
+	int (*write)(void*, const void*, long);	/* NULL if the format can't be written */
 } __stdf_fops;
 
+#if HAVE_BZIP2
+/* bzip2 input goes through BZ2_bzDecompress() and not BZ2_bzread(): that one
+ * throws away everything it decoded in a call that runs into damaged data */
+typedef struct {
+	BZFILE		*file;			/* writing */
+	bz_stream	strm;			/* reading */
+	int			init;			/* strm needs BZ2_bzDecompressEnd() */
+	int			eof;			/* read() returned 0 */
+	int			end;			/* the first stream ended, the rest is ignored */
+	int			error;			/* errno for the next read, after the data before it */
+	char		buf[BZ_MAX_UNUSED];
+} __stdf_bzip2;
+#endif
+
 /**
  * @brief The main STDF file structure.
  */
@@ -36,11 +57,11 @@ typedef struct {
 #  define fd_zip __fd.zip
 # endif
 # if HAVE_GZIP
-	gzFile		*gzip;
+	gzFile		gzip;
 #  define fd_gzip __fd.gzip
 # endif
 # if HAVE_BZIP2
-	BZFILE		*bzip2;
+	__stdf_bzip2 *bzip2;
 #  define fd_bzip2 __fd.bzip2
 # endif
 # if HAVE_LZW
@@ -62,9 +83,15 @@ typedef struct {
 	byte_t		*rec_pos;
 	byte_t		*rec_end;
 
+	byte_t		*_read_buf;		/**< Input buffer in front of fops->read() */
+	byte_t		*_read_pos;		/**< Next unread byte in _read_buf */
+	byte_t		*_read_end;		/**< End of the valid data in _read_buf */
+	void		*_pipe;			/**< Decompression thread(s) in front of fops->read() */
+
 	byte_t		*__output;
 	byte_t		*_write_pos;
-	dtc_U2		_write_chunk_size;
+	dtc_U4		_write_chunk_size;	/**< Output is written once this much is buffered */
+	int			_compress_level;	/**< STDF_SETTING_COMPRESS_LEVEL, -1 for the default */
 } stdf_file;
 
 
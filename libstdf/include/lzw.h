@@ -22,29 +22,36 @@ extern "C" {
 #define LZW_MAGIC   "\037\235"
 
 #ifdef __IN_LIBLZW
-# define HBITS   17			/* 50% occupancy */
-# define HSIZE   (1<<HBITS)
-# define HMASK   (HSIZE-1)
-# define HPRIME  9941
+# define LZW_CODES       (1<<16)		/* codes of the largest (16 bit) table */
+# define LZW_NO_STRING   0xFFFFFFFFU
 
 typedef struct {
 	int fd;
 	int eof;
+	int error;
 
-	unsigned char *inbuf, *outbuf, *stackp;
-	unsigned char *unreadbuf;
-	size_t stackp_diff;
-	size_t insize, outpos;
-	ssize_t rsize;
+	unsigned char *inbuf;			/* compressed data read from fd */
+	size_t inpos, insize;
+	unsigned long long bitbuf;		/* input bits not used yet, next code in the low bits */
+	int bitcnt;
+	unsigned long groupbits;		/* bits read since the code size last changed */
+
+	unsigned char *outbuf;			/* decoded data not handed out yet */
+	size_t outpos, outsize;
 
 	unsigned char flags;
 	int maxbits, block_mode;
+	int n_bits, finchar;
+	long maxcode, maxmaxcode, oldcode, free_ent;
 
-	unsigned long int htab[HSIZE];
-	unsigned short codetab[HSIZE];
-
-	int n_bits, posbits, inbits, bitmask, finchar;
-	long int maxcode, oldcode, incode, code, free_ent;
+	/* every code is its prefix code plus one suffix byte; the whole string is
+	 * also kept in strings[] while it fits, so it can be copied in one go */
+	unsigned short prefix[LZW_CODES];
+	unsigned char suffix[LZW_CODES];
+	unsigned int length[LZW_CODES];
+	unsigned int strpos[LZW_CODES];	/* offset in strings, LZW_NO_STRING if not kept */
+	unsigned char *strings;
+	size_t strings_used;
 } lzwFile;
 
 #else
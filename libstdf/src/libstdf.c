@@ -14,6 +14,7 @@
 #include <libstdf.h>
 #include "dtc.h"
 #include "rec.h"
+#include "pipe.h"
 
 
 
@@ -69,18 +70,28 @@ static int __stdf_init(stdf_file *f, dtc_U1 cpu_type, dtc_U1 stdf_ver, uint32_t
 	f->rec_end = NULL;
 
 	if (f->opts & STDF_OPTS_WRITE) {
-		/* make the buffer big enough to hold the largest record possible */
-		f->__output = (byte_t*)malloc(sizeof(byte_t) * (dtc_U2)-1);
+		/* records are collected into big blocks, with room for the largest record possible */
+		f->__output = (byte_t*)malloc(sizeof(byte_t) * __STDF_WRITE_BUF_SIZE);
 		if (f->__output == NULL)
 			return 1;
 	} else
 		f->__output = NULL;
 	f->_write_pos = f->__output;
-	f->_write_chunk_size = 4096;
+	f->_write_chunk_size = __STDF_WRITE_SIZE;
+	f->_compress_level = -1;
 
 	return 0;
 }
 
+static void __stdf_set_compress_level(stdf_file *f)
+{
+#if HAVE_GZIP
+	if ((f->opts & STDF_OPTS_WRITE) && f->file_format == STDF_FORMAT_GZIP && f->fd_gzip != NULL)
+		gzsetparams(f->fd_gzip, (f->_compress_level < 0 ? Z_DEFAULT_COMPRESSION : f->_compress_level),
+		            Z_DEFAULT_STRATEGY);
+#endif
+}
+
 int stdf_set_setting(stdf_file *f, uint32_t option, ...)
 {
 	va_list ap;
@@ -94,6 +105,10 @@ int stdf_set_setting(stdf_file *f, uint32_t option, ...)
 		case STDF_SETTING_WRITE_SIZE: f->_write_chunk_size = input; break;
 		case STDF_SETTING_VERSION:    f->ver               = input; break;
 		case STDF_SETTING_BYTE_ORDER: f->byte_order        = input; break;
+		case STDF_SETTING_COMPRESS_LEVEL:
+			f->_compress_level = (input > 9 ? 9 : (int)input);
+			__stdf_set_compress_level(f);
+			break;
 	}
 
 	return 0;
@@ -111,6 +126,7 @@ void stdf_get_setting(stdf_file *f, uint32_t option, ...)
 		case STDF_SETTING_WRITE_SIZE: *ret = f->_write_chunk_size; break;
 		case STDF_SETTING_VERSION:    *ret = f->ver;               break;
 		case STDF_SETTING_BYTE_ORDER: *ret = f->byte_order;        break;
+		case STDF_SETTING_COMPRESS_LEVEL: *ret = f->_compress_level; break;
 	}
 }
 
@@ -130,12 +146,22 @@ static int __stdf_open_reg(void *data, int flags, uint32_t mode)
 			stdf->fd = open(stdf->filename, flags, mode);
 	}
 
+#ifdef POSIX_FADV_SEQUENTIAL
+	/* records are read front to back, let the kernel read ahead aggressively */
+	if (stdf->fd != -1 && !(flags & (O_WRONLY | O_RDWR)))
+		posix_fadvise(stdf->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
 	return stdf->fd;
 }
 static int __stdf_read_reg(void *data, void *buf, long count)
 {
 	return read(((stdf_file*)data)->fd, buf, count);
 }
+static int __stdf_write_reg(void *data, const void *buf, long count)
+{
+	return write(((stdf_file*)data)->fd, buf, count);
+}
 static int __stdf_close_reg(void *data)
 {
 	stdf_file *stdf = (stdf_file*)data;
@@ -148,7 +174,8 @@ static int __stdf_close_reg(void *data)
 static __stdf_fops __stdf_fops_reg = {
 	__stdf_open_reg,
 	__stdf_read_reg,
-	__stdf_close_reg
+	__stdf_close_reg,
+	__stdf_write_reg
 };
 
 
@@ -199,7 +226,8 @@ static int __stdf_close_zip(void *data)
 static __stdf_fops __stdf_fops_zip = {
 	__stdf_open_zip,
 	__stdf_read_zip,
-	__stdf_close_zip
+	__stdf_close_zip,
+	NULL
 };
 #endif
 
@@ -217,15 +245,48 @@ static int __stdf_open_gzip(void *data, int flags, uint32_t mode)
 	if (__stdf_open_reg(data, flags, mode) == -1)
 		return -1;
 
-	stdf->fd_gzip = gzdopen(stdf->fd, "rb");
+	/* O_RDWR files are only written to, see _stdf_open() */
+	stdf->fd_gzip = gzdopen(stdf->fd, ((flags & O_ACCMODE) == O_RDONLY ? "rb" : "wb"));
 	if (stdf->fd_gzip == NULL)
 		return -1;
 
 	return stdf->fd;
 }
+/* gzread() drops what it decoded in a call that fails, so it is asked for
+ * less than its own buffer (8 KB by default) at a time: it then copies out of
+ * that buffer and gztell() tells how much of a failed call arrived.  That
+ * data is returned first, the error with the next call. */
+#define __STDF_GZIP_PIECE	(4 * 1024)
 static int __stdf_read_gzip(void *data, void *buf, long count)
 {
-	return gzread(((stdf_file*)data)->fd_gzip, buf, count);
+	gzFile gzip = ((stdf_file*)data)->fd_gzip;
+	long done = 0;
+	z_off_t before, after;
+	int ret;
+
+	while (done < count) {
+		ret = (count - done < __STDF_GZIP_PIECE ? (int)(count - done) : __STDF_GZIP_PIECE);
+		before = gztell(gzip);
+		ret = gzread(gzip, (byte_t*)buf + done, ret);
+		if (ret < 0) {
+			after = gztell(gzip);
+			if (before >= 0 && after > before)
+				done += after - before;
+			if (done)
+				return done;
+			errno = EINVAL;
+			return -1;
+		}
+		if (ret == 0)
+			break;
+		done += ret;
+	}
+	return done;
+}
+static int __stdf_write_gzip(void *data, const void *buf, long count)
+{
+	int ret = gzwrite(((stdf_file*)data)->fd_gzip, buf, count);
+	return (ret == 0 ? -1 : ret);
 }
 static int __stdf_close_gzip(void *data)
 {
@@ -237,7 +298,8 @@ static int __stdf_close_gzip(void *data)
 static __stdf_fops __stdf_fops_gzip = {
 	__stdf_open_gzip,
 	__stdf_read_gzip,
-	__stdf_close_gzip
+	__stdf_close_gzip,
+	__stdf_write_gzip
 };
 #endif
 
@@ -250,32 +312,102 @@ static __stdf_fops __stdf_fops_gzip = {
 static int __stdf_open_bzip2(void *data, int flags, uint32_t mode)
 {
 	stdf_file *stdf = (stdf_file*)data;
+	__stdf_bzip2 *bzip2;
+
 	stdf->fd_bzip2 = NULL;
 
 	if (__stdf_open_reg(data, flags, mode) == -1)
 		return -1;
 
-	stdf->fd_bzip2 = BZ2_bzdopen(stdf->fd, "rb");
-	if (stdf->fd_bzip2 == NULL)
+	bzip2 = (__stdf_bzip2*)calloc(1, sizeof(*bzip2));
+	if (bzip2 == NULL)
 		return -1;
+	stdf->fd_bzip2 = bzip2;
+	if ((flags & O_ACCMODE) == O_RDONLY) {
+		if (BZ2_bzDecompressInit(&bzip2->strm, 0, 0) != BZ_OK)
+			return -1;
+		bzip2->init = 1;
+	} else {
+		bzip2->file = BZ2_bzdopen(stdf->fd, "wb");
+		if (bzip2->file == NULL)
+			return -1;
+	}
 
 	return stdf->fd;
 }
+/* as BZ2_bzread(), but the data decoded before an error is returned and the
+ * error comes with the next call */
 static int __stdf_read_bzip2(void *data, void *buf, long count)
 {
-	return BZ2_bzread(((stdf_file*)data)->fd_bzip2, buf, count);
+	stdf_file *stdf = (stdf_file*)data;
+	__stdf_bzip2 *bzip2 = stdf->fd_bzip2;
+	bz_stream *strm = &bzip2->strm;
+	ssize_t rsize;
+	int ret;
+
+	if (bzip2->error) {
+		errno = bzip2->error;
+		return -1;
+	}
+	if (bzip2->end || count <= 0)
+		return 0;
+
+	strm->next_out = (char*)buf;
+	strm->avail_out = count;
+	while (strm->avail_out) {
+		if (strm->avail_in == 0 && !bzip2->eof) {
+			rsize = read(stdf->fd, bzip2->buf, sizeof(bzip2->buf));
+			if (rsize < 0) {
+				bzip2->error = errno;
+				break;
+			}
+			if (rsize == 0)
+				bzip2->eof = 1;
+			strm->next_in = bzip2->buf;
+			strm->avail_in = rsize;
+		}
+		ret = BZ2_bzDecompress(strm);
+		if (ret == BZ_STREAM_END) {
+			bzip2->end = 1;
+			break;
+		}
+		if (ret != BZ_OK || (bzip2->eof && strm->avail_in == 0 && strm->avail_out)) {
+			/* damaged or truncated */
+			bzip2->error = EINVAL;
+			break;
+		}
+	}
+
+	ret = count - strm->avail_out;
+	if (ret == 0 && bzip2->error) {
+		errno = bzip2->error;
+		return -1;
+	}
+	return ret;
+}
+static int __stdf_write_bzip2(void *data, const void *buf, long count)
+{
+	return BZ2_bzwrite(((stdf_file*)data)->fd_bzip2->file, (void*)buf, count);
 }
 static int __stdf_close_bzip2(void *data)
 {
 	stdf_file *stdf = (stdf_file*)data;
-	if (stdf->fd_bzip2 != NULL)
-		BZ2_bzclose(stdf->fd_bzip2);
+	__stdf_bzip2 *bzip2 = stdf->fd_bzip2;
+	if (bzip2 != NULL) {
+		if (bzip2->file != NULL)
+			BZ2_bzclose(bzip2->file);
+		if (bzip2->init)
+			BZ2_bzDecompressEnd(&bzip2->strm);
+		free(bzip2);
+		stdf->fd_bzip2 = NULL;
+	}
 	return __stdf_close_reg(data);
 }
 static __stdf_fops __stdf_fops_bzip2 = {
 	__stdf_open_bzip2,
 	__stdf_read_bzip2,
-	__stdf_close_bzip2
+	__stdf_close_bzip2,
+	__stdf_write_bzip2
 };
 #endif
 
@@ -310,12 +442,70 @@ static int __stdf_close_lzw(void *data)
 static __stdf_fops __stdf_fops_lzw = {
 	__stdf_open_lzw,
 	__stdf_read_lzw,
-	__stdf_close_lzw
+	__stdf_close_lzw,
+	NULL
 };
 #endif
 
 
 
+/*
+ * BUFFERED INPUT
+ * All backends are read through one big buffer, a record then costs a memcpy
+ * instead of a read() for its header and another one for its data.
+ * Compressed files are decompressed on other threads when possible (pipe.c).
+ */
+static long __stdf_read_backend(stdf_file *stdf, void *buf, long count)
+{
+#if __STDF_HAVE_PIPE
+	if (stdf->_pipe)
+		return __stdf_pipe_read((__stdf_pipe*)stdf->_pipe, buf, count);
+#endif
+	return stdf->fops->read(stdf, buf, count);
+}
+static void __stdf_close_backend(stdf_file *stdf)
+{
+#if __STDF_HAVE_PIPE
+	if (stdf->_pipe) {
+		__stdf_pipe_close((__stdf_pipe*)stdf->_pipe);
+		stdf->_pipe = NULL;
+	}
+#endif
+}
+static long __stdf_fill(stdf_file *stdf, long count)
+{
+	/* make sure count bytes are buffered, returns what is buffered (less at EOF) */
+	long have = stdf->_read_end - stdf->_read_pos;
+	long ret;
+
+	if (have >= count)
+		return have;
+	if (have && stdf->_read_pos != stdf->_read_buf)
+		memmove(stdf->_read_buf, stdf->_read_pos, have);
+	stdf->_read_pos = stdf->_read_buf;
+	stdf->_read_end = stdf->_read_buf + have;
+
+	while (have < count) {
+		ret = __stdf_read_backend(stdf, stdf->_read_end, __STDF_READ_BUF_SIZE - have);
+		if (ret <= 0)
+			break;
+		have += ret;
+		stdf->_read_end += ret;
+	}
+	return have;
+}
+static long __stdf_read(stdf_file *stdf, void *buf, long count)
+{
+	long have = __stdf_fill(stdf, count);
+	if (count > have)
+		count = have;
+	memcpy(buf, stdf->_read_pos, count);
+	stdf->_read_pos += count;
+	return count;
+}
+
+
+
 static stdf_file* _stdf_open(char *pathname, int fd, uint32_t opts, uint32_t mode)
 {
 	int flags, ret_errno = EINVAL;
@@ -334,6 +524,9 @@ static stdf_file* _stdf_open(char *pathname, int fd, uint32_t opts, uint32_t mod
 	} else
 		ret->filename = strdup(pathname);
 	ret->fops = NULL;
+	ret->__data = NULL;
+	ret->_read_buf = ret->_read_pos = ret->_read_end = NULL;
+	ret->_pipe = NULL;
 
 	if (opts == STDF_OPTS_DEFAULT)
 		opts = STDF_OPTS_READ;
@@ -398,6 +591,11 @@ static stdf_file* _stdf_open(char *pathname, int fd, uint32_t opts, uint32_t mod
 		case STDF_FORMAT_REG:
 			ret->fops = &__stdf_fops_reg;
 	}
+	if ((opts & STDF_OPTS_WRITE) && ret->fops->write == NULL) {
+		warn("format not supported for writing");
+		ret->fops = NULL;
+		goto out_err;
+	}
 
 	flags = O_BINARY;
 	if ((opts & STDF_OPTS_READ) && (opts & STDF_OPTS_WRITE))
@@ -415,18 +613,26 @@ static stdf_file* _stdf_open(char *pathname, int fd, uint32_t opts, uint32_t mod
 	}
 
 	if (!(opts & STDF_OPTS_WRITE)) {
-		/* try to peek at the FAR record to figure out the CPU type/STDF ver */
-		ret->__data = (byte_t*)malloc(6);
-		if (ret->fops->read(ret, ret->__data, 6) != 6)
+		ret->_read_buf = (byte_t*)malloc(__STDF_READ_BUF_SIZE);
+		if (ret->_read_buf == NULL)
 			goto out_err;
-		if ((MAKE_REC(ret->__data[2], ret->__data[3]) != REC_FAR)
+		ret->_read_pos = ret->_read_end = ret->_read_buf;
+#if __STDF_HAVE_PIPE
+		if (ret->file_format == STDF_FORMAT_GZIP || ret->file_format == STDF_FORMAT_BZIP2)
+			ret->_pipe = __stdf_pipe_open(ret);
+#endif
+		/* try to peek at the FAR record to figure out the CPU type/STDF ver,
+		 * the bytes stay in the buffer for the first stdf_read_record() */
+		if (__stdf_fill(ret, 6) < 6)
+			goto out_err;
+		if ((MAKE_REC(ret->_read_pos[2], ret->_read_pos[3]) != REC_FAR)
 #ifdef STDF_VER3
 		    /* STDF v3 can have either a FAR or a MIR record */
-		    && (MAKE_REC(ret->__data[2], ret->__data[3]) != REC_MIR)
+		    && (MAKE_REC(ret->_read_pos[2], ret->_read_pos[3]) != REC_MIR)
 #endif
 		   )
 			goto out_err;
-		if (__stdf_init(ret, ret->__data[4], ret->__data[5], opts))
+		if (__stdf_init(ret, ret->_read_pos[4], ret->_read_pos[5], opts))
 			goto out_err;
 	} else {
 		if (__stdf_init(ret, -1, 4, opts))
@@ -438,8 +644,10 @@ static stdf_file* _stdf_open(char *pathname, int fd, uint32_t opts, uint32_t mod
 	return ret;
 
 out_err:
+	__stdf_close_backend(ret);
 	if (ret->fops)
 		ret->fops->close(ret);
+	free(ret->_read_buf);
 	free(ret->filename);
 	free(ret);
 
@@ -487,8 +695,10 @@ int stdf_close(stdf_file *file)
 		_stdf_write_flush(file, (size_t)-1);
 		free(file->__output);
 	}
+	__stdf_close_backend(file);
 	ret = file->fops->close(file);
 	ret_errno = errno;
+	free(file->_read_buf);
 	if (file->filename) free(file->filename);
 	free(file);
 	_stdf_muntrace();
@@ -499,22 +709,15 @@ int stdf_close(stdf_file *file)
 rec_unknown* stdf_read_record_raw(stdf_file *file)
 {
 	rec_unknown *raw_rec = NULL;
-	char header[6];
-	int cheated;
+	byte_t *header;
 
 	_stdf_mtrace();
 
-	if (!file->__data) {
-		/* read the record header to find out how big this next record is */
-		if (file->fops->read(file, header, 4) != 4)
-			goto ret_null;
-		cheated = 0;
-	} else {
-		memcpy(header, file->__data, 6);
-		free(file->__data);
-		file->__data = NULL;
-		cheated = 1;
-	}
+	/* the record header tells how big this next record is */
+	if (__stdf_fill(file, 4) < 4)
+		goto ret_null;
+	header = file->_read_pos;
+
 	raw_rec = (rec_unknown*)malloc(sizeof(rec_unknown));
 	if (raw_rec == NULL) {
 		warnfp("malloc.1");
@@ -528,20 +731,14 @@ rec_unknown* stdf_read_record_raw(stdf_file *file)
 	memcpy(&(file->header), &(raw_rec->header), sizeof(rec_header));
 	_stdf_byte_order_to_host(file, &(file->header.REC_LEN), sizeof(dtc_U2));
 
-	/* buffer the whole record in memory */
+	/* buffer the whole record in memory, straight out of the input buffer */
 	raw_rec->data = (void*)malloc(file->header.REC_LEN+4);
 	if (raw_rec->data == NULL) {
 		warnfp("malloc.2");
 		free(raw_rec);
 		goto ret_null;
 	}
-	if (cheated) {
-		file->fops->read(file, ((byte_t*)raw_rec->data)+6, file->header.REC_LEN-2);
-		memcpy(raw_rec->data, header, 6);
-	} else {
-		file->fops->read(file, ((byte_t*)raw_rec->data)+4, file->header.REC_LEN);
-		memcpy(raw_rec->data, header, 4);
-	}
+	__stdf_read(file, raw_rec->data, file->header.REC_LEN+4);
 
 	_stdf_muntrace();
 	return raw_rec;
@@ -31,9 +31,10 @@
 /*
  * Misc common define cruft
  */
-#define BUFSIZE      4
-#define IN_BUFSIZE   (BUFSIZE + 64)
-#define OUT_BUFSIZE  (BUFSIZE + 2048)
+#define IN_BUFSIZE   (64*1024)
+#define OUT_BUFSIZE  (256*1024)
+#define OUT_SLACK    (LZW_CODES + 16)	/* room for the longest string past OUT_BUFSIZE */
+#define POOL_SIZE    (4*1024*1024)
 #define BITS         16
 #define INIT_BITS    9			/* initial number of bits/code */
 #define MAXCODE(n)   (1L << (n))
@@ -49,6 +50,7 @@ lzwFile *lzw_fdopen(int fd)
 {
 	lzwFile *ret;
 	unsigned char buf[3];
+	int code;
 
 	if (read(fd, buf, 3) != 3)
 		goto err_out;
@@ -62,12 +64,15 @@ lzwFile *lzw_fdopen(int fd)
 	memset(ret, 0x00, sizeof(*ret));
 	ret->fd = fd;
 	ret->eof = 0;
+	ret->error = 0;
 	ret->inbuf = (unsigned char*)malloc(sizeof(unsigned char) * IN_BUFSIZE);
-	ret->outbuf = (unsigned char*)malloc(sizeof(unsigned char) * OUT_BUFSIZE);
-	ret->stackp = NULL;
-	ret->insize = 3; /* we read three bytes above */
-	ret->outpos = 0;
-	ret->rsize = 0;
+	ret->outbuf = (unsigned char*)malloc(sizeof(unsigned char) * (OUT_BUFSIZE + OUT_SLACK));
+	ret->strings = (unsigned char*)malloc(sizeof(unsigned char) * (POOL_SIZE + 16));
+	ret->inpos = ret->insize = 0;
+	ret->bitbuf = 0;
+	ret->bitcnt = 0;
+	ret->groupbits = 0;
+	ret->outpos = ret->outsize = 0;
 
 	ret->flags = buf[2];
 	ret->maxbits = ret->flags & 0x1f;    /* Mask for 'number of compresssion bits' */
@@ -75,18 +80,12 @@ lzwFile *lzw_fdopen(int fd)
 
 	ret->n_bits = INIT_BITS;
 	ret->maxcode = MAXCODE(INIT_BITS) - 1;
-	ret->bitmask = (1<<INIT_BITS)-1;
+	ret->maxmaxcode = MAXCODE(ret->maxbits);
 	ret->oldcode = -1;
 	ret->finchar = 0;
-	ret->posbits = 3<<3;
 	ret->free_ent = ((ret->block_mode) ? FIRST : 256);
 
-	/* initialize the first 256 entries in the table */
-	memset(ret->codetab, 0x00, sizeof(ret->codetab));
-	for (ret->code = 255; ret->code >= 0; --ret->code)
-		ret->htab[ret->code] = ret->code;
-
-	if (ret->inbuf == NULL || ret->outbuf == NULL) {
+	if (ret->inbuf == NULL || ret->outbuf == NULL || ret->strings == NULL) {
 		errno = ENOMEM;
 		goto err_out_free;
 	}
@@ -95,6 +94,15 @@ lzwFile *lzw_fdopen(int fd)
 		goto err_out_free;
 	}
 
+	/* initialize the first 256 entries in the table */
+	for (code = 0; code < 256; ++code) {
+		ret->suffix[code] = code;
+		ret->length[code] = 1;
+		ret->strpos[code] = code;
+		ret->strings[code] = code;
+	}
+	ret->strings_used = 256;
+
 	return ret;
 
 err_out:
@@ -104,6 +112,7 @@ err_out:
 err_out_free:
 	if (ret->inbuf) free(ret->inbuf);
 	if (ret->outbuf) free(ret->outbuf);
+	if (ret->strings) free(ret->strings);
 	free(ret);
 	return NULL;
 }
@@ -141,207 +150,273 @@ int lzw_close(lzwFile *lzw)
 	ret = close(lzw->fd);
 	free(lzw->inbuf);
 	free(lzw->outbuf);
+	free(lzw->strings);
 	free(lzw);
 	return ret;
 }
 
 
 /*
- * Misc read-specific define cruft
+ * Bit input: codes are packed least significant bit first, the bit
+ * buffer is topped up from a large read() buffer, 7 bytes at a time
+ * where possible.
  */
-
-#ifndef	NOALLIGN
-# define NOALLIGN	0
-#endif
-
-union bytes {
-	long word;
-	struct {
-#if BYTE_ORDER == BIG_ENDIAN
-		unsigned char b1, b2, b3, b4;
-#elif BYTE_ORDER == LITTLE_ENDIAN
-		unsigned char b4, b3, b2, b1;
-#endif
-	} bytes;
-};
-
-#if BYTE_ORDER == BIG_ENDIAN && NOALLIGN == 1
-# define input(b,o,c,n,m) \
-	do { \
-		(c) = (*(long *)(&(b)[(o)>>3])>>((o)&0x7))&(m); \
-		(o) += (n); \
-	} while (0)
-#else
-# define input(b,o,c,n,m) \
-	do { \
-		unsigned char *p = &(b)[(o)>>3]; \
-		(c) = ((((long)(p[0]))|((long)(p[1])<<8)| \
-		       ((long)(p[2])<<16))>>((o)&0x7))&(m); \
-		(o) += (n); \
-	} while (0)
+static int __lzw_refill(lzwFile *lzw)
+{
+	ssize_t rsize;
+
+	while (lzw->bitcnt < 56) {
+		if (lzw->inpos == lzw->insize) {
+			do {
+				rsize = read(lzw->fd, lzw->inbuf, IN_BUFSIZE);
+			} while (rsize < 0 && errno == EINTR);
+			if (rsize < 0)
+				return -1;
+			lzw->inpos = 0;
+			lzw->insize = rsize;
+			if (rsize == 0)
+				break;
+			continue;
+		}
+#if BYTE_ORDER == LITTLE_ENDIAN
+		if (lzw->insize - lzw->inpos >= 8) {
+			unsigned long long word;
+			int n = (63 - lzw->bitcnt) >> 3;
+			memcpy(&word, lzw->inbuf + lzw->inpos, 8);
+			lzw->bitbuf |= (word & ((1ULL << (n << 3)) - 1)) << lzw->bitcnt;
+			lzw->inpos += n;
+			lzw->bitcnt += n << 3;
+			continue;
+		}
 #endif
-
-#define de_stack				((unsigned char *)&(lzw->htab[HSIZE-1]))
+		lzw->bitbuf |= (unsigned long long)lzw->inbuf[lzw->inpos++] << lzw->bitcnt;
+		lzw->bitcnt += 8;
+	}
+	return 0;
+}
 
 /*
- * Read LZW file
+ * Drop the rest of a group of 8 codes: compress only changes the code
+ * size (or clears the table) at group boundaries.
  */
-hidden_in_another_lib
-ssize_t lzw_read(lzwFile *lzw, void *readbuf, size_t count)
+static int __lzw_skip(lzwFile *lzw, unsigned long count)
 {
-	size_t count_left = count;
-	unsigned char *inbuf = lzw->inbuf;
-	unsigned char *outbuf = lzw->outbuf;
-
-	long int maxmaxcode = MAXCODE(lzw->maxbits);
-
-	if (!count || lzw->eof)
-		return 0;
-
-	if (lzw->stackp != NULL) {
-		if (lzw->outpos) {
-			if (lzw->outpos >= count) {
-				outbuf = lzw->unreadbuf;
-				goto empty_existing_buffer;
-			} else /*if (lzw->outpos < count)*/ {
-				memcpy(readbuf, lzw->unreadbuf, lzw->outpos);
-				goto resume_partial_reading;
-			}
-		}
-		goto resume_reading;
-	}
-
-	do {
-resetbuf:
-		{
-			int	i, e, o;
-			e = lzw->insize - (o = (lzw->posbits >> 3));
+	int n;
 
-			for (i = 0; i < e; ++i)
-				inbuf[i] = inbuf[i+o];
-
-			lzw->insize = e;
-			lzw->posbits = 0;
-		}
-
-		if (lzw->insize < IN_BUFSIZE-BUFSIZE) {
-			if ((lzw->rsize = read(lzw->fd, inbuf+lzw->insize, BUFSIZE)) < 0)
+	while (count > 0) {
+		if (lzw->bitcnt == 0) {
+			if (__lzw_refill(lzw) < 0)
 				return -1;
-			lzw->insize += lzw->rsize;
+			if (lzw->bitcnt == 0)
+				break;
 		}
+		n = (count < (unsigned long)lzw->bitcnt ? (int)count : lzw->bitcnt);
+		lzw->bitbuf >>= n;
+		lzw->bitcnt -= n;
+		count -= n;
+	}
+	return 0;
+}
 
-		lzw->inbits = ((lzw->rsize > 0) ? (lzw->insize - lzw->insize%lzw->n_bits)<<3 : 
-		               (lzw->insize<<3) - (lzw->n_bits-1));
-
-		while (lzw->inbits > lzw->posbits) {
-			if (lzw->free_ent > lzw->maxcode) {
-				lzw->posbits = ((lzw->posbits-1) + ((lzw->n_bits<<3) -
-				                (lzw->posbits-1 + (lzw->n_bits<<3)) % (lzw->n_bits<<3)));
+#define SAVE_BITS()	do { lzw->bitbuf = bitbuf; lzw->bitcnt = bitcnt; } while (0)
+#define LOAD_BITS()	do { bitbuf = lzw->bitbuf; bitcnt = lzw->bitcnt; } while (0)
+#define GROUP_REST(g, n)	((((unsigned long)(n) << 3) - (g) % ((unsigned long)(n) << 3)) % ((unsigned long)(n) << 3))
 
-				++lzw->n_bits;
-				if (lzw->n_bits == lzw->maxbits)
-					lzw->maxcode = maxmaxcode;
-				else
-					lzw->maxcode = MAXCODE(lzw->n_bits)-1;
+/*
+ * Decode into outbuf until it holds OUT_BUFSIZE bytes or the input ends.
+ *
+ * Strings usually get copied whole from the string pool: a new entry is
+ * the previous string plus one byte, which is still contiguous in the
+ * output (or in the pool).  Once the pool is full the few remaining
+ * entries are written by walking their prefix chain backwards.
+ */
+static int __lzw_decode(lzwFile *lzw)
+{
+	unsigned char *out = lzw->outbuf;
+	unsigned char *out_end = lzw->outbuf + OUT_BUFSIZE;
+	unsigned char *prev = NULL;		/* string of oldcode, if it is in outbuf */
+	unsigned char *strings = lzw->strings;
+	unsigned short *prefix = lzw->prefix;
+	unsigned char *suffix = lzw->suffix;
+	unsigned int *length = lzw->length;
+	unsigned int *strpos = lzw->strpos;
+	unsigned long long bitbuf = lzw->bitbuf;
+	int bitcnt = lzw->bitcnt;
+	unsigned long groupbits = lzw->groupbits;
+	int n_bits = lzw->n_bits;
+	int finchar = lzw->finchar;
+	long maxcode = lzw->maxcode;
+	long maxmaxcode = lzw->maxmaxcode;
+	long oldcode = lzw->oldcode;
+	long free_ent = lzw->free_ent;
+	size_t strings_used = lzw->strings_used;
+	long code, c;
+	unsigned int len;
+	unsigned char *p;
+
+	while (out < out_end) {
+		if (free_ent > maxcode) {
+			SAVE_BITS();
+			if (__lzw_skip(lzw, GROUP_REST(groupbits, n_bits)) < 0)
+				goto err_read;
+			LOAD_BITS();
+			groupbits = 0;
+
+			++n_bits;
+			if (n_bits == lzw->maxbits)
+				maxcode = maxmaxcode;
+			else
+				maxcode = MAXCODE(n_bits)-1;
+		}
 
-				lzw->bitmask = (1 << lzw->n_bits) - 1;
-				goto resetbuf;
+		if (bitcnt < n_bits) {
+			SAVE_BITS();
+			if (__lzw_refill(lzw) < 0)
+				goto err_read;
+			LOAD_BITS();
+			if (bitcnt < n_bits) {
+				/* no complete code left */
+				lzw->eof = 1;
+				break;
 			}
+		}
+		code = (long)(bitbuf & ((1UL << n_bits) - 1));
+		bitbuf >>= n_bits;
+		bitcnt -= n_bits;
+		groupbits += n_bits;
+
+		if (oldcode == -1) {
+			if (code >= 256)
+				goto err_data;
+			prev = out;
+			*out++ = finchar = oldcode = code;
+			continue;
+		}
 
-			input(inbuf,lzw->posbits,lzw->code,lzw->n_bits,lzw->bitmask);
+		if (code == CLEAR && lzw->block_mode) {
+			SAVE_BITS();
+			if (__lzw_skip(lzw, GROUP_REST(groupbits, n_bits)) < 0)
+				goto err_read;
+			LOAD_BITS();
+			groupbits = 0;
+			n_bits = INIT_BITS;
+			maxcode = MAXCODE(INIT_BITS)-1;
+			free_ent = FIRST - 1;
+			strings_used = 256;
+			continue;
+		}
 
-			if (lzw->oldcode == -1) {
-				outbuf[lzw->outpos++] = lzw->finchar = lzw->oldcode = lzw->code;
-				continue;
-			}
+		/* Special case for KwKwK string: the previous one plus its first byte */
+		c = code;
+		if (code >= free_ent) {
+			if (code > free_ent)
+				goto err_data;
+			c = oldcode;
+		}
 
-			if (lzw->code == CLEAR && lzw->block_mode) {
-				memset(lzw->codetab, 0x00, sizeof(lzw->codetab));
-				lzw->free_ent = FIRST - 1;
-				lzw->posbits = ((lzw->posbits-1) + ((lzw->n_bits<<3) -
-				                (lzw->posbits-1 + (lzw->n_bits<<3)) % (lzw->n_bits<<3)));
-				lzw->maxcode = MAXCODE(lzw->n_bits = INIT_BITS)-1;
-				lzw->bitmask = (1 << lzw->n_bits) - 1;
-				goto resetbuf;
+		len = length[c];
+		if (strpos[c] != LZW_NO_STRING) {
+			if (len <= 16) {
+				memcpy(out, strings + strpos[c], 8);
+				memcpy(out + 8, strings + strpos[c] + 8, 8);
+			} else
+				memcpy(out, strings + strpos[c], len);
+		} else {
+			p = out + len;
+			while (c >= 256) {
+				*--p = suffix[c];
+				c = prefix[c];
 			}
-
-			lzw->incode = lzw->code;
-			lzw->stackp = de_stack;
-
-			/* Special case for KwKwK string.*/
-			if (lzw->code >= lzw->free_ent) {
-				if (lzw->code > lzw->free_ent) {
-					errno = EINVAL;
-					return -1;
+			*--p = c;
+		}
+		if (code == free_ent)
+			out[len++] = out[0];
+		finchar = out[0];
+
+		/* Generate the new entry; the one right after a clear is never used */
+		if (free_ent < maxmaxcode) {
+			if (free_ent != CLEAR || !lzw->block_mode) {
+				unsigned int entry_len = length[oldcode] + 1;
+
+				prefix[free_ent] = oldcode;
+				suffix[free_ent] = finchar;
+				length[free_ent] = entry_len;
+				strpos[free_ent] = LZW_NO_STRING;
+				if (strings_used + entry_len <= POOL_SIZE) {
+					if (prev != NULL) {
+						if (entry_len <= 16) {
+							memcpy(strings + strings_used, prev, 8);
+							memcpy(strings + strings_used + 8, prev + 8, 8);
+						} else
+							memcpy(strings + strings_used, prev, entry_len);
+						strpos[free_ent] = strings_used;
+						strings_used += entry_len;
+					} else if (strpos[oldcode] != LZW_NO_STRING) {
+						memcpy(strings + strings_used, strings + strpos[oldcode], entry_len - 1);
+						strings[strings_used + entry_len - 1] = finchar;
+						strpos[free_ent] = strings_used;
+						strings_used += entry_len;
+					}
 				}
-
-				*--lzw->stackp = lzw->finchar;
-				lzw->code = lzw->oldcode;
-			}
-
-			/* Generate output characters in reverse order */
-			while (lzw->code >= 256) {
-				*--lzw->stackp = lzw->htab[lzw->code];
-				lzw->code = lzw->codetab[lzw->code];
 			}
+			++free_ent;
+		}
 
-			*--lzw->stackp = (lzw->finchar = lzw->htab[lzw->code]);
-
-			/* And put them out in forward order */
-			{
-				lzw->stackp_diff = de_stack - lzw->stackp;
-
-				if (lzw->outpos+lzw->stackp_diff >= BUFSIZE) {
-					do {
-						if (lzw->stackp_diff > BUFSIZE-lzw->outpos)
-							lzw->stackp_diff = BUFSIZE-lzw->outpos;
-
-						if (lzw->stackp_diff > 0) {
-							memcpy(outbuf+lzw->outpos, lzw->stackp, lzw->stackp_diff);
-							lzw->outpos += lzw->stackp_diff;
-						}
-
-						if (lzw->outpos >= BUFSIZE) {
-							if (lzw->outpos < count_left) {
-								memcpy(readbuf, outbuf, lzw->outpos);
-resume_partial_reading:
-								readbuf += lzw->outpos;
-								count_left -= lzw->outpos;
-							} else {
-empty_existing_buffer:
-								lzw->outpos -= count_left;
-								memcpy(readbuf, outbuf, count_left);
-								lzw->unreadbuf = outbuf + count_left;
-								return count;
-							}
-resume_reading:
-							lzw->outpos = 0;
-						}
-						lzw->stackp += lzw->stackp_diff;
-					} while ((lzw->stackp_diff = (de_stack-lzw->stackp)) > 0);
-				} else {
-					memcpy(outbuf+lzw->outpos, lzw->stackp, lzw->stackp_diff);
-					lzw->outpos += lzw->stackp_diff;
-				}
-			}
+		prev = out;
+		out += len;
+		oldcode = code;	/* Remember previous code. */
+	}
 
-			/* Generate the new entry. */
-			if ((lzw->code = lzw->free_ent) < maxmaxcode) {
-				lzw->codetab[lzw->code] = lzw->oldcode;
-				lzw->htab[lzw->code] = lzw->finchar;
-				lzw->free_ent = lzw->code+1;
-			}
+	SAVE_BITS();
+	lzw->groupbits = groupbits;
+	lzw->n_bits = n_bits;
+	lzw->finchar = finchar;
+	lzw->maxcode = maxcode;
+	lzw->oldcode = oldcode;
+	lzw->free_ent = free_ent;
+	lzw->strings_used = strings_used;
+	lzw->outpos = 0;
+	lzw->outsize = out - lzw->outbuf;
+	return 0;
+
+err_data:
+	errno = EINVAL;
+err_read:
+	/* keep what was decoded before the bad code, lzw_read() hands it out first */
+	lzw->error = errno;
+	lzw->outpos = 0;
+	lzw->outsize = out - lzw->outbuf;
+	return -1;
+}
 
-			lzw->oldcode = lzw->incode;	/* Remember previous code. */
+/*
+ * Read LZW file
+ */
+hidden_in_another_lib
+ssize_t lzw_read(lzwFile *lzw, void *readbuf, size_t count)
+{
+	unsigned char *dest = (unsigned char*)readbuf;
+	size_t done = 0, avail;
+
+	while (done < count) {
+		if (lzw->outpos == lzw->outsize) {
+			if (lzw->eof || lzw->error)
+				break;
+			__lzw_decode(lzw);
+			continue;
 		}
-    } while (lzw->rsize != 0);
-
-	if (lzw->outpos < count_left) {
-		lzw->eof = 1;
-		memcpy(readbuf, outbuf, lzw->outpos);
-		count_left -= lzw->outpos;
-		return (count - count_left);
-	} else {
-		goto empty_existing_buffer;
+		avail = lzw->outsize - lzw->outpos;
+		if (avail > count - done)
+			avail = count - done;
+		memcpy(dest + done, lzw->outbuf + lzw->outpos, avail);
+		lzw->outpos += avail;
+		done += avail;
+	}
+
+	/* an error is only reported once the data in front of it is read */
+	if (done == 0 && lzw->error) {
+		errno = lzw->error;
+		return -1;
 	}
+	return done;
 }
@@ -0,0 +1,154 @@
+/**
+ * @file lzw_bench.c
+ * @brief Time lzw_read() over a compress(1) file, old and new decoder
+ * @internal
+ */
+/*
+ * Released into the public domain
+ *
+ * Usage: lzw_bench <file.Z> [uncompressed file]
+ *
+ * The file is decoded once per read size by the current decoder (lzw.c)
+ * and by the one it replaced (lzw_old.c); with a second argument the
+ * output is also compared against the uncompressed original.  On a damaged
+ * file both stop with an error; the new one must deliver at least as many
+ * bytes before it as the old one, which drops what it decoded in the failing
+ * call (at read size 1 both give exactly the data before the bad code).
+ */
+
+#include <libstdf.h>
+#include <time.h>
+
+#if HAVE_LZW
+
+static const size_t read_sizes[] = { 1, 512, 4096, 65536, 1024*1024 };
+
+typedef struct lzwOldFile lzwOldFile;
+extern lzwOldFile *lzw_old_fdopen(int);
+extern int lzw_old_close(lzwOldFile*);
+extern ssize_t lzw_old_read(lzwOldFile*, void*, size_t);
+
+typedef struct {
+	const char *name;
+	void *(*fdopen)(int);
+	ssize_t (*read)(void*, void*, size_t);
+	void (*close)(void*);
+} decoder;
+
+static void *new_fdopen(int fd) { return lzw_fdopen(fd); }
+static ssize_t new_read(void *lzw, void *buf, size_t count) { return lzw_read((lzwFile*)lzw, buf, count); }
+static void new_close(void *lzw) { lzw_close((lzwFile*)lzw); }
+static void *old_fdopen(int fd) { return lzw_old_fdopen(fd); }
+static ssize_t old_read(void *lzw, void *buf, size_t count) { return lzw_old_read((lzwOldFile*)lzw, buf, count); }
+static void old_close(void *lzw) { lzw_old_close((lzwOldFile*)lzw); }
+
+static const decoder decoders[] = {
+	{ "old", old_fdopen, old_read, old_close },
+	{ "new", new_fdopen, new_read, new_close }
+};
+
+static double now_ms(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+/* returns the time in ms, -1 on errors; the bytes read end up in *bytes */
+static double bench(const decoder *dec, const char *zfile, const char *reffile, size_t bs, size_t *bytes)
+{
+	void *lzw;
+	unsigned char *buf, *refbuf = NULL;
+	FILE *ref = NULL;
+	ssize_t rsize;
+	size_t total = 0;
+	double start, elapsed;
+	int fd, ret = 0;
+
+	if ((fd = open(zfile, O_RDONLY | O_BINARY)) == -1) {
+		perror(zfile);
+		return -1;
+	}
+	if ((lzw = dec->fdopen(fd)) == NULL) {
+		perror(zfile);
+		close(fd);
+		return -1;
+	}
+	if (reffile && (ref = fopen(reffile, "rb")) == NULL) {
+		perror(reffile);
+		dec->close(lzw);
+		return -1;
+	}
+	buf = (unsigned char*)malloc(bs);
+	if (ref)
+		refbuf = (unsigned char*)malloc(bs);
+
+	start = now_ms();
+	while ((rsize = dec->read(lzw, buf, bs)) > 0) {
+		if (ref && (fread(refbuf, 1, rsize, ref) != (size_t)rsize ||
+		            memcmp(buf, refbuf, rsize) != 0)) {
+			fprintf(stderr, "%s: %s decoder output differs near byte %zu\n", zfile, dec->name, total);
+			ret = 1;
+			break;
+		}
+		total += rsize;
+	}
+	elapsed = now_ms() - start;
+
+	*bytes = total;
+	if (rsize < 0) {
+		fprintf(stderr, "%s: %s decoder: %s after %zu bytes\n", zfile, dec->name, strerror(errno), total);
+		ret = 1;
+	} else if (ref && !ret && fgetc(ref) != EOF) {
+		fprintf(stderr, "%s: %s decoder output ends after %zu bytes\n", zfile, dec->name, total);
+		ret = 1;
+	}
+	printf("%s read size %8zu: %12zu bytes in %9.1f ms, %8.1f MB/s\n", dec->name, bs, total, elapsed,
+	       elapsed > 0 ? total / elapsed / 1000.0 : 0.0);
+
+	free(buf);
+	free(refbuf);
+	if (ref)
+		fclose(ref);
+	dec->close(lzw);
+	return ret ? -1 : elapsed;
+}
+
+int main(int argc, char *argv[])
+{
+	size_t i, d;
+	double elapsed[2];
+	size_t bytes[2];
+	int ret = 0;
+
+	if (argc < 2 || argc > 3) {
+		fprintf(stderr, "Usage: %s <file.Z> [uncompressed file]\n", argv[0]);
+		return 1;
+	}
+
+	for (i = 0; i < sizeof(read_sizes) / sizeof(read_sizes[0]); ++i) {
+		for (d = 0; d < 2; ++d) {
+			bytes[d] = 0;
+			if ((elapsed[d] = bench(&decoders[d], argv[1], (argc == 3 ? argv[2] : NULL), read_sizes[i], &bytes[d])) < 0)
+				ret = 1;
+		}
+		if (bytes[1] < bytes[0]) {
+			printf("read size %8zu: new decoder delivered %zu bytes, the old one %zu\n", read_sizes[i], bytes[1], bytes[0]);
+			ret = 1;
+		}
+		if (elapsed[0] >= 0 && elapsed[1] > 0)
+			printf("read size %8zu: new decoder %.2fx the speed of the old one\n", read_sizes[i], elapsed[0] / elapsed[1]);
+	}
+
+	return ret;
+}
+
+#else
+
+int main(void)
+{
+	fprintf(stderr, "libstdf was built without lzw support\n");
+	return 1;
+}
+
+#endif
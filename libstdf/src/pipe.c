@@ -0,0 +1,775 @@
+/**
+ * @file pipe.c
+ * @brief Threaded decompression in front of the gzip/bzip2 backends.
+ * @internal
+ *
+ * Without this gzread()/BZ2_bzread() run on the thread that parses the
+ * records, so decompressing and decoding take turns on one core.  Here the
+ * backend output is produced ahead of time into a ring of slots:
+ *
+ * - read ahead: one thread calls fops->read() into 1 MB slots while the
+ *   caller consumes the previous ones (any gzip/bzip2 input)
+ * - parallel: when the file can be mapped, a scan thread cuts it into
+ *   pieces that decompress on their own (gzip members, bzip2 blocks) and
+ *   a pool of workers decompresses several at once; the slots are still
+ *   handed out in file order
+ *
+ * If a parallel piece turns out bad the rest of the file is read through
+ * the normal backend, skipping what was handed out already, so damaged
+ * files and trailing garbage are reported by the backend as before.
+ */
+/*
+ * Released under the BSD license.  For more information,
+ * please see: http://opensource.org/licenses/bsd-license.php
+ */
+
+#include "pipe.h"
+
+#if __STDF_HAVE_PIPE
+
+#include <pthread.h>
+#include <sys/mman.h>
+
+#ifndef __STDF_PIPE_THREADS
+# define __STDF_PIPE_THREADS 0			/* 0: one per online cpu */
+#endif
+#define PIPE_MAX_THREADS	8
+#define PIPE_SLOTS			16
+#define PIPE_READ_AHEAD		4			/* slots in flight when reading ahead */
+#define PIPE_CHUNK_SIZE		(1024 * 1024)
+#define PIPE_MAX_OUTPUT		(256 * 1024 * 1024)	/* bigger pieces are left to the backend */
+
+enum {
+	PIPE_MODE_READ_AHEAD,
+	PIPE_MODE_GZIP,
+	PIPE_MODE_BZIP2
+};
+
+enum {
+	SLOT_FREE,
+	SLOT_QUEUED,
+	SLOT_BUSY,
+	SLOT_READY
+};
+
+typedef struct {
+	int			state;
+	byte_t		*data;
+	size_t		len, cap, pos;
+	int			error;			/* piece did not decompress */
+
+	uint64_t	start, end;		/* gzip: byte offset of the member, and where it ended;
+								 * bzip2: bit offsets of the block and of the next marker */
+	uint32_t	crc;			/* bzip2: block crc */
+	int			last;			/* bzip2: last block of the stream */
+	uint32_t	stream_crc;		/* bzip2: crc of the whole stream, with last */
+	int			level;			/* bzip2: block size of the stream */
+} __stdf_pipe_slot;
+
+struct __stdf_pipe {
+	stdf_file	*stdf;
+	int			mode;
+	const byte_t *map;
+	size_t		map_size;
+
+	pthread_mutex_t lock;
+	pthread_cond_t cond;		/* any slot changed state */
+	pthread_t	feeder;
+	pthread_t	workers[PIPE_MAX_THREADS];
+	int			nworkers;
+	int			running;
+	int			stop;
+	int			done;			/* the feeder queued its last slot */
+	int			error;			/* errno of the feeder */
+
+	__stdf_pipe_slot slot[PIPE_SLOTS];
+	unsigned long head;			/* next slot the feeder queues */
+	unsigned long tail;			/* next slot handed to the caller */
+	unsigned long next_job;		/* next queued slot a worker takes */
+	unsigned long depth;		/* slots in flight */
+
+	/* caller side */
+	uint64_t	expect;			/* gzip: where the next member has to start */
+	uint32_t	stream_crc;		/* bzip2: crc of the blocks handed out */
+	uint64_t	delivered;
+	uint64_t	skipped;
+	int			finished;
+	int			fallback;
+};
+
+static int __stdf_pipe_grow(__stdf_pipe_slot *slot)
+{
+	size_t size = (slot->cap ? slot->cap * 2 : PIPE_CHUNK_SIZE);
+	byte_t *data;
+
+	if (size > PIPE_MAX_OUTPUT)
+		size = PIPE_MAX_OUTPUT;
+	if (size <= slot->cap)
+		return -1;
+	data = (byte_t*)realloc(slot->data, size);
+	if (data == NULL)
+		return -1;
+	slot->data = data;
+	slot->cap = size;
+	return 0;
+}
+
+
+
+/*
+ * GZIP: every member starts on a byte boundary with its own header
+ */
+#if HAVE_GZIP
+static int __stdf_pipe_gzip_header(const byte_t *p, size_t left)
+{
+	/* magic, deflate, no reserved flags */
+	return left >= 18 && p[0] == 0x1f && p[1] == 0x8b && p[2] == 8 && !(p[3] & 0xe0);
+}
+
+/* the header bytes also show up inside compressed data: try the first bit of it */
+static int __stdf_pipe_gzip_check(const byte_t *p, size_t left)
+{
+	z_stream z;
+	byte_t out[16 * 1024];
+	size_t total = 0;
+	int ret;
+
+	memset(&z, 0, sizeof(z));
+	if (inflateInit2(&z, 16 + MAX_WBITS) != Z_OK)
+		return 0;
+	z.next_in = (Bytef*)p;
+	z.avail_in = (left > 256 * 1024 ? 256 * 1024 : left);
+	do {
+		z.next_out = out;
+		z.avail_out = sizeof(out);
+		ret = inflate(&z, Z_NO_FLUSH);
+		total += sizeof(out) - z.avail_out;
+	} while (ret == Z_OK && total < 64 * 1024 && z.avail_in);
+	inflateEnd(&z);
+	return ret == Z_OK || ret == Z_STREAM_END || (ret == Z_BUF_ERROR && z.avail_in == 0);
+}
+
+static uint64_t __stdf_pipe_gzip_next(__stdf_pipe *pipe, uint64_t from)
+{
+	const byte_t *p = pipe->map + from, *end = pipe->map + pipe->map_size;
+
+	if (from >= pipe->map_size)
+		return pipe->map_size;
+	while ((p = (const byte_t*)memchr(p, 0x1f, end - p)) != NULL) {
+		if (__stdf_pipe_gzip_header(p, end - p) && __stdf_pipe_gzip_check(p, end - p))
+			return p - pipe->map;
+		++p;
+	}
+	return pipe->map_size;
+}
+
+static void __stdf_pipe_gzip_member(__stdf_pipe *pipe, __stdf_pipe_slot *slot)
+{
+	z_stream z;
+	const byte_t *in = pipe->map + slot->start;
+	size_t left = pipe->map_size - slot->start;
+	uInt n;
+	int ret;
+
+	memset(&z, 0, sizeof(z));
+	if (inflateInit2(&z, 16 + MAX_WBITS) != Z_OK) {
+		slot->error = 1;
+		return;
+	}
+	do {
+		if (z.avail_in == 0 && left) {
+			n = (left > (1U << 30) ? (1U << 30) : (uInt)left);
+			z.next_in = (Bytef*)in;
+			z.avail_in = n;
+			in += n;
+			left -= n;
+		}
+		if (slot->len == slot->cap && __stdf_pipe_grow(slot)) {
+			ret = Z_MEM_ERROR;
+			break;
+		}
+		z.next_out = slot->data + slot->len;
+		z.avail_out = slot->cap - slot->len;
+		ret = inflate(&z, Z_NO_FLUSH);
+		slot->len = slot->cap - z.avail_out;
+	} while (ret == Z_OK);
+
+	slot->error = (ret != Z_STREAM_END);
+	slot->end = (const byte_t*)z.next_in - pipe->map;
+	inflateEnd(&z);
+}
+
+static void *__stdf_pipe_gzip_feeder(void *arg);
+#endif
+
+
+
+/*
+ * BZIP2: blocks are bit aligned, each one starts with a 48 bit magic and
+ * its crc, the stream ends with another magic and the combined crc
+ */
+#if HAVE_BZIP2
+#define BZ_BLOCK_MAGIC	0x314159265359ULL
+#define BZ_EOS_MAGIC	0x177245385090ULL
+#define BZ_MAGIC_MASK	0xFFFFFFFFFFFFULL
+
+/* n (<= 56) bits at the given bit offset, most significant first */
+static uint64_t __stdf_pipe_bits(const byte_t *map, size_t size, uint64_t bit, int n)
+{
+	uint64_t v = 0;
+	size_t i = bit >> 3;
+	int k;
+
+	for (k = 0; k < 8; ++k)
+		v = (v << 8) | (i + k < size ? map[i + k] : 0);
+	return (v << (bit & 7)) >> (64 - n);
+}
+
+/* bit offset of the next block or end of stream magic, (uint64_t)-1 if none */
+static uint64_t __stdf_pipe_bzip2_next(const byte_t *map, size_t size, uint64_t bit, int *eos)
+{
+	uint64_t window = 0, magic, pos;
+	size_t i = bit >> 3;
+	int s, k;
+
+	for (k = 0; k < 8; ++k)
+		window = (window << 8) | (i + k < size ? map[i + k] : 0);
+	for (; i + 6 <= size; ++i) {
+		for (s = 0; s < 8; ++s) {
+			magic = (window >> (16 - s)) & BZ_MAGIC_MASK;
+			if (magic != BZ_BLOCK_MAGIC && magic != BZ_EOS_MAGIC)
+				continue;
+			pos = (uint64_t)i * 8 + s;
+			if (pos < bit || pos + 48 > (uint64_t)size * 8)
+				continue;
+			*eos = (magic == BZ_EOS_MAGIC);
+			return pos;
+		}
+		window = (window << 8) | (i + 8 < size ? map[i + 8] : 0);
+	}
+	return (uint64_t)-1;
+}
+
+static void __stdf_pipe_putbits(byte_t *buf, uint64_t *pos, uint64_t value, int n)
+{
+	while (n-- > 0) {
+		if ((value >> n) & 1)
+			buf[*pos >> 3] |= 0x80 >> (*pos & 7);
+		++*pos;
+	}
+}
+
+static void __stdf_pipe_bzip2_block(__stdf_pipe *pipe, __stdf_pipe_slot *slot)
+{
+	/* rebuild the block as a stream of its own: "BZh<level>", the block,
+	 * and an end of stream marker whose combined crc is the block crc */
+	uint64_t nbits = slot->end - slot->start, pos;
+	size_t whole = nbits >> 3, size = 4 + whole + 12, i;
+	size_t first = slot->start >> 3;
+	int shift = slot->start & 7, ret;
+	byte_t *in;
+	bz_stream bz;
+
+	slot->error = 1;
+	in = (byte_t*)malloc(size);
+	if (in == NULL)
+		return;
+	memset(in + 4 + whole, 0, size - 4 - whole);
+	in[0] = 'B';
+	in[1] = 'Z';
+	in[2] = 'h';
+	in[3] = '0' + slot->level;
+	if (shift == 0)
+		memcpy(in + 4, pipe->map + first, whole);
+	else
+		for (i = 0; i < whole; ++i)
+			in[4 + i] = (pipe->map[first + i] << shift) | (pipe->map[first + i + 1] >> (8 - shift));
+	pos = (uint64_t)(4 + whole) * 8;
+	if (nbits & 7)
+		__stdf_pipe_putbits(in, &pos, __stdf_pipe_bits(pipe->map, pipe->map_size, slot->start + whole * 8, nbits & 7), nbits & 7);
+	__stdf_pipe_putbits(in, &pos, BZ_EOS_MAGIC, 48);
+	__stdf_pipe_putbits(in, &pos, slot->crc, 32);
+
+	memset(&bz, 0, sizeof(bz));
+	if (BZ2_bzDecompressInit(&bz, 0, 0) != BZ_OK) {
+		free(in);
+		return;
+	}
+	bz.next_in = (char*)in;
+	bz.avail_in = (pos + 7) >> 3;
+	do {
+		if (slot->len == slot->cap && __stdf_pipe_grow(slot)) {
+			ret = BZ_MEM_ERROR;
+			break;
+		}
+		bz.next_out = (char*)slot->data + slot->len;
+		bz.avail_out = slot->cap - slot->len;
+		ret = BZ2_bzDecompress(&bz);
+		slot->len = slot->cap - bz.avail_out;
+		if (ret == BZ_OK && bz.avail_in == 0 && bz.avail_out)
+			ret = BZ_UNEXPECTED_EOF;
+	} while (ret == BZ_OK);
+
+	slot->error = (ret != BZ_STREAM_END);
+	BZ2_bzDecompressEnd(&bz);
+	free(in);
+}
+
+static void *__stdf_pipe_bzip2_feeder(void *arg);
+#endif
+
+
+
+/*
+ * Threads
+ */
+
+/* called with the lock held, waits for room in the ring */
+static int __stdf_pipe_queue(__stdf_pipe *pipe, const __stdf_pipe_slot *piece)
+{
+	__stdf_pipe_slot *slot;
+
+	while (!pipe->stop && pipe->head - pipe->tail >= pipe->depth)
+		pthread_cond_wait(&pipe->cond, &pipe->lock);
+	if (pipe->stop)
+		return -1;
+
+	slot = &pipe->slot[pipe->head % PIPE_SLOTS];
+	slot->start = piece->start;
+	slot->end = piece->end;
+	slot->crc = piece->crc;
+	slot->last = piece->last;
+	slot->stream_crc = piece->stream_crc;
+	slot->level = piece->level;
+	slot->error = 0;
+	slot->len = slot->pos = 0;
+	slot->state = SLOT_QUEUED;
+	++pipe->head;
+	pthread_cond_broadcast(&pipe->cond);
+	return 0;
+}
+
+static void *__stdf_pipe_read_ahead(void *arg)
+{
+	__stdf_pipe *pipe = (__stdf_pipe*)arg;
+	__stdf_pipe_slot *slot;
+	long ret = 0;
+
+	pthread_mutex_lock(&pipe->lock);
+	while (1) {
+		while (!pipe->stop && pipe->head - pipe->tail >= pipe->depth)
+			pthread_cond_wait(&pipe->cond, &pipe->lock);
+		if (pipe->stop)
+			break;
+		slot = &pipe->slot[pipe->head % PIPE_SLOTS];
+		slot->state = SLOT_BUSY;
+		pthread_mutex_unlock(&pipe->lock);
+
+		slot->len = slot->pos = 0;
+		if (slot->cap < PIPE_CHUNK_SIZE && __stdf_pipe_grow(slot)) {
+			errno = ENOMEM;
+			ret = -1;
+		} else
+			while (slot->len < PIPE_CHUNK_SIZE) {
+				ret = pipe->stdf->fops->read(pipe->stdf, slot->data + slot->len, PIPE_CHUNK_SIZE - slot->len);
+				if (ret <= 0)
+					break;
+				slot->len += ret;
+			}
+
+		pthread_mutex_lock(&pipe->lock);
+		if (ret < 0)
+			pipe->error = errno;
+		if (slot->len) {
+			slot->state = SLOT_READY;
+			++pipe->head;
+		} else
+			slot->state = SLOT_FREE;
+		pthread_cond_broadcast(&pipe->cond);
+		if (ret <= 0)
+			break;
+	}
+	pipe->done = 1;
+	pthread_cond_broadcast(&pipe->cond);
+	pthread_mutex_unlock(&pipe->lock);
+	return NULL;
+}
+
+#if HAVE_GZIP
+static void *__stdf_pipe_gzip_feeder(void *arg)
+{
+	__stdf_pipe *pipe = (__stdf_pipe*)arg;
+	__stdf_pipe_slot piece;
+	uint64_t pos = 0, next;
+
+	/* looking for a second member can take a pass over the whole file, so it
+	 * is done here and not in __stdf_pipe_open(); one member can only be read
+	 * in order, then the workers go and this thread reads ahead instead */
+	if (__stdf_pipe_gzip_next(pipe, 18) >= pipe->map_size) {
+		pthread_mutex_lock(&pipe->lock);
+		pipe->mode = PIPE_MODE_READ_AHEAD;
+		pipe->depth = PIPE_READ_AHEAD;
+		pthread_cond_broadcast(&pipe->cond);
+		pthread_mutex_unlock(&pipe->lock);
+		return __stdf_pipe_read_ahead(arg);
+	}
+
+	memset(&piece, 0, sizeof(piece));
+	pthread_mutex_lock(&pipe->lock);
+	while (pos < pipe->map_size && !pipe->stop) {
+		pthread_mutex_unlock(&pipe->lock);
+		next = __stdf_pipe_gzip_next(pipe, pos + 18);
+		pthread_mutex_lock(&pipe->lock);
+		piece.start = pos;
+		if (__stdf_pipe_queue(pipe, &piece))
+			break;
+		pos = next;
+	}
+	pipe->done = 1;
+	pthread_cond_broadcast(&pipe->cond);
+	pthread_mutex_unlock(&pipe->lock);
+	return NULL;
+}
+#endif
+
+#if HAVE_BZIP2
+static void *__stdf_pipe_bzip2_feeder(void *arg)
+{
+	__stdf_pipe *pipe = (__stdf_pipe*)arg;
+	__stdf_pipe_slot piece;
+	uint64_t bit = 32, next;
+	int eos = 0;
+
+	memset(&piece, 0, sizeof(piece));
+	piece.level = pipe->map[3] - '0';
+	pthread_mutex_lock(&pipe->lock);
+	/* only the first stream, like BZ2_bzread() */
+	while (!eos && !pipe->stop) {
+		pthread_mutex_unlock(&pipe->lock);
+		next = __stdf_pipe_bzip2_next(pipe->map, pipe->map_size, bit + 48 + 32, &eos);
+		pthread_mutex_lock(&pipe->lock);
+		if (next == (uint64_t)-1) {
+			/* truncated, let the backend report it */
+			pipe->error = EINVAL;
+			break;
+		}
+		piece.start = bit;
+		piece.end = next;
+		piece.crc = __stdf_pipe_bits(pipe->map, pipe->map_size, bit + 48, 32);
+		piece.last = eos;
+		if (eos)
+			piece.stream_crc = __stdf_pipe_bits(pipe->map, pipe->map_size, next + 48, 32);
+		if (__stdf_pipe_queue(pipe, &piece))
+			break;
+		bit = next;
+	}
+	pipe->done = 1;
+	pthread_cond_broadcast(&pipe->cond);
+	pthread_mutex_unlock(&pipe->lock);
+	return NULL;
+}
+#endif
+
+static void *__stdf_pipe_worker(void *arg)
+{
+	__stdf_pipe *pipe = (__stdf_pipe*)arg;
+	__stdf_pipe_slot *slot;
+
+	pthread_mutex_lock(&pipe->lock);
+	while (!pipe->stop && pipe->mode != PIPE_MODE_READ_AHEAD) {
+		if (pipe->next_job == pipe->head) {
+			pthread_cond_wait(&pipe->cond, &pipe->lock);
+			continue;
+		}
+		slot = &pipe->slot[pipe->next_job % PIPE_SLOTS];
+		++pipe->next_job;
+		slot->state = SLOT_BUSY;
+		pthread_mutex_unlock(&pipe->lock);
+
+		switch (pipe->mode) {
+#if HAVE_GZIP
+			case PIPE_MODE_GZIP:  __stdf_pipe_gzip_member(pipe, slot); break;
+#endif
+#if HAVE_BZIP2
+			case PIPE_MODE_BZIP2: __stdf_pipe_bzip2_block(pipe, slot); break;
+#endif
+		}
+
+		pthread_mutex_lock(&pipe->lock);
+		slot->state = SLOT_READY;
+		pthread_cond_broadcast(&pipe->cond);
+	}
+	pthread_mutex_unlock(&pipe->lock);
+	return NULL;
+}
+
+static void __stdf_pipe_stop(__stdf_pipe *pipe)
+{
+	int i;
+
+	if (!pipe->running)
+		return;
+	pthread_mutex_lock(&pipe->lock);
+	pipe->stop = 1;
+	pthread_cond_broadcast(&pipe->cond);
+	pthread_mutex_unlock(&pipe->lock);
+	pthread_join(pipe->feeder, NULL);
+	for (i = 0; i < pipe->nworkers; ++i)
+		pthread_join(pipe->workers[i], NULL);
+	pipe->running = 0;
+}
+
+
+
+/*
+ * Caller side
+ */
+
+/* the decompressed data so far came out fine, the backend takes over from here */
+static long __stdf_pipe_backend(__stdf_pipe *pipe, void *buf, long count)
+{
+	stdf_file *stdf = pipe->stdf;
+	long ret;
+
+	if (!pipe->fallback) {
+		__stdf_pipe_stop(pipe);
+		pipe->fallback = 1;
+	}
+	while (pipe->skipped < pipe->delivered) {
+		ret = (pipe->delivered - pipe->skipped < (uint64_t)count ? (long)(pipe->delivered - pipe->skipped) : count);
+		ret = stdf->fops->read(stdf, buf, ret);
+		if (ret <= 0)
+			return ret;
+		pipe->skipped += ret;
+	}
+	return stdf->fops->read(stdf, buf, count);
+}
+
+/* 1: hand out the slot, 0: drop it, -1: let the backend take over */
+static int __stdf_pipe_accept(__stdf_pipe *pipe, __stdf_pipe_slot *slot)
+{
+	switch (pipe->mode) {
+#if HAVE_GZIP
+		case PIPE_MODE_GZIP:
+			if (slot->start < pipe->expect)
+				return 0;		/* header look alike inside the previous member */
+			if (slot->start > pipe->expect)
+				return -1;
+			if (slot->error)
+				return -1;
+			pipe->expect = slot->end;
+			return 1;
+#endif
+#if HAVE_BZIP2
+		case PIPE_MODE_BZIP2:
+			if (slot->error)
+				return -1;
+			pipe->stream_crc = ((pipe->stream_crc << 1) | (pipe->stream_crc >> 31)) ^ slot->crc;
+			if (slot->last && pipe->stream_crc != slot->stream_crc)
+				return -1;
+			return 1;
+#endif
+	}
+	return 1;
+}
+
+/* nothing left in the ring: 0 at the end of the data, -1 to use the backend */
+static int __stdf_pipe_end(__stdf_pipe *pipe)
+{
+	switch (pipe->mode) {
+#if HAVE_GZIP
+		case PIPE_MODE_GZIP:
+			/* zlib ignores anything after a member that is not another member */
+			if (pipe->expect + 2 <= pipe->map_size &&
+			    pipe->map[pipe->expect] == 0x1f && pipe->map[pipe->expect + 1] == 0x8b)
+				return -1;
+			return 0;
+#endif
+#if HAVE_BZIP2
+		case PIPE_MODE_BZIP2:
+			return (pipe->error ? -1 : 0);
+#endif
+	}
+	return 0;
+}
+
+long __stdf_pipe_read(__stdf_pipe *pipe, void *buf, long count)
+{
+	__stdf_pipe_slot *slot;
+	long ret;
+
+	if (pipe->fallback)
+		return __stdf_pipe_backend(pipe, buf, count);
+	if (pipe->finished || count <= 0)
+		return 0;
+
+	pthread_mutex_lock(&pipe->lock);
+	while (1) {
+		if (pipe->tail == pipe->head && pipe->done) {
+			pthread_mutex_unlock(&pipe->lock);
+			if (pipe->mode == PIPE_MODE_READ_AHEAD) {
+				if (pipe->error) {
+					errno = pipe->error;
+					return -1;
+				}
+			} else if (__stdf_pipe_end(pipe) < 0)
+				return __stdf_pipe_backend(pipe, buf, count);
+			pipe->finished = 1;
+			return 0;
+		}
+		slot = &pipe->slot[pipe->tail % PIPE_SLOTS];
+		if (pipe->tail == pipe->head || slot->state != SLOT_READY) {
+			pthread_cond_wait(&pipe->cond, &pipe->lock);
+			continue;
+		}
+		if (slot->pos == 0 && pipe->mode != PIPE_MODE_READ_AHEAD) {
+			ret = __stdf_pipe_accept(pipe, slot);
+			if (ret < 0) {
+				pthread_mutex_unlock(&pipe->lock);
+				return __stdf_pipe_backend(pipe, buf, count);
+			}
+			if (ret == 0)
+				slot->pos = slot->len;
+		}
+		if (slot->pos < slot->len)
+			break;
+		/* dropped or empty */
+		slot->state = SLOT_FREE;
+		++pipe->tail;
+		pthread_cond_broadcast(&pipe->cond);
+	}
+	pthread_mutex_unlock(&pipe->lock);
+
+	ret = (slot->len - slot->pos < (size_t)count ? (long)(slot->len - slot->pos) : count);
+	memcpy(buf, slot->data + slot->pos, ret);
+	slot->pos += ret;
+	pipe->delivered += ret;
+
+	if (slot->pos == slot->len) {
+		pthread_mutex_lock(&pipe->lock);
+		if (slot->cap > 8 * PIPE_CHUNK_SIZE) {
+			/* don't keep the memory of an unusually big piece */
+			free(slot->data);
+			slot->data = NULL;
+			slot->cap = 0;
+		}
+		slot->state = SLOT_FREE;
+		++pipe->tail;
+		pthread_cond_broadcast(&pipe->cond);
+		pthread_mutex_unlock(&pipe->lock);
+	}
+	return ret;
+}
+
+__stdf_pipe* __stdf_pipe_open(stdf_file *stdf)
+{
+	__stdf_pipe *pipe;
+	struct stat st;
+	long nthreads = __STDF_PIPE_THREADS;
+	void *map;
+	int i;
+
+	if (nthreads <= 0)
+		nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+	if (nthreads > PIPE_MAX_THREADS)
+		nthreads = PIPE_MAX_THREADS;
+	if (nthreads < 2)
+		return NULL;
+
+	pipe = (__stdf_pipe*)calloc(1, sizeof(*pipe));
+	if (pipe == NULL)
+		return NULL;
+	pipe->stdf = stdf;
+	pipe->mode = PIPE_MODE_READ_AHEAD;
+	pipe->depth = PIPE_READ_AHEAD;
+
+	if (fstat(stdf->fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 &&
+	    (uint64_t)st.st_size == (size_t)st.st_size) {
+		map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, stdf->fd, 0);
+		if (map != MAP_FAILED) {
+			pipe->map = (const byte_t*)map;
+			pipe->map_size = st.st_size;
+		}
+	}
+	if (pipe->map) {
+#if HAVE_GZIP
+		/* the feeder reads a single member ahead instead */
+		if (stdf->file_format == STDF_FORMAT_GZIP &&
+		    __stdf_pipe_gzip_header(pipe->map, pipe->map_size) &&
+		    __stdf_pipe_gzip_check(pipe->map, pipe->map_size))
+			pipe->mode = PIPE_MODE_GZIP;
+#endif
+#if HAVE_BZIP2
+		if (stdf->file_format == STDF_FORMAT_BZIP2 && pipe->map_size >= 14 &&
+		    pipe->map[0] == 'B' && pipe->map[1] == 'Z' && pipe->map[2] == 'h' &&
+		    pipe->map[3] >= '1' && pipe->map[3] <= '9' &&
+		    __stdf_pipe_bits(pipe->map, pipe->map_size, 32, 48) == BZ_BLOCK_MAGIC)
+			pipe->mode = PIPE_MODE_BZIP2;
+#endif
+		if (pipe->mode == PIPE_MODE_READ_AHEAD) {
+			munmap((void*)pipe->map, pipe->map_size);
+			pipe->map = NULL;
+		} else {
+#ifdef MADV_SEQUENTIAL
+			madvise((void*)pipe->map, pipe->map_size, MADV_SEQUENTIAL);
+#endif
+			pipe->nworkers = nthreads;
+			/* gzip members can be large, keep fewer of them around */
+			pipe->depth = (pipe->mode == PIPE_MODE_GZIP ? nthreads + 1 : 2 * nthreads);
+			if (pipe->depth > PIPE_SLOTS)
+				pipe->depth = PIPE_SLOTS;
+		}
+	}
+
+	pthread_mutex_init(&pipe->lock, NULL);
+	pthread_cond_init(&pipe->cond, NULL);
+	switch (pipe->mode) {
+#if HAVE_GZIP
+		case PIPE_MODE_GZIP:
+			i = pthread_create(&pipe->feeder, NULL, __stdf_pipe_gzip_feeder, pipe);
+			break;
+#endif
+#if HAVE_BZIP2
+		case PIPE_MODE_BZIP2:
+			i = pthread_create(&pipe->feeder, NULL, __stdf_pipe_bzip2_feeder, pipe);
+			break;
+#endif
+		default:
+			i = pthread_create(&pipe->feeder, NULL, __stdf_pipe_read_ahead, pipe);
+			break;
+	}
+	if (i != 0) {
+		__stdf_pipe_close(pipe);
+		return NULL;
+	}
+	pipe->running = 1;
+
+	for (i = 0; i < pipe->nworkers; ++i)
+		if (pthread_create(&pipe->workers[i], NULL, __stdf_pipe_worker, pipe) != 0)
+			break;
+	if (i == 0 && pipe->nworkers) {
+		/* nobody to decompress, throw the feeder away */
+		pipe->nworkers = 0;
+		__stdf_pipe_close(pipe);
+		return NULL;
+	}
+	pipe->nworkers = i;
+
+	return pipe;
+}
+
+void __stdf_pipe_close(__stdf_pipe *pipe)
+{
+	int i;
+
+	__stdf_pipe_stop(pipe);
+	pthread_cond_destroy(&pipe->cond);
+	pthread_mutex_destroy(&pipe->lock);
+	for (i = 0; i < PIPE_SLOTS; ++i)
+		free(pipe->slot[i].data);
+	if (pipe->map)
+		munmap((void*)pipe->map, pipe->map_size);
+	free(pipe);
+}
+
+#endif
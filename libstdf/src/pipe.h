@@ -0,0 +1,30 @@
+/**
+ * @file pipe.h
+ * @brief Threaded decompression in front of the gzip/bzip2 backends.
+ * @internal
+ */
+/*
+ * Released under the BSD license.  For more information,
+ * please see: http://opensource.org/licenses/bsd-license.php
+ */
+
+#ifndef _LIBSTDF_PIPE_H
+#define _LIBSTDF_PIPE_H
+
+#include <libstdf.h>
+
+#if HAVE_PTHREAD_H && (HAVE_GZIP || HAVE_BZIP2)
+# define __STDF_HAVE_PIPE 1
+
+typedef struct __stdf_pipe __stdf_pipe;
+
+/* returns NULL when the file is better read on the calling thread */
+extern __stdf_pipe* __stdf_pipe_open(stdf_file*) attribute_hidden;
+extern long __stdf_pipe_read(__stdf_pipe*, void*, long) attribute_hidden;
+extern void __stdf_pipe_close(__stdf_pipe*) attribute_hidden;
+
+#else
+# define __STDF_HAVE_PIPE 0
+#endif
+
+#endif /* _LIBSTDF_PIPE_H */
@@ -1509,16 +1509,18 @@ static inline size_t _calc_rec_len_dtr(attribute_unused stdf_file *f, rec_dtr *r
 
 ssize_t _stdf_write_flush(stdf_file *file, size_t count)
 {
-	size_t write_ret = 1;
+	ssize_t write_ret = 1;
 
+	/* count == -1 forces the flush, otherwise records are collected
+	 * until the write size is reached and go out in one block */
 	if (count == (size_t)-1) {
 		count = file->_write_pos - file->__output;
 		if (count == 0)
 			return 0;
 	} else {
+		count = file->_write_pos - file->__output;
 		if (count < file->_write_chunk_size)
 			return 0;
-		count = file->_write_pos - file->__output;
 	}
 
 	file->_write_pos = file->__output;
@@ -1532,7 +1534,7 @@ ssize_t _stdf_write_flush(stdf_file *file, size_t count)
 	}
 #else
 	while (count > 0 && write_ret > 0) {
-		write_ret = write(file->fd, file->_write_pos, count);
+		write_ret = file->fops->write(file, file->_write_pos, count);
 		if (write_ret > 0) {
 			count -= write_ret;
 			file->_write_pos += write_ret;
@@ -1563,7 +1565,8 @@ ssize_t _stdf_write_flush(stdf_file *file, size_t count)
 
 static inline ssize_t _stdf_check_write_buffer(stdf_file *file, size_t count)
 {
-	if ((file->_write_pos - file->__output) + count >= (dtc_U2)-1)
+	/* count is REC_LEN, the header comes on top */
+	if ((file->_write_pos - file->__output) + count + 4 > __STDF_WRITE_BUF_SIZE)
 		return _stdf_write_flush(file, (size_t)-1);
 	else
 		return 0;
@@ -5,11 +5,18 @@
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <cstring>
+#include <cstdio>
 #include <mutex>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <condition_variable>
 #include <chrono>
 #include <ctime>
 #include <sys/time.h>
 #include <iomanip>
+#include <algorithm>
 
 enum class LogLevel {
     DEBUG,
@@ -19,6 +26,21 @@ enum class LogLevel {
     CRITICAL
 };
 
+// Messages below this level are compiled out by LOG_DEBUG / LOG_INFO
+// (0 = DEBUG ... 4 = CRITICAL), e.g. -DLOGGER_COMPILE_LEVEL=1 for release builds
+#ifndef LOGGER_COMPILE_LEVEL
+#define LOGGER_COMPILE_LEVEL 0
+#endif
+
+/**
+ * Logger with a background writer.
+ *
+ * After init() the calling thread only takes the time and moves the message into a
+ * lock free ring buffer; the writer thread formats the lines, with the date part of
+ * the timestamp cached per second, and writes them to the console and the log file
+ * in batches. With a full ring the caller waits for free slots, nothing is dropped.
+ * Before init() messages are written at once, as before.
+ */
 class Logger {
 public:
     // Singleton instance accessor
@@ -34,26 +56,35 @@ public:
         if (!logFile_.is_open()) {
             std::cerr << "Failed to open log file: " << logFilePath << std::endl;
         }
-        minLevel_ = minLevel;
+        minLevel_ = static_cast<int>(minLevel);
         initialized_ = true;
+        if (!running_) {
+            running_ = true;
+            writer_ = std::thread(&Logger::writerLoop, this);
+        }
+    }
+
+    // Cheap check to skip building messages that would be filtered out
+    bool isEnabled(LogLevel level) const {
+        return static_cast<int>(level) >= minLevel_.load(std::memory_order_relaxed);
     }
 
     // Log a message with a specific level
     void log(LogLevel level, const std::string& message, const std::string& component = "") {
-        if (level < minLevel_) return;
-        
-        std::lock_guard<std::mutex> lock(mutex_);
-        std::string timestamp = getCurrentTimestamp();
-        std::string levelStr = logLevelToString(level);
-        std::string formattedMessage = formatMessage(timestamp, levelStr, message, component);
-        
-        // Output to console
-        std::cout << formattedMessage << std::endl;
-        
-        // Output to file if initialized
-        if (initialized_ && logFile_.is_open()) {
-            logFile_ << formattedMessage << std::endl;
-            logFile_.flush();
+        if (!isEnabled(level)) return;
+
+        struct timeval tv;
+        gettimeofday(&tv, nullptr);
+        if (!running_.load(std::memory_order_acquire)) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::string line;
+            formatLine(line, level, tv, message, component);
+            writeLines(line);
+            return;
+        }
+        while (!push(level, tv, message, component)) {
+            // ring full, let the writer catch up
+            std::this_thread::yield();
         }
     }
 
@@ -61,53 +92,166 @@ public:
     void debug(const std::string& message, const std::string& component = "") {
         log(LogLevel::DEBUG, message, component);
     }
-    
+
     void info(const std::string& message, const std::string& component = "") {
         log(LogLevel::INFO, message, component);
     }
-    
+
     void warning(const std::string& message, const std::string& component = "") {
         log(LogLevel::WARNING, message, component);
     }
-    
+
     void error(const std::string& message, const std::string& component = "") {
         log(LogLevel::ERROR, message, component);
     }
-    
+
     void critical(const std::string& message, const std::string& component = "") {
         log(LogLevel::CRITICAL, message, component);
     }
 
+    // Wait until everything logged so far has been written
+    void flush() {
+        size_t target = enqueuePos_.load(std::memory_order_acquire);
+        while (running_.load(std::memory_order_acquire) && writtenPos_.load(std::memory_order_acquire) < target) {
+            wakeCondition_.notify_one();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
     // Clean up
     ~Logger() {
+        if (running_) {
+            running_ = false;
+            wakeCondition_.notify_one();
+            writer_.join();
+        }
         if (logFile_.is_open()) {
             logFile_.close();
         }
     }
 
 private:
+    static const size_t RING_SIZE = 8192;  // power of two
+    static const size_t BATCH_SIZE = 256;
+
+    struct Entry {
+        std::atomic<size_t> sequence;
+        LogLevel level;
+        struct timeval time;
+        std::string message;
+        std::string component;
+    };
+
     // Private constructor to enforce singleton pattern
-    Logger() : initialized_(false), minLevel_(LogLevel::INFO) {}
-    
+    Logger() : initialized_(false), minLevel_(static_cast<int>(LogLevel::INFO)), running_(false),
+               ring_(new Entry[RING_SIZE]), enqueuePos_(0), dequeuePos_(0), writtenPos_(0), cachedSecond_(-1) {
+        for (size_t i = 0; i < RING_SIZE; i++) {
+            ring_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
     // Prevent copying and assignment
     Logger(const Logger&) = delete;
     Logger& operator=(const Logger&) = delete;
 
-    // Get current timestamp with milliseconds
-    std::string getCurrentTimestamp() {
-        struct timeval tv;
-        gettimeofday(&tv, nullptr);
+    // Multi producer slot claim: a slot is free for position pos when its sequence is pos,
+    // it is readable by the writer once the sequence is pos + 1
+    bool push(LogLevel level, const struct timeval& tv, const std::string& message, const std::string& component) {
+        size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+        while (true) {
+            Entry& entry = ring_[pos & (RING_SIZE - 1)];
+            size_t sequence = entry.sequence.load(std::memory_order_acquire);
+            long diff = static_cast<long>(sequence) - static_cast<long>(pos);
+            if (diff == 0) {
+                if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    entry.level = level;
+                    entry.time = tv;
+                    entry.message = message;
+                    entry.component = component;
+                    entry.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueuePos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void writerLoop() {
+        std::string batch;
+        while (true) {
+            bool stopping = !running_.load(std::memory_order_acquire);
+            size_t count = 0;
+            batch.clear();
+            std::unique_lock<std::mutex> writeLock(mutex_);
+            while (count < BATCH_SIZE) {
+                Entry& entry = ring_[dequeuePos_ & (RING_SIZE - 1)];
+                if (entry.sequence.load(std::memory_order_acquire) != dequeuePos_ + 1) break;
+                formatLine(batch, entry.level, entry.time, entry.message, entry.component);
+                entry.message.clear();
+                entry.sequence.store(dequeuePos_ + RING_SIZE, std::memory_order_release);
+                dequeuePos_++;
+                count++;
+            }
+
+            if (count > 0) {
+                writeLines(batch);
+                writtenPos_.store(dequeuePos_, std::memory_order_release);
+                continue;
+            }
+            writeLock.unlock();
+            if (stopping) return;
+
+            std::unique_lock<std::mutex> lock(wakeMutex_);
+            wakeCondition_.wait_for(lock, std::chrono::milliseconds(5));
+        }
+    }
+
+    void writeLines(const std::string& lines) {
+        // Output to console
+        fwrite(lines.data(), 1, lines.size(), stdout);
+        fflush(stdout);
+
+        // Output to file if initialized
+        if (initialized_ && logFile_.is_open()) {
+            logFile_.write(lines.data(), static_cast<std::streamsize>(lines.size()));
+            logFile_.flush();
+        }
+    }
 
-        struct tm *tm_info = localtime(&tv.tv_sec);
-        char buffer[64];
-        strftime(buffer, sizeof(buffer), "%Y/%m/%d %H:%M:%S", tm_info);
+    // "[2025/03/02 00:09:12.345] [INFO    ] [component] message\n"
+    void formatLine(std::string& line, LogLevel level, const struct timeval& tv,
+                    const std::string& message, const std::string& component) {
+        if (tv.tv_sec != cachedSecond_) {
+            struct tm tm_info;
+            localtime_r(&tv.tv_sec, &tm_info);
+            strftime(cachedDate_, sizeof(cachedDate_), "%Y/%m/%d %H:%M:%S", &tm_info);
+            cachedSecond_ = tv.tv_sec;
+        }
+        char millis[8];
+        snprintf(millis, sizeof(millis), ".%03ld", static_cast<long>(tv.tv_usec / 1000));
 
-        snprintf(buffer + strlen(buffer), sizeof(buffer) - strlen(buffer), ".%03ld", tv.tv_usec / 1000);
-        return std::string(buffer);
+        line += '[';
+        line += cachedDate_;
+        line += millis;
+        line += "] [";
+        const char* levelStr = logLevelToString(level);
+        line += levelStr;
+        line.append(8 - std::min<size_t>(8, strlen(levelStr)), ' ');
+        line += "] ";
+        if (!component.empty()) {
+            line += '[';
+            line += component;
+            line += "] ";
+        }
+        line += message;
+        line += '\n';
     }
 
     // Convert LogLevel to string representation
-    std::string logLevelToString(LogLevel level) {
+    static const char* logLevelToString(LogLevel level) {
         switch (level) {
             case LogLevel::DEBUG:    return "DEBUG";
             case LogLevel::INFO:     return "INFO";
@@ -118,28 +262,36 @@ private:
         }
     }
 
-    // Format the log message
-    std::string formatMessage(const std::string& timestamp, const std::string& level, 
-                             const std::string& message, const std::string& component) {
-        std::stringstream ss;
-        ss << "[" << timestamp << "] ";
-        ss << "[" << std::left << std::setw(8) << level << "] ";
-        
-        if (!component.empty()) {
-            ss << "[" << component << "] ";
-        }
-        
-        ss << message;
-        return ss.str();
-    }
-
     std::ofstream logFile_;
     std::mutex mutex_;
     bool initialized_;
-    LogLevel minLevel_;
+    std::atomic<int> minLevel_;
+
+    std::atomic<bool> running_;
+    std::thread writer_;
+    std::unique_ptr<Entry[]> ring_;
+    std::atomic<size_t> enqueuePos_;
+    size_t dequeuePos_;                 // writer thread only
+    std::atomic<size_t> writtenPos_;
+    std::mutex wakeMutex_;
+    std::condition_variable wakeCondition_;
+    time_t cachedSecond_;
+    char cachedDate_[32];
 };
 
 // Macro for easy access to logger instance
 #define LOG Logger::getInstance()
 
-#endif // LOGGER_H
\ No newline at end of file
+// The message expression is only evaluated when the level is enabled
+#if LOGGER_COMPILE_LEVEL <= 0
+#define LOG_DEBUG(...) do { if (LOG.isEnabled(LogLevel::DEBUG)) LOG.debug(__VA_ARGS__); } while (0)
+#else
+#define LOG_DEBUG(...) do { } while (0)
+#endif
+#if LOGGER_COMPILE_LEVEL <= 1
+#define LOG_INFO(...) do { if (LOG.isEnabled(LogLevel::INFO)) LOG.info(__VA_ARGS__); } while (0)
+#else
+#define LOG_INFO(...) do { } while (0)
+#endif
+
+#endif // LOGGER_H
@@ -0,0 +1,395 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <cerrno>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include "logger.h"
+
+/**
+ * Counters and latency histograms of the daemon.
+ *
+ * Updating a series is a few relaxed atomic adds, no lock. Looking a labeled
+ * series up takes the mutex of its family, the daemon does that once per sync
+ * or message, never per record. A family keeps at most MAX_SERIES label values
+ * (files come and go), later ones are counted under "other".
+ *
+ * Metrics::text() is the Prometheus text format, MetricsServer serves it on
+ * GET /metrics; Metrics::summary() is one log line with the rates since the
+ * last call, for a periodic stats record.
+ */
+class MetricCounter {
+public:
+    static const char* type() { return "counter"; }
+
+    MetricCounter() : value_(0) {}
+
+    void add(uint64_t n = 1) { value_.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+    void write(std::string& out, const std::string& name, const std::string& labels) const {
+        out += name;
+        if (!labels.empty()) out += "{" + labels + "}";
+        out += " " + std::to_string(value()) + "\n";
+    }
+
+private:
+    std::atomic<uint64_t> value_;
+};
+
+class MetricHistogram {
+public:
+    static const char* type() { return "histogram"; }
+
+    // bounds: upper bounds of the buckets, ascending, +Inf is added
+    explicit MetricHistogram(const std::vector<double>& bounds)
+        : bounds_(bounds), buckets_(new std::atomic<uint64_t>[bounds.size() + 1]), sum_(0), count_(0) {
+        for (size_t i = 0; i <= bounds_.size(); i++) buckets_[i] = 0;
+    }
+
+    void observe(double value) {
+        size_t bucket = 0;
+        while (bucket < bounds_.size() && value > bounds_[bucket]) bucket++;
+        buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+        double sum = sum_.load(std::memory_order_relaxed);
+        while (!sum_.compare_exchange_weak(sum, sum + value, std::memory_order_relaxed)) {
+        }
+        count_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    double sum() const { return sum_.load(std::memory_order_relaxed); }
+
+    void write(std::string& out, const std::string& name, const std::string& labels) const {
+        std::string prefix = labels.empty() ? "" : labels + ",";
+        uint64_t cumulative = 0;
+        char bound[32];
+        for (size_t i = 0; i <= bounds_.size(); i++) {
+            cumulative += buckets_[i].load(std::memory_order_relaxed);
+            if (i < bounds_.size()) snprintf(bound, sizeof(bound), "%g", bounds_[i]);
+            else snprintf(bound, sizeof(bound), "+Inf");
+            out += name + "_bucket{" + prefix + "le=\"" + bound + "\"} " + std::to_string(cumulative) + "\n";
+        }
+        std::string braces = labels.empty() ? "" : "{" + labels + "}";
+        char sum[32];
+        snprintf(sum, sizeof(sum), "%.6f", this->sum());
+        out += name + "_sum" + braces + " " + sum + "\n";
+        out += name + "_count" + braces + " " + std::to_string(count()) + "\n";
+    }
+
+private:
+    MetricHistogram(const MetricHistogram&) = delete;
+    MetricHistogram& operator=(const MetricHistogram&) = delete;
+
+    std::vector<double> bounds_;
+    std::unique_ptr<std::atomic<uint64_t>[]> buckets_;
+    std::atomic<double> sum_;
+    std::atomic<uint64_t> count_;
+};
+
+// One metric with its series per value of one label (none if labelName is empty)
+template <typename T>
+class MetricFamily {
+public:
+    static const size_t MAX_SERIES = 256;
+    typedef std::function<T*()> Factory;
+
+    MetricFamily(const std::string& name, const std::string& help, const std::string& labelName, const Factory& factory)
+        : name_(name), help_(help), labelName_(labelName), factory_(factory) {}
+
+    // the series stays valid for the life of the family
+    T& get(const std::string& labelValue = "") {
+        std::lock_guard<std::mutex> lock(mutex_);
+        typename std::map<std::string, std::unique_ptr<T>>::iterator it = series_.find(labelValue);
+        if (it != series_.end()) return *it->second;
+        std::string key = (series_.size() < MAX_SERIES) ? labelValue : "other";
+        std::unique_ptr<T>& series = series_[key];
+        if (!series) series.reset(factory_());
+        return *series;
+    }
+
+    void write(std::string& out) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        out += "# HELP " + name_ + " " + help_ + "\n";
+        out += "# TYPE " + name_ + " " + T::type() + "\n";
+        for (const auto& series : series_) {
+            std::string labels = labelName_.empty() ? "" : labelName_ + "=\"" + escape(series.first) + "\"";
+            series.second->write(out, name_, labels);
+        }
+    }
+
+    // f(labelValue, series) for every series
+    void forEach(const std::function<void(const std::string&, const T&)>& f) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& series : series_) f(series.first, *series.second);
+    }
+
+private:
+    static std::string escape(const std::string& value) {
+        std::string escaped;
+        for (char c : value) {
+            if (c == '\\' || c == '"') escaped += '\\';
+            if (c == '\n') {
+                escaped += "\\n";
+                continue;
+            }
+            escaped += c;
+        }
+        return escaped;
+    }
+
+    std::string name_;
+    std::string help_;
+    std::string labelName_;
+    Factory factory_;
+    mutable std::mutex mutex_;
+    std::map<std::string, std::unique_ptr<T>> series_;
+};
+
+class Metrics {
+public:
+    static Metrics& getInstance() {
+        static Metrics instance;
+        return instance;
+    }
+
+    // seconds since start, for the latency histograms
+    static double secondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Sync side, per tester
+    MetricFamily<MetricHistogram> syncDuration;
+    MetricFamily<MetricHistogram> syncBytes;
+    MetricFamily<MetricCounter> syncErrors;
+    MetricFamily<MetricHistogram> publishDuration;
+    MetricFamily<MetricCounter> published;
+    // Consumer side, per file
+    MetricFamily<MetricHistogram> queueLag;
+    MetricFamily<MetricHistogram> extractDuration;
+    MetricFamily<MetricCounter> recordsParsed;
+    MetricFamily<MetricCounter> bytesParsed;
+    MetricFamily<MetricCounter> prrsExtracted;
+    MetricFamily<MetricHistogram> outputWriteDuration;
+    MetricFamily<MetricCounter> messages;
+    MetricFamily<MetricHistogram> ackLatency;
+
+    std::string text() const {
+        std::string out;
+        syncDuration.write(out);
+        syncBytes.write(out);
+        syncErrors.write(out);
+        publishDuration.write(out);
+        published.write(out);
+        queueLag.write(out);
+        extractDuration.write(out);
+        recordsParsed.write(out);
+        bytesParsed.write(out);
+        prrsExtracted.write(out);
+        outputWriteDuration.write(out);
+        messages.write(out);
+        ackLatency.write(out);
+        return out;
+    }
+
+    // totals over all series and rates since the previous call; one caller only
+    std::string summary() {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(now - lastSummary_).count();
+        lastSummary_ = now;
+
+        uint64_t records = counterTotal(recordsParsed);
+        uint64_t bytes = counterTotal(bytesParsed);
+        uint64_t prrs = counterTotal(prrsExtracted);
+        double recordRate = (seconds > 0) ? (records - lastRecords_) / seconds : 0;
+        double byteRate = (seconds > 0) ? (bytes - lastBytes_) / seconds : 0;
+        lastRecords_ = records;
+        lastBytes_ = bytes;
+
+        char line[512];
+        snprintf(line, sizeof(line),
+                 "records %llu (%.0f/s), %.1f MB parsed (%.2f MB/s), PRRs %llu, messages acked %llu rejected %llu, "
+                 "mean ms: sync %.1f, publish %.1f, queue lag %.1f, extract %.1f, write %.1f, ack %.1f",
+                 static_cast<unsigned long long>(records), recordRate, bytes / 1048576.0, byteRate / 1048576.0,
+                 static_cast<unsigned long long>(prrs),
+                 static_cast<unsigned long long>(messages.get("acked").value()),
+                 static_cast<unsigned long long>(messages.get("rejected").value()),
+                 meanMs(syncDuration), meanMs(publishDuration), meanMs(queueLag),
+                 meanMs(extractDuration), meanMs(outputWriteDuration), meanMs(ackLatency));
+        return line;
+    }
+
+private:
+    Metrics()
+        : syncDuration("stdf_sync_duration_seconds", "Duration of one rsync run or fetch", "tester", seconds()),
+          syncBytes("stdf_sync_delta_bytes", "Bytes a sync added to the local copy", "tester", bytes()),
+          syncErrors("stdf_sync_errors_total", "Failed rsync runs or fetches", "tester", counter()),
+          publishDuration("stdf_publish_duration_seconds", "Publish of a position update, broker confirm included", "tester", seconds()),
+          published("stdf_published_messages_total", "Position updates published", "result", counter()),
+          queueLag("stdf_queue_lag_seconds", "From publishing a position update to a worker taking it", "file", seconds()),
+          extractDuration("stdf_extract_duration_seconds", "Extraction of the records of one delta", "file", seconds()),
+          recordsParsed("stdf_records_parsed_total", "Records gone through by the tail readers", "file", counter()),
+          bytesParsed("stdf_parsed_bytes_total", "Bytes gone through by the tail readers", "file", counter()),
+          prrsExtracted("stdf_prr_extracted_total", "PRR records extracted", "file", counter()),
+          outputWriteDuration("stdf_output_write_duration_seconds", "Writing the PRRs of one message to the output", "format", seconds()),
+          messages("stdf_messages_total", "Consumed messages by outcome", "result", counter()),
+          ackLatency("stdf_ack_latency_seconds", "From receiving a message to acking or rejecting it", "", seconds()),
+          lastSummary_(std::chrono::steady_clock::now()), lastRecords_(0), lastBytes_(0) {}
+
+    Metrics(const Metrics&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+
+    static MetricFamily<MetricCounter>::Factory counter() {
+        return []() { return new MetricCounter(); };
+    }
+
+    // 0.5 ms to 60 s
+    static MetricFamily<MetricHistogram>::Factory seconds() {
+        return []() {
+            static const std::vector<double> bounds = {0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05,
+                                                       0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30, 60};
+            return new MetricHistogram(bounds);
+        };
+    }
+
+    // 1 KB to 1 GB in powers of 4
+    static MetricFamily<MetricHistogram>::Factory bytes() {
+        return []() {
+            static const std::vector<double> bounds = {1024, 4096, 16384, 65536, 262144, 1048576,
+                                                       4194304, 16777216, 67108864, 268435456, 1073741824};
+            return new MetricHistogram(bounds);
+        };
+    }
+
+    static uint64_t counterTotal(const MetricFamily<MetricCounter>& family) {
+        uint64_t total = 0;
+        family.forEach([&total](const std::string&, const MetricCounter& counter) { total += counter.value(); });
+        return total;
+    }
+
+    static double meanMs(const MetricFamily<MetricHistogram>& family) {
+        uint64_t count = 0;
+        double sum = 0;
+        family.forEach([&](const std::string&, const MetricHistogram& histogram) {
+            count += histogram.count();
+            sum += histogram.sum();
+        });
+        return count ? sum * 1000.0 / count : 0.0;
+    }
+
+    std::chrono::steady_clock::time_point lastSummary_;
+    uint64_t lastRecords_;
+    uint64_t lastBytes_;
+};
+
+/**
+ * Minimal HTTP server for Prometheus scrapes: GET /metrics answers
+ * Metrics::text(), everything else 404. One connection at a time on its own
+ * thread, scrapes are rare and small.
+ */
+class MetricsServer {
+public:
+    explicit MetricsServer(int port) : port_(port), fd_(-1), running_(false) {
+        fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd_ < 0) {
+            LOG.error("Failed to create metrics socket: " + std::string(strerror(errno)), "Metrics");
+            return;
+        }
+        int reuse = 1;
+        setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_ANY);
+        address.sin_port = htons(static_cast<uint16_t>(port_));
+        if (bind(fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(fd_, 8) != 0) {
+            LOG.error("Failed to listen for metrics on port " + std::to_string(port_) + ": " + strerror(errno), "Metrics");
+            close(fd_);
+            fd_ = -1;
+            return;
+        }
+        running_ = true;
+        thread_ = std::thread(&MetricsServer::serve, this);
+        LOG.info("Serving metrics on port " + std::to_string(port_), "Metrics");
+    }
+
+    ~MetricsServer() {
+        running_ = false;
+        if (thread_.joinable()) thread_.join();
+        if (fd_ >= 0) close(fd_);
+    }
+
+private:
+    void serve() {
+        while (running_) {
+            pollfd listening;
+            listening.fd = fd_;
+            listening.events = POLLIN;
+            // wake up now and then to see running_
+            if (::poll(&listening, 1, 500) <= 0) continue;
+            int client = accept(fd_, nullptr, nullptr);
+            if (client < 0) continue;
+            answer(client);
+            close(client);
+        }
+    }
+
+    void answer(int client) {
+        timeval timeout;
+        timeout.tv_sec = 2;
+        timeout.tv_usec = 0;
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+        char request[1024];
+        ssize_t count = recv(client, request, sizeof(request) - 1, 0);
+        if (count <= 0) return;
+        request[count] = '\0';
+
+        std::string body;
+        std::string status;
+        if (strncmp(request, "GET /metrics", 12) == 0 && (request[12] == ' ' || request[12] == '?')) {
+            status = "200 OK";
+            body = Metrics::getInstance().text();
+        } else {
+            status = "404 Not Found";
+            body = "not found\n";
+        }
+        std::string response = "HTTP/1.0 " + status + "\r\n"
+                               "Content-Type: text/plain; version=0.0.4\r\n"
+                               "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                               "Connection: close\r\n\r\n" + body;
+        size_t sent = 0;
+        while (sent < response.size()) {
+            ssize_t n = send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) return;
+            sent += static_cast<size_t>(n);
+        }
+    }
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    int port_;
+    int fd_;
+    std::atomic<bool> running_;
+    std::thread thread_;
+};
+
+#define METRICS Metrics::getInstance()
+
+#endif // METRICS_H
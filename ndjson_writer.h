@@ -0,0 +1,246 @@
+#ifndef NDJSON_WRITER_H
+#define NDJSON_WRITER_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <ctime>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "stdf_v4_api.h"
+#include "logger.h"
+
+/**
+ * Appends PRR records to a newline delimited JSON file, one compact object per line.
+ *
+ * The records are serialized straight into a buffer that is reused between calls,
+ * written with one write() to the end of the file and fsynced, so the cost of a
+ * delta only depends on the records it added. When the file grows past
+ * maxFileBytes it is renamed to "<path>.<timestamp>" and a new one is started.
+ *
+ * The output directory is created once by the constructor. append() may be called
+ * from several threads, the lines of one call stay together.
+ */
+class NdjsonWriter {
+public:
+    explicit NdjsonWriter(const std::string& path, unsigned long long maxFileBytes = 256ULL << 20)
+        : path_(path), maxFileBytes_(maxFileBytes), fd_(-1), fileBytes_(0) {
+        size_t slash = path_.find_last_of('/');
+        if (slash != std::string::npos && slash > 0) {
+            createDirectories(path_.substr(0, slash));
+        }
+        buffer_.reserve(64 * 1024);
+        openFile();
+    }
+
+    ~NdjsonWriter() {
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+    }
+
+    const std::string& path() const { return path_; }
+
+    /**
+     * Append one line per PRR record and fsync the file.
+     *
+     * @param prrRecords Records of the delta
+     * @param sourceFile The stdf file the records come from
+     * @param sync_time Timestamp to use for the records
+     * @return true when the lines are on disk
+     */
+    bool append(const std::vector<StdfPRR*>& prrRecords, const std::string& sourceFile, time_t sync_time) {
+        if (prrRecords.empty()) return true;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        buffer_.clear();
+        for (const StdfPRR* prr : prrRecords) {
+            appendRecord(*prr, sourceFile, sync_time);
+        }
+        return writeBuffer(buffer_);
+    }
+
+    /**
+     * Append lines serialized by the caller and fsync the file.
+     *
+     * @param lines One or more complete lines, each ending with '\n'
+     * @return true when the lines are on disk
+     */
+    bool appendLines(const std::string& lines) {
+        if (lines.empty()) return true;
+        std::lock_guard<std::mutex> lock(mutex_);
+        return writeBuffer(lines);
+    }
+
+    // mkdir -p without a shell
+    static bool createDirectories(const std::string& directory) {
+        std::string path;
+        size_t start = 0;
+        while (start <= directory.size()) {
+            size_t slash = directory.find('/', start);
+            if (slash == std::string::npos) slash = directory.size();
+            path = directory.substr(0, slash);
+            if (!path.empty() && mkdir(path.c_str(), 0755) != 0 && errno != EEXIST) {
+                LOG.warning("Failed to create directory: " + path + ": " + strerror(errno), "NdjsonWriter");
+                return false;
+            }
+            start = slash + 1;
+        }
+        return true;
+    }
+
+private:
+    bool openFile() {
+        fd_ = open(path_.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (fd_ < 0) {
+            LOG.error("Failed to open output file " + path_ + ": " + strerror(errno), "NdjsonWriter");
+            return false;
+        }
+        struct stat info;
+        fileBytes_ = (fstat(fd_, &info) == 0) ? static_cast<unsigned long long>(info.st_size) : 0;
+        return true;
+    }
+
+    void rotate() {
+        char suffix[32];
+        time_t now = time(nullptr);
+        struct tm tm_info;
+        localtime_r(&now, &tm_info);
+        strftime(suffix, sizeof(suffix), ".%Y%m%d_%H%M%S", &tm_info);
+
+        close(fd_);
+        fd_ = -1;
+        std::string rotatedName = path_ + suffix;
+        struct stat info;
+        for (int n = 1; stat(rotatedName.c_str(), &info) == 0; n++) {
+            // rotated twice within one second
+            rotatedName = path_ + suffix + "." + std::to_string(n);
+        }
+        if (std::rename(path_.c_str(), rotatedName.c_str()) != 0) {
+            LOG.warning("Failed to rotate " + path_ + ": " + strerror(errno), "NdjsonWriter");
+        } else {
+            LOG.info("Rotated output file to " + rotatedName, "NdjsonWriter");
+        }
+        openFile();
+    }
+
+    // called with mutex_ held
+    bool writeBuffer(const std::string& buffer) {
+        if (fd_ < 0 && !openFile()) return false;
+        if (!writeAll(buffer.data(), buffer.size())) {
+            LOG.error("Failed to write " + path_ + ": " + strerror(errno), "NdjsonWriter");
+            return false;
+        }
+        if (fdatasync(fd_) != 0) {
+            LOG.error("Failed to sync " + path_ + ": " + strerror(errno), "NdjsonWriter");
+            return false;
+        }
+        fileBytes_ += buffer.size();
+        if (fileBytes_ >= maxFileBytes_) {
+            rotate();
+        }
+        return true;
+    }
+
+    bool writeAll(const char* data, size_t size) {
+        while (size > 0) {
+            ssize_t count = write(fd_, data, size);
+            if (count < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            data += count;
+            size -= static_cast<size_t>(count);
+        }
+        return true;
+    }
+
+    // same fields as StdfExtractor::savePrrRecords, plus the source file
+    void appendRecord(const StdfPRR& prr, const std::string& sourceFile, time_t sync_time) {
+        buffer_ += "{\"file\":";
+        appendString(sourceFile.c_str());
+        buffer_ += ",\"head_number\":";
+        appendNumber(prr.get_head_number());
+        buffer_ += ",\"site_number\":";
+        appendNumber(prr.get_site_number());
+        buffer_ += ",\"test_count\":";
+        appendNumber(prr.get_number_test());
+        buffer_ += ",\"hard_bin\":";
+        appendNumber(prr.get_hardbin_number());
+        buffer_ += ",\"soft_bin\":";
+        appendNumber(prr.get_softbin_number());
+        buffer_ += ",\"x_coord\":";
+        appendNumber(prr.get_x_coordinate());
+        buffer_ += ",\"y_coord\":";
+        appendNumber(prr.get_y_coordinate());
+        buffer_ += ",\"test_time\":";
+        appendNumber(prr.get_elapsed_ms());
+        buffer_ += ",\"part_flags\":{\"superseded\":";
+        buffer_ += prr.part_supersede_flag() ? "true" : "false";
+        buffer_ += ",\"abnormal\":";
+        buffer_ += prr.part_abnormal_flag() ? "true" : "false";
+        buffer_ += ",\"failed\":";
+        buffer_ += prr.part_failed_flag() ? "true" : "false";
+        buffer_ += ",\"invalid_flag\":";
+        buffer_ += prr.pass_fail_flag_invalid() ? "true" : "false";
+        buffer_ += '}';
+
+        const char* part_id = prr.get_part_id();
+        if (part_id) {
+            buffer_ += ",\"part_id\":";
+            appendString(part_id);
+        }
+        const char* part_text = prr.get_part_discription();
+        if (part_text) {
+            buffer_ += ",\"part_text\":";
+            appendString(part_text);
+        }
+
+        buffer_ += ",\"last_modified\":";
+        appendNumber(static_cast<long long>(sync_time));
+        buffer_ += ",\"sot\":";
+        appendNumber(static_cast<long long>(sync_time - prr.get_elapsed_ms() / 1000));
+        buffer_ += ",\"eot\":";
+        appendNumber(static_cast<long long>(sync_time));
+        buffer_ += "}\n";
+    }
+
+    void appendNumber(long long value) {
+        char digits[24];
+        int length = snprintf(digits, sizeof(digits), "%lld", value);
+        buffer_.append(digits, static_cast<size_t>(length));
+    }
+
+    // printable ASCII only, like StdfExtractor::sanitizeString
+    void appendString(const char* text) {
+        buffer_ += '"';
+        for (const char* c = text; *c; c++) {
+            unsigned char ch = static_cast<unsigned char>(*c);
+            if (ch == '\\' || ch == '"') {
+                buffer_ += '\\';
+                buffer_ += static_cast<char>(ch);
+            } else if (ch >= 32 && ch < 127) {
+                buffer_ += static_cast<char>(ch);
+            } else {
+                buffer_ += '?';
+            }
+        }
+        buffer_ += '"';
+    }
+
+    NdjsonWriter(const NdjsonWriter&) = delete;
+    NdjsonWriter& operator=(const NdjsonWriter&) = delete;
+
+    std::string path_;
+    unsigned long long maxFileBytes_;
+    int fd_;
+    unsigned long long fileBytes_;
+    std::string buffer_;
+    std::mutex mutex_;
+};
+
+#endif // NDJSON_WRITER_H
@@ -0,0 +1,255 @@
+#ifndef PRR_BLOCK_H
+#define PRR_BLOCK_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "stdf_v4_api.h"
+#include "nlohmann/json.hpp"
+
+/**
+ * Columnar binary block of part results, the compact alternative to the JSON output.
+ *
+ * Layout (byte order of the writing machine, every column 8 byte aligned):
+ *   PrrBlockHeader
+ *   one column per field, record_count values each, at the offsets of the header
+ *   string table: part_id / part_text zero terminated, referenced by byte offset
+ *
+ * A consumer can mmap the file and use the columns in place, PrrBlockView does
+ * that and gives the same fields as StdfExtractor::savePrrRecords.
+ */
+#define PRR_BLOCK_MAGIC   "PRRB"
+#define PRR_BLOCK_VERSION 1
+#define PRR_BLOCK_NO_STRING 0xFFFFFFFFU
+
+// bits of the flags column
+#define PRR_BLOCK_SUPERSEDED 0x01
+#define PRR_BLOCK_ABNORMAL   0x02
+#define PRR_BLOCK_FAILED     0x04
+#define PRR_BLOCK_INVALID    0x08
+
+struct PrrBlockHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t record_count;
+    uint32_t string_bytes;
+    int64_t sync_time;
+    // byte offsets from the start of the file
+    uint64_t head_offset;        // uint8_t
+    uint64_t site_offset;        // uint8_t
+    uint64_t flags_offset;       // uint8_t, PRR_BLOCK_* bits
+    uint64_t test_count_offset;  // uint16_t
+    uint64_t hard_bin_offset;    // uint16_t
+    uint64_t soft_bin_offset;    // uint16_t
+    uint64_t x_coord_offset;     // int16_t
+    uint64_t y_coord_offset;     // int16_t
+    uint64_t test_time_offset;   // uint32_t, ms
+    uint64_t part_id_offset;     // uint32_t string table offset or PRR_BLOCK_NO_STRING
+    uint64_t part_text_offset;   // uint32_t string table offset or PRR_BLOCK_NO_STRING
+    uint64_t string_offset;
+};
+
+class PrrBlockWriter {
+public:
+    // Serializes the records into one block, ready to be written as is
+    static std::string build(const std::vector<StdfPRR*>& prrRecords, time_t sync_time) {
+        uint32_t count = static_cast<uint32_t>(prrRecords.size());
+
+        std::vector<uint8_t> head(count), site(count), flags(count);
+        std::vector<uint16_t> testCount(count), hardBin(count), softBin(count);
+        std::vector<int16_t> xCoord(count), yCoord(count);
+        std::vector<uint32_t> testTime(count), partId(count), partText(count);
+        std::string strings;
+
+        for (uint32_t i = 0; i < count; i++) {
+            const StdfPRR* prr = prrRecords[i];
+            head[i] = prr->get_head_number();
+            site[i] = prr->get_site_number();
+            flags[i] = (prr->part_supersede_flag() ? PRR_BLOCK_SUPERSEDED : 0) |
+                       (prr->part_abnormal_flag() ? PRR_BLOCK_ABNORMAL : 0) |
+                       (prr->part_failed_flag() ? PRR_BLOCK_FAILED : 0) |
+                       (prr->pass_fail_flag_invalid() ? PRR_BLOCK_INVALID : 0);
+            testCount[i] = prr->get_number_test();
+            hardBin[i] = prr->get_hardbin_number();
+            softBin[i] = prr->get_softbin_number();
+            xCoord[i] = prr->get_x_coordinate();
+            yCoord[i] = prr->get_y_coordinate();
+            testTime[i] = prr->get_elapsed_ms();
+            partId[i] = addString(strings, prr->get_part_id());
+            partText[i] = addString(strings, prr->get_part_discription());
+        }
+
+        PrrBlockHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, PRR_BLOCK_MAGIC, 4);
+        header.version = PRR_BLOCK_VERSION;
+        header.record_count = count;
+        header.string_bytes = static_cast<uint32_t>(strings.size());
+        header.sync_time = static_cast<int64_t>(sync_time);
+
+        std::string block(sizeof(header), '\0');
+        header.head_offset = addColumn(block, head);
+        header.site_offset = addColumn(block, site);
+        header.flags_offset = addColumn(block, flags);
+        header.test_count_offset = addColumn(block, testCount);
+        header.hard_bin_offset = addColumn(block, hardBin);
+        header.soft_bin_offset = addColumn(block, softBin);
+        header.x_coord_offset = addColumn(block, xCoord);
+        header.y_coord_offset = addColumn(block, yCoord);
+        header.test_time_offset = addColumn(block, testTime);
+        header.part_id_offset = addColumn(block, partId);
+        header.part_text_offset = addColumn(block, partText);
+        header.string_offset = block.size();
+        block += strings;
+        memcpy(&block[0], &header, sizeof(header));
+        return block;
+    }
+
+private:
+    static uint32_t addString(std::string& strings, const char* text) {
+        if (!text) return PRR_BLOCK_NO_STRING;
+        uint32_t offset = static_cast<uint32_t>(strings.size());
+        strings += text;
+        strings += '\0';
+        return offset;
+    }
+
+    template <typename T>
+    static uint64_t addColumn(std::string& block, const std::vector<T>& values) {
+        block.resize((block.size() + 7) & ~static_cast<size_t>(7), '\0');
+        uint64_t offset = block.size();
+        if (!values.empty()) {
+            block.append(reinterpret_cast<const char*>(&values[0]), values.size() * sizeof(T));
+        }
+        return offset;
+    }
+};
+
+// Read only mapping of a block file
+class PrrBlockView {
+public:
+    PrrBlockView() : data_(nullptr), size_(0), header_(nullptr) {}
+    ~PrrBlockView() { close(); }
+
+    bool open(const std::string& fileName) {
+        close();
+        int fd = ::open(fileName.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return false;
+        struct stat info;
+        if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(PrrBlockHeader)) {
+            ::close(fd);
+            return false;
+        }
+        size_ = static_cast<size_t>(info.st_size);
+        void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (data == MAP_FAILED) {
+            size_ = 0;
+            return false;
+        }
+        data_ = static_cast<const char*>(data);
+        header_ = reinterpret_cast<const PrrBlockHeader*>(data_);
+        if (memcmp(header_->magic, PRR_BLOCK_MAGIC, 4) != 0 || header_->version != PRR_BLOCK_VERSION ||
+            header_->string_offset + header_->string_bytes > size_ || !columnsFit() ||
+            (header_->string_bytes > 0 && data_[header_->string_offset + header_->string_bytes - 1] != '\0')) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+        if (data_) {
+            munmap(const_cast<char*>(data_), size_);
+        }
+        data_ = nullptr;
+        size_ = 0;
+        header_ = nullptr;
+    }
+
+    uint32_t count() const { return header_ ? header_->record_count : 0; }
+    time_t syncTime() const { return static_cast<time_t>(header_->sync_time); }
+
+    uint8_t head(uint32_t i) const { return column<uint8_t>(header_->head_offset)[i]; }
+    uint8_t site(uint32_t i) const { return column<uint8_t>(header_->site_offset)[i]; }
+    uint8_t flags(uint32_t i) const { return column<uint8_t>(header_->flags_offset)[i]; }
+    uint16_t testCount(uint32_t i) const { return column<uint16_t>(header_->test_count_offset)[i]; }
+    uint16_t hardBin(uint32_t i) const { return column<uint16_t>(header_->hard_bin_offset)[i]; }
+    uint16_t softBin(uint32_t i) const { return column<uint16_t>(header_->soft_bin_offset)[i]; }
+    int16_t xCoord(uint32_t i) const { return column<int16_t>(header_->x_coord_offset)[i]; }
+    int16_t yCoord(uint32_t i) const { return column<int16_t>(header_->y_coord_offset)[i]; }
+    uint32_t testTime(uint32_t i) const { return column<uint32_t>(header_->test_time_offset)[i]; }
+    // nullptr when the PRR had no part id / text
+    const char* partId(uint32_t i) const { return string(column<uint32_t>(header_->part_id_offset)[i]); }
+    const char* partText(uint32_t i) const { return string(column<uint32_t>(header_->part_text_offset)[i]); }
+
+    // The record as savePrrRecords writes it
+    nlohmann::json toJson(uint32_t i) const {
+        nlohmann::json jsonRecord;
+        jsonRecord["head_number"] = head(i);
+        jsonRecord["site_number"] = site(i);
+        jsonRecord["test_count"] = testCount(i);
+        jsonRecord["hard_bin"] = hardBin(i);
+        jsonRecord["soft_bin"] = softBin(i);
+        jsonRecord["x_coord"] = xCoord(i);
+        jsonRecord["y_coord"] = yCoord(i);
+        jsonRecord["test_time"] = testTime(i);
+        jsonRecord["part_flags"] = {
+            {"superseded", (flags(i) & PRR_BLOCK_SUPERSEDED) != 0},
+            {"abnormal", (flags(i) & PRR_BLOCK_ABNORMAL) != 0},
+            {"failed", (flags(i) & PRR_BLOCK_FAILED) != 0},
+            {"invalid_flag", (flags(i) & PRR_BLOCK_INVALID) != 0}
+        };
+        if (partId(i)) {
+            jsonRecord["part_id"] = partId(i);
+        }
+        if (partText(i)) {
+            jsonRecord["part_text"] = partText(i);
+        }
+        time_t sync_time = syncTime();
+        jsonRecord["last_modified"] = sync_time;
+        jsonRecord["sot"] = sync_time - testTime(i) / 1000;
+        jsonRecord["eot"] = sync_time;
+        return jsonRecord;
+    }
+
+private:
+    bool columnsFit() const {
+        uint64_t count = header_->record_count;
+        const uint64_t columns[][2] = {
+            {header_->head_offset, 1}, {header_->site_offset, 1}, {header_->flags_offset, 1},
+            {header_->test_count_offset, 2}, {header_->hard_bin_offset, 2}, {header_->soft_bin_offset, 2},
+            {header_->x_coord_offset, 2}, {header_->y_coord_offset, 2}, {header_->test_time_offset, 4},
+            {header_->part_id_offset, 4}, {header_->part_text_offset, 4}
+        };
+        for (size_t i = 0; i < sizeof(columns) / sizeof(columns[0]); i++) {
+            if (columns[i][0] % columns[i][1] != 0 || columns[i][0] + count * columns[i][1] > size_) return false;
+        }
+        return true;
+    }
+
+    template <typename T>
+    const T* column(uint64_t offset) const {
+        return reinterpret_cast<const T*>(data_ + offset);
+    }
+
+    const char* string(uint32_t offset) const {
+        if (offset == PRR_BLOCK_NO_STRING || offset >= header_->string_bytes) return nullptr;
+        return data_ + header_->string_offset + offset;
+    }
+
+    PrrBlockView(const PrrBlockView&) = delete;
+    PrrBlockView& operator=(const PrrBlockView&) = delete;
+
+    const char* data_;
+    size_t size_;
+    const PrrBlockHeader* header_;
+};
+
+#endif // PRR_BLOCK_H
@@ -0,0 +1,226 @@
+#ifndef SYNC_SCHEDULER_H
+#define SYNC_SCHEDULER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <chrono>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "logger.h"
+#include "file_watcher.h"
+#include "append_fetcher.h"
+#include "daemon_config.h"
+
+// Sync state of one tester, only touched by the thread syncing it
+struct SyncState {
+    TesterConfig tester;
+    long long previousPosition;              // read position of the last published update
+    std::unique_ptr<AppendFetcher> fetcher;  // kept between syncs by the sync function
+};
+
+/**
+ * Syncs many testers with a fixed number of threads instead of one per tester.
+ *
+ * The scheduler thread is the event loop: it polls a wake pipe and the inotify
+ * descriptors of idle testers with mounted sources, with the time until the next
+ * due check as timeout. Due testers are queued for the sync workers, which probe
+ * the source (FileWatcher::check, "rsync --list-only" for remote ones) and call
+ * the sync function when it changed, in LOOP mode remote sources every time.
+ * A tester is synced by one worker at a time, its next check is due its
+ * watcher's interval later.
+ */
+class SyncScheduler {
+public:
+    typedef std::function<void(SyncState& state)> SyncFunction;
+
+    SyncScheduler(const std::vector<TesterConfig>& testers, SyncMode mode, int minIntervalMs, int maxIntervalMs,
+                  size_t workers, const SyncFunction& sync)
+        : maxIntervalMs_(maxIntervalMs), sync_(sync), running_(true) {
+        wakePipe_[0] = wakePipe_[1] = -1;
+        if (pipe2(wakePipe_, O_NONBLOCK | O_CLOEXEC) != 0) {
+            LOG.error("Failed to create the scheduler wake pipe: " + std::string(strerror(errno)), "Scheduler");
+        }
+
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        for (const TesterConfig& tester : testers) {
+            std::unique_ptr<Entry> entry(new Entry());
+            entry->state.tester = tester;
+            entry->state.previousPosition = 0;
+            // a mounted source is always watched, LOOP only replaces the remote listing
+            if (mode == SyncMode::ON_CHANGE || !FileWatcher::isRemote(tester.source)) {
+                entry->watcher.reset(new FileWatcher(tester.source, minIntervalMs, maxIntervalMs));
+            }
+            entry->due = now;
+            entry->busy = false;
+            entries_.push_back(std::move(entry));
+        }
+
+        if (workers == 0) workers = 1;
+        for (size_t i = 0; i < workers; i++) {
+            workers_.push_back(std::thread(&SyncScheduler::work, this));
+        }
+        loop_ = std::thread(&SyncScheduler::loop, this);
+        LOG.info("Syncing " + std::to_string(entries_.size()) + " testers with " + std::to_string(workers) +
+                 " workers", "Scheduler");
+    }
+
+    ~SyncScheduler() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            running_ = false;
+        }
+        wake();
+        jobCondition_.notify_all();
+        loop_.join();
+        for (std::thread& worker : workers_) {
+            worker.join();
+        }
+        if (wakePipe_[0] >= 0) close(wakePipe_[0]);
+        if (wakePipe_[1] >= 0) close(wakePipe_[1]);
+    }
+
+    size_t size() const { return entries_.size(); }
+
+private:
+    struct Entry {
+        SyncState state;
+        std::unique_ptr<FileWatcher> watcher;    // none for remote sources in LOOP mode
+        std::chrono::steady_clock::time_point due;
+        bool busy;                               // queued or syncing
+    };
+
+    void wake() {
+        if (wakePipe_[1] < 0) return;
+        char byte = 0;
+        if (write(wakePipe_[1], &byte, 1) < 0 && errno != EAGAIN) {
+            LOG.warning("Failed to wake the scheduler: " + std::string(strerror(errno)), "Scheduler");
+        }
+    }
+
+    void loop() {
+        std::vector<struct pollfd> fds;
+        std::vector<size_t> fdEntries;   // entry of fds[i + 1]
+        while (true) {
+            fds.clear();
+            fdEntries.clear();
+            struct pollfd wakeFd;
+            wakeFd.fd = wakePipe_[0];
+            wakeFd.events = POLLIN;
+            wakeFd.revents = 0;
+            fds.push_back(wakeFd);
+
+            // wait for the next due tester, an inotify event or a finished sync
+            int timeoutMs = maxIntervalMs_;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (!running_) return;
+                std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+                for (size_t i = 0; i < entries_.size(); i++) {
+                    Entry& entry = *entries_[i];
+                    if (entry.busy) continue;
+                    long long untilDue = std::chrono::duration_cast<std::chrono::milliseconds>(entry.due - now).count();
+                    timeoutMs = static_cast<int>(std::max(0LL, std::min(static_cast<long long>(timeoutMs), untilDue)));
+                    if (entry.watcher && entry.watcher->eventFd() >= 0) {
+                        struct pollfd eventFd;
+                        eventFd.fd = entry.watcher->eventFd();
+                        eventFd.events = POLLIN;
+                        eventFd.revents = 0;
+                        fds.push_back(eventFd);
+                        fdEntries.push_back(i);
+                    }
+                }
+            }
+
+            if (poll(fds.data(), fds.size(), timeoutMs) < 0 && errno != EINTR) {
+                LOG.error("Scheduler poll failed: " + std::string(strerror(errno)), "Scheduler");
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+            if (fds[0].revents & POLLIN) {
+                char buffer[256];
+                while (read(wakePipe_[0], buffer, sizeof(buffer)) > 0) {
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!running_) return;
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < fdEntries.size(); i++) {
+                Entry& entry = *entries_[fdEntries[i]];
+                // still idle: a worker only takes an entry through jobs_
+                if (!entry.busy && (fds[i + 1].revents & POLLIN)) {
+                    entry.watcher->drainEvents();
+                    entry.due = now;
+                }
+            }
+            bool queued = false;
+            for (size_t i = 0; i < entries_.size(); i++) {
+                Entry& entry = *entries_[i];
+                if (entry.busy || entry.due > now) continue;
+                entry.busy = true;
+                jobs_.push_back(i);
+                queued = true;
+            }
+            if (queued) jobCondition_.notify_all();
+        }
+    }
+
+    void work() {
+        while (true) {
+            size_t index;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                jobCondition_.wait(lock, [this]() { return !running_ || !jobs_.empty(); });
+                if (!running_) return;
+                index = jobs_.front();
+                jobs_.pop_front();
+            }
+
+            Entry& entry = *entries_[index];
+            bool changed = true;
+            if (entry.watcher) {
+                changed = (entry.watcher->check() == FileWatcher::Probe::CHANGED);
+            }
+            if (changed) {
+                try {
+                    sync_(entry.state);
+                } catch (const std::exception& e) {
+                    LOG.error("Sync of " + entry.state.tester.name + " failed: " + std::string(e.what()), "Scheduler");
+                }
+            }
+            int intervalMs = entry.watcher ? entry.watcher->intervalMs() : 1;
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                entry.due = std::chrono::steady_clock::now() + std::chrono::milliseconds(intervalMs);
+                entry.busy = false;
+            }
+            wake();
+        }
+    }
+
+    SyncScheduler(const SyncScheduler&) = delete;
+    SyncScheduler& operator=(const SyncScheduler&) = delete;
+
+    int maxIntervalMs_;
+    SyncFunction sync_;
+    std::vector<std::unique_ptr<Entry>> entries_;
+    std::deque<size_t> jobs_;
+    std::mutex mutex_;
+    std::condition_variable jobCondition_;
+    bool running_;
+    int wakePipe_[2];
+    std::thread loop_;
+    std::vector<std::thread> workers_;
+};
+
+#endif // SYNC_SCHEDULER_H
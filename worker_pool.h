@@ -0,0 +1,132 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+#include "logger.h"
+
+/**
+ * Worker threads for consumed messages.
+ *
+ * Every message has a key (the file name); all messages with one key go to the
+ * same worker and are handled in the order they were submitted, messages of
+ * different keys run in parallel. The result of each message is queued as a
+ * completion for the thread owning the AMQP connection, which sends the ack:
+ * rabbitmq-c connections must not be used from several threads.
+ */
+class WorkerPool {
+public:
+    // worker: index of the handling worker, for per-worker state
+    typedef std::function<bool(const std::string& message, size_t worker)> Handler;
+
+    struct Completion {
+        uint64_t deliveryTag;
+        bool success;
+    };
+
+    WorkerPool(size_t workers, const Handler& handler) : handler_(handler), running_(true) {
+        if (workers == 0) workers = 1;
+        for (size_t i = 0; i < workers; i++) {
+            workers_.push_back(std::unique_ptr<Worker>(new Worker()));
+        }
+        for (size_t i = 0; i < workers; i++) {
+            workers_[i]->thread = std::thread(&WorkerPool::run, this, i);
+        }
+    }
+
+    ~WorkerPool() {
+        for (size_t i = 0; i < workers_.size(); i++) {
+            {
+                std::lock_guard<std::mutex> lock(workers_[i]->mutex);
+                running_ = false;
+            }
+            workers_[i]->condition.notify_all();
+        }
+        for (size_t i = 0; i < workers_.size(); i++) {
+            workers_[i]->thread.join();
+        }
+    }
+
+    size_t size() const { return workers_.size(); }
+
+    void submit(const std::string& key, uint64_t deliveryTag, const std::string& message) {
+        size_t index = std::hash<std::string>()(key) % workers_.size();
+        Worker& worker = *workers_[index];
+        {
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            Job job;
+            job.deliveryTag = deliveryTag;
+            job.message = message;
+            worker.jobs.push_back(job);
+        }
+        worker.condition.notify_one();
+    }
+
+    // moves the finished messages into completions, returns false if there were none
+    bool takeCompletions(std::vector<Completion>& completions) {
+        std::lock_guard<std::mutex> lock(completionMutex_);
+        if (completions_.empty()) return false;
+        completions.insert(completions.end(), completions_.begin(), completions_.end());
+        completions_.clear();
+        return true;
+    }
+
+private:
+    struct Job {
+        uint64_t deliveryTag;
+        std::string message;
+    };
+
+    struct Worker {
+        std::thread thread;
+        std::deque<Job> jobs;
+        std::mutex mutex;
+        std::condition_variable condition;
+    };
+
+    void run(size_t index) {
+        Worker& worker = *workers_[index];
+        while (true) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(worker.mutex);
+                worker.condition.wait(lock, [&]() { return !running_ || !worker.jobs.empty(); });
+                if (worker.jobs.empty()) return;
+                job = worker.jobs.front();
+                worker.jobs.pop_front();
+            }
+
+            bool success = false;
+            try {
+                success = handler_(job.message, index);
+            } catch (const std::exception& e) {
+                LOG.error("Worker " + std::to_string(index) + " failed: " + std::string(e.what()), "Consumer");
+            }
+
+            std::lock_guard<std::mutex> lock(completionMutex_);
+            Completion completion;
+            completion.deliveryTag = job.deliveryTag;
+            completion.success = success;
+            completions_.push_back(completion);
+        }
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    Handler handler_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<bool> running_;
+    std::vector<Completion> completions_;
+    std::mutex completionMutex_;
+};
+
+#endif // WORKER_POOL_H
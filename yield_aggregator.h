@@ -0,0 +1,343 @@
+#ifndef YIELD_AGGREGATOR_H
+#define YIELD_AGGREGATOR_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <utility>
+#include <cstdint>
+#include <ctime>
+#include <cmath>
+#include "stdf_v4_api.h"
+#include "nlohmann/json.hpp"
+
+/**
+ * Live bin and yield summary of one stdf file, fed with the PRRs of every delta.
+ *
+ * Per head/site it counts the hard and soft bins of the parts, the parts that
+ * passed, the retests and the test times, the same numbers the HBR/SBR/PCR
+ * records only give at the end of the lot. Counts are flat arrays indexed by the
+ * bin number; the sites of a file are a short vector searched linearly.
+ *
+ * A retest (PRR supersede flag, or a part id / die coordinate seen before on the
+ * same wafer) moves the part from its earlier bin to the new one, so bins and
+ * yield count every part once with its last result. "tested" counts every PRR.
+ * The wafer is the WAFER_ID of the last WIR, a wafer probed again later keeps
+ * its parts.
+ *
+ * takeDelta() returns what changed since the last call as one JSON object: the
+ * changed sites with their current totals and only the bins that changed, with
+ * their absolute counts. Applying a delta twice changes nothing, a lost one is
+ * repaired by the next delta of the same bins or the final one, which has
+ * everything.
+ *
+ * Not thread safe, the aggregator of a file belongs to the worker of the file.
+ */
+class YieldAggregator {
+public:
+    YieldAggregator(const std::string& tester, const std::string& file)
+        : tester_(tester), file_(file), sequence_(0), reset_(false), lastSite_(0) {}
+
+    void add(const std::vector<StdfPRR*>& prrRecords) {
+        for (const StdfPRR* prr : prrRecords) {
+            add(*prr);
+        }
+    }
+
+    // wafers: the WIRs among the PRRs, as extractNewPrrRecords returns them
+    void add(const std::vector<StdfPRR*>& prrRecords, const std::vector<std::pair<size_t, std::string>>& wafers) {
+        size_t next = 0;
+        for (const std::pair<size_t, std::string>& wafer : wafers) {
+            for (; next < wafer.first && next < prrRecords.size(); next++) {
+                add(*prrRecords[next]);
+            }
+            startWafer(wafer.second);
+        }
+        for (; next < prrRecords.size(); next++) {
+            add(*prrRecords[next]);
+        }
+    }
+
+    // The parts of the following PRRs are on this wafer
+    void startWafer(const std::string& waferId) { wafer_ = waferId; }
+
+    void add(const StdfPRR& prr) {
+        size_t siteIndex = findSite(prr.get_head_number(), prr.get_site_number());
+        SiteStats& site = sites_[siteIndex];
+        PartResult result;
+        result.site = static_cast<uint32_t>(siteIndex);
+        result.hardBin = prr.get_hardbin_number();
+        result.softBin = prr.get_softbin_number();
+        // without a valid pass/fail flag the hard bin 1 convention decides
+        result.passed = prr.pass_fail_flag_invalid() ? (result.hardBin == 1) : !prr.part_failed_flag();
+
+        site.tested++;
+        site.testTimes[timeBucket(prr.get_elapsed_ms())]++;
+        markSite(siteIndex);
+
+        partKey(prr, wafer_, key_);
+        PartResult* previous = nullptr;
+        if (!key_.empty()) {
+            std::unordered_map<std::string, PartResult>::iterator it = parts_.find(key_);
+            if (it != parts_.end()) previous = &it->second;
+        }
+
+        if (previous) {
+            // retest: the part leaves the bin of its earlier result
+            SiteStats& earlier = sites_[previous->site];
+            count(earlier.hardBins, previous->hardBin, -1);
+            count(earlier.softBins, previous->softBin, -1);
+            earlier.parts--;
+            if (previous->passed) earlier.passed--;
+            markSite(previous->site);
+            site.retests++;
+            *previous = result;
+        } else {
+            // flagged, but the earlier result is not known (other delta range, no key)
+            if (prr.part_supersede_flag()) site.retests++;
+            if (!key_.empty()) parts_.emplace(key_, result);
+        }
+        count(site.hardBins, result.hardBin, 1);
+        count(site.softBins, result.softBin, 1);
+        site.parts++;
+        if (result.passed) site.passed++;
+    }
+
+    // The file was replaced and is read again from the start, forget everything
+    void reset() {
+        sites_.clear();
+        parts_.clear();
+        dirtySites_.clear();
+        wafer_.clear();
+        lastSite_ = 0;
+        reset_ = true;
+    }
+
+    bool hasDelta() const { return reset_ || !dirtySites_.empty(); }
+
+    /**
+     * The changes since the last call, and mark them published.
+     *
+     * @param final The file is complete; then all sites and bins are in the object
+     * @return {"type":"yield","tester","file","seq","final","reset","sites":[...]}
+     */
+    nlohmann::json takeDelta(bool final = false) {
+        nlohmann::json delta = header(final, ++sequence_);
+        nlohmann::json& sites = delta["sites"];
+        if (final) {
+            for (size_t i = 0; i < sites_.size(); i++) {
+                sites.push_back(siteJson(sites_[i], true));
+            }
+        } else {
+            for (uint32_t index : dirtySites_) {
+                sites.push_back(siteJson(sites_[index], false));
+            }
+        }
+        for (SiteStats& site : sites_) {
+            site.dirty = false;
+            site.hardBins.clearDirty();
+            site.softBins.clearDirty();
+        }
+        dirtySites_.clear();
+        reset_ = false;
+        return delta;
+    }
+
+    // Everything, without changing what the next delta contains
+    nlohmann::json summary() const {
+        nlohmann::json result = header(true, sequence_);
+        nlohmann::json& sites = result["sites"];
+        for (const SiteStats& site : sites_) {
+            sites.push_back(siteJson(site, true));
+        }
+        return result;
+    }
+
+private:
+    // ~12% wide test time buckets: exact below 16 ms, then 8 per power of two
+    static const int TIME_BUCKETS = 240;
+
+    struct BinCounts {
+        std::vector<uint32_t> counts;     // index = bin number
+        std::vector<uint8_t> isDirty;
+        std::vector<uint16_t> dirty;      // changed bins since the last delta
+
+        void clearDirty() {
+            for (uint16_t bin : dirty) isDirty[bin] = 0;
+            dirty.clear();
+        }
+    };
+
+    struct SiteStats {
+        unsigned char head;
+        unsigned char site;
+        unsigned long long tested;
+        unsigned long long parts;
+        unsigned long long passed;
+        unsigned long long retests;
+        BinCounts hardBins;
+        BinCounts softBins;
+        std::vector<uint32_t> testTimes;
+        bool dirty;
+    };
+
+    struct PartResult {
+        uint32_t site;
+        uint16_t hardBin;
+        uint16_t softBin;
+        bool passed;
+    };
+
+    size_t findSite(unsigned char head, unsigned char site) {
+        // consecutive PRRs are mostly from the sites of one touchdown
+        if (lastSite_ < sites_.size() && sites_[lastSite_].head == head && sites_[lastSite_].site == site) {
+            return lastSite_;
+        }
+        for (size_t i = 0; i < sites_.size(); i++) {
+            if (sites_[i].head == head && sites_[i].site == site) {
+                lastSite_ = i;
+                return i;
+            }
+        }
+        SiteStats stats;
+        stats.head = head;
+        stats.site = site;
+        stats.tested = stats.parts = stats.passed = stats.retests = 0;
+        stats.testTimes.assign(TIME_BUCKETS, 0);
+        stats.dirty = false;
+        sites_.push_back(stats);
+        lastSite_ = sites_.size() - 1;
+        return lastSite_;
+    }
+
+    void markSite(size_t index) {
+        if (!sites_[index].dirty) {
+            sites_[index].dirty = true;
+            dirtySites_.push_back(static_cast<uint32_t>(index));
+        }
+    }
+
+    static void count(BinCounts& bins, uint16_t bin, int change) {
+        if (bin >= bins.counts.size()) {
+            bins.counts.resize(bin + 1, 0);
+            bins.isDirty.resize(bin + 1, 0);
+        }
+        bins.counts[bin] += change;
+        if (!bins.isDirty[bin]) {
+            bins.isDirty[bin] = 1;
+            bins.dirty.push_back(bin);
+        }
+    }
+
+    // wafer and part id, else wafer, head and die coordinates; empty when the
+    // PRR has neither
+    static void partKey(const StdfPRR& prr, const std::string& wafer, std::string& key) {
+        key.clear();
+        const char* partId = prr.get_part_id();
+        if (partId && partId[0]) {
+            key += 'i';
+            key += wafer;
+            key += '\0';
+            key += partId;
+        } else if (prr.get_x_coordinate() != -32768 && prr.get_y_coordinate() != -32768) {
+            short x = prr.get_x_coordinate();
+            short y = prr.get_y_coordinate();
+            key += 'x';
+            key += wafer;
+            key += '\0';
+            key += static_cast<char>(prr.get_head_number());
+            key.append(reinterpret_cast<const char*>(&x), sizeof(x));
+            key.append(reinterpret_cast<const char*>(&y), sizeof(y));
+        }
+    }
+
+    static int timeBucket(unsigned int ms) {
+        if (ms < 16) return static_cast<int>(ms);
+        int exponent = 31 - __builtin_clz(ms);
+        int mantissa = static_cast<int>((ms >> (exponent - 3)) & 7);
+        return 16 + (exponent - 4) * 8 + mantissa;
+    }
+
+    // middle of the bucket
+    static double bucketValue(int bucket) {
+        if (bucket < 16) return bucket;
+        int exponent = (bucket - 16) / 8 + 4;
+        unsigned long long low = static_cast<unsigned long long>(8 + (bucket - 16) % 8) << (exponent - 3);
+        unsigned long long width = 1ULL << (exponent - 3);
+        return static_cast<double>(low) + (width - 1) / 2.0;
+    }
+
+    static double percentile(const std::vector<uint32_t>& buckets, unsigned long long total, double fraction) {
+        if (total == 0) return 0;
+        // nearest rank
+        unsigned long long rank = static_cast<unsigned long long>(std::ceil(fraction * total));
+        if (rank == 0) rank = 1;
+        unsigned long long seen = 0;
+        for (int i = 0; i < TIME_BUCKETS; i++) {
+            seen += buckets[i];
+            if (seen >= rank) return bucketValue(i);
+        }
+        return bucketValue(TIME_BUCKETS - 1);
+    }
+
+    nlohmann::json header(bool final, unsigned long long sequence) const {
+        nlohmann::json result;
+        result["type"] = "yield";
+        result["tester"] = tester_;
+        result["file"] = file_;
+        result["time"] = static_cast<long long>(time(nullptr));
+        result["seq"] = sequence;
+        result["final"] = final;
+        result["reset"] = reset_;
+        result["sites"] = nlohmann::json::array();
+        return result;
+    }
+
+    static nlohmann::json binsJson(const BinCounts& bins, bool all) {
+        nlohmann::json result = nlohmann::json::object();
+        if (all) {
+            for (size_t bin = 0; bin < bins.counts.size(); bin++) {
+                if (bins.counts[bin]) result[std::to_string(bin)] = bins.counts[bin];
+            }
+        } else {
+            for (uint16_t bin : bins.dirty) {
+                result[std::to_string(bin)] = bins.counts[bin];
+            }
+        }
+        return result;
+    }
+
+    static nlohmann::json siteJson(const SiteStats& site, bool all) {
+        nlohmann::json result;
+        result["head"] = site.head;
+        result["site"] = site.site;
+        result["tested"] = site.tested;
+        result["parts"] = site.parts;
+        result["passed"] = site.passed;
+        result["retests"] = site.retests;
+        result["yield"] = site.parts ? static_cast<double>(site.passed) / site.parts : 0.0;
+        result["hard_bins"] = binsJson(site.hardBins, all);
+        result["soft_bins"] = binsJson(site.softBins, all);
+        nlohmann::json& times = result["test_time_ms"];
+        times["p50"] = percentile(site.testTimes, site.tested, 0.50);
+        times["p90"] = percentile(site.testTimes, site.tested, 0.90);
+        times["p99"] = percentile(site.testTimes, site.tested, 0.99);
+        return result;
+    }
+
+    YieldAggregator(const YieldAggregator&) = delete;
+    YieldAggregator& operator=(const YieldAggregator&) = delete;
+
+    std::string tester_;
+    std::string file_;
+    unsigned long long sequence_;
+    bool reset_;
+    size_t lastSite_;
+    std::vector<SiteStats> sites_;
+    std::vector<uint32_t> dirtySites_;
+    std::unordered_map<std::string, PartResult> parts_;   // part key -> last result, for retests
+    std::string wafer_;                                   // WAFER_ID of the last WIR
+    std::string key_;                                     // reused by add()
+};
+
+#endif // YIELD_AGGREGATOR_H